@@ -0,0 +1,98 @@
+#
+# Copyright 2012-2013 The libLTE Developers. See the
+# COPYRIGHT file at the top-level directory of this distribution.
+#
+# This file is part of the libLTE library.
+#
+# libLTE is free software: you can redistribute it and/or modify
+# it under the terms of the GNU Lesser General Public License as
+# published by the Free Software Foundation, either version 3 of
+# the License, or (at your option) any later version.
+#
+# libLTE is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU Lesser General Public License for more details.
+#
+# A copy of the GNU Lesser General Public License can be found in
+# the LICENSE file in the top-level directory of this distribution
+# and at http://www.gnu.org/licenses/.
+#
+
+# - Check if the compiler and the build host support SSE4.1 and AVX2
+# Once done this will define
+#  HAVE_SSE      - SSE4.1 intrinsics compile and run
+#  HAVE_AVX2     - AVX2 intrinsics compile and run
+#  HAVE_PCLMUL   - Carry-less multiplication (PCLMULQDQ) intrinsics compile
+#  SSE_FLAGS     - Compiler flags enabling SSE4.1 or AVX2, for the intrinsic kernel sources only
+#  SSE_DEFINITIONS - LV_HAVE_SSE / LV_HAVE_AVX2 / LV_HAVE_PCLMUL preprocessor definitions
+#
+# The SSE4.1/AVX2 kernels are built for the instruction sets of the build host, 
+# so the library requires them on the target CPU. PCLMULQDQ code is compiled with 
+# function target attributes and only used if the CPU supports it at run time.
+#
+# Set DISABLE_SSE=1 to force the generic C implementations.
+
+INCLUDE(CheckCSourceRuns)
+INCLUDE(CheckCSourceCompiles)
+
+SET(SSE_FLAGS "")
+SET(SSE_DEFINITIONS "")
+
+IF(NOT CMAKE_SYSTEM_PROCESSOR MATCHES "^(arm|aarch64)" AND NOT DISABLE_SSE)
+
+  SET(_SSE_SAVED_REQUIRED_LIBRARIES "${CMAKE_REQUIRED_LIBRARIES}")
+  SET(CMAKE_REQUIRED_LIBRARIES "")
+
+  SET(CMAKE_REQUIRED_FLAGS "-msse4.1")
+  CHECK_C_SOURCE_RUNS("
+    #include <emmintrin.h>
+    #include <smmintrin.h>
+    int main()
+    {
+      __m128i a = _mm_setzero_si128();
+      __m128i b = _mm_max_epi16(a, _mm_set1_epi16(1));
+      b = _mm_shuffle_epi8(b, a);
+      return _mm_extract_epi16(_mm_min_epi32(a, b), 0);
+    }" HAVE_SSE)
+
+  IF(HAVE_SSE)
+    SET(SSE_FLAGS "-msse4.1")
+    SET(SSE_DEFINITIONS "-DLV_HAVE_SSE")
+
+    SET(CMAKE_REQUIRED_FLAGS "-mavx2")
+    CHECK_C_SOURCE_RUNS("
+      #include <immintrin.h>
+      int main()
+      {
+        __m256i a = _mm256_setzero_si256();
+        __m256i b = _mm256_adds_epi16(a, _mm256_set1_epi16(1));
+        return _mm256_extract_epi16(_mm256_max_epi16(a, b), 0) - 1;
+      }" HAVE_AVX2)
+
+    IF(HAVE_AVX2)
+      SET(SSE_FLAGS "-mavx2")
+      SET(SSE_DEFINITIONS "${SSE_DEFINITIONS} -DLV_HAVE_AVX2")
+    ENDIF(HAVE_AVX2)
+
+    SET(CMAKE_REQUIRED_FLAGS "-msse4.1 -mpclmul")
+    CHECK_C_SOURCE_COMPILES("
+      #include <wmmintrin.h>
+      int main()
+      {
+        __m128i a = _mm_set_epi32(0, 0, 0, 3);
+        __m128i b = _mm_clmulepi64_si128(a, a, 0x00);
+        return _mm_cvtsi128_si32(b) - 5;
+      }" HAVE_PCLMUL)
+
+    IF(HAVE_PCLMUL)
+      SET(SSE_DEFINITIONS "${SSE_DEFINITIONS} -DLV_HAVE_PCLMUL")
+    ENDIF(HAVE_PCLMUL)
+  ENDIF(HAVE_SSE)
+
+  SET(CMAKE_REQUIRED_FLAGS "")
+  SET(CMAKE_REQUIRED_LIBRARIES "${_SSE_SAVED_REQUIRED_LIBRARIES}")
+
+ENDIF(NOT CMAKE_SYSTEM_PROCESSOR MATCHES "^(arm|aarch64)" AND NOT DISABLE_SSE)
+
+MARK_AS_ADVANCED(HAVE_SSE HAVE_AVX2 HAVE_PCLMUL SSE_FLAGS SSE_DEFINITIONS)
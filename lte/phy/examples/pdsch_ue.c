@@ -192,7 +192,10 @@ int main(int argc, char **argv) {
     fprintf(stderr, "Error initiating UE downlink processing module\n");
     exit(-1);
   }
-  pdsch_set_rnti(&ue_dl.pdsch, prog_args.rnti);
+  if (!prog_args.disable_plots) {
+    /* The plots show the intermediate buffers of the step by step equalizer */
+    pdsch_set_fused_equalizer(&ue_dl.pdsch, false);
+  }
   
   /* Main loop */
   while (!go_exit && (sf_cnt < prog_args.nof_subframes || prog_args.nof_subframes == -1)) {
@@ -28,14 +28,48 @@
 #ifndef LTESEQ_
 #define LTESEQ_
 
+#include <pthread.h>
+
 #include "liblte/config.h"
 #include "liblte/phy/common/phy_common.h"
 
+/* c holds one bit per char. c_packed holds the same bits packed MSB first,
+ * followed by SEQUENCE_PACKED_PAD zero bytes so that it can be read a whole
+ * word at a time starting from any bit.
+ */
+#define SEQUENCE_PACKED_PAD 8
+
 typedef struct LIBLTE_API {
   char *c;
+  uint8_t *c_packed;
   uint32_t len;
 } sequence_t;
 
+/* LRU cache of sequences indexed by their c_init, which for the data channels
+ * already combines the RNTI, codeword, slot and cell id. Sequences are
+ * generated on demand with the length requested and regenerated when a longer
+ * one is needed. Memory is bounded by nof_entries sequences. The cache can be
+ * shared by several threads: sequence_cache_get() returns a reference to the
+ * sequence that stays valid until it is released with sequence_cache_put().
+ * Entries in use are not evicted nor regenerated; when a longer sequence is
+ * needed or every entry is in use, a private sequence is returned instead and
+ * freed by sequence_cache_put().
+ */
+typedef struct LIBLTE_API {
+  uint32_t c_init;
+  uint32_t refs;
+  uint64_t last_used;
+  sequence_t seq;
+} sequence_cache_entry_t;
+
+typedef struct LIBLTE_API {
+  sequence_cache_entry_t *entries;
+  uint32_t nof_entries;
+  uint32_t nof_used;
+  uint64_t clock;
+  pthread_mutex_t mutex;
+} sequence_cache_t;
+
 LIBLTE_API int sequence_init(sequence_t *q, uint32_t len);
 
 LIBLTE_API void sequence_free(sequence_t *q);
@@ -61,6 +95,23 @@ LIBLTE_API int sequence_pdcch(sequence_t *seq,
                               uint32_t cell_id, 
                               uint32_t len);
 
+LIBLTE_API int sequence_cache_init(sequence_cache_t *q, 
+                                   uint32_t nof_entries);
+
+LIBLTE_API void sequence_cache_free(sequence_cache_t *q);
+
+LIBLTE_API sequence_t *sequence_cache_get(sequence_cache_t *q, 
+                                          uint32_t c_init, 
+                                          uint32_t len);
+
+LIBLTE_API void sequence_cache_put(sequence_cache_t *q, 
+                                   sequence_t *seq);
+
+LIBLTE_API uint32_t sequence_pdsch_c_init(unsigned short rnti, 
+                                          int q,
+                                          uint32_t nslot, 
+                                          uint32_t cell_id);
+
 LIBLTE_API int sequence_pdsch(sequence_t *seq, 
                               unsigned short rnti, 
                               int q,
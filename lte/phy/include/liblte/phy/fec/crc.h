@@ -32,20 +32,55 @@
 #include "liblte/config.h"
 #include <stdint.h>
 
+/* CRC engines over packed bytes. The carry-less multiplication one (PCLMULQDQ) 
+ * is only available if the library was built with it and the CPU supports it. 
+ */
+typedef enum LIBLTE_API {
+  CRC_ENGINE_SLICE8 = 0, 
+  CRC_ENGINE_CLMUL
+} crc_engine_t;
+
 typedef struct LIBLTE_API {
-  unsigned long table[256];
-  unsigned char byte;
   int polynom;
   int order;
   unsigned long crcinit; 
   unsigned long crcmask;
   unsigned long crchighbit;
   unsigned int crc_out;
+
+  /* Slice-by-8 tables, with the CRC register aligned to the MSB of 32 bits */
+  uint32_t poly_s8;
+  uint32_t table_s8[8][256];
+
+  /* Folding constants x^(D+64) and x^D mod P for D=128 and D=512 bits */
+  uint32_t fold_k[2][2];
+  crc_engine_t engine;
+
+  /* CRC register of the incremental computation */
+  uint32_t state;
 } crc_t;
 
+/* Selects the fastest engine available */
 LIBLTE_API int crc_init(crc_t *h, unsigned int crc_poly, int crc_order);
+
+/* Returns -1 if the engine is not available */
+LIBLTE_API int crc_set_engine(crc_t *h, crc_engine_t engine);
 LIBLTE_API int crc_set_init(crc_t *h, unsigned long crc_init_value);
 LIBLTE_API void crc_attach(crc_t *h, char *data, int len);
 LIBLTE_API uint32_t crc_checksum(crc_t *h, char *data, int len);
 
+/* Same as crc_checksum() over len bits packed in bytes, MSB first */
+LIBLTE_API uint32_t crc_checksum_packed(crc_t *h, uint8_t *data, int len);
+
+/* Same as crc_attach() over len bits packed in bytes, MSB first */
+LIBLTE_API void crc_attach_packed(crc_t *h, uint8_t *data, int len);
+
+/* Incremental CRC over packed bits. crc_reset() starts a new message, each 
+ * crc_update_packed() appends len bits, and crc_value() returns the checksum of 
+ * the bits appended so far. 
+ */
+LIBLTE_API void crc_reset(crc_t *h);
+LIBLTE_API void crc_update_packed(crc_t *h, uint8_t *data, int len);
+LIBLTE_API uint32_t crc_value(crc_t *h);
+
 #endif
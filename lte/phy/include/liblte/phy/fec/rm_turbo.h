@@ -28,6 +28,8 @@
 #ifndef RM_TURBO_
 #define RM_TURBO_
 
+#include <stdint.h>
+
 #include "liblte/config.h"
 
 #ifndef RX_NULL
@@ -57,6 +59,92 @@ LIBLTE_API int rm_turbo_rx(float *w_buff,
                            uint32_t out_len, 
                            uint32_t rv_idx);
 
+/* Soft buffer size limitation (36.212 5.1.4.1.2). Only the first N_cb bits of the 
+ * circular buffer are used, and N_cb=0 means the whole 3*K_p bits. The circular
+ * buffer for coded_len coded bits must have rm_turbo_buff_len(coded_len, N_cb) 
+ * elements.
+ */
+LIBLTE_API uint32_t rm_turbo_buff_len(uint32_t coded_len, 
+                                      uint32_t N_cb);
+
+LIBLTE_API int rm_turbo_tx_lim(char *w_buff,
+                               uint32_t buff_len, 
+                               char *input, 
+                               uint32_t in_len, 
+                               char *output,
+                               uint32_t out_len, 
+                               uint32_t rv_idx, 
+                               uint32_t N_cb);
+
+/* As rm_turbo_tx_lim() with the input and output bits packed in bytes, MSB first. 
+ * The circular buffer holds one bit per element, as in rm_turbo_tx_lim(), so both 
+ * functions can be used for the retransmissions of the same code block. 
+ */
+LIBLTE_API int rm_turbo_tx_packed(char *w_buff,
+                                  uint32_t buff_len, 
+                                  uint8_t *input, 
+                                  uint32_t in_len, 
+                                  uint8_t *output,
+                                  uint32_t out_len, 
+                                  uint32_t rv_idx, 
+                                  uint32_t N_cb);
+
+LIBLTE_API int rm_turbo_rx_lim(float *w_buff,
+                               uint32_t buff_len, 
+                               float *input, 
+                               uint32_t in_len,
+                               float *output, 
+                               uint32_t out_len, 
+                               uint32_t rv_idx, 
+                               uint32_t N_cb);
+
+/* Soft-combining with compressed circular buffers of saturated 16 or 8-bit LLRs. 
+ * With rv_idx==0 the scaling of the code block is chosen from the input LLRs and 
+ * stored in scale, which must be passed again for the retransmissions. Set scale 
+ * to 0 before the first transmission received, it may have rv_idx!=0. 
+ */
+LIBLTE_API int rm_turbo_rx_s(int16_t *w_buff,
+                             uint32_t buff_len, 
+                             float *input, 
+                             uint32_t in_len,
+                             float *output, 
+                             uint32_t out_len, 
+                             uint32_t rv_idx, 
+                             uint32_t N_cb, 
+                             float *scale);
+
+LIBLTE_API int rm_turbo_rx_b(int8_t *w_buff,
+                             uint32_t buff_len, 
+                             float *input, 
+                             uint32_t in_len,
+                             float *output, 
+                             uint32_t out_len, 
+                             uint32_t rv_idx, 
+                             uint32_t N_cb, 
+                             float *scale);
+
+/* Fixed-point soft-combining of int16_t or int8_t LLRs with a circular buffer of 
+ * the same type and scale, saturating. The output is the int16_t input of 
+ * tdec_simd_t. 
+ */
+LIBLTE_API int rm_turbo_rx_fixed_s(int16_t *w_buff,
+                                   uint32_t buff_len, 
+                                   int16_t *input, 
+                                   uint32_t in_len,
+                                   int16_t *output, 
+                                   uint32_t out_len, 
+                                   uint32_t rv_idx, 
+                                   uint32_t N_cb);
+
+LIBLTE_API int rm_turbo_rx_fixed_b(int8_t *w_buff,
+                                   uint32_t buff_len, 
+                                   int8_t *input, 
+                                   uint32_t in_len,
+                                   int16_t *output, 
+                                   uint32_t out_len, 
+                                   uint32_t rv_idx, 
+                                   uint32_t N_cb);
+
 /* High-level API */
 typedef struct LIBLTE_API {
   
@@ -30,13 +30,20 @@
 
 #include "liblte/config.h"
 
+/* The LTE interleaver does not own any memory: forward and reverse point to 
+ * a process-wide read-only table of the QPP permutation for each of the 
+ * NOF_TC_CB_SIZES code block sizes, computed the first time a size is used. 
+ * Only the UMTS interleaver allocates buff to hold its permutation. 
+ */
 typedef struct LIBLTE_API {
-  uint32_t *forward;
-  uint32_t *reverse;
+  const uint16_t *forward;
+  const uint16_t *reverse;
+  uint16_t *buff;
   uint32_t max_long_cb;
 } tc_interl_t;
 
 LIBLTE_API int tc_interl_LTE_gen(tc_interl_t *h, uint32_t long_cb);
+LIBLTE_API int tc_interl_LTE_gen_all(void);
 LIBLTE_API int tc_interl_UMTS_gen(tc_interl_t *h, uint32_t long_cb);
 
 LIBLTE_API int tc_interl_init(tc_interl_t *h, uint32_t max_long_cb);
@@ -45,5 +45,10 @@ LIBLTE_API int tcod_init(tcod_t *h, uint32_t max_long_cb);
 LIBLTE_API void tcod_free(tcod_t *h);
 LIBLTE_API int tcod_encode(tcod_t *h, char *input, char *output, uint32_t long_cb);
 
+/* Same as tcod_encode() with input and output bits packed in bytes, MSB first. 
+ * long_cb must be a multiple of 8, as are all the LTE code block sizes. 
+ */
+LIBLTE_API int tcod_encode_packed(tcod_t *h, uint8_t *input, uint8_t *output, uint32_t long_cb);
+
 #endif
 
@@ -30,6 +30,8 @@
 
 #include "liblte/config.h"
 #include "liblte/phy/fec/tc_interl.h"
+#include "liblte/phy/fec/crc.h"
+#include "liblte/phy/utils/thread_pool.h"
 
 #define RATE 3
 #define TOTALTAIL 12
@@ -47,13 +49,25 @@
 #define MAX_LONG_CB     6114
 #define MAX_LONG_CODED  (RATE*MAX_LONG_CB+TOTALTAIL)
 
+#define TDEC_MAX_SUBBLOCKS 16
+
 typedef float llr_t;
 
 typedef struct LIBLTE_API {
   int max_long_cb;
+  uint32_t window;
   llr_t *beta;
 } map_gen_t;
 
+/* State metrics at the sub-block boundaries, inherited from the previous
+ * iteration. alpha[p] are the forward metrics at the start of sub-block p and
+ * beta[p] the backward metrics at its end.
+ */
+typedef struct LIBLTE_API {
+  llr_t alpha[TDEC_MAX_SUBBLOCKS][NUMSTATES];
+  llr_t beta[TDEC_MAX_SUBBLOCKS][NUMSTATES];
+} map_bounds_t;
+
 typedef struct LIBLTE_API {
   int max_long_cb;
 
@@ -66,6 +80,9 @@ typedef struct LIBLTE_API {
   llr_t *parity;
 
   tc_interl_t interleaver;
+
+  uint32_t nof_subblocks;
+  map_bounds_t bounds[2];
 } tdec_t;
 
 LIBLTE_API int tdec_init(tdec_t * h, 
@@ -73,16 +90,47 @@ LIBLTE_API int tdec_init(tdec_t * h,
 
 LIBLTE_API void tdec_free(tdec_t * h);
 
+/* Selects sliding-window decoding with windows of the given number of bits
+ * (32 to 128 are sensible values), which keeps the backward metrics of a
+ * single window instead of the whole block. window=0 decodes the whole block
+ * at once (default).
+ */
+LIBLTE_API int tdec_set_window(tdec_t * h,
+                               uint32_t window);
+
 LIBLTE_API int tdec_reset(tdec_t * h, uint32_t long_cb);
 
 LIBLTE_API void tdec_iteration(tdec_t * h, 
                                llr_t * input, 
                                uint32_t long_cb);
 
+/* Same as tdec_iteration() but each MAP decoder splits the block in
+ * nof_subblocks sub-blocks which are decoded concurrently in the given pool
+ * (or one after another if pool is NULL). The state metrics at the
+ * boundaries are taken from the previous iteration, which costs a small
+ * loss in exchange for dividing the latency by up to nof_subblocks.
+ */
+LIBLTE_API int tdec_iteration_par(tdec_t * h,
+                                  llr_t * input,
+                                  uint32_t long_cb,
+                                  uint32_t nof_subblocks,
+                                  thread_pool_t *pool);
+
 LIBLTE_API void tdec_decision(tdec_t * h, 
                               char *output, 
                               uint32_t long_cb);
 
+/* Hard decision packed in bytes, MSB first, with the first nof_filler bits
+ * set to zero. Returns the CRC of the long_cb decoded bits, so that a zero
+ * return value means the block is correct. Filler bits are zero and do not
+ * change the CRC.
+ */
+LIBLTE_API uint32_t tdec_decision_crc(tdec_t * h,
+                                      uint8_t *output,
+                                      uint32_t long_cb,
+                                      uint32_t nof_filler,
+                                      crc_t *crc);
+
 LIBLTE_API void tdec_run_all(tdec_t * h, 
                              llr_t * input, 
                              char *output,
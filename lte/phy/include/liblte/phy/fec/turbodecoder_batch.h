@@ -0,0 +1,88 @@
+/**
+ *
+ * \section COPYRIGHT
+ *
+ * Copyright 2013-2014 The libLTE Developers. See the
+ * COPYRIGHT file at the top-level directory of this distribution.
+ *
+ * \section LICENSE
+ *
+ * This file is part of the libLTE library.
+ *
+ * libLTE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libLTE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * A copy of the GNU Lesser General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+/* Batched fixed-point turbo decoder.
+ *
+ * Decodes several code blocks of the same length at once, one code block per
+ * 16-bit SIMD lane (16 lanes with AVX2, 8 otherwise). Every lane uses the
+ * same saturating arithmetic as tdec_simd_t, so its output is bit-exact with
+ * decoding that code block alone. Because all lanes share the interleaver,
+ * the interleaving becomes a permutation of whole rows of lanes.
+ */
+
+#ifndef TURBODECODER_BATCH_
+#define TURBODECODER_BATCH_
+
+#include <stdint.h>
+
+#include "liblte/config.h"
+#include "liblte/phy/fec/tc_interl.h"
+#include "liblte/phy/fec/crc.h"
+#include "liblte/phy/fec/turbodecoder_simd.h"
+
+typedef struct LIBLTE_API {
+  uint32_t max_long_cb;
+  uint32_t nof_lanes;
+
+  int16_t *beta;
+  int16_t *llr1;
+  int16_t *llr2;
+  int16_t *w;
+  int16_t *syst;
+  int16_t *parity;
+  int16_t *input;
+
+  tc_interl_t interleaver;
+} tdec_batch_t;
+
+LIBLTE_API int tdec_batch_init(tdec_batch_t * h,
+                               uint32_t max_long_cb);
+
+LIBLTE_API void tdec_batch_free(tdec_batch_t * h);
+
+LIBLTE_API uint32_t tdec_batch_nof_lanes(tdec_batch_t * h);
+
+/* Decodes nof_cb code blocks of long_cb bits each. inputs[i] holds the
+ * 3*long_cb+12 LLRs of code block i and outputs[i] receives its long_cb
+ * decoded bits. If crc is not NULL, the decision of each code block is
+ * checked after every iteration and its lane is masked once the CRC over the
+ * long_cb bits is correct. The number of iterations run for each code block is
+ * stored in nof_iterations[i] if it is not NULL.
+ *
+ * Returns the number of code blocks with a correct CRC (or nof_cb if crc is NULL),
+ * or -1 on error.
+ */
+LIBLTE_API int tdec_run_batch(tdec_batch_t * h,
+                              int16_t **inputs,
+                              char **outputs,
+                              uint32_t nof_cb,
+                              uint32_t long_cb,
+                              uint32_t max_iterations,
+                              crc_t *crc,
+                              uint32_t *nof_iterations);
+
+#endif
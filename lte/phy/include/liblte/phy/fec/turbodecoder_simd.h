@@ -0,0 +1,96 @@
+/**
+ *
+ * \section COPYRIGHT
+ *
+ * Copyright 2013-2014 The libLTE Developers. See the
+ * COPYRIGHT file at the top-level directory of this distribution.
+ *
+ * \section LICENSE
+ *
+ * This file is part of the libLTE library.
+ *
+ * libLTE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libLTE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * A copy of the GNU Lesser General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+/* Fixed-point (int16) MAX-LOG-MAP turbo decoder.
+ *
+ * The 8 trellis states are kept in one SSE register and all metrics use
+ * saturating 16-bit arithmetic, normalized to state 0 at every trellis step.
+ * While no metric saturates, the output is bit-exact with the floating point
+ * decoder in turbodecoder.h fed with the same integer-valued LLRs. A generic
+ * C implementation with the same arithmetic is used without LV_HAVE_SSE.
+ */
+
+#ifndef TURBODECODER_SIMD_
+#define TURBODECODER_SIMD_
+
+#include <stdint.h>
+
+#include "liblte/config.h"
+#include "liblte/phy/fec/tc_interl.h"
+#include "liblte/phy/fec/turbodecoder.h"
+
+#define TDEC_SIMD_INF   16384
+
+typedef struct LIBLTE_API {
+  int max_long_cb;
+  int16_t *beta;
+} map_simd_t;
+
+typedef struct LIBLTE_API {
+  int max_long_cb;
+
+  map_simd_t dec;
+
+  int16_t *llr1;
+  int16_t *llr2;
+  int16_t *w;
+  int16_t *syst;
+  int16_t *parity;
+
+  tc_interl_t interleaver;
+} tdec_simd_t;
+
+LIBLTE_API int tdec_simd_init(tdec_simd_t * h,
+                              uint32_t max_long_cb);
+
+LIBLTE_API void tdec_simd_free(tdec_simd_t * h);
+
+LIBLTE_API int tdec_simd_reset(tdec_simd_t * h,
+                               uint32_t long_cb);
+
+LIBLTE_API void tdec_simd_iteration(tdec_simd_t * h,
+                                    int16_t * input,
+                                    uint32_t long_cb);
+
+LIBLTE_API void tdec_simd_decision(tdec_simd_t * h,
+                                   char *output,
+                                   uint32_t long_cb);
+
+/* Packed hard decision and CRC, as tdec_decision_crc() */
+LIBLTE_API uint32_t tdec_simd_decision_crc(tdec_simd_t * h,
+                                           uint8_t *output,
+                                           uint32_t long_cb,
+                                           uint32_t nof_filler,
+                                           crc_t *crc);
+
+LIBLTE_API void tdec_simd_run_all(tdec_simd_t * h,
+                                  int16_t * input,
+                                  char *output,
+                                  uint32_t nof_iterations,
+                                  uint32_t long_cb);
+
+#endif
@@ -32,8 +32,11 @@
 #include <stdbool.h>
 #include "liblte/config.h"
 
+/* viterbi_37 selects the SIMD decoder when SSE is available. viterbi_37_port and 
+ * viterbi_37_simd force one implementation. Both produce the same output. 
+ */
 typedef enum {
-  viterbi_27, viterbi_29, viterbi_37, viterbi_39
+  viterbi_27, viterbi_29, viterbi_37, viterbi_39, viterbi_37_port, viterbi_37_simd
 }viterbi_type_t;
 
 typedef struct LIBLTE_API{
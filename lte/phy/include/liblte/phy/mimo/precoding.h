@@ -28,6 +28,8 @@
 #ifndef PRECODING_H_
 #define PRECODING_H_
 
+#include <stdint.h>
+
 #include "liblte/config.h"
 
 typedef _Complex float cf_t;
@@ -53,4 +55,22 @@ LIBLTE_API int predecoding_diversity_zf(cf_t *y, cf_t *ce[MAX_PORTS], cf_t *x[MA
 LIBLTE_API int predecoding_type(cf_t *y, cf_t *ce[MAX_PORTS], cf_t *x[MAX_LAYERS],
     int nof_ports, int nof_layers, int nof_symbols, lte_mimo_type_t type);
 
+/* MMSE versions for a noise variance noise_estimate per RE (0 is the ZF detector).
+ * If snr is not NULL it receives the post-equalization SNR of each symbol, in
+ * layer-demapped order, or its channel power if noise_estimate is 0.
+ */
+LIBLTE_API int predecoding_single_mmse(cf_t *y, cf_t *ce, cf_t *x, float *snr,
+    float noise_estimate, int nof_symbols);
+LIBLTE_API int predecoding_diversity_mmse(cf_t *y, cf_t *ce[MAX_PORTS], cf_t *x[MAX_LAYERS],
+    float *snr, float noise_estimate, int nof_ports, int nof_symbols);
+
+/* Same as above followed by layerdemap_diversity(), in a single pass. "y" and "ce"
+ * are read at the positions re_idx of the resource grid and the layer-demapped
+ * symbols are written to "d". Returns the number of symbols written to "d".
+ */
+LIBLTE_API int predecoding_single_idx(cf_t *y, cf_t *ce, uint32_t *re_idx, cf_t *d,
+    float *snr, float noise_estimate, int nof_symbols);
+LIBLTE_API int predecoding_diversity_idx(cf_t *y, cf_t *ce[MAX_PORTS], uint32_t *re_idx,
+    cf_t *d, float *snr, float noise_estimate, int nof_ports, int nof_symbols);
+
 #endif /* PRECODING_H_ */
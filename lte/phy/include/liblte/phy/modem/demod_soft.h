@@ -37,10 +37,14 @@
 
 enum alg { EXACT, APPROX };
 
+/* Symbols demapped at once by the fixed-point outputs */
+#define DEMOD_SOFT_BLOCK_LEN  256
+
 typedef struct LIBLTE_API {
   float sigma;      // noise power
   enum alg alg_type;    // soft demapping algorithm (EXACT or APPROX)
   modem_table_t *table;  // symbol mapping table (see modem_table.h)
+  float llr_block[DEMOD_SOFT_BLOCK_LEN * 6]; // scratch for the fixed-point outputs
 }demod_soft_t;
 
 LIBLTE_API void demod_soft_init(demod_soft_t *q);
@@ -49,6 +53,13 @@ LIBLTE_API void demod_soft_alg_set(demod_soft_t *q, enum alg alg_type);
 LIBLTE_API void demod_soft_sigma_set(demod_soft_t *q, float sigma);
 LIBLTE_API int demod_soft_demodulate(demod_soft_t *q, const cf_t* symbols, float* llr, int nsymbols);
 
+/* Same LLRs multiplied by scale, and by weights[i] for the bits of symbol i if 
+ * weights is not NULL, rounded and saturated to +-INT16_MAX or +-INT8_MAX */
+LIBLTE_API int demod_soft_demodulate_s(demod_soft_t *q, const cf_t* symbols, int16_t* llr, float scale, 
+                                       const float *weights, int nsymbols);
+LIBLTE_API int demod_soft_demodulate_b(demod_soft_t *q, const cf_t* symbols, int8_t* llr, float scale, 
+                                       const float *weights, int nsymbols);
+
 
 /* High-level API */
 typedef struct LIBLTE_API {
@@ -37,8 +37,31 @@
 
 typedef _Complex float cf_t;
 
+/* Maps nbits bits, one per char, to symbols and returns the number of symbols. 
+ * Trailing bits that do not fill a symbol are ignored. 
+ */
 LIBLTE_API int mod_modulate(modem_table_t* table, const char *bits, cf_t* symbols, uint32_t nbits);
 
+/* Same as mod_modulate() but writes symbol j to sf_symbols[re_idx[j]], so the 
+ * symbols go straight to their resource elements. 
+ */
+LIBLTE_API int mod_modulate_re(modem_table_t* table, 
+                               const char *bits, 
+                               cf_t* sf_symbols, 
+                               const uint32_t *re_idx, 
+                               uint32_t nbits);
+
+/* Same as mod_modulate() with the bits packed MSB first, 8 per byte. nbits must be 
+ * a multiple of the bits per symbol. 
+ */
+LIBLTE_API int mod_modulate_packed(modem_table_t* table, const uint8_t *bits, cf_t* symbols, uint32_t nbits);
+
+LIBLTE_API int mod_modulate_packed_re(modem_table_t* table, 
+                                      const uint8_t *bits, 
+                                      cf_t* sf_symbols, 
+                                      const uint32_t *re_idx, 
+                                      uint32_t nbits);
+
 /* High-level API */
 typedef struct LIBLTE_API {
   modem_table_t obj;
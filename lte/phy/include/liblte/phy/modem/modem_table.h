@@ -40,13 +40,11 @@
 typedef _Complex float cf_t;
 typedef struct LIBLTE_API {
   uint32_t idx[2][6][32];
-  uint32_t min_idx[2][64][6];	/* NEW: for each constellation point zone (2, 4, 16, 64 for BPSK, QPSK, 16QAM, 64QAM) the 2x(1, 2, 4, and 6 closest constellation points) for each bit, respectively. */
-  uint32_t d_idx[64][7];	/* NEW: for each constellation point zone (2, 4, 16, 64 for BPSK, QPSK, 16QAM, 64QAM) the 2, 3, 5 and 7 indices to constellation points that need to be computed for any recevied symbol modulated as BPSK, QPSK, 16QAM, and 64QAM, respectively. */
-
 }soft_table_t;
 
 typedef struct LIBLTE_API {
   cf_t* symbol_table;     	// bit-to-symbol mapping
+  cf_t* byte_table;             // symbols of each input byte, 8/nbits_x_symbol per byte (BPSK, QPSK, 16QAM)
   soft_table_t soft_table;   	// symbol-to-bit mapping (used in soft demodulating)
   uint32_t nsymbols;        	// number of modulation symbols
   uint32_t nbits_x_symbol;      // number of bits per symbol
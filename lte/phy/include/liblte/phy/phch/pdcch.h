@@ -41,14 +41,32 @@
 #include "liblte/phy/fec/crc.h"
 #include "liblte/phy/phch/dci.h"
 #include "liblte/phy/phch/regs.h"
+#include "liblte/phy/utils/thread_pool.h"
 
 typedef _Complex float cf_t;
 
+#define PDCCH_MAX_THREADS       8
+#define PDCCH_MAX_LOCATIONS     32
+#define PDCCH_MAX_FORMATS       4
 
 typedef enum LIBLTE_API {
   SEARCH_UE, SEARCH_COMMON
 } pdcch_search_mode_t;
 
+/* DCI message found by pdcch_blind_search() or pdcch_decode_all() */
+typedef struct LIBLTE_API {
+  dci_msg_t msg;
+  dci_location_t location;
+  dci_format_t format;
+  dci_msg_type_t type; /* only set by pdcch_decode_all() */
+  uint16_t rnti;
+} pdcch_candidate_t;
+
+/* Decoder owned by each blind search worker */
+typedef struct LIBLTE_API {
+  viterbi_t decoder;
+  crc_t crc;
+} pdcch_dci_decoder_t;
 
 /* PDCCH object */
 typedef struct LIBLTE_API {
@@ -57,6 +75,7 @@ typedef struct LIBLTE_API {
   uint32_t nof_regs;
   uint32_t nof_cce;
   uint32_t max_bits;
+  uint32_t max_region_bits;
 
   regs_t *regs;
 
@@ -74,6 +93,13 @@ typedef struct LIBLTE_API {
   sequence_t seq_pdcch[NSUBFRAMES_X_FRAME];
   viterbi_t decoder;
   crc_t crc;
+
+  /* blind search */
+  float *llr_region;
+  uint32_t region_nof_cce;
+  uint32_t nof_threads;
+  pdcch_dci_decoder_t *dci_decoders;
+  thread_pool_t pool;
 } pdcch_t;
 
 LIBLTE_API int pdcch_init(pdcch_t *q, 
@@ -82,6 +108,9 @@ LIBLTE_API int pdcch_init(pdcch_t *q,
 
 LIBLTE_API void pdcch_free(pdcch_t *q);
 
+LIBLTE_API int pdcch_set_threads(pdcch_t *q, 
+                                 uint32_t nof_threads);
+
 
 /* Encoding function */
 LIBLTE_API int pdcch_encode(pdcch_t *q, 
@@ -106,6 +135,42 @@ LIBLTE_API int pdcch_decode_msg(pdcch_t *q,
                                 dci_format_t format,
                                 uint16_t *crc_rem);
 
+/* Decoding functions: Extract the LLRs of the whole control region once per subframe */
+LIBLTE_API int pdcch_extract_llr_region(pdcch_t *q, 
+                                        cf_t *sf_symbols, 
+                                        cf_t *ce[MAX_PORTS],
+                                        uint32_t nsubframe, 
+                                        uint32_t cfi);
+
+/* Decoding functions: Decodes every (location, format) hypothesis at once from the LLRs 
+ * saved by pdcch_extract_llr_region() and returns the messages whose CRC is masked with 
+ * one of the rntis */
+LIBLTE_API int pdcch_blind_search(pdcch_t *q, 
+                                  dci_location_t *locations, 
+                                  uint32_t nof_locations,
+                                  dci_format_t *formats, 
+                                  uint32_t nof_formats,
+                                  uint16_t *rntis, 
+                                  uint32_t nof_rntis,
+                                  pdcch_candidate_t *candidates, 
+                                  uint32_t max_candidates);
+
+/* Decoding functions: Decodes every DCI message of any of the formats and rntis, running 
+ * the Viterbi decoder once per (location, payload size). With rntis NULL or nof_rntis 0 
+ * every RNTI is accepted, for passive monitoring: each (location, payload size) gives a 
+ * candidate unless dci_msg_get_type() rejects its payload, so wrong sizes and locations 
+ * show up with random RNTIs */
+LIBLTE_API int pdcch_decode_all(pdcch_t *q, 
+                                dci_location_t *locations, 
+                                uint32_t nof_locations,
+                                dci_format_t *formats, 
+                                uint32_t nof_formats,
+                                uint16_t *rntis, 
+                                uint32_t nof_rntis,
+                                uint16_t crnti,
+                                pdcch_candidate_t *candidates, 
+                                uint32_t max_candidates);
+
 /* Function for generation of UE-specific search space DCI locations */
 LIBLTE_API uint32_t pdcch_ue_locations(pdcch_t *q, 
                                        dci_location_t *locations, 
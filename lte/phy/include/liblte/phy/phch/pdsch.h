@@ -39,23 +39,66 @@
 #include "liblte/phy/fec/rm_turbo.h"
 #include "liblte/phy/fec/turbocoder.h"
 #include "liblte/phy/fec/turbodecoder.h"
+#include "liblte/phy/fec/turbodecoder_simd.h"
 #include "liblte/phy/fec/crc.h"
 #include "liblte/phy/phch/dci.h"
 #include "liblte/phy/phch/regs.h"
+#include "liblte/phy/utils/thread_pool.h"
 
 #define TDEC_MAX_ITERATIONS         6
 
+#define PDSCH_MAX_CB                13  // TBS index 26 with 110 PRB
+#define PDSCH_MAX_THREADS           16
+#define PDSCH_RE_MAP_CACHE_LEN      4
+#define PDSCH_SEQ_CACHE_LEN         (4 * NSUBFRAMES_X_FRAME)
+
 typedef _Complex float cf_t;
 
+/* Storage of the received LLRs in the HARQ soft buffers */
+typedef enum LIBLTE_API {
+  PDSCH_SOFTBUF_FLOAT = 0, 
+  PDSCH_SOFTBUF_INT16, 
+  PDSCH_SOFTBUF_INT8
+} pdsch_softbuf_t;
+
+/* Format of the LLRs from the demapper to the turbo decoder.
+ *
+ * With PDSCH_LLR_INT16 or PDSCH_LLR_INT8 the demapper scales the LLRs so that 
+ * a noiseless symbol on an innermost constellation point gives an LLR of 
+ * +-PDSCH_LLR_UNIT_S or +-PDSCH_LLR_UNIT_B for its sign bits, and rounds and 
+ * saturates them to +-INT16_MAX or +-INT8_MAX. The saturation is symmetric, so 
+ * descrambling only changes signs. The HARQ soft buffers hold LLRs of the same 
+ * type and scale and soft combining saturates to the same range. The soft 
+ * buffer format of the HARQ process is switched to match when decoding rv_idx=0; 
+ * decoding a retransmission with a different format is an error, so if rv_idx=0 
+ * may be missed call pdsch_harq_set_softbuf() beforehand. The fixed-point turbo 
+ * decoder consumes the combined LLRs without any further scaling. 
+ */
+typedef enum LIBLTE_API {
+  PDSCH_LLR_FLOAT = 0, 
+  PDSCH_LLR_INT16, 
+  PDSCH_LLR_INT8
+} pdsch_llr_t;
+
+#define PDSCH_LLR_UNIT_S            32
+#define PDSCH_LLR_UNIT_B            4
+
 typedef struct LIBLTE_API {
   ra_mcs_t mcs;
   ra_prb_t prb_alloc;
   lte_cell_t cell;
   
   uint32_t max_cb;
-  uint32_t w_buff_size;
-  float **pdsch_w_buff_f;  
-  char **pdsch_w_buff_c;  
+  uint32_t ue_category;
+  uint32_t N_cb;            // Soft buffer size of each code block, 0 if not limited 
+  pdsch_softbuf_t softbuf;
+  
+  /* Circular buffers of each code block, allocated on first use */
+  void **pdsch_w_buff_rx;  
+  uint32_t *w_buff_rx_len; 
+  float *w_buff_scale; 
+  void **pdsch_w_buff_tx;  
+  uint32_t *w_buff_tx_len; 
 
   struct cb_segm {
     uint32_t F;
@@ -68,6 +111,31 @@ typedef struct LIBLTE_API {
   
 } pdsch_harq_t;
 
+/* Code block decoder context used by each worker thread */
+typedef struct LIBLTE_API {
+  tdec_t decoder;
+  tdec_simd_t decoder_simd;
+  crc_t crc_tb;
+  crc_t crc_cb;
+  char *cb_in;
+  uint8_t *cb_in_b;
+  void *cb_out;
+} pdsch_cb_decoder_t;
+
+/* Positions in the resource grid of the PDSCH RE for one allocation. The
+ * number of ports and the CP are those of the cell, the subframe is reduced
+ * to 0, 5 or any other (sf_type 1), which are the only ones with different maps.
+ */
+typedef struct LIBLTE_API {
+  uint32_t hash;
+  ra_prb_slot_t slot[2];
+  uint32_t lstart;
+  uint32_t sf_type;
+  uint32_t nof_re;
+  uint32_t *re_idx;
+  uint64_t last_used;
+} pdsch_re_map_t;
+
 /* PDSCH object */
 typedef struct LIBLTE_API {
   lte_cell_t cell;
@@ -85,18 +153,41 @@ typedef struct LIBLTE_API {
   cf_t *pdsch_symbols[MAX_PORTS];
   cf_t *pdsch_x[MAX_PORTS];
   cf_t *pdsch_d;
+  float *pdsch_snr;
   char *cb_in; 
+  uint8_t *cb_in_b; 
   void *cb_out;  
   void *pdsch_e;
+  uint8_t *pdsch_e_b;
 
   /* tx & rx objects */
   modem_table_t mod[4];
   demod_soft_t demod;
-  sequence_t seq_pdsch[NSUBFRAMES_X_FRAME];
+  /* Scrambling sequences per RNTI and subframe. seq_pdsch points to the own 
+   * cache or to one shared with other PDSCH objects, which may run in other 
+   * threads. Sequences are only referenced while scrambling. 
+   */
+  sequence_cache_t seq_cache;
+  sequence_cache_t *seq_pdsch;
   tcod_t encoder;
   tdec_t decoder;  
+  tdec_simd_t decoder_simd;
   crc_t crc_tb;
   crc_t crc_cb;
+
+  /* LRU cache of RE maps, the most recent allocations are usually repeated */
+  pdsch_re_map_t re_maps[PDSCH_RE_MAP_CACHE_LEN];
+  uint32_t nof_re_maps;
+  uint64_t re_map_clock;
+  bool fused_equalizer;
+  float noise_estimate;
+  pdsch_llr_t llr_format;
+
+  /* multi-threaded code block decoding */
+  uint32_t nof_threads;
+  uint32_t nof_subblocks;
+  pdsch_cb_decoder_t *cb_decoders;
+  thread_pool_t pool;
 }pdsch_t;
 
 LIBLTE_API int pdsch_init(pdsch_t *q, 
@@ -107,6 +198,24 @@ LIBLTE_API void pdsch_free(pdsch_t *q);
 LIBLTE_API int pdsch_set_rnti(pdsch_t *q, 
                                uint16_t rnti);
 
+LIBLTE_API int pdsch_set_sequence_cache(pdsch_t *q, 
+                                        sequence_cache_t *cache);
+
+LIBLTE_API int pdsch_set_threads(pdsch_t *q, 
+                                 uint32_t nof_threads);
+
+LIBLTE_API int pdsch_set_subblocks(pdsch_t *q, 
+                                   uint32_t nof_subblocks);
+
+LIBLTE_API int pdsch_set_fused_equalizer(pdsch_t *q, 
+                                         bool enabled);
+
+LIBLTE_API int pdsch_set_noise_estimate(pdsch_t *q, 
+                                        float noise_estimate);
+
+LIBLTE_API int pdsch_set_llr_format(pdsch_t *q, 
+                                    pdsch_llr_t llr_format);
+
 LIBLTE_API int pdsch_harq_init(pdsch_harq_t *p, 
                                pdsch_t *pdsch);
 
@@ -116,6 +225,12 @@ LIBLTE_API int pdsch_harq_setup(pdsch_harq_t *p,
 
 LIBLTE_API void pdsch_harq_free(pdsch_harq_t *p);
 
+LIBLTE_API int pdsch_harq_set_softbuf(pdsch_harq_t *p, 
+                                      pdsch_softbuf_t softbuf);
+
+LIBLTE_API int pdsch_harq_set_ue_category(pdsch_harq_t *p, 
+                                          uint32_t ue_category);
+
 LIBLTE_API int pdsch_encode(pdsch_t *q, 
                             char *data, 
                             cf_t *sf_symbols[MAX_PORTS],
@@ -123,6 +238,14 @@ LIBLTE_API int pdsch_encode(pdsch_t *q,
                             pdsch_harq_t *harq_process, 
                             uint32_t rv_idx);
 
+LIBLTE_API int pdsch_encode_rnti(pdsch_t *q, 
+                                 char *data, 
+                                 cf_t *sf_symbols[MAX_PORTS],
+                                 uint32_t nsubframe,
+                                 pdsch_harq_t *harq_process, 
+                                 uint32_t rv_idx, 
+                                 uint16_t rnti);
+
 LIBLTE_API int pdsch_decode(pdsch_t *q, 
                             cf_t *sf_symbols, 
                             cf_t *ce[MAX_PORTS],
@@ -131,6 +254,36 @@ LIBLTE_API int pdsch_decode(pdsch_t *q,
                             pdsch_harq_t *harq_process, 
                             uint32_t rv_idx);
 
+LIBLTE_API int pdsch_decode_rnti(pdsch_t *q, 
+                                 cf_t *sf_symbols, 
+                                 cf_t *ce[MAX_PORTS],
+                                 char *data, 
+                                 uint32_t nsubframe,
+                                 pdsch_harq_t *harq_process, 
+                                 uint32_t rv_idx, 
+                                 uint16_t rnti);
+
+/* Same as pdsch_encode_rnti() and pdsch_decode_rnti() with the transport block 
+ * bits packed MSB first, 8 per byte. Both paths give the same symbols and share 
+ * the HARQ buffers. 
+ */
+LIBLTE_API int pdsch_encode_packed(pdsch_t *q, 
+                                   uint8_t *data, 
+                                   cf_t *sf_symbols[MAX_PORTS],
+                                   uint32_t nsubframe,
+                                   pdsch_harq_t *harq_process, 
+                                   uint32_t rv_idx, 
+                                   uint16_t rnti);
+
+LIBLTE_API int pdsch_decode_packed(pdsch_t *q, 
+                                   cf_t *sf_symbols, 
+                                   cf_t *ce[MAX_PORTS],
+                                   uint8_t *data, 
+                                   uint32_t nsubframe,
+                                   pdsch_harq_t *harq_process, 
+                                   uint32_t rv_idx, 
+                                   uint16_t rnti);
+
 LIBLTE_API float pdsch_average_noi(pdsch_t *q); 
 
 LIBLTE_API uint32_t pdsch_last_noi(pdsch_t *q); 
@@ -141,4 +294,18 @@ LIBLTE_API int pdsch_get(pdsch_t *q,
                          ra_prb_t *prb_alloc, 
                          uint32_t subframe);
 
+LIBLTE_API int pdsch_get_equalized(pdsch_t *q, 
+                                   cf_t *sf_symbols, 
+                                   cf_t *ce[MAX_PORTS],
+                                   cf_t *d,
+                                   float *snr,
+                                   ra_prb_t *prb_alloc, 
+                                   uint32_t subframe);
+
+LIBLTE_API int pdsch_put(pdsch_t *q, 
+                         cf_t *pdsch_symbols, 
+                         cf_t *sf_symbols,
+                         ra_prb_t *prb_alloc, 
+                         uint32_t subframe);
+
 #endif
@@ -54,6 +54,7 @@ typedef struct LIBLTE_API {
 typedef struct LIBLTE_API {
   uint32_t nof_regs;
   regs_reg_t **regs;
+  uint32_t *re_idx; /* Index in the resource grid of the 4 REs of each REG */
 }regs_ch_t;
 
 typedef struct LIBLTE_API {
@@ -94,6 +95,13 @@ LIBLTE_API int regs_pcfich_get(regs_t *h,
                                cf_t *slot_symbols, 
                                cf_t pcfich_symbols[REGS_PCFICH_NSYM]);
 
+LIBLTE_API int regs_pcfich_get_ce(regs_t *h,
+                                  cf_t *slot_symbols, 
+                                  cf_t *ce[MAX_PORTS], 
+                                  uint32_t nof_ports, 
+                                  cf_t pcfich_symbols[REGS_PCFICH_NSYM], 
+                                  cf_t *pcfich_ce[MAX_PORTS]);
+
 LIBLTE_API uint32_t regs_phich_nregs(regs_t *h);
 LIBLTE_API int regs_phich_add(regs_t *h, 
                               cf_t phich_symbols[REGS_PHICH_NSYM], 
@@ -105,6 +113,14 @@ LIBLTE_API int regs_phich_get(regs_t *h,
                               cf_t phich_symbols[REGS_PHICH_NSYM], 
                               uint32_t ngroup);
 
+LIBLTE_API int regs_phich_get_ce(regs_t *h, 
+                                 cf_t *slot_symbols, 
+                                 cf_t *ce[MAX_PORTS], 
+                                 uint32_t nof_ports, 
+                                 cf_t phich_symbols[REGS_PHICH_NSYM], 
+                                 cf_t *phich_ce[MAX_PORTS], 
+                                 uint32_t ngroup);
+
 LIBLTE_API uint32_t regs_phich_ngroups(regs_t *h);
 LIBLTE_API int regs_phich_reset(regs_t *h, 
                                 cf_t *slot_symbols);
@@ -130,6 +146,37 @@ LIBLTE_API int regs_pdcch_get_offset(regs_t *h,
                                      uint32_t start_reg, 
                                      uint32_t nof_regs);
 
+/* Same as regs_pdcch_get_offset() but also reads the channel estimates of nof_ports 
+ * ports into pdcch_ce[], in the same pass over the RE map */
+LIBLTE_API int regs_pdcch_get_offset_ce(regs_t *h, 
+                                        cf_t *slot_symbols, 
+                                        cf_t *ce[MAX_PORTS], 
+                                        uint32_t nof_ports, 
+                                        cf_t *pdcch_symbols, 
+                                        cf_t *pdcch_ce[MAX_PORTS], 
+                                        uint32_t start_reg, 
+                                        uint32_t nof_regs);
+
+/* Copy nof_re symbols from/to the positions re_idx of the resource grid */
+LIBLTE_API void regs_gather(cf_t *slot_symbols, 
+                            uint32_t *re_idx, 
+                            cf_t *data, 
+                            uint32_t nof_re);
+
+/* Same as regs_gather() also reading ce[0..nof_ports-1] into ce_data[] at each RE */
+LIBLTE_API void regs_gather_ce(cf_t *slot_symbols, 
+                               cf_t *ce[MAX_PORTS], 
+                               uint32_t nof_ports, 
+                               uint32_t *re_idx, 
+                               cf_t *data, 
+                               cf_t *ce_data[MAX_PORTS], 
+                               uint32_t nof_re);
+
+LIBLTE_API void regs_scatter(cf_t *data, 
+                             uint32_t *re_idx, 
+                             cf_t *slot_symbols, 
+                             uint32_t nof_re);
+
 #endif // REGS_H_
 
 
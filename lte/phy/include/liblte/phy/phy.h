@@ -47,6 +47,7 @@
 #include "liblte/phy/utils/cexptab.h"
 #include "liblte/phy/utils/pack.h"
 #include "liblte/phy/utils/vector.h"
+#include "liblte/phy/utils/thread_pool.h"
 
 #include "liblte/phy/common/phy_common.h"
 #include "liblte/phy/common/fft.h"
@@ -66,6 +67,8 @@
 #include "liblte/phy/fec/tc_interl.h"
 #include "liblte/phy/fec/turbocoder.h"
 #include "liblte/phy/fec/turbodecoder.h"
+#include "liblte/phy/fec/turbodecoder_simd.h"
+#include "liblte/phy/fec/turbodecoder_batch.h"
 #include "liblte/phy/fec/rm_conv.h"
 #include "liblte/phy/fec/rm_turbo.h"
 
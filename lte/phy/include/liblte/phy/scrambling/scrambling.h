@@ -29,6 +29,8 @@
 #ifndef SCRAMBLING_
 #define SCRAMBLING_
 
+#include <stdint.h>
+
 #include "liblte/config.h"
 #include "liblte/phy/common/sequence.h"
 #include "liblte/phy/common/phy_common.h"
@@ -39,9 +41,17 @@ typedef _Complex float cf_t;
 LIBLTE_API void scrambling_b(sequence_t *s, char *data);
 LIBLTE_API void scrambling_b_offset(sequence_t *s, char *data, int offset, int len);
 
+/* len bits packed MSB first, 8 per byte */
+LIBLTE_API void scrambling_b_packed(sequence_t *s, uint8_t *data);
+LIBLTE_API void scrambling_b_packed_offset(sequence_t *s, uint8_t *data, int offset, int len);
+
 LIBLTE_API void scrambling_f(sequence_t *s, float *data);
 LIBLTE_API void scrambling_f_offset(sequence_t *s, float *data, int offset, int len);
 
+/* int16_t and int8_t (signed byte) LLRs */
+LIBLTE_API void scrambling_s_offset(sequence_t *s, int16_t *data, int offset, int len);
+LIBLTE_API void scrambling_sb_offset(sequence_t *s, int8_t *data, int offset, int len);
+
 LIBLTE_API void scrambling_c(sequence_t *s, cf_t *data);
 LIBLTE_API void scrambling_c_offset(sequence_t *s, cf_t *data, int offset, int len);
 
@@ -36,6 +36,10 @@
 
 LIBLTE_API uint32_t bit_unpack(char **bits, int nof_bits);
 LIBLTE_API void bit_pack(uint32_t value, char **bits, int nof_bits);
+LIBLTE_API void bit_pack_vector(char *bits, uint8_t *packed, int nof_bits);
+LIBLTE_API void bit_unpack_vector(uint8_t *packed, char *bits, int nof_bits);
+LIBLTE_API void bit_copy(uint8_t *dst, uint32_t dst_offset, uint8_t *src, 
+                         uint32_t src_offset, uint32_t nof_bits);
 LIBLTE_API void bit_fprint(FILE *stream, char *bits, int nof_bits);
 LIBLTE_API unsigned int bit_diff(char *x, char *y, int nbits);
 LIBLTE_API uint32_t bit_count(uint32_t n);
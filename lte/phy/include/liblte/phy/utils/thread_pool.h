@@ -0,0 +1,76 @@
+/**
+ *
+ * \section COPYRIGHT
+ *
+ * Copyright 2013-2014 The libLTE Developers. See the
+ * COPYRIGHT file at the top-level directory of this distribution.
+ *
+ * \section LICENSE
+ *
+ * This file is part of the libLTE library.
+ *
+ * libLTE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libLTE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * A copy of the GNU Lesser General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#ifndef THREAD_POOL_
+#define THREAD_POOL_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+#include "liblte/config.h"
+
+/* Pool of worker threads executing a batch of independent jobs.
+ *
+ * thread_pool_run() hands out job indices 0..nof_jobs-1 dynamically to the
+ * first idle worker and returns once all of them have finished. The calling
+ * thread takes part as worker 0, so a pool of N workers spawns N-1 threads.
+ * The worker index passed to the job function can be used to select
+ * per-worker scratch buffers.
+ */
+typedef void (*thread_pool_job_t)(void *arg, uint32_t job_idx, uint32_t worker_idx);
+
+struct thread_pool_worker;
+
+typedef struct LIBLTE_API {
+  uint32_t nof_workers;
+  pthread_t *threads;
+  struct thread_pool_worker *workers;
+
+  pthread_mutex_t mutex;
+  pthread_cond_t cvar_jobs;
+  pthread_cond_t cvar_done;
+  bool stop;
+
+  thread_pool_job_t job;
+  void *arg;
+  uint32_t nof_jobs;
+  uint32_t next_job;
+  uint32_t pending_jobs;
+} thread_pool_t;
+
+LIBLTE_API int thread_pool_init(thread_pool_t *q,
+                                uint32_t nof_workers);
+
+LIBLTE_API void thread_pool_free(thread_pool_t *q);
+
+LIBLTE_API void thread_pool_run(thread_pool_t *q,
+                                uint32_t nof_jobs,
+                                thread_pool_job_t job,
+                                void *arg);
+
+#endif // THREAD_POOL_
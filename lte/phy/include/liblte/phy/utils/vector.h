@@ -107,6 +107,10 @@ LIBLTE_API uint32_t vec_max_abs_ci(cf_t *x, uint32_t len);
 /* quantify vector of floats and convert to unsigned char */
 LIBLTE_API void vec_quant_fuc(float *in, unsigned char *out, float gain, float offset, float clip, uint32_t len);
 
+/* quantify vector of floats to int16_t or int8_t, rounding and saturating to +-INT16_MAX or +-INT8_MAX */
+LIBLTE_API void vec_quant_fs(float *in, int16_t *out, float gain, uint32_t len);
+LIBLTE_API void vec_quant_fc(float *in, int8_t *out, float gain, uint32_t len);
+
 /* magnitude of each vector element */
 LIBLTE_API void vec_abs_cf(cf_t *x, float *abs, uint32_t len);
 
@@ -27,14 +27,45 @@
 
 
 #include "liblte/phy/common/sequence.h"
+#include "liblte/phy/utils/bit.h"
 
 #include <stdlib.h>
 #include <stdio.h>
 #include <strings.h>
+#include <stdbool.h>
 #include <assert.h>
 
 #define Nc 1600
 
+/* The m-sequences x1 and x2 are kept as 31-bit windows where bit i holds 
+ * x(n+i). Since the feedback taps reach back 31 bits, the next 28 bits of 
+ * each sequence depend only on the current window and are computed at once. 
+ */
+#define SEQ_STEP  28
+#define SEQ_MASK  0x0fffffff
+
+/* Window of x1 at n = Nc. x1 has a fixed initial state. */
+#define X1_NC 0x5e485840
+
+/* Window of x2 at n = Nc for each bit of c_init. The generator is linear, so 
+ * the window for any c_init is the XOR of the entries for its bits. 
+ */
+static const uint32_t x2_nc[31] = {
+  0x70889900, 0x1199ab01, 0x53bbcf03, 0x57ff0707,
+  0x2ffe0e0e, 0x5ffc1c1c, 0x3ff83838, 0x7ff07070,
+  0x7fe0e0e1, 0x7fc1c1c2, 0x7f838384, 0x7f070708,
+  0x7e0e0e11, 0x7c1c1c22, 0x78383844, 0x70707088,
+  0x60e0e111, 0x41c1c222, 0x03838444, 0x07070889,
+  0x0e0e1113, 0x1c1c2226, 0x3838444c, 0x70708899,
+  0x60e11132, 0x41c22264, 0x038444c8, 0x07088990,
+  0x0e111320, 0x1c222640, 0x38444c80};
+
+static inline uint8_t reverse_byte(uint32_t b) {
+  b = ((b & 0xf0) >> 4) | ((b & 0x0f) << 4);
+  b = ((b & 0xcc) >> 2) | ((b & 0x33) << 2);
+  b = ((b & 0xaa) >> 1) | ((b & 0x55) << 1);
+  return (uint8_t) b;
+}
 
 /*
  * Pseudo Random Sequence generation.
@@ -42,37 +73,38 @@
  * Section 7.2
  */
 void generate_prs_c(sequence_t *q, uint32_t seed) {
-  int n;
-  uint32_t *x1, *x2;
-
-  x1 = calloc(Nc + q->len + 31, sizeof(uint32_t));
-  if (!x1) {
-    perror("calloc");
-    return;
-  }
-  x2 = calloc(Nc + q->len + 31, sizeof(uint32_t));
-  if (!x2) {
-    free(x1);
-    perror("calloc");
-    return;
-  }
+  uint32_t x1 = X1_NC, x2 = 0;
+  uint32_t n, k = 0;
+  uint32_t nof_bytes = (q->len + 7) / 8;
+  uint64_t acc = 0;
+  uint32_t nacc = 0;
 
   for (n = 0; n < 31; n++) {
-    x2[n] = (seed >> n) & 0x1;
+    if ((seed >> n) & 0x1) {
+      x2 ^= x2_nc[n];
+    }
   }
-  x1[0] = 1;
 
-  for (n = 0; n < Nc + q->len; n++) {
-    x1[n + 31] = (x1[n + 3] + x1[n]) & 0x1;
-    x2[n + 31] = (x2[n + 3] + x2[n + 2] + +x2[n+1] + x2[n]) & 0x1;
+  for (n = 0; n < q->len; n += SEQ_STEP) {
+    /* Bits are produced LSB first and packed MSB first */
+    acc |= (uint64_t) ((x1 ^ x2) & SEQ_MASK) << nacc;
+    nacc += SEQ_STEP;
+    while (nacc >= 8 && k < nof_bytes) {
+      q->c_packed[k++] = reverse_byte(acc & 0xff);
+      acc >>= 8;
+      nacc -= 8;
+    }
+    x1 = (x1 >> SEQ_STEP) | ((((x1 >> 3) ^ x1) & SEQ_MASK) << 3);
+    x2 = (x2 >> SEQ_STEP) | ((((x2 >> 3) ^ (x2 >> 2) ^ (x2 >> 1) ^ x2) & SEQ_MASK) << 3);
   }
-
-  for (n = 0; n < q->len; n++) {
-    q->c[n] = (x1[n + Nc] + x2[n + Nc]) & 0x1;
+  if (k < nof_bytes) {
+    q->c_packed[k++] = reverse_byte(acc & 0xff);
+  }
+  if (q->len % 8) {
+    q->c_packed[nof_bytes - 1] &= (uint8_t) (0xff << (8 - q->len % 8));
   }
 
-  free(x1);
-  free(x2);
+  bit_unpack_vector(q->c_packed, q->c, q->len);
 }
 
 int sequence_LTEPRS(sequence_t *q, uint32_t len, uint32_t seed) {
@@ -87,6 +119,11 @@ int sequence_LTEPRS(sequence_t *q, uint32_t len, uint32_t seed) {
 int sequence_init(sequence_t *q, uint32_t len) {
   if (q->c && (q->len != len)) {
     free(q->c);
+    q->c = NULL;
+    if (q->c_packed) {
+      free(q->c_packed);
+      q->c_packed = NULL;
+    }
   }
   if (!q->c) {
     q->c = malloc(len * sizeof(char));
@@ -94,6 +131,12 @@ int sequence_init(sequence_t *q, uint32_t len) {
       return LIBLTE_ERROR;
     }
   }
+  if (!q->c_packed) {
+    q->c_packed = calloc((len + 7) / 8 + SEQUENCE_PACKED_PAD, sizeof(uint8_t));
+    if (!q->c_packed) {
+      return LIBLTE_ERROR;
+    }
+  }
   return LIBLTE_SUCCESS;
 }
 
@@ -101,7 +144,130 @@ void sequence_free(sequence_t *q) {
   if (q->c) {
     free(q->c);
   }
+  if (q->c_packed) {
+    free(q->c_packed);
+  }
   bzero(q, sizeof(sequence_t));
 }
 
+int sequence_cache_init(sequence_cache_t *q, uint32_t nof_entries) {
+  if (q != NULL && nof_entries > 0) {
+    bzero(q, sizeof(sequence_cache_t));
+    q->entries = calloc(nof_entries, sizeof(sequence_cache_entry_t));
+    if (!q->entries) {
+      perror("calloc");
+      return LIBLTE_ERROR;
+    }
+    if (pthread_mutex_init(&q->mutex, NULL)) {
+      perror("pthread_mutex_init");
+      free(q->entries);
+      q->entries = NULL;
+      return LIBLTE_ERROR;
+    }
+    q->nof_entries = nof_entries;
+    return LIBLTE_SUCCESS;
+  } else {
+    return LIBLTE_ERROR_INVALID_INPUTS;
+  }
+}
 
+void sequence_cache_free(sequence_cache_t *q) {
+  uint32_t i;
+  if (q->entries) {
+    for (i = 0; i < q->nof_used; i++) {
+      sequence_free(&q->entries[i].seq);
+    }
+    free(q->entries);
+    pthread_mutex_destroy(&q->mutex);
+  }
+  bzero(q, sizeof(sequence_cache_t));
+}
+
+/* Generates a sequence which is not in the cache, freed by sequence_cache_put() */
+static sequence_t *sequence_cache_private(uint32_t c_init, uint32_t len) {
+  sequence_t *seq = calloc(1, sizeof(sequence_t));
+  if (!seq) {
+    perror("calloc");
+    return NULL;
+  }
+  if (sequence_LTEPRS(seq, len, c_init)) {
+    sequence_free(seq);
+    free(seq);
+    return NULL;
+  }
+  return seq;
+}
+
+/* Returns a sequence for c_init of at least len bits, generating it in the 
+ * least recently used free entry if it is not in the cache. The reference must
+ * be released with sequence_cache_put(). Returns NULL on error. 
+ */
+sequence_t *sequence_cache_get(sequence_cache_t *q, uint32_t c_init, uint32_t len) {
+  uint32_t i;
+  sequence_cache_entry_t *e = NULL;
+  bool generate;
+
+  pthread_mutex_lock(&q->mutex);
+  q->clock++;
+  for (i = 0; i < q->nof_used; i++) {
+    if (q->entries[i].c_init == c_init) {
+      e = &q->entries[i];
+      break;
+    }
+  }
+  if (e != NULL) {
+    generate = e->seq.len < len;
+    if (generate && e->refs) {
+      e = NULL;
+    }
+  } else {
+    generate = true;
+    if (q->nof_used < q->nof_entries) {
+      e = &q->entries[q->nof_used++];
+    } else {
+      for (i = 0; i < q->nof_entries; i++) {
+        if (!q->entries[i].refs && (!e || q->entries[i].last_used < e->last_used)) {
+          e = &q->entries[i];
+        }
+      }
+    }
+  }
+  if (e == NULL) {
+    /* the entry is being used with a shorter length, or all of them are */
+    pthread_mutex_unlock(&q->mutex);
+    return sequence_cache_private(c_init, len);
+  }
+  if (generate) {
+    if (sequence_LTEPRS(&e->seq, len, c_init)) {
+      sequence_free(&e->seq);
+      e->c_init = 0;
+      e->last_used = 0;
+      pthread_mutex_unlock(&q->mutex);
+      return NULL;
+    }
+    e->c_init = c_init;
+  }
+  e->refs++;
+  e->last_used = q->clock;
+  pthread_mutex_unlock(&q->mutex);
+  return &e->seq;
+}
+
+/* Releases a sequence returned by sequence_cache_get() */
+void sequence_cache_put(sequence_cache_t *q, sequence_t *seq) {
+  sequence_cache_entry_t *e;
+  uint32_t i;
+
+  pthread_mutex_lock(&q->mutex);
+  for (i = 0; i < q->nof_used; i++) {
+    e = &q->entries[i];
+    if (&e->seq == seq) {
+      e->refs--;
+      pthread_mutex_unlock(&q->mutex);
+      return;
+    }
+  }
+  pthread_mutex_unlock(&q->mutex);
+  sequence_free(seq);
+  free(seq);
+}
@@ -0,0 +1,221 @@
+/**
+ *
+ * \section COPYRIGHT
+ *
+ * Copyright 2013-2014 The libLTE Developers. See the
+ * COPYRIGHT file at the top-level directory of this distribution.
+ *
+ * \section LICENSE
+ *
+ * This file is part of the libLTE library.
+ *
+ * libLTE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libLTE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * A copy of the GNU Lesser General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <sys/time.h>
+
+#include "liblte/phy/phy.h"
+
+uint32_t len = 0;
+int nof_seeds = 100;
+
+void usage(char *prog) {
+  printf("Usage: %s\n", prog);
+  printf("\t-l sequence length [Default several]\n");
+  printf("\t-n number of random seeds [Default %d]\n", nof_seeds);
+}
+
+void parse_args(int argc, char **argv) {
+  int opt;
+  while ((opt = getopt(argc, argv, "ln")) != -1) {
+    switch (opt) {
+    case 'l':
+      len = atoi(argv[optind]);
+      break;
+    case 'n':
+      nof_seeds = atoi(argv[optind]);
+      break;
+    default:
+      usage(argv[0]);
+      exit(-1);
+    }
+  }
+}
+
+/* Bit-serial generator following 36.211 Section 7.2 */
+void sequence_reference(char *c, uint32_t len, uint32_t seed) {
+  uint32_t n;
+  char *x1 = calloc(1600 + len + 31, sizeof(char));
+  char *x2 = calloc(1600 + len + 31, sizeof(char));
+  if (!x1 || !x2) {
+    perror("calloc");
+    exit(-1);
+  }
+  for (n = 0; n < 31; n++) {
+    x2[n] = (seed >> n) & 0x1;
+  }
+  x1[0] = 1;
+  for (n = 0; n < 1600 + len; n++) {
+    x1[n + 31] = (x1[n + 3] + x1[n]) & 0x1;
+    x2[n + 31] = (x2[n + 3] + x2[n + 2] + x2[n + 1] + x2[n]) & 0x1;
+  }
+  for (n = 0; n < len; n++) {
+    c[n] = (x1[n + 1600] + x2[n + 1600]) & 0x1;
+  }
+  free(x1);
+  free(x2);
+}
+
+int test_sequence(uint32_t seq_len, uint32_t seed) {
+  sequence_t seq;
+  uint32_t i;
+  char *ref = malloc(sizeof(char) * seq_len);
+  uint8_t *packed = calloc((seq_len + 7) / 8, sizeof(uint8_t));
+  if (!ref || !packed) {
+    perror("malloc");
+    exit(-1);
+  }
+
+  bzero(&seq, sizeof(sequence_t));
+  if (sequence_LTEPRS(&seq, seq_len, seed)) {
+    fprintf(stderr, "Error generating sequence\n");
+    exit(-1);
+  }
+  sequence_reference(ref, seq_len, seed);
+  bit_pack_vector(ref, packed, seq_len);
+
+  for (i = 0; i < seq_len; i++) {
+    if (seq.c[i] != ref[i]) {
+      printf("Error in bit %d, len %d, seed 0x%x\n", i, seq_len, seed);
+      return -1;
+    }
+  }
+  if (memcmp(seq.c_packed, packed, (seq_len + 7) / 8)) {
+    printf("Error in packed sequence, len %d, seed 0x%x\n", seq_len, seed);
+    return -1;
+  }
+  for (i = 0; i < SEQUENCE_PACKED_PAD; i++) {
+    if (seq.c_packed[(seq_len + 7) / 8 + i]) {
+      printf("Error in padding, len %d, seed 0x%x\n", seq_len, seed);
+      return -1;
+    }
+  }
+  sequence_free(&seq);
+  free(ref);
+  free(packed);
+  return 0;
+}
+
+/* Sequences referenced from the cache stay valid while other ones are requested */
+int test_cache() {
+  sequence_cache_t cache;
+  sequence_t *s1, *s2, *s3;
+  char *ref = malloc(sizeof(char) * 2 * 1920);
+  int ret = -1;
+  if (!ref) {
+    perror("malloc");
+    exit(-1);
+  }
+  if (sequence_cache_init(&cache, 1)) {
+    fprintf(stderr, "Error initiating sequence cache\n");
+    exit(-1);
+  }
+  
+  s1 = sequence_cache_get(&cache, 1234, 1920);
+  /* all entries in use, and a longer version of the one in use */
+  s2 = sequence_cache_get(&cache, 5678, 1920);
+  s3 = sequence_cache_get(&cache, 1234, 2 * 1920);
+  if (!s1 || !s2 || !s3 || s1 == s2 || s1 == s3) {
+    printf("Error sequences in use were shared or evicted\n");
+    goto clean;
+  }
+  sequence_reference(ref, 2 * 1920, 1234);
+  if (memcmp(s1->c, ref, 1920) || memcmp(s3->c, ref, 2 * 1920)) {
+    printf("Error in cached sequence 0x%x\n", 1234);
+    goto clean;
+  }
+  sequence_reference(ref, 1920, 5678);
+  if (memcmp(s2->c, ref, 1920)) {
+    printf("Error in private sequence 0x%x\n", 5678);
+    goto clean;
+  }
+  sequence_cache_put(&cache, s3);
+  sequence_cache_put(&cache, s2);
+  sequence_cache_put(&cache, s1);
+  
+  /* once released the entry is reused */
+  s2 = sequence_cache_get(&cache, 5678, 1920);
+  if (s2 != &cache.entries[0].seq || memcmp(s2->c, ref, 1920)) {
+    printf("Error free cache entry was not reused\n");
+    goto clean;
+  }
+  sequence_cache_put(&cache, s2);
+  ret = 0;
+clean:
+  sequence_cache_free(&cache);
+  free(ref);
+  return ret;
+}
+
+int main(int argc, char **argv) {
+  uint32_t lengths[] = {1, 12, 27, 28, 29, 32, 1728, 1920, 6001, LTE_NSOFT_BITS};
+  uint32_t nof_lengths = sizeof(lengths) / sizeof(uint32_t);
+  uint32_t i;
+  int j;
+  sequence_t seq;
+  struct timeval t[3];
+
+  parse_args(argc, argv);
+
+  if (len) {
+    lengths[0] = len;
+    nof_lengths = 1;
+  }
+
+  for (i = 0; i < nof_lengths; i++) {
+    if (test_sequence(lengths[i], 0) || test_sequence(lengths[i], 0x7fffffff)) {
+      exit(-1);
+    }
+    for (j = 0; j < nof_seeds; j++) {
+      if (test_sequence(lengths[i], rand() & 0x7fffffff)) {
+        exit(-1);
+      }
+    }
+  }
+
+  if (test_cache()) {
+    exit(-1);
+  }
+
+  bzero(&seq, sizeof(sequence_t));
+  gettimeofday(&t[1], NULL);
+  for (i = 0; i < NSUBFRAMES_X_FRAME; i++) {
+    sequence_pdsch(&seq, 1234, 0, 2 * i, 1, LTE_NSOFT_BITS);
+    sequence_free(&seq);
+  }
+  gettimeofday(&t[2], NULL);
+  get_time_interval(t);
+  printf("PDSCH sequences for %d subframes generated in %.1f us\n", NSUBFRAMES_X_FRAME, 
+      (float) t[0].tv_sec * 1e6 + t[0].tv_usec);
+
+  printf("Ok\n");
+  exit(0);
+}
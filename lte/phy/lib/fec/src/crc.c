@@ -29,49 +29,70 @@
 #include <stdlib.h>
 #include <string.h>
 
+#ifdef LV_HAVE_PCLMUL
+#include <smmintrin.h>
+#include <wmmintrin.h>
+#endif
+
 #include "liblte/phy/utils/pack.h"
+#include "liblte/phy/utils/bit.h"
 #include "liblte/phy/fec/crc.h"
 
-void gen_crc_table(crc_t *h) {
+/* Bits packed before calling the packed engines in crc_checksum() */
+#define CRC_PACK_CHUNK 64
+
+/* Shortest input, in bytes, passed to the carry-less multiplication engine */
+#define CRC_CLMUL_MIN_BYTES 128
+
+void gen_crc_table_s8(crc_t *h) {
 
-  int i, j, ord = (h->order - 8);
-  unsigned long bit, crc;
+  int i, j, k;
+  uint32_t crc;
 
+  h->poly_s8 = (uint32_t) (((unsigned long) h->polynom) << (32 - h->order));
   for (i = 0; i < 256; i++) {
-    crc = ((unsigned long) i) << ord;
+    crc = ((uint32_t) i) << 24;
     for (j = 0; j < 8; j++) {
-      bit = crc & h->crchighbit;
-      crc <<= 1;
-      if (bit)
-        crc ^= h->polynom;
+      if (crc & 0x80000000) {
+        crc = (crc << 1) ^ h->poly_s8;
+      } else {
+        crc <<= 1;
+      }
+    }
+    h->table_s8[0][i] = crc;
+  }
+  for (k = 1; k < 8; k++) {
+    for (i = 0; i < 256; i++) {
+      crc = h->table_s8[k - 1][i];
+      h->table_s8[k][i] = (crc << 8) ^ h->table_s8[0][crc >> 24];
     }
-    h->table[i] = crc & h->crcmask;
   }
 }
 
-unsigned long crctable(crc_t *h) {
+/* x^n mod P, where P = x^32 + poly_s8 is the polynomial aligned to 32 bits */
+static uint32_t xpow_mod(crc_t *h, uint32_t n) {
+  uint32_t r = 0x80000000;  /* x^31 */
+  uint32_t i;
 
-  // Polynom order 8, 16, 24 or 32 only.
-  int ord = h->order - 8;
-  unsigned long crc = h->crcinit;
-  unsigned char byte = h->byte;
-
-  crc = (crc << 8) ^ h->table[((crc >> (ord)) & 0xff) ^ byte];
-  h->crcinit = crc;
-  return (crc  & h->crcmask);
+  if (n < 32) {
+    return 1 << n;
+  }
+  for (i = 31; i < n; i++) {
+    if (r & 0x80000000) {
+      r = (r << 1) ^ h->poly_s8;
+    } else {
+      r <<= 1;
+    }
+  }
+  return r;
 }
 
-unsigned long reversecrcbit(unsigned int crc, int nbits, crc_t *h) {
-
-  unsigned long m, rmask = 0x1;
-
-  for (m = 0; m < nbits; m++) {
-    if ((rmask & crc) == 0x01)
-      crc = (crc ^ h->polynom) >> 1;
-    else
-      crc = crc >> 1;
-  }
-  return (crc & h->crcmask);
+/* Folding constants x^(D+64) mod P and x^D mod P for a distance of D bits */
+static void gen_fold_constants(crc_t *h) {
+  h->fold_k[0][0] = xpow_mod(h, 128 + 64);
+  h->fold_k[0][1] = xpow_mod(h, 128);
+  h->fold_k[1][0] = xpow_mod(h, 512 + 64);
+  h->fold_k[1][1] = xpow_mod(h, 512);
 }
 
 int crc_set_init(crc_t *crc_par, unsigned long crc_init_value) {
@@ -108,48 +129,166 @@ int crc_init(crc_t *h, unsigned int crc_poly, int crc_order) {
     return -1;
   }
 
-  // generate lookup table
-  gen_crc_table(h);
+  // generate lookup tables
+  gen_crc_table_s8(h);
+  gen_fold_constants(h);
+
+  // use the fastest engine the CPU supports
+  h->engine = CRC_ENGINE_SLICE8;
+  crc_set_engine(h, CRC_ENGINE_CLMUL);
+  crc_reset(h);
 
   return 0;
 }
 
-uint32_t crc_checksum(crc_t *h, char *data, int len) {
-  int i, k, len8, res8, a = 0;
-  unsigned int crc = 0;
-  char *pter;
-
-  crc_set_init(h, 0);
-
-  // Pack bits into bytes
-  len8 = (len >> 3);
-  res8 = (len - (len8 << 3));
-  if (res8 > 0) {
-    a = 1;
-  }
-
-  // Calculate CRC
-  for (i = 0; i < len8 + a; i++) {
-    pter = (char *) (data + 8 * i);
-    if (i == len8) {
-      h->byte = 0x00;
-      for (k = 0; k < res8; k++) {
-        h->byte |= ((unsigned char) *(pter + k)) << (7 - k);
-      }
-    } else {
-      h->byte = (unsigned char) (unpack_bits(&pter, 8) & 0xFF);
+int crc_set_engine(crc_t *h, crc_engine_t engine) {
+  switch (engine) {
+  case CRC_ENGINE_SLICE8:
+    h->engine = engine;
+    return 0;
+  case CRC_ENGINE_CLMUL:
+#ifdef LV_HAVE_PCLMUL
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("pclmul") && __builtin_cpu_supports("ssse3")) {
+      h->engine = engine;
+      return 0;
     }
-    crc = crctable(h);
+#endif
+    return -1;
+  default:
+    return -1;
   }
+}
+
+/* Slice-by-8 CRC: 8 bytes are processed per step with 8 table lookups. The CRC 
+ * register is aligned to the MSB of 32 bits. 
+ */
+static uint32_t crc_update_s8(crc_t *h, uint32_t crc, uint8_t *data, int nbytes) {
+  int i;
+  uint32_t w1, w2;
+  uint32_t (*t)[256] = h->table_s8;
 
-  // Reverse CRC res8 positions
-  if (a == 1) {
-    crc = reversecrcbit(crc, 8 - res8, h);
+  for (i = 0; i + 8 <= nbytes; i += 8) {
+    w1 = crc ^ (((uint32_t) data[i] << 24) | ((uint32_t) data[i + 1] << 16) | 
+                ((uint32_t) data[i + 2] << 8) | data[i + 3]);
+    w2 = ((uint32_t) data[i + 4] << 24) | ((uint32_t) data[i + 5] << 16) | 
+         ((uint32_t) data[i + 6] << 8) | data[i + 7];
+    crc = t[7][w1 >> 24] ^ t[6][(w1 >> 16) & 0xff] ^ 
+          t[5][(w1 >> 8) & 0xff] ^ t[4][w1 & 0xff] ^ 
+          t[3][w2 >> 24] ^ t[2][(w2 >> 16) & 0xff] ^ 
+          t[1][(w2 >> 8) & 0xff] ^ t[0][w2 & 0xff];
+  }
+  for (; i < nbytes; i++) {
+    crc = (crc << 8) ^ t[0][(crc >> 24) ^ data[i]];
   }
+  return crc;
+}
+
+#ifdef LV_HAVE_PCLMUL
+
+/* The library is not built with -mpclmul, these functions are only called once 
+ * crc_set_engine() has checked the CPU */
+#define CLMUL_TARGET __attribute__((target("pclmul,ssse3")))
+
+/* Multiplies the 128-bit remainder x by x^D mod P, with k = (x^(D+64), x^D) mod P */
+CLMUL_TARGET static inline __m128i clmul_fold(__m128i x, __m128i k) {
+  return _mm_xor_si128(_mm_clmulepi64_si128(x, k, 0x11), _mm_clmulepi64_si128(x, k, 0x00));
+}
+
+/* Carry-less multiplication folding for generic (non-reflected) polynomials. The 
+ * input is loaded in 128-bit blocks with the first bit as the highest degree, and 
+ * 4 blocks at a time are folded 512 bits ahead into 4 independent remainders. 
+ * These are then folded into a single block which is congruent with the data 
+ * consumed, so its CRC through the tables is the CRC register after that data. 
+ * 
+ * Returns the number of bytes consumed, a multiple of 64. 
+ */
+CLMUL_TARGET static int crc_update_clmul(crc_t *h, uint32_t *crc, uint8_t *data, int nbytes) {
+  const __m128i bswap = _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+  __m128i k1 = _mm_set_epi32(0, h->fold_k[0][0], 0, h->fold_k[0][1]);
+  __m128i k4 = _mm_set_epi32(0, h->fold_k[1][0], 0, h->fold_k[1][1]);
+  __m128i x[4], y;
+  uint8_t block[16];
+  int i, j;
 
-  //Return CRC value
+  for (j = 0; j < 4; j++) {
+    x[j] = _mm_shuffle_epi8(_mm_loadu_si128((__m128i*) &data[16 * j]), bswap);
+  }
+  x[0] = _mm_xor_si128(x[0], _mm_set_epi32((int) *crc, 0, 0, 0));
+
+  for (i = 64; i + 64 <= nbytes; i += 64) {
+    for (j = 0; j < 4; j++) {
+      y = _mm_shuffle_epi8(_mm_loadu_si128((__m128i*) &data[i + 16 * j]), bswap);
+      x[j] = _mm_xor_si128(clmul_fold(x[j], k4), y);
+    }
+  }
+
+  y = x[0];
+  for (j = 1; j < 4; j++) {
+    y = _mm_xor_si128(clmul_fold(y, k1), x[j]);
+  }
+  _mm_storeu_si128((__m128i*) block, _mm_shuffle_epi8(y, bswap));
+  *crc = crc_update_s8(h, 0, block, 16);
+  return i;
+}
+
+#endif
+
+/* Returns the CRC register after len bits packed MSB first. The trailing bits 
+ * that do not fill a byte are shifted in one by one. 
+ */
+static uint32_t crc_update(crc_t *h, uint32_t crc, uint8_t *data, int len) {
+  int j, i = 0;
+  int nbytes = len / 8;
+
+#ifdef LV_HAVE_PCLMUL
+  if (h->engine == CRC_ENGINE_CLMUL && nbytes >= CRC_CLMUL_MIN_BYTES) {
+    i = crc_update_clmul(h, &crc, data, nbytes);
+  }
+#endif
+  crc = crc_update_s8(h, crc, &data[i], nbytes - i);
+  for (j = 0; j < len % 8; j++) {
+    crc ^= ((uint32_t) (data[nbytes] >> (7 - j)) & 0x1) << 31;
+    if (crc & 0x80000000) {
+      crc = (crc << 1) ^ h->poly_s8;
+    } else {
+      crc <<= 1;
+    }
+  }
   return crc;
+}
+
+void crc_reset(crc_t *h) {
+  h->state = 0;
+}
+
+/* Only the last call before crc_value() may have len % 8 != 0 */
+void crc_update_packed(crc_t *h, uint8_t *data, int len) {
+  h->state = crc_update(h, h->state, data, len);
+}
+
+uint32_t crc_value(crc_t *h) {
+  return h->state >> (32 - h->order);
+}
+
+/* The bits are packed CRC_PACK_CHUNK bytes at a time and passed to the packed engines */
+uint32_t crc_checksum(crc_t *h, char *data, int len) {
+  uint8_t packed[CRC_PACK_CHUNK];
+  uint32_t crc = 0;
+  int n;
+
+  while (len > 0) {
+    n = len < 8 * CRC_PACK_CHUNK ? len : 8 * CRC_PACK_CHUNK;
+    bit_pack_vector(data, packed, n);
+    crc = crc_update(h, crc, packed, n);
+    data += n;
+    len -= n;
+  }
+  return crc >> (32 - h->order);
+}
 
+uint32_t crc_checksum_packed(crc_t *h, uint8_t *data, int len) {
+  return crc_update(h, 0, data, len) >> (32 - h->order);
 }
 
 /** Appends crc_order checksum bits to the buffer data.
@@ -163,3 +302,16 @@ void crc_attach(crc_t *h, char *data, int len) {
   pack_bits(checksum, &ptr, h->order);
 }
 
+/** Appends crc_order checksum bits after the first len bits of data. 
+ * The buffer data must hold len + crc_order bits
+ */
+void crc_attach_packed(crc_t *h, uint8_t *data, int len) {
+  uint32_t checksum = crc_checksum_packed(h, data, len);
+  uint8_t ck[4];
+  int i;
+
+  for (i = 0; i < h->order / 8; i++) {
+    ck[i] = (uint8_t) (checksum >> (h->order - 8 * (i + 1)));
+  }
+  bit_copy(data, len, ck, 0, h->order);
+}
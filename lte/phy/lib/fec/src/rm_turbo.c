@@ -26,11 +26,13 @@
  */
 
 #include <string.h>
+#include <strings.h>
 #include <stdio.h>
 #include <math.h>
 #include <stdbool.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <pthread.h>
 
 #include "liblte/phy/fec/rm_turbo.h"
 
@@ -41,6 +43,266 @@ uint8_t RM_PERM_TC[NCOLS] = { 0, 16, 8, 24, 4, 20, 12, 28, 2, 18, 10, 26,
     6, 22, 14, 30, 1, 17, 9, 25, 5, 21, 13, 29, 3, 19, 11, 27, 7, 23, 15, 31 };
 
 
+/* Rate matching plans.
+ *
+ * For a given number of coded bits, output length E and redundancy version the
+ * rate matcher is a fixed permutation, so the index maps are computed once and
+ * shared by all callers (and all pdsch_t instances). deint[i] is the position in
+ * the circular buffer of coded bit i and sel[k] the position of the k-th
+ * transmitted bit, with the dummy bits already skipped.
+ *
+ * With soft buffer limitation (N_cb < 3*K_p) the coded bits beyond the first N_cb
+ * positions are never transmitted. Their deint entries point to an extra position
+ * N_cb, which the receiver keeps at zero, so the circular buffer has w_len = N_cb+1
+ * elements and no branches are needed to skip them.
+ *
+ * The cache holds at most RM_PLAN_MAX_ENTRIES plans and RM_PLAN_MAX_BYTES of
+ * index maps. When it is full, the least recently used plan which is not being
+ * applied is evicted. If every plan is in use, a private plan is built for the
+ * call and released afterwards.
+ */
+#define RM_PLAN_MAX_ENTRIES 64
+#define RM_PLAN_MAX_BYTES   (2*1024*1024)
+
+typedef struct {
+  uint32_t nof_coded;   /* in_len/3 */
+  uint32_t E;
+  uint32_t rv_idx;
+  uint32_t N_cb;
+  uint32_t w_len;
+  uint32_t refs;
+  uint64_t last_use;
+  uint32_t size;
+  uint16_t *deint;
+  uint16_t *sel;
+} rm_plan_t;
+
+static rm_plan_t *plan_cache[RM_PLAN_MAX_ENTRIES];
+static uint32_t plan_cache_bytes = 0;
+static uint64_t plan_cache_clock = 0;
+static pthread_mutex_t plan_cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/* Sub-block interleaver (5.1.4.1.1), bit collection and bit selection (5.1.4.1.2) */
+static rm_plan_t *plan_gen(uint32_t nof_coded, uint32_t E, uint32_t rv_idx, uint32_t N_cb) {
+  int i, j, k, s, kidx;
+  int nrows, K_p, ndummy, k0, nof_valid;
+  int32_t *w2in;
+  rm_plan_t *plan;
+  uint32_t size;
+
+  nrows = (nof_coded - 1) / NCOLS + 1;
+  K_p = nrows * NCOLS;
+  ndummy = K_p - nof_coded;
+
+  size = sizeof(rm_plan_t) + sizeof(uint16_t) * (3 * nof_coded + E);
+  plan = malloc(size);
+  if (!plan) {
+    perror("malloc");
+    return NULL;
+  }
+  w2in = malloc(sizeof(int32_t) * 3 * K_p);
+  if (!w2in) {
+    perror("malloc");
+    free(plan);
+    return NULL;
+  }
+  plan->nof_coded = nof_coded;
+  plan->E = E;
+  plan->rv_idx = rv_idx;
+  plan->N_cb = N_cb;
+  plan->w_len = N_cb < 3 * K_p ? N_cb + 1 : N_cb;
+  plan->refs = 0;
+  plan->last_use = 0;
+  plan->size = size;
+  plan->deint = (uint16_t*) &plan[1];
+  plan->sel = &plan->deint[3 * nof_coded];
+
+  /* Coded bit carried by each position of the circular buffer, -1 for dummy bits */
+  k = 0;
+  for (s = 0; s < 2; s++) {
+    for (j = 0; j < NCOLS; j++) {
+      for (i = 0; i < nrows; i++) {
+        if (s == 0) {
+          kidx = k % K_p;
+        } else {
+          kidx = K_p + 2 * (k % K_p);
+        }
+        if (i * NCOLS + RM_PERM_TC[j] < ndummy) {
+          w2in[kidx] = -1;
+        } else {
+          w2in[kidx] = (i * NCOLS + RM_PERM_TC[j] - ndummy) * 3 + s;
+        }
+        k++;
+      }
+    }
+  }
+  // d_k^(2) goes through special permutation
+  for (k = 0; k < K_p; k++) {
+    kidx = (RM_PERM_TC[k / nrows] + NCOLS * (k % nrows) + 1) % K_p;
+    if ((kidx - ndummy) < 0) {
+      w2in[K_p + 2 * k + 1] = -1;
+    } else {
+      w2in[K_p + 2 * k + 1] = 3 * (kidx - ndummy) + 2;
+    }
+  }
+
+  nof_valid = 0;
+  for (i = 0; i < 3 * K_p; i++) {
+    if (w2in[i] >= 0) {
+      plan->deint[w2in[i]] = (uint16_t) (i < N_cb ? i : N_cb);
+      if (i < N_cb) {
+        nof_valid++;
+      }
+    }
+  }
+  if (!nof_valid && E) {
+    fprintf(stderr, "Soft buffer size N_cb=%d holds no coded bits\n", N_cb);
+    free(w2in);
+    free(plan);
+    return NULL;
+  }
+
+  k0 = nrows * (2 * ((N_cb + 8 * nrows - 1) / (8 * nrows)) * rv_idx + 2);
+  k = 0;
+  j = k0 % N_cb;
+  while (k < E) {
+    if (w2in[j] >= 0) {
+      plan->sel[k++] = (uint16_t) j;
+    }
+    if (++j == N_cb) {
+      j = 0;
+    }
+  }
+
+  free(w2in);
+  return plan;
+}
+
+/* Looks up a cached plan. Called with the mutex locked */
+static rm_plan_t *plan_find(uint32_t nof_coded, uint32_t E, uint32_t rv_idx, uint32_t N_cb) {
+  int i;
+  rm_plan_t *plan;
+  for (i = 0; i < RM_PLAN_MAX_ENTRIES; i++) {
+    plan = plan_cache[i];
+    if (plan && plan->nof_coded == nof_coded && plan->E == E && plan->rv_idx == rv_idx
+        && plan->N_cb == N_cb) {
+      plan->refs++;
+      plan->last_use = ++plan_cache_clock;
+      return plan;
+    }
+  }
+  return NULL;
+}
+
+/* Returns the plan for (nof_coded, E, rv_idx, N_cb) with its reference count increased */
+static rm_plan_t *plan_get(uint32_t nof_coded, uint32_t E, uint32_t rv_idx, uint32_t N_cb) {
+  int i, free_idx, lru_idx;
+  rm_plan_t *plan, *cached;
+
+  pthread_mutex_lock(&plan_cache_mutex);
+  plan = plan_find(nof_coded, E, rv_idx, N_cb);
+  pthread_mutex_unlock(&plan_cache_mutex);
+  if (plan) {
+    return plan;
+  }
+
+  plan = plan_gen(nof_coded, E, rv_idx, N_cb);
+  if (!plan) {
+    return NULL;
+  }
+  plan->refs = 1;
+
+  pthread_mutex_lock(&plan_cache_mutex);
+  /* Another thread may have built the same plan in the meantime */
+  cached = plan_find(nof_coded, E, rv_idx, N_cb);
+  if (cached) {
+    free(plan);
+    plan = cached;
+  } else if (plan->size <= RM_PLAN_MAX_BYTES) {
+    /* Evict unused plans, oldest first, until the new one fits */
+    do {
+      free_idx = -1;
+      lru_idx = -1;
+      for (i = 0; i < RM_PLAN_MAX_ENTRIES; i++) {
+        if (!plan_cache[i]) {
+          if (free_idx < 0) {
+            free_idx = i;
+          }
+        } else if (!plan_cache[i]->refs
+            && (lru_idx < 0 || plan_cache[i]->last_use < plan_cache[lru_idx]->last_use)) {
+          lru_idx = i;
+        }
+      }
+      if (free_idx >= 0 && plan_cache_bytes + plan->size <= RM_PLAN_MAX_BYTES) {
+        plan->last_use = ++plan_cache_clock;
+        plan_cache[free_idx] = plan;
+        plan_cache_bytes += plan->size;
+        break;
+      }
+      if (lru_idx >= 0) {
+        plan_cache_bytes -= plan_cache[lru_idx]->size;
+        free(plan_cache[lru_idx]);
+        plan_cache[lru_idx] = NULL;
+      }
+    } while (lru_idx >= 0);
+  }
+  pthread_mutex_unlock(&plan_cache_mutex);
+  return plan;
+}
+
+static void plan_put(rm_plan_t *plan) {
+  pthread_mutex_lock(&plan_cache_mutex);
+  plan->refs--;
+  /* Plans which did not fit in the cache are private to the caller */
+  if (!plan->last_use) {
+    free(plan);
+  }
+  pthread_mutex_unlock(&plan_cache_mutex);
+}
+
+/* Soft buffer size N_cb for a code block of coded_len bits. N_cb=0 or larger than
+ * the circular buffer means no limitation. Returns 0 if coded_len is invalid.
+ */
+static uint32_t rm_ncb(uint32_t coded_len, uint32_t N_cb) {
+  uint32_t K_w;
+  if (coded_len < 3) {
+    return 0;
+  }
+  K_w = 3 * NCOLS * ((coded_len / 3 - 1) / NCOLS + 1);
+  if (N_cb == 0 || N_cb > K_w) {
+    N_cb = K_w;
+  }
+  return N_cb;
+}
+
+uint32_t rm_turbo_buff_len(uint32_t coded_len, uint32_t N_cb) {
+  uint32_t K_w = rm_ncb(coded_len, 0);
+  N_cb = rm_ncb(coded_len, N_cb);
+  return N_cb < K_w ? N_cb + 1 : N_cb;
+}
+
+/* Returns the plan to rate match coded_len bits into E bits, or NULL on error */
+static rm_plan_t *plan_check_get(uint32_t coded_len, uint32_t w_buff_len, uint32_t E,
+    uint32_t rv_idx, uint32_t N_cb) {
+  uint32_t w_len = rm_turbo_buff_len(coded_len, N_cb);
+  if (coded_len < 3) {
+    fprintf(stderr, "Invalid number of coded bits %d\n", coded_len);
+    return NULL;
+  }
+  if (w_len > w_buff_len || rm_ncb(coded_len, 0) > UINT16_MAX + 1) {
+    fprintf(stderr,
+        "Input too large. Circular buffer needs %d elements (in_len %d, N_cb %d) and has %d\n",
+        w_len, coded_len, N_cb, w_buff_len);
+    return NULL;
+  }
+  return plan_get(coded_len / 3, E, rv_idx, rm_ncb(coded_len, N_cb));
+}
+
+int rm_turbo_tx(char *w_buff, uint32_t w_buff_len, char *input, uint32_t in_len, char *output,
+    uint32_t out_len, uint32_t rv_idx) {
+  return rm_turbo_tx_lim(w_buff, w_buff_len, input, in_len, output, out_len, rv_idx, 0);
+}
+
 /* Turbo Code Rate Matching.
  * 3GPP TS 36.212 v10.1.0 section 5.1.4.1
  *
@@ -50,180 +312,240 @@ uint8_t RM_PERM_TC[NCOLS] = { 0, 16, 8, 24, 4, 20, 12, 28, 2, 18, 10, 26,
  * 
  * Note that calling this function with rv_idx!=0 without having called it first with rv_idx=0
  * will produce unwanted results. 
- * 
- * TODO: Soft buffer size limitation according to UE category
  */
-int rm_turbo_tx(char *w_buff, uint32_t w_buff_len, char *input, uint32_t in_len, char *output,
-    uint32_t out_len, uint32_t rv_idx) {
-
-  int ndummy, kidx; 
-  int nrows, K_p;
+int rm_turbo_tx_lim(char *w_buff, uint32_t w_buff_len, char *input, uint32_t in_len, char *output,
+    uint32_t out_len, uint32_t rv_idx, uint32_t N_cb) {
+  uint32_t i, k;
+  rm_plan_t *plan;
 
-  int i, j, k, s, N_cb, k0;
-
-  nrows = (uint32_t) (in_len / 3 - 1) / NCOLS + 1;
-  K_p = nrows * NCOLS;
-  if (3 * K_p > w_buff_len) {
-    fprintf(stderr,
-        "Input too large. Max input length including dummy bits is %d (3x%dx32, in_len %d)\n",
-        w_buff_len, nrows, in_len);
+  plan = plan_check_get(in_len, w_buff_len, out_len, rv_idx, N_cb);
+  if (!plan) {
     return -1;
   }
 
-  ndummy = K_p - in_len / 3;
-  if (ndummy < 0) {
-    ndummy = 0;
-  }
-
   if (rv_idx == 0) {
-    /* Sub-block interleaver (5.1.4.1.1) and bit collection */
-    k = 0;
-    for (s = 0; s < 2; s++) {
-      for (j = 0; j < NCOLS; j++) {
-        for (i = 0; i < nrows; i++) {
-          if (s == 0) {
-            kidx = k % K_p;
-          } else {
-            kidx = K_p + 2 * (k % K_p);
-          }
-          if (i * NCOLS + RM_PERM_TC[j] < ndummy) {
-            w_buff[kidx] = TX_NULL;
-          } else {
-            w_buff[kidx] = input[(i * NCOLS + RM_PERM_TC[j] - ndummy) * 3 + s];
-          }
-          k++;
-        }
-      }
-    }
-
-    // d_k^(2) goes through special permutation
-    for (k = 0; k < K_p; k++) {
-      kidx = (RM_PERM_TC[k / nrows] + NCOLS * (k % nrows) + 1) % K_p;
-      if ((kidx - ndummy) < 0) {
-        w_buff[K_p + 2 * k + 1] = TX_NULL;
-      } else {
-        w_buff[K_p + 2 * k + 1] = input[3 * (kidx - ndummy) + 2];
-      }
+    memset(w_buff, TX_NULL, plan->w_len);
+    for (i = 0; i < 3 * plan->nof_coded; i++) {
+      w_buff[plan->deint[i]] = input[i];
     }
   }
+  for (k = 0; k < out_len; k++) {
+    output[k] = w_buff[plan->sel[k]];
+  }
 
-  /* Bit selection and transmission 5.1.4.1.2 */
-  N_cb = 3 * K_p;       // TODO: Soft buffer size limitation
+  plan_put(plan);
+  return 0;
+}
 
-  k0 = nrows
-      * (2 * (uint32_t) ceilf((float) N_cb / (float) (8 * nrows)) * rv_idx + 2);
-  k = 0;
-  j = 0;
+int rm_turbo_tx_packed(char *w_buff, uint32_t w_buff_len, uint8_t *input, uint32_t in_len, 
+    uint8_t *output, uint32_t out_len, uint32_t rv_idx, uint32_t N_cb) {
+  uint32_t i, j, k;
+  uint8_t byte;
+  rm_plan_t *plan;
 
-  while (k < out_len) {
-    if (w_buff[(k0 + j) % N_cb] != TX_NULL) {
-      output[k] = w_buff[(k0 + j) % N_cb];
-      k++;
+  plan = plan_check_get(in_len, w_buff_len, out_len, rv_idx, N_cb);
+  if (!plan) {
+    return -1;
+  }
+
+  if (rv_idx == 0) {
+    memset(w_buff, TX_NULL, plan->w_len);
+    for (i = 0; i < 3 * plan->nof_coded; i++) {
+      w_buff[plan->deint[i]] = (input[i / 8] >> (7 - i % 8)) & 0x1;
     }
-    j++;
   }
+  for (k = 0; k < out_len / 8; k++) {
+    byte = 0;
+    for (j = 0; j < 8; j++) {
+      byte = (byte << 1) | w_buff[plan->sel[8 * k + j]];
+    }
+    output[k] = byte;
+  }
+  if (out_len % 8) {
+    byte = 0;
+    for (j = 0; j < out_len % 8; j++) {
+      byte |= w_buff[plan->sel[8 * k + j]] << (7 - j);
+    }
+    output[k] = byte;
+  }
+
+  plan_put(plan);
   return 0;
 }
 
+int rm_turbo_rx(float *w_buff, uint32_t w_buff_len, float *input, uint32_t in_len, float *output,
+    uint32_t out_len, uint32_t rv_idx) {
+  return rm_turbo_rx_lim(w_buff, w_buff_len, input, in_len, output, out_len, rv_idx, 0);
+}
+
 /* Undoes Turbo Code Rate Matching.
  * 3GPP TS 36.212 v10.1.0 section 5.1.4.1
  * 
  * If rv_idx==0, the w_buff circular buffer is initialized. Every subsequent call 
- * with rv_idx!=0 will soft-combine the LLRs from input with w_buff
+ * with rv_idx!=0 will soft-combine the LLRs from input with w_buff. Positions 
+ * never received, including the dummy bits, hold a zero LLR. 
  */
-int rm_turbo_rx(float *w_buff, uint32_t w_buff_len, float *input, uint32_t in_len, float *output,
-    uint32_t out_len, uint32_t rv_idx) {
+int rm_turbo_rx_lim(float *w_buff, uint32_t w_buff_len, float *input, uint32_t in_len, 
+    float *output, uint32_t out_len, uint32_t rv_idx, uint32_t N_cb) {
+  uint32_t i, k;
+  rm_plan_t *plan;
 
-  int nrows, ndummy, K_p, k0, N_cb, jp, kidx;
-  int i, j, k;
-  int d_i, d_j;
-  bool isdummy;
+  plan = plan_check_get(out_len, w_buff_len, in_len, rv_idx, N_cb);
+  if (!plan) {
+    return -1;
+  }
 
-  nrows = (uint32_t) (out_len / 3 - 1) / NCOLS + 1;
-  K_p = nrows * NCOLS;
-  if (3 * K_p > w_buff_len) {
-    fprintf(stderr,
-        "Input too large. Max output length including dummy bits is %d (3x%dx32, in_len %d)\n",
-        w_buff_len, nrows, out_len);
+  if (rv_idx == 0) {
+    bzero(w_buff, sizeof(float) * plan->w_len);
+  }
+  /* soft combine LLRs */
+  for (k = 0; k < in_len; k++) {
+    w_buff[plan->sel[k]] += input[k];
+  }
+  for (i = 0; i < 3 * plan->nof_coded; i++) {
+    output[i] = w_buff[plan->deint[i]];
+  }
+
+  plan_put(plan);
+  return 0;
+}
+
+/* Mean absolute LLR mapped to the integer soft buffers. It leaves room to combine 
+ * several retransmissions before saturating. 
+ */
+#define RM_SOFT_MEAN_S 1024.0
+#define RM_SOFT_MEAN_B 16.0
+
+static float rm_soft_scale(float *input, uint32_t in_len, float mean_q) {
+  uint32_t k;
+  float mean = 0;
+  for (k = 0; k < in_len; k++) {
+    mean += fabsf(input[k]);
+  }
+  if (mean == 0) {
+    return 1.0;
+  }
+  return mean_q * in_len / mean;
+}
+
+/* As rm_turbo_rx_lim() but with a circular buffer of saturated 16-bit LLRs. When 
+ * rv_idx==0, or *scale is 0 because nothing was stored yet, the buffer is cleared 
+ * and the scale of the stored LLRs is chosen from input and saved in *scale, 
+ * which retransmissions of the same code block must pass back. 
+ */
+int rm_turbo_rx_s(int16_t *w_buff, uint32_t w_buff_len, float *input, uint32_t in_len, 
+    float *output, uint32_t out_len, uint32_t rv_idx, uint32_t N_cb, float *scale) {
+  uint32_t i, k;
+  float v, inv;
+  rm_plan_t *plan;
+
+  plan = plan_check_get(out_len, w_buff_len, in_len, rv_idx, N_cb);
+  if (!plan) {
+    return -1;
+  }
+
+  if (rv_idx == 0 || *scale == 0) {
+    bzero(w_buff, sizeof(int16_t) * plan->w_len);
+    *scale = rm_soft_scale(input, in_len, RM_SOFT_MEAN_S);
+  }
+  for (k = 0; k < in_len; k++) {
+    v = w_buff[plan->sel[k]] + input[k] * *scale;
+    v = fminf(fmaxf(v, -INT16_MAX), INT16_MAX);
+    w_buff[plan->sel[k]] = (int16_t) lrintf(v);
+  }
+  inv = 1 / *scale;
+  for (i = 0; i < 3 * plan->nof_coded; i++) {
+    output[i] = w_buff[plan->deint[i]] * inv;
+  }
+
+  plan_put(plan);
+  return 0;
+}
+
+/* As rm_turbo_rx_s() with 8-bit LLRs */
+int rm_turbo_rx_b(int8_t *w_buff, uint32_t w_buff_len, float *input, uint32_t in_len, 
+    float *output, uint32_t out_len, uint32_t rv_idx, uint32_t N_cb, float *scale) {
+  uint32_t i, k;
+  float v, inv;
+  rm_plan_t *plan;
+
+  plan = plan_check_get(out_len, w_buff_len, in_len, rv_idx, N_cb);
+  if (!plan) {
     return -1;
   }
 
-  ndummy = K_p - out_len / 3;
-  if (ndummy < 0) {
-    ndummy = 0;
+  if (rv_idx == 0 || *scale == 0) {
+    bzero(w_buff, sizeof(int8_t) * plan->w_len);
+    *scale = rm_soft_scale(input, in_len, RM_SOFT_MEAN_B);
+  }
+  for (k = 0; k < in_len; k++) {
+    v = w_buff[plan->sel[k]] + input[k] * *scale;
+    v = fminf(fmaxf(v, -INT8_MAX), INT8_MAX);
+    w_buff[plan->sel[k]] = (int8_t) lrintf(v);
+  }
+  inv = 1 / *scale;
+  for (i = 0; i < 3 * plan->nof_coded; i++) {
+    output[i] = w_buff[plan->deint[i]] * inv;
+  }
+
+  plan_put(plan);
+  return 0;
+}
+
+/* Fixed-point rate dematching. The input LLRs, the circular buffer and the output 
+ * share the same scale, and soft combining saturates to +-INT16_MAX. The output 
+ * feeds tdec_simd_t directly. 
+ */
+int rm_turbo_rx_fixed_s(int16_t *w_buff, uint32_t w_buff_len, int16_t *input, uint32_t in_len, 
+    int16_t *output, uint32_t out_len, uint32_t rv_idx, uint32_t N_cb) {
+  uint32_t i, k;
+  int32_t v;
+  rm_plan_t *plan;
+
+  plan = plan_check_get(out_len, w_buff_len, in_len, rv_idx, N_cb);
+  if (!plan) {
+    return -1;
   }
 
   if (rv_idx == 0) {
-    for (i = 0; i < 3 * K_p; i++) {
-      w_buff[i] = RX_NULL;
-    }    
+    bzero(w_buff, sizeof(int16_t) * plan->w_len);
+  }
+  for (k = 0; k < in_len; k++) {
+    v = w_buff[plan->sel[k]] + input[k];
+    w_buff[plan->sel[k]] = (int16_t) (v > INT16_MAX ? INT16_MAX : (v < -INT16_MAX ? -INT16_MAX : v));
+  }
+  for (i = 0; i < 3 * plan->nof_coded; i++) {
+    output[i] = w_buff[plan->deint[i]];
   }
 
-  /* Undo bit collection. Account for dummy bits */
-  N_cb = 3 * K_p;       // TODO: Soft buffer size limitation
-  k0 = nrows
-      * (2 * (uint32_t) ceilf((float) N_cb / (float) (8 * nrows)) * rv_idx + 2);
+  plan_put(plan);
+  return 0;
+}
 
-  k = 0;
-  j = 0;
-  while (k < in_len) {
-    jp = (k0 + j) % N_cb;
-
-    if (jp < K_p || !(jp % 2)) {
-      if (jp >= K_p) {
-        d_i = ((jp - K_p) / 2) / nrows;
-        d_j = ((jp - K_p) / 2) % nrows;
-      } else {
-        d_i = jp / nrows;
-        d_j = jp % nrows;
-      }
-      if (d_j * NCOLS + RM_PERM_TC[d_i] >= ndummy) {
-        isdummy = false;
-      } else {
-        isdummy = true;
-      }
-    } else {
-      uint32_t jpp = (jp - K_p - 1) / 2;
-      kidx = (RM_PERM_TC[jpp / nrows] + NCOLS * (jpp % nrows) + 1) % K_p;
-      if ((kidx - ndummy) < 0) {
-        isdummy = true;
-      } else {
-        isdummy = false;
-      }
-    }
+/* As rm_turbo_rx_fixed_s() with 8-bit LLRs, saturated to +-INT8_MAX */
+int rm_turbo_rx_fixed_b(int8_t *w_buff, uint32_t w_buff_len, int8_t *input, uint32_t in_len, 
+    int16_t *output, uint32_t out_len, uint32_t rv_idx, uint32_t N_cb) {
+  uint32_t i, k;
+  int32_t v;
+  rm_plan_t *plan;
 
-    if (!isdummy) {
-      if (w_buff[jp] == RX_NULL) {
-        w_buff[jp] = input[k];
-      } else if (input[k] != RX_NULL) {
-        w_buff[jp] += input[k]; /* soft combine LLRs */
-      }
-      k++;
-    }
-    j++;
-  }
-
-  /* interleaving and bit selection */
-  for (i = 0; i < out_len / 3; i++) {
-    d_i = (i + ndummy) / NCOLS;
-    d_j = (i + ndummy) % NCOLS;
-    for (j = 0; j < 3; j++) {
-      if (j != 2) {
-        kidx = K_p * j + (j + 1) * (RM_PERM_TC[d_j] * nrows + d_i);
-      } else {
-        k = (i + ndummy - 1) % K_p;
-        if (k < 0)
-          k += K_p;
-        kidx = (k / NCOLS + nrows * RM_PERM_TC[k % NCOLS]) % K_p;
-        kidx = 2 * kidx + K_p + 1;
-      }
-      if (w_buff[kidx] != RX_NULL) {
-        output[i * 3 + j] = w_buff[kidx];
-      } else {
-        output[i * 3 + j] = 0;
-      }
-    }
+  plan = plan_check_get(out_len, w_buff_len, in_len, rv_idx, N_cb);
+  if (!plan) {
+    return -1;
+  }
+
+  if (rv_idx == 0) {
+    bzero(w_buff, sizeof(int8_t) * plan->w_len);
+  }
+  for (k = 0; k < in_len; k++) {
+    v = w_buff[plan->sel[k]] + input[k];
+    w_buff[plan->sel[k]] = (int8_t) (v > INT8_MAX ? INT8_MAX : (v < -INT8_MAX ? -INT8_MAX : v));
   }
+  for (i = 0; i < 3 * plan->nof_coded; i++) {
+    output[i] = w_buff[plan->deint[i]];
+  }
+
+  plan_put(plan);
   return 0;
 }
 
@@ -28,6 +28,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <pthread.h>
 
 #include "liblte/phy/common/phy_common.h"
 #include "liblte/phy/fec/tc_interl.h"
@@ -66,35 +67,110 @@ const uint32_t f2_list[NOF_TC_CB_SIZES] = { 10, 12, 42, 16, 18, 20, 22, 24, 26,
     280, 142, 480, 146, 444, 120, 152, 462, 234, 158, 80, 96, 902, 166, 336,
     170, 86, 174, 176, 178, 120, 182, 184, 186, 94, 190, 480 };
 
-int tc_interl_LTE_gen(tc_interl_t *h, uint32_t long_cb) {
-  uint32_t cb_table_idx, f1, f2;
-  uint64_t i, j;
+/* Shared QPP permutations. Each entry holds forward followed by reverse and is 
+ * published once, the first time its code block size is requested. 
+ */
+static uint16_t *interl_table[NOF_TC_CB_SIZES];
+static pthread_mutex_t interl_table_mutex = PTHREAD_MUTEX_INITIALIZER;
 
-  if (long_cb > h->max_long_cb) {
-    fprintf(stderr, "Interleaver initiated for max_long_cb=%d\n",
-        h->max_long_cb);
+/* Index of long_cb in the table of valid code block sizes (36.212 Table 5.1.3-3), 
+ * which uses steps of 8, 16, 32 and 64 bits. Returns -1 if long_cb is not valid. 
+ */
+static int cb_size_index(uint32_t long_cb) {
+  int idx;
+  if (long_cb < 40 || long_cb > 6144) {
     return -1;
+  } else if (long_cb <= 512) {
+    idx = (long_cb - 40) / 8;
+  } else if (long_cb <= 1024) {
+    idx = 60 + (long_cb - 528) / 16;
+  } else if (long_cb <= 2048) {
+    idx = 92 + (long_cb - 1056) / 32;
+  } else {
+    idx = 124 + (long_cb - 2112) / 64;
   }
-
-  cb_table_idx = lte_find_cb_index(long_cb);
-  if (cb_table_idx == -1) {
-    fprintf(stderr, "Can't find long_cb=%d in valid TC CB table\n", long_cb);
+  if (lte_cb_size(idx) != long_cb) {
     return -1;
   }
+  return idx;
+}
+
+static uint16_t *interl_table_gen(uint32_t cb_table_idx) {
+  uint32_t long_cb, f1, f2;
+  uint64_t i, j;
+  uint16_t *forward, *reverse;
 
+  long_cb = lte_cb_size(cb_table_idx);
   f1 = f1_list[cb_table_idx];
   f2 = f2_list[cb_table_idx];
 
   DEBUG("table_idx: %d, f1: %d, f2: %d\n", cb_table_idx, f1, f2);
 
-  h->forward[0] = 0;
-  h->reverse[0] = 0;
+  forward = malloc(sizeof(uint16_t) * 2 * long_cb);
+  if (!forward) {
+    perror("malloc");
+    return NULL;
+  }
+  reverse = &forward[long_cb];
+
+  forward[0] = 0;
+  reverse[0] = 0;
   for (i = 1; i < long_cb; i++) {
     j = (f1 * i + f2 * i * i) % (long_cb);
-    h->forward[i] = (uint32_t) j;
-    h->reverse[j] = (uint32_t) i;
+    forward[i] = (uint16_t) j;
+    reverse[j] = (uint16_t) i;
   }
-  return 0;
+  return forward;
+}
+
+static uint16_t *interl_table_get(uint32_t cb_table_idx) {
+  uint16_t *t = __atomic_load_n(&interl_table[cb_table_idx], __ATOMIC_ACQUIRE);
+  if (!t) {
+    pthread_mutex_lock(&interl_table_mutex);
+    t = interl_table[cb_table_idx];
+    if (!t) {
+      t = interl_table_gen(cb_table_idx);
+      __atomic_store_n(&interl_table[cb_table_idx], t, __ATOMIC_RELEASE);
+    }
+    pthread_mutex_unlock(&interl_table_mutex);
+  }
+  return t;
+}
 
+/* Computes the permutations for all code block sizes, so that later calls to 
+ * tc_interl_LTE_gen() never allocate memory. 
+ */
+int tc_interl_LTE_gen_all(void) {
+  uint32_t i;
+  for (i = 0; i < NOF_TC_CB_SIZES; i++) {
+    if (!interl_table_get(i)) {
+      return -1;
+    }
+  }
+  return 0;
 }
 
+int tc_interl_LTE_gen(tc_interl_t *h, uint32_t long_cb) {
+  int cb_table_idx;
+  uint16_t *t;
+
+  if (long_cb > h->max_long_cb) {
+    fprintf(stderr, "Interleaver initiated for max_long_cb=%d\n",
+        h->max_long_cb);
+    return -1;
+  }
+
+  cb_table_idx = cb_size_index(long_cb);
+  if (cb_table_idx == -1) {
+    fprintf(stderr, "Can't find long_cb=%d in valid TC CB table\n", long_cb);
+    return -1;
+  }
+
+  t = interl_table_get(cb_table_idx);
+  if (!t) {
+    return -1;
+  }
+  h->forward = t;
+  h->reverse = &t[long_cb];
+  return 0;
+}
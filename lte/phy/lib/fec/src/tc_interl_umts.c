@@ -55,31 +55,14 @@ const unsigned char table_v[52] = { 3, 2, 2, 3, 2, 5, 2, 3, 2, 6, 3, 5, 2, 2, 2,
     5, 2, 3, 2, 3, 2, 6, 3, 7, 7, 6, 3 };
 
 int tc_interl_init(tc_interl_t *h, uint32_t max_long_cb) {
-  int ret = -1;
-  h->forward = malloc(sizeof(uint32_t) * max_long_cb);
-  if (!h->forward) {
-    perror("malloc");
-    goto clean_exit;
-  }
-  h->reverse = malloc(sizeof(uint32_t) * max_long_cb);
-  if (!h->reverse) {
-    perror("malloc");
-    goto clean_exit;
-  }
+  bzero(h, sizeof(tc_interl_t));
   h->max_long_cb = max_long_cb;
-  ret = 0;
-  clean_exit: if (ret == -1) {
-    tc_interl_free(h);
-  }
-  return ret;
+  return 0;
 }
 
 void tc_interl_free(tc_interl_t *h) {
-  if (h->forward) {
-    free(h->forward);
-  }
-  if (h->reverse) {
-    free(h->reverse);
+  if (h->buff) {
+    free(h->buff);
   }
   bzero(h, sizeof(tc_interl_t));
 }
@@ -89,7 +72,7 @@ int tc_interl_UMTS_gen(tc_interl_t *h, uint32_t long_cb) {
   uint32_t i, j;
   uint32_t res, prim, aux;
   uint32_t kp, k;
-  uint32_t *per, *desper;
+  uint16_t *per, *desper;
   uint8_t v;
   uint16_t p;
   uint16_t s[MAX_COLS], q[MAX_ROWS], r[MAX_ROWS], T[MAX_ROWS];
@@ -242,8 +225,18 @@ int tc_interl_UMTS_gen(tc_interl_t *h, uint32_t long_cb) {
     }
   }
 
-  per = h->forward;
-  desper = h->reverse;
+  /* Unlike the LTE interleaver, the UMTS one computes its own permutation */
+  if (!h->buff) {
+    h->buff = malloc(sizeof(uint16_t) * 2 * h->max_long_cb);
+    if (!h->buff) {
+      perror("malloc");
+      return -1;
+    }
+  }
+  per = h->buff;
+  desper = &h->buff[h->max_long_cb];
+  h->forward = per;
+  h->reverse = desper;
 
   k = 0;
   for (j = 0; j < M_Cols; j++) {
@@ -0,0 +1,85 @@
+/**
+ *
+ * \section COPYRIGHT
+ *
+ * Copyright 2013-2014 The libLTE Developers. See the
+ * COPYRIGHT file at the top-level directory of this distribution.
+ *
+ * \section LICENSE
+ *
+ * This file is part of the libLTE library.
+ *
+ * libLTE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libLTE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * A copy of the GNU Lesser General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#ifndef TDEC_DECISION_
+#define TDEC_DECISION_
+
+#include <stdint.h>
+#include <string.h>
+
+#include "liblte/phy/fec/crc.h"
+
+/* Returns 1 if the LLR at position idx of llr is positive. One per LLR type,
+ * so that tdec_pack_decision_crc() is shared by all the turbo decoders.
+ */
+typedef int (*tdec_llr_positive_t)(const void *llr, uint32_t idx);
+
+/* Packs the hard decisions of llr2, read through the deinterleaver reverse,
+ * in bytes MSB first, clears the first nof_filler bits and returns the CRC of
+ * the long_cb bits, or 0 if crc is NULL. positive is a constant at every call
+ * site and is inlined.
+ */
+static inline uint32_t tdec_pack_decision_crc(const void *llr2,
+                                              tdec_llr_positive_t positive,
+                                              const uint16_t *reverse,
+                                              uint8_t *output,
+                                              uint32_t long_cb,
+                                              uint32_t nof_filler,
+                                              crc_t *crc)
+{
+  uint32_t i, j;
+  uint8_t byte;
+
+  for (i = 0; i < long_cb / 8; i++) {
+    byte = 0;
+    for (j = 0; j < 8; j++) {
+      byte |= positive(llr2, reverse[8 * i + j]) << (7 - j);
+    }
+    output[i] = byte;
+  }
+  if (long_cb % 8) {
+    byte = 0;
+    for (j = 0; j < long_cb % 8; j++) {
+      byte |= positive(llr2, reverse[8 * i + j]) << (7 - j);
+    }
+    output[i] = byte;
+  }
+
+  /* Clear filler bits */
+  memset(output, 0, nof_filler / 8);
+  if (nof_filler % 8) {
+    output[nof_filler / 8] &= 0xff >> (nof_filler % 8);
+  }
+
+  if (crc) {
+    return crc_checksum_packed(crc, output, long_cb);
+  } else {
+    return 0;
+  }
+}
+
+#endif
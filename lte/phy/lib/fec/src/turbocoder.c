@@ -28,17 +28,61 @@
 
 #include <stdio.h>
 #include <stdint.h>
+#include <pthread.h>
 
 #include "liblte/phy/fec/turbocoder.h"
 
 #define NOF_REGS 3
 
+/* Constituent encoder 8 bits at a time: parity bits and next state for each 
+ * state and input byte. spread[b] places bit j of b at bit 23-3*j. They are 
+ * shared by all the encoders and generated by the first tcod_init(). 
+ */
+static uint8_t trellis_parity[8][256];
+static uint8_t trellis_state[8][256];
+static uint32_t spread[256];
+static pthread_once_t trellis_once = PTHREAD_ONCE_INIT;
+
+/* The state of a constituent encoder is reg_0 | reg_1 << 1 | reg_2 << 2 */
+static void gen_trellis_tables(void) {
+  uint32_t s, b, j;
+  char reg0, reg1, reg2, bit, in, out;
+  uint8_t parity;
+
+  for (s = 0; s < 8; s++) {
+    for (b = 0; b < 256; b++) {
+      reg0 = s & 0x1;
+      reg1 = (s >> 1) & 0x1;
+      reg2 = (s >> 2) & 0x1;
+      parity = 0;
+      for (j = 0; j < 8; j++) {
+        bit = (b >> (7 - j)) & 0x1;
+        in = bit ^ (reg2 ^ reg1);
+        out = reg2 ^ (reg0 ^ in);
+        reg2 = reg1;
+        reg1 = reg0;
+        reg0 = in;
+        parity |= out << (7 - j);
+      }
+      trellis_parity[s][b] = parity;
+      trellis_state[s][b] = reg0 | (reg1 << 1) | (reg2 << 2);
+    }
+  }
+  for (b = 0; b < 256; b++) {
+    spread[b] = 0;
+    for (j = 0; j < 8; j++) {
+      spread[b] |= ((b >> (7 - j)) & 0x1) << (23 - 3 * j);
+    }
+  }
+}
+
 int tcod_init(tcod_t *h, uint32_t max_long_cb) {
 
   if (tc_interl_init(&h->interl, max_long_cb)) {
     return -1;
   }
   h->max_long_cb = max_long_cb;
+  pthread_once(&trellis_once, gen_trellis_tables);
   return 0;
 }
 
@@ -53,7 +97,7 @@ int tcod_encode(tcod_t *h, char *input, char *output, uint32_t long_cb) {
   uint32_t i, k = 0, j;
   char bit;
   char in, out;
-  uint32_t *per;
+  const uint16_t *per;
 
   if (long_cb > h->max_long_cb) {
     fprintf(stderr, "Turbo coder initiated for max_long_cb=%d\n",
@@ -146,3 +190,73 @@ int tcod_encode(tcod_t *h, char *input, char *output, uint32_t long_cb) {
   return 0;
 }
 
+/* Writes the tail bits of a constituent encoder in state s at bit k of output */
+static uint32_t tail_packed(uint32_t s, uint8_t *output, uint32_t k) {
+  char reg0 = s & 0x1, reg1 = (s >> 1) & 0x1, reg2 = (s >> 2) & 0x1;
+  char bit, in, out;
+  uint32_t j;
+
+  for (j = 0; j < NOF_REGS; j++) {
+    bit = reg2 ^ reg1;
+    in = bit ^ (reg2 ^ reg1);
+    out = reg2 ^ (reg0 ^ in);
+    reg2 = reg1;
+    reg1 = reg0;
+    reg0 = in;
+
+    output[k / 8] |= bit << (7 - k % 8);
+    k++;
+    output[k / 8] |= out << (7 - k % 8);
+    k++;
+  }
+  return k;
+}
+
+int tcod_encode_packed(tcod_t *h, uint8_t *input, uint8_t *output, uint32_t long_cb) {
+
+  uint32_t i, j, k, idx;
+  uint32_t s1 = 0, s2 = 0;
+  uint32_t w;
+  uint8_t sys, inter, p1, p2;
+  const uint16_t *per;
+
+  if (long_cb > h->max_long_cb || long_cb % 8) {
+    fprintf(stderr, "Turbo coder initiated for max_long_cb=%d and long_cb=%d is not a multiple of 8\n",
+        h->max_long_cb, long_cb);
+    return -1;
+  }
+
+  if (tc_interl_LTE_gen(&h->interl, long_cb)) {
+    fprintf(stderr, "Error initiating TC interleaver\n");
+    return -1;
+  }
+
+  per = h->interl.forward;
+
+  for (i = 0; i < long_cb / 8; i++) {
+    sys = input[i];
+    p1 = trellis_parity[s1][sys];
+    s1 = trellis_state[s1][sys];
+
+    inter = 0;
+    for (j = 0; j < 8; j++) {
+      idx = per[8 * i + j];
+      inter |= ((input[idx / 8] >> (7 - idx % 8)) & 0x1) << (7 - j);
+    }
+    p2 = trellis_parity[s2][inter];
+    s2 = trellis_state[s2][inter];
+
+    /* systematic, parity 1 and parity 2 bits are interleaved */
+    w = spread[sys] | (spread[p1] >> 1) | (spread[p2] >> 2);
+    output[3 * i] = (uint8_t) (w >> 16);
+    output[3 * i + 1] = (uint8_t) (w >> 8);
+    output[3 * i + 2] = (uint8_t) w;
+  }
+
+  k = 3 * long_cb;
+  output[k / 8] = 0;
+  output[k / 8 + 1] = 0;
+  k = tail_packed(s1, output, k);
+  tail_packed(s2, output, k);
+  return 0;
+}
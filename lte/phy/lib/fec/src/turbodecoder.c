@@ -34,27 +34,27 @@
 
 #include "liblte/phy/fec/turbodecoder.h"
 
+#include "tdec_decision.h"
+
 /************************************************
  *
  *  MAP_GEN is the MAX-LOG-MAP generic implementation of the
  *  Decoder
  *
  ************************************************/
-void map_gen_beta(map_gen_t * s, llr_t * input, llr_t * parity,
-                  uint32_t long_cb)
+/* Runs the backward recursion from k=end-1 down to k=start. old holds the
+ * metrics at k=end on entry and at k=start on exit. If beta is not NULL the
+ * metrics at each k are stored in beta[8*(k-start)].
+ */
+static void map_gen_beta_run(llr_t * old, llr_t * beta, llr_t * input,
+                             llr_t * parity, int start, int end)
 {
-  llr_t m_b[8], new[8], old[8];
+  llr_t m_b[8], new[8];
   llr_t x, y, xy;
   int k;
-  uint32_t end = long_cb + RATE;
-  llr_t *beta = s->beta;
   uint32_t i;
 
-  for (i = 0; i < 8; i++) {
-    old[i] = beta[8 * (end) + i];
-  }
-
-  for (k = end - 1; k >= 0; k--) {
+  for (k = end - 1; k >= start; k--) {
     x = input[k];
     y = parity[k];
 
@@ -81,30 +81,32 @@ void map_gen_beta(map_gen_t * s, llr_t * input, llr_t * parity,
     for (i = 0; i < 8; i++) {
       if (m_b[i] > new[i])
         new[i] = m_b[i];
-      beta[8 * k + i] = new[i];
       old[i] = new[i];
     }
+    if (beta) {
+      for (i = 0; i < 8; i++) {
+        beta[8 * (k - start) + i] = new[i];
+      }
+    }
   }
 }
 
-void map_gen_alpha(map_gen_t * s, llr_t * input, llr_t * parity, llr_t * output,
-                   uint32_t long_cb)
+/* Runs the forward recursion and computes the output from k=start+1 to
+ * k=end. old holds the metrics at k=start on entry and at k=end on exit.
+ * The backward metrics at each k are read from beta[8*(k-start)].
+ */
+static void map_gen_alpha_run(llr_t * old, llr_t * beta, llr_t * input,
+                              llr_t * parity, llr_t * output,
+                              uint32_t start, uint32_t end)
 {
-  llr_t m_b[8], new[8], old[8], max1[8], max0[8];
+  llr_t m_b[8], new[8], max1[8], max0[8];
   llr_t m1, m0;
   llr_t x, y, xy;
   llr_t out;
   uint32_t k;
-  uint32_t end = long_cb;
-  llr_t *beta = s->beta;
   uint32_t i;
 
-  old[0] = 0;
-  for (i = 1; i < 8; i++) {
-    old[i] = -INF;
-  }
-
-  for (k = 1; k < end + 1; k++) {
+  for (k = start + 1; k < end + 1; k++) {
     x = input[k - 1];
     y = parity[k - 1];
 
@@ -129,8 +131,8 @@ void map_gen_alpha(map_gen_t * s, llr_t * input, llr_t * parity, llr_t * output,
     new[7] = old[7] + xy;
 
     for (i = 0; i < 8; i++) {
-      max0[i] = m_b[i] + beta[8 * k + i];
-      max1[i] = new[i] + beta[8 * k + i];
+      max0[i] = m_b[i] + beta[8 * (k - start) + i];
+      max1[i] = new[i] + beta[8 * (k - start) + i];
     }
 
     m1 = max1[0];
@@ -154,10 +156,83 @@ void map_gen_alpha(map_gen_t * s, llr_t * input, llr_t * parity, llr_t * output,
   }
 }
 
+void map_gen_beta(map_gen_t * s, llr_t * input, llr_t * parity,
+                  uint32_t long_cb)
+{
+  llr_t old[8];
+  uint32_t end = long_cb + RATE;
+  llr_t *beta = s->beta;
+  uint32_t i;
+
+  for (i = 0; i < 8; i++) {
+    old[i] = beta[8 * (end) + i];
+  }
+
+  map_gen_beta_run(old, beta, input, parity, 0, end);
+}
+
+void map_gen_alpha(map_gen_t * s, llr_t * input, llr_t * parity, llr_t * output,
+                   uint32_t long_cb)
+{
+  llr_t old[8];
+  uint32_t i;
+
+  old[0] = 0;
+  for (i = 1; i < 8; i++) {
+    old[i] = -INF;
+  }
+
+  map_gen_alpha_run(old, s->beta, input, parity, output, 0, long_cb);
+}
+
+/* Sliding-window decoder. The block is processed in windows of s->window
+ * bits and only the backward metrics of the current window are stored. The
+ * backward recursion of each window starts from equiprobable states one
+ * window further ahead (training), except for the last window, which starts
+ * from the metrics given by the tail bits.
+ */
+void map_gen_window(map_gen_t * s, llr_t * input, llr_t * parity, llr_t * output,
+                    uint32_t long_cb)
+{
+  llr_t alpha[8], beta_end[8], old[8];
+  uint32_t start, end, train;
+  uint32_t i;
+
+  beta_end[0] = 0;
+  for (i = 1; i < 8; i++) {
+    beta_end[i] = -INF;
+  }
+  map_gen_beta_run(beta_end, NULL, input, parity, long_cb, long_cb + RATE);
+
+  alpha[0] = 0;
+  for (i = 1; i < 8; i++) {
+    alpha[i] = -INF;
+  }
+
+  for (start = 0; start < long_cb; start += s->window) {
+    end = start + s->window;
+    if (end > long_cb) {
+      end = long_cb;
+    }
+    train = end + s->window;
+    if (train >= long_cb) {
+      memcpy(old, beta_end, sizeof(llr_t) * 8);
+      train = long_cb;
+    } else {
+      bzero(old, sizeof(llr_t) * 8);
+    }
+    map_gen_beta_run(old, NULL, input, parity, end, train);
+
+    memcpy(&s->beta[8 * (end - start)], old, sizeof(llr_t) * 8);
+    map_gen_beta_run(old, s->beta, input, parity, start, end);
+    map_gen_alpha_run(alpha, s->beta, input, parity, output, start, end);
+  }
+}
+
 int map_gen_init(map_gen_t * h, int max_long_cb)
 {
   bzero(h, sizeof(map_gen_t));
-  h->beta = malloc(sizeof(llr_t) * (max_long_cb + TOTALTAIL + 1) * NUMSTATES);
+  h->beta = malloc(sizeof(llr_t) * (max_long_cb + TOTALTAIL + 1 + TDEC_MAX_SUBBLOCKS) * NUMSTATES);
   if (!h->beta) {
     perror("malloc");
     return -1;
@@ -174,11 +249,37 @@ void map_gen_free(map_gen_t * h)
   bzero(h, sizeof(map_gen_t));
 }
 
+/* Allocates the backward metrics for the whole block (window=0) or for one window */
+int map_gen_set_window(map_gen_t * h, uint32_t window)
+{
+  uint32_t len;
+  if (window) {
+    len = window + 1;
+  } else {
+    len = h->max_long_cb + TOTALTAIL + 1 + TDEC_MAX_SUBBLOCKS;
+  }
+  if (h->beta) {
+    free(h->beta);
+  }
+  h->beta = malloc(sizeof(llr_t) * len * NUMSTATES);
+  if (!h->beta) {
+    perror("malloc");
+    return -1;
+  }
+  h->window = window;
+  return 0;
+}
+
 void map_gen_dec(map_gen_t * h, llr_t * input, llr_t * parity, llr_t * output,
                  uint32_t long_cb)
 {
   uint32_t k;
 
+  if (h->window) {
+    map_gen_window(h, input, parity, output, long_cb);
+    return;
+  }
+
   h->beta[(long_cb + TAIL) * NUMSTATES] = 0;
   for (k = 1; k < NUMSTATES; k++)
     h->beta[(long_cb + TAIL) * NUMSTATES + k] = -INF;
@@ -187,6 +288,86 @@ void map_gen_dec(map_gen_t * h, llr_t * input, llr_t * parity, llr_t * output,
   map_gen_alpha(h, input, parity, output, long_cb);
 }
 
+/* Sub-block decoding job, shared by all the sub-blocks of one MAP decoder run */
+typedef struct {
+  map_gen_t *h;
+  llr_t *input;
+  llr_t *parity;
+  llr_t *output;
+  uint32_t long_cb;
+  uint32_t nof_subblocks;
+  map_bounds_t in;
+  map_bounds_t *out;
+} map_par_job_t;
+
+/* Decodes sub-block p. Each sub-block keeps its backward metrics in its own
+ * rows of beta, shifted by p rows so that neighbouring sub-blocks do not
+ * share their boundary row.
+ */
+static void map_gen_subblock(void *arg, uint32_t p, uint32_t worker_idx)
+{
+  map_par_job_t *job = (map_par_job_t*) arg;
+  uint32_t P = job->nof_subblocks;
+  uint32_t start = p * job->long_cb / P;
+  uint32_t end = (p + 1) * job->long_cb / P;
+  llr_t *beta = &job->h->beta[8 * (start + p)];
+  llr_t old[8];
+  uint32_t i;
+
+  if (p == P - 1) {
+    old[0] = 0;
+    for (i = 1; i < 8; i++) {
+      old[i] = -INF;
+    }
+    map_gen_beta_run(old, NULL, job->input, job->parity, job->long_cb, job->long_cb + RATE);
+  } else {
+    memcpy(old, job->in.beta[p], sizeof(llr_t) * 8);
+  }
+  memcpy(&beta[8 * (end - start)], old, sizeof(llr_t) * 8);
+  map_gen_beta_run(old, beta, job->input, job->parity, start, end);
+  if (p > 0) {
+    memcpy(job->out->beta[p - 1], old, sizeof(llr_t) * 8);
+  }
+
+  if (p == 0) {
+    old[0] = 0;
+    for (i = 1; i < 8; i++) {
+      old[i] = -INF;
+    }
+  } else {
+    memcpy(old, job->in.alpha[p], sizeof(llr_t) * 8);
+  }
+  map_gen_alpha_run(old, beta, job->input, job->parity, job->output, start, end);
+  if (p < P - 1) {
+    memcpy(job->out->alpha[p + 1], old, sizeof(llr_t) * 8);
+  }
+}
+
+void map_gen_dec_par(map_gen_t * h, map_bounds_t * bounds, llr_t * input,
+                     llr_t * parity, llr_t * output, uint32_t long_cb,
+                     uint32_t nof_subblocks, thread_pool_t * pool)
+{
+  map_par_job_t job;
+  uint32_t p;
+
+  job.h = h;
+  job.input = input;
+  job.parity = parity;
+  job.output = output;
+  job.long_cb = long_cb;
+  job.nof_subblocks = nof_subblocks;
+  memcpy(&job.in, bounds, sizeof(map_bounds_t));
+  job.out = bounds;
+
+  if (pool) {
+    thread_pool_run(pool, nof_subblocks, map_gen_subblock, &job);
+  } else {
+    for (p = 0; p < nof_subblocks; p++) {
+      map_gen_subblock(&job, p, 0);
+    }
+  }
+}
+
 /************************************************
  *
  *  TURBO DECODER INTERFACE
@@ -266,7 +447,20 @@ void tdec_free(tdec_t * h)
   bzero(h, sizeof(tdec_t));
 }
 
-void tdec_iteration(tdec_t * h, llr_t * input, uint32_t long_cb)
+/* Runs MAP decoder dec (0 or 1) on the whole block or split in sub-blocks */
+static void tdec_map(tdec_t * h, uint32_t dec, llr_t * output, uint32_t long_cb,
+                     uint32_t nof_subblocks, thread_pool_t * pool)
+{
+  if (nof_subblocks > 1) {
+    map_gen_dec_par(&h->dec, &h->bounds[dec], h->syst, h->parity, output,
+                    long_cb, nof_subblocks, pool);
+  } else {
+    map_gen_dec(&h->dec, h->syst, h->parity, output, long_cb);
+  }
+}
+
+static void tdec_iteration_gen(tdec_t * h, llr_t * input, uint32_t long_cb,
+                               uint32_t nof_subblocks, thread_pool_t * pool)
 {
   uint32_t i;
 
@@ -281,7 +475,7 @@ void tdec_iteration(tdec_t * h, llr_t * input, uint32_t long_cb)
   }
 
   // Run MAP DEC #1
-  map_gen_dec(&h->dec, h->syst, h->parity, h->llr1, long_cb);
+  tdec_map(h, 0, h->llr1, long_cb, nof_subblocks, pool);
 
   // Prepare systematic and parity bits for MAP DEC #1
   for (i = 0; i < long_cb; i++) {
@@ -297,7 +491,7 @@ void tdec_iteration(tdec_t * h, llr_t * input, uint32_t long_cb)
   }
 
   // Run MAP DEC #1
-  map_gen_dec(&h->dec, h->syst, h->parity, h->llr2, long_cb);
+  tdec_map(h, 1, h->llr2, long_cb, nof_subblocks, pool);
  
   // Update a-priori LLR from the last iteration
   for (i = 0; i < long_cb; i++) {
@@ -306,6 +500,42 @@ void tdec_iteration(tdec_t * h, llr_t * input, uint32_t long_cb)
 
 }
 
+void tdec_iteration(tdec_t * h, llr_t * input, uint32_t long_cb)
+{
+  tdec_iteration_gen(h, input, long_cb, 1, NULL);
+}
+
+int tdec_iteration_par(tdec_t * h, llr_t * input, uint32_t long_cb,
+                       uint32_t nof_subblocks, thread_pool_t * pool)
+{
+  if (nof_subblocks == 0 || nof_subblocks > TDEC_MAX_SUBBLOCKS ||
+      nof_subblocks > long_cb) {
+    fprintf(stderr, "Invalid number of sub-blocks %d\n", nof_subblocks);
+    return -1;
+  }
+  if (h->dec.window) {
+    fprintf(stderr, "Sub-block decoding is not supported with a sliding window\n");
+    return -1;
+  }
+  /* Boundaries start equiprobable when the split changes */
+  if (nof_subblocks != h->nof_subblocks) {
+    bzero(h->bounds, sizeof(h->bounds));
+    h->nof_subblocks = nof_subblocks;
+  }
+  tdec_iteration_gen(h, input, long_cb, nof_subblocks, pool);
+  return 0;
+}
+
+int tdec_set_window(tdec_t * h, uint32_t window)
+{
+  if (window > h->max_long_cb) {
+    fprintf(stderr, "Invalid window size %d (max_long_cb=%d)\n", window,
+            h->max_long_cb);
+    return -1;
+  }
+  return map_gen_set_window(&h->dec, window);
+}
+
 int tdec_reset(tdec_t * h, uint32_t long_cb)
 {
   if (long_cb > h->max_long_cb) {
@@ -314,6 +544,8 @@ int tdec_reset(tdec_t * h, uint32_t long_cb)
     return -1;
   }
   memset(h->w, 0, sizeof(llr_t) * long_cb);
+  bzero(h->bounds, sizeof(h->bounds));
+  h->nof_subblocks = 0;
   return tc_interl_LTE_gen(&h->interleaver, long_cb);
 }
 
@@ -325,6 +557,18 @@ void tdec_decision(tdec_t * h, char *output, uint32_t long_cb)
   }
 }
 
+static inline int llr_positive(const void *llr, uint32_t idx)
+{
+  return ((const llr_t *) llr)[idx] > 0;
+}
+
+uint32_t tdec_decision_crc(tdec_t * h, uint8_t *output, uint32_t long_cb,
+                           uint32_t nof_filler, crc_t *crc)
+{
+  return tdec_pack_decision_crc(h->llr2, llr_positive, h->interleaver.reverse,
+                                output, long_cb, nof_filler, crc);
+}
+
 void tdec_run_all(tdec_t * h, llr_t * input, char *output,
                   uint32_t nof_iterations, uint32_t long_cb)
 {
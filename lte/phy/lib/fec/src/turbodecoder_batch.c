@@ -0,0 +1,526 @@
+/**
+ *
+ * \section COPYRIGHT
+ *
+ * Copyright 2013-2014 The libLTE Developers. See the
+ * COPYRIGHT file at the top-level directory of this distribution.
+ *
+ * \section LICENSE
+ *
+ * This file is part of the libLTE library.
+ *
+ * libLTE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libLTE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * A copy of the GNU Lesser General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <strings.h>
+
+#include "liblte/phy/fec/turbodecoder_batch.h"
+#include "liblte/phy/utils/vector.h"
+
+/* All buffers are arrays of rows of NOF_LANES samples, one per code block.
+ * lanes_t holds one row.
+ */
+#if defined(LV_HAVE_AVX2)
+#include <immintrin.h>
+
+#define NOF_LANES 16
+typedef __m256i lanes_t;
+
+static inline lanes_t lanes_load(int16_t *p) {
+  return _mm256_loadu_si256((__m256i*) p);
+}
+static inline void lanes_store(int16_t *p, lanes_t v) {
+  _mm256_storeu_si256((__m256i*) p, v);
+}
+static inline lanes_t lanes_set1(int16_t x) {
+  return _mm256_set1_epi16(x);
+}
+static inline lanes_t lanes_adds(lanes_t a, lanes_t b) {
+  return _mm256_adds_epi16(a, b);
+}
+static inline lanes_t lanes_subs(lanes_t a, lanes_t b) {
+  return _mm256_subs_epi16(a, b);
+}
+static inline lanes_t lanes_max(lanes_t a, lanes_t b) {
+  return _mm256_max_epi16(a, b);
+}
+
+#elif defined(LV_HAVE_SSE)
+#include <smmintrin.h>
+
+#define NOF_LANES 8
+typedef __m128i lanes_t;
+
+static inline lanes_t lanes_load(int16_t *p) {
+  return _mm_loadu_si128((__m128i*) p);
+}
+static inline void lanes_store(int16_t *p, lanes_t v) {
+  _mm_storeu_si128((__m128i*) p, v);
+}
+static inline lanes_t lanes_set1(int16_t x) {
+  return _mm_set1_epi16(x);
+}
+static inline lanes_t lanes_adds(lanes_t a, lanes_t b) {
+  return _mm_adds_epi16(a, b);
+}
+static inline lanes_t lanes_subs(lanes_t a, lanes_t b) {
+  return _mm_subs_epi16(a, b);
+}
+static inline lanes_t lanes_max(lanes_t a, lanes_t b) {
+  return _mm_max_epi16(a, b);
+}
+
+#else
+
+#define NOF_LANES 8
+typedef struct {
+  int16_t v[NOF_LANES];
+} lanes_t;
+
+static inline int16_t sat16(int32_t x) {
+  if (x > INT16_MAX) {
+    return INT16_MAX;
+  } else if (x < INT16_MIN) {
+    return INT16_MIN;
+  } else {
+    return (int16_t) x;
+  }
+}
+
+static inline lanes_t lanes_load(int16_t *p) {
+  lanes_t r;
+  memcpy(r.v, p, sizeof(r.v));
+  return r;
+}
+static inline void lanes_store(int16_t *p, lanes_t v) {
+  memcpy(p, v.v, sizeof(v.v));
+}
+static inline lanes_t lanes_set1(int16_t x) {
+  lanes_t r;
+  int i;
+  for (i = 0; i < NOF_LANES; i++) {
+    r.v[i] = x;
+  }
+  return r;
+}
+static inline lanes_t lanes_adds(lanes_t a, lanes_t b) {
+  int i;
+  for (i = 0; i < NOF_LANES; i++) {
+    a.v[i] = sat16((int32_t) a.v[i] + b.v[i]);
+  }
+  return a;
+}
+static inline lanes_t lanes_subs(lanes_t a, lanes_t b) {
+  int i;
+  for (i = 0; i < NOF_LANES; i++) {
+    a.v[i] = sat16((int32_t) a.v[i] - b.v[i]);
+  }
+  return a;
+}
+static inline lanes_t lanes_max(lanes_t a, lanes_t b) {
+  int i;
+  for (i = 0; i < NOF_LANES; i++) {
+    if (b.v[i] > a.v[i]) {
+      a.v[i] = b.v[i];
+    }
+  }
+  return a;
+}
+
+#endif
+
+#define ROW(p, i) (&(p)[(i) * NOF_LANES])
+
+/************************************************
+ *
+ *  MAP decoder over all lanes. Branch metrics and state transitions
+ *  are the same as in map_simd_beta/alpha.
+ *
+ ************************************************/
+static void map_batch_beta(int16_t *beta, int16_t *input, int16_t *parity,
+                           uint32_t long_cb)
+{
+  lanes_t m_b[8], new[8], old[8];
+  lanes_t x, y, xy;
+  int k;
+  uint32_t end = long_cb + RATE;
+  uint32_t i;
+
+  for (i = 0; i < 8; i++) {
+    old[i] = lanes_load(ROW(beta, 8 * end + i));
+  }
+
+  for (k = end - 1; k >= 0; k--) {
+    x = lanes_load(ROW(input, k));
+    y = lanes_load(ROW(parity, k));
+
+    xy = lanes_adds(x, y);
+
+    m_b[0] = lanes_adds(old[4], xy);
+    m_b[1] = old[4];
+    m_b[2] = lanes_adds(old[5], y);
+    m_b[3] = lanes_adds(old[5], x);
+    m_b[4] = lanes_adds(old[6], x);
+    m_b[5] = lanes_adds(old[6], y);
+    m_b[6] = old[7];
+    m_b[7] = lanes_adds(old[7], xy);
+
+    new[0] = old[0];
+    new[1] = lanes_adds(old[0], xy);
+    new[2] = lanes_adds(old[1], x);
+    new[3] = lanes_adds(old[1], y);
+    new[4] = lanes_adds(old[2], y);
+    new[5] = lanes_adds(old[2], x);
+    new[6] = lanes_adds(old[3], xy);
+    new[7] = old[3];
+
+    for (i = 0; i < 8; i++) {
+      new[i] = lanes_max(m_b[i], new[i]);
+    }
+    for (i = 0; i < 8; i++) {
+      old[i] = lanes_subs(new[i], new[0]);
+      lanes_store(ROW(beta, 8 * k + i), old[i]);
+    }
+  }
+}
+
+static void map_batch_alpha(int16_t *beta, int16_t *input, int16_t *parity,
+                            int16_t *output, uint32_t long_cb)
+{
+  lanes_t m_b[8], new[8], old[8];
+  lanes_t x, y, xy, b, m1, m0;
+  uint32_t k;
+  uint32_t end = long_cb;
+  uint32_t i;
+
+  old[0] = lanes_set1(0);
+  for (i = 1; i < 8; i++) {
+    old[i] = lanes_set1(-TDEC_SIMD_INF);
+  }
+
+  for (k = 1; k < end + 1; k++) {
+    x = lanes_load(ROW(input, k - 1));
+    y = lanes_load(ROW(parity, k - 1));
+
+    xy = lanes_adds(x, y);
+
+    m_b[0] = old[0];
+    m_b[1] = lanes_adds(old[3], y);
+    m_b[2] = lanes_adds(old[4], y);
+    m_b[3] = old[7];
+    m_b[4] = old[1];
+    m_b[5] = lanes_adds(old[2], y);
+    m_b[6] = lanes_adds(old[5], y);
+    m_b[7] = old[6];
+
+    new[0] = lanes_adds(old[1], xy);
+    new[1] = lanes_adds(old[2], x);
+    new[2] = lanes_adds(old[5], x);
+    new[3] = lanes_adds(old[6], xy);
+    new[4] = lanes_adds(old[0], xy);
+    new[5] = lanes_adds(old[3], x);
+    new[6] = lanes_adds(old[4], x);
+    new[7] = lanes_adds(old[7], xy);
+
+    b = lanes_load(ROW(beta, 8 * k));
+    m0 = lanes_adds(m_b[0], b);
+    m1 = lanes_adds(new[0], b);
+    for (i = 1; i < 8; i++) {
+      b = lanes_load(ROW(beta, 8 * k + i));
+      m0 = lanes_max(m0, lanes_adds(m_b[i], b));
+      m1 = lanes_max(m1, lanes_adds(new[i], b));
+    }
+
+    for (i = 0; i < 8; i++) {
+      new[i] = lanes_max(m_b[i], new[i]);
+    }
+    for (i = 0; i < 8; i++) {
+      old[i] = lanes_subs(new[i], new[0]);
+    }
+
+    lanes_store(ROW(output, k - 1), lanes_subs(m1, m0));
+  }
+}
+
+static void map_batch_dec(int16_t *beta, int16_t *input, int16_t *parity,
+                          int16_t *output, uint32_t long_cb)
+{
+  uint32_t k;
+
+  lanes_store(ROW(beta, (long_cb + TAIL) * NUMSTATES), lanes_set1(0));
+  for (k = 1; k < NUMSTATES; k++) {
+    lanes_store(ROW(beta, (long_cb + TAIL) * NUMSTATES + k), lanes_set1(-TDEC_SIMD_INF));
+  }
+
+  map_batch_beta(beta, input, parity, long_cb);
+  map_batch_alpha(beta, input, parity, output, long_cb);
+}
+
+/************************************************
+ *
+ *  TURBO DECODER INTERFACE
+ *
+ ************************************************/
+int tdec_batch_init(tdec_batch_t * h, uint32_t max_long_cb)
+{
+  int ret = -1;
+  bzero(h, sizeof(tdec_batch_t));
+  uint32_t len = (max_long_cb + TOTALTAIL) * NOF_LANES;
+
+  h->max_long_cb = max_long_cb;
+  h->nof_lanes = NOF_LANES;
+
+  h->beta = vec_malloc(sizeof(int16_t) * (max_long_cb + TOTALTAIL + 1) * NUMSTATES * NOF_LANES);
+  if (!h->beta) {
+    perror("vec_malloc");
+    goto clean_and_exit;
+  }
+  h->llr1 = vec_malloc(sizeof(int16_t) * len);
+  if (!h->llr1) {
+    perror("vec_malloc");
+    goto clean_and_exit;
+  }
+  h->llr2 = vec_malloc(sizeof(int16_t) * len);
+  if (!h->llr2) {
+    perror("vec_malloc");
+    goto clean_and_exit;
+  }
+  h->w = vec_malloc(sizeof(int16_t) * len);
+  if (!h->w) {
+    perror("vec_malloc");
+    goto clean_and_exit;
+  }
+  h->syst = vec_malloc(sizeof(int16_t) * len);
+  if (!h->syst) {
+    perror("vec_malloc");
+    goto clean_and_exit;
+  }
+  h->parity = vec_malloc(sizeof(int16_t) * len);
+  if (!h->parity) {
+    perror("vec_malloc");
+    goto clean_and_exit;
+  }
+  h->input = vec_malloc(sizeof(int16_t) * (RATE * max_long_cb + TOTALTAIL) * NOF_LANES);
+  if (!h->input) {
+    perror("vec_malloc");
+    goto clean_and_exit;
+  }
+
+  if (tc_interl_init(&h->interleaver, h->max_long_cb) < 0) {
+    goto clean_and_exit;
+  }
+
+  ret = 0;
+clean_and_exit:if (ret == -1) {
+    tdec_batch_free(h);
+  }
+  return ret;
+}
+
+void tdec_batch_free(tdec_batch_t * h)
+{
+  if (h->beta) {
+    free(h->beta);
+  }
+  if (h->llr1) {
+    free(h->llr1);
+  }
+  if (h->llr2) {
+    free(h->llr2);
+  }
+  if (h->w) {
+    free(h->w);
+  }
+  if (h->syst) {
+    free(h->syst);
+  }
+  if (h->parity) {
+    free(h->parity);
+  }
+  if (h->input) {
+    free(h->input);
+  }
+
+  tc_interl_free(&h->interleaver);
+
+  bzero(h, sizeof(tdec_batch_t));
+}
+
+uint32_t tdec_batch_nof_lanes(tdec_batch_t * h)
+{
+  return h->nof_lanes;
+}
+
+static void tdec_batch_iteration(tdec_batch_t * h, uint32_t long_cb)
+{
+  uint32_t i;
+  int16_t *input = h->input;
+  const uint16_t *forward = h->interleaver.forward;
+  const uint16_t *reverse = h->interleaver.reverse;
+
+  // Prepare systematic and parity bits for MAP DEC #1
+  for (i = 0; i < long_cb; i++) {
+    lanes_store(ROW(h->syst, i), lanes_adds(lanes_load(ROW(input, RATE * i)),
+                                            lanes_load(ROW(h->w, i))));
+    lanes_store(ROW(h->parity, i), lanes_load(ROW(input, RATE * i + 1)));
+  }
+  for (i = long_cb; i < long_cb + RATE; i++) {
+    lanes_store(ROW(h->syst, i),
+                lanes_load(ROW(input, RATE * long_cb + NINPUTS * (i - long_cb))));
+    lanes_store(ROW(h->parity, i),
+                lanes_load(ROW(input, RATE * long_cb + NINPUTS * (i - long_cb) + 1)));
+  }
+
+  // Run MAP DEC #1
+  map_batch_dec(h->beta, h->syst, h->parity, h->llr1, long_cb);
+
+  // Prepare systematic and parity bits for MAP DEC #2
+  for (i = 0; i < long_cb; i++) {
+    lanes_store(ROW(h->syst, i), lanes_subs(lanes_load(ROW(h->llr1, forward[i])),
+                                            lanes_load(ROW(h->w, forward[i]))));
+    lanes_store(ROW(h->parity, i), lanes_load(ROW(input, RATE * i + 2)));
+  }
+  for (i = long_cb; i < long_cb + RATE; i++) {
+    lanes_store(ROW(h->syst, i),
+                lanes_load(ROW(input, RATE * long_cb + NINPUTS * RATE + NINPUTS * (i - long_cb))));
+    lanes_store(ROW(h->parity, i),
+                lanes_load(ROW(input, RATE * long_cb + NINPUTS * RATE + NINPUTS * (i - long_cb) + 1)));
+  }
+
+  // Run MAP DEC #2
+  map_batch_dec(h->beta, h->syst, h->parity, h->llr2, long_cb);
+
+  // Update a-priori LLR from the last iteration
+  for (i = 0; i < long_cb; i++) {
+    lanes_store(ROW(h->w, i), lanes_adds(lanes_load(ROW(h->w, i)),
+                                         lanes_subs(lanes_load(ROW(h->llr2, reverse[i])),
+                                                    lanes_load(ROW(h->llr1, i)))));
+  }
+}
+
+/* Loads the input of a code block into a lane and clears its a-priori LLRs */
+static void tdec_batch_load_lane(tdec_batch_t * h, uint32_t lane, int16_t *input,
+                                 uint32_t long_cb)
+{
+  uint32_t i;
+  for (i = 0; i < RATE * long_cb + TOTALTAIL; i++) {
+    h->input[i * NOF_LANES + lane] = input[i];
+  }
+  for (i = 0; i < long_cb; i++) {
+    h->w[i * NOF_LANES + lane] = 0;
+  }
+}
+
+/* Idle lanes decode an all-zero input */
+static void tdec_batch_clear_lane(tdec_batch_t * h, uint32_t lane, uint32_t long_cb)
+{
+  uint32_t i;
+  for (i = 0; i < RATE * long_cb + TOTALTAIL; i++) {
+    h->input[i * NOF_LANES + lane] = 0;
+  }
+  for (i = 0; i < long_cb; i++) {
+    h->w[i * NOF_LANES + lane] = 0;
+  }
+}
+
+static void tdec_batch_decision(tdec_batch_t * h, uint32_t lane, char *output,
+                                uint32_t long_cb)
+{
+  uint32_t i;
+  for (i = 0; i < long_cb; i++) {
+    output[i] = (h->llr2[h->interleaver.reverse[i] * NOF_LANES + lane] > 0) ? 1 : 0;
+  }
+}
+
+/* Lanes are refilled with the next pending code block as soon as the one they
+ * hold has finished, so code blocks that need fewer iterations do not hold the
+ * rest of the batch back.
+ */
+int tdec_run_batch(tdec_batch_t * h, int16_t **inputs, char **outputs, uint32_t nof_cb,
+                   uint32_t long_cb, uint32_t max_iterations, crc_t *crc,
+                   uint32_t *nof_iterations)
+{
+  int lane_cb[NOF_LANES];
+  uint32_t lane_iter[NOF_LANES];
+  uint32_t next_cb = 0;
+  uint32_t nof_active = 0;
+  uint32_t nof_ok = 0;
+  uint32_t lane;
+  bool done;
+
+  if (h             != NULL &&
+      inputs        != NULL &&
+      outputs       != NULL &&
+      long_cb       <= h->max_long_cb &&
+      max_iterations > 0)
+  {
+    if (tc_interl_LTE_gen(&h->interleaver, long_cb)) {
+      return -1;
+    }
+
+    for (lane = 0; lane < NOF_LANES; lane++) {
+      if (next_cb < nof_cb) {
+        tdec_batch_load_lane(h, lane, inputs[next_cb], long_cb);
+        lane_cb[lane] = next_cb++;
+        nof_active++;
+      } else {
+        tdec_batch_clear_lane(h, lane, long_cb);
+        lane_cb[lane] = -1;
+      }
+      lane_iter[lane] = 0;
+    }
+
+    while (nof_active > 0) {
+      tdec_batch_iteration(h, long_cb);
+
+      for (lane = 0; lane < NOF_LANES; lane++) {
+        if (lane_cb[lane] < 0) {
+          continue;
+        }
+        lane_iter[lane]++;
+        done = lane_iter[lane] >= max_iterations;
+        if (crc || done) {
+          tdec_batch_decision(h, lane, outputs[lane_cb[lane]], long_cb);
+        }
+        if (crc && !crc_checksum(crc, outputs[lane_cb[lane]], long_cb)) {
+          nof_ok++;
+          done = true;
+        }
+        if (done) {
+          if (nof_iterations) {
+            nof_iterations[lane_cb[lane]] = lane_iter[lane];
+          }
+          /* Mask the lane or refill it with the next code block */
+          if (next_cb < nof_cb) {
+            tdec_batch_load_lane(h, lane, inputs[next_cb], long_cb);
+            lane_cb[lane] = next_cb++;
+          } else {
+            lane_cb[lane] = -1;
+            nof_active--;
+          }
+          lane_iter[lane] = 0;
+        }
+      }
+    }
+    return crc ? nof_ok : nof_cb;
+  }
+  return -1;
+}
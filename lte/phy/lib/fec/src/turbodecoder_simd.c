@@ -0,0 +1,460 @@
+/**
+ *
+ * \section COPYRIGHT
+ *
+ * Copyright 2013-2014 The libLTE Developers. See the
+ * COPYRIGHT file at the top-level directory of this distribution.
+ *
+ * \section LICENSE
+ *
+ * This file is part of the libLTE library.
+ *
+ * libLTE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libLTE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * A copy of the GNU Lesser General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <strings.h>
+
+#include "liblte/phy/fec/turbodecoder_simd.h"
+#include "liblte/phy/utils/vector.h"
+#include "tdec_decision.h"
+
+#ifdef LV_HAVE_SSE
+#include <smmintrin.h>
+#endif
+
+static inline int16_t sat16(int32_t x) {
+  if (x > INT16_MAX) {
+    return INT16_MAX;
+  } else if (x < INT16_MIN) {
+    return INT16_MIN;
+  } else {
+    return (int16_t) x;
+  }
+}
+
+/************************************************
+ *
+ *  MAP_SIMD is the fixed-point MAX-LOG-MAP decoder. Branch metrics
+ *  and state transitions are the same as in map_gen.
+ *
+ ************************************************/
+#ifdef LV_HAVE_SSE
+
+/* Returns the maximum of the 8 signed 16-bit lanes of v */
+static inline int16_t hmax_epi16(__m128i v) {
+  __m128i t = _mm_sub_epi16(_mm_set1_epi16(INT16_MAX), v);
+  return INT16_MAX - (int16_t) _mm_extract_epi16(_mm_minpos_epu16(t), 0);
+}
+
+void map_simd_beta(map_simd_t * s, int16_t * input, int16_t * parity,
+                   uint32_t long_cb)
+{
+  int k;
+  uint32_t end = long_cb + RATE;
+  int16_t *beta = s->beta;
+  __m128i old, m_b, new, x, y, norm;
+
+  /* Source state of each branch: m_b from states 4..7, new from states 0..3 */
+  __m128i shuf_mb = _mm_setr_epi8(8, 9, 8, 9, 10, 11, 10, 11, 12, 13, 12, 13, 14, 15, 14, 15);
+  __m128i shuf_new = _mm_setr_epi8(0, 1, 0, 1, 2, 3, 2, 3, 4, 5, 4, 5, 6, 7, 6, 7);
+  __m128i shuf_norm = _mm_setr_epi8(0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1);
+
+  /* Lanes of m_b that add x and y. Lanes of new use the complement */
+  __m128i mask_x = _mm_setr_epi16(-1, 0, 0, -1, -1, 0, 0, -1);
+  __m128i mask_y = _mm_setr_epi16(-1, 0, -1, 0, 0, -1, 0, -1);
+
+  old = _mm_loadu_si128((__m128i*) &beta[8 * end]);
+
+  for (k = end - 1; k >= 0; k--) {
+    x = _mm_set1_epi16(input[k]);
+    y = _mm_set1_epi16(parity[k]);
+
+    m_b = _mm_adds_epi16(_mm_shuffle_epi8(old, shuf_mb),
+                         _mm_adds_epi16(_mm_and_si128(mask_x, x),
+                                        _mm_and_si128(mask_y, y)));
+    new = _mm_adds_epi16(_mm_shuffle_epi8(old, shuf_new),
+                         _mm_adds_epi16(_mm_andnot_si128(mask_x, x),
+                                        _mm_andnot_si128(mask_y, y)));
+
+    new = _mm_max_epi16(m_b, new);
+    norm = _mm_shuffle_epi8(new, shuf_norm);
+    old = _mm_subs_epi16(new, norm);
+
+    _mm_storeu_si128((__m128i*) &beta[8 * k], old);
+  }
+}
+
+void map_simd_alpha(map_simd_t * s, int16_t * input, int16_t * parity,
+                    int16_t * output, uint32_t long_cb)
+{
+  uint32_t k;
+  uint32_t end = long_cb;
+  int16_t *beta = s->beta;
+  __m128i old, m_b, new, x, y, b, norm;
+  int16_t m1, m0;
+
+  __m128i shuf_mb = _mm_setr_epi8(0, 1, 6, 7, 8, 9, 14, 15, 2, 3, 4, 5, 10, 11, 12, 13);
+  __m128i shuf_new = _mm_setr_epi8(2, 3, 4, 5, 10, 11, 12, 13, 0, 1, 6, 7, 8, 9, 14, 15);
+  __m128i shuf_norm = _mm_setr_epi8(0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1);
+
+  /* m_b only adds y on lanes 1,2,5,6. new adds x on all lanes and y on the rest */
+  __m128i mask_y = _mm_setr_epi16(0, -1, -1, 0, 0, -1, -1, 0);
+
+  old = _mm_setr_epi16(0, -TDEC_SIMD_INF, -TDEC_SIMD_INF, -TDEC_SIMD_INF,
+                       -TDEC_SIMD_INF, -TDEC_SIMD_INF, -TDEC_SIMD_INF, -TDEC_SIMD_INF);
+
+  for (k = 1; k < end + 1; k++) {
+    x = _mm_set1_epi16(input[k - 1]);
+    y = _mm_set1_epi16(parity[k - 1]);
+
+    m_b = _mm_adds_epi16(_mm_shuffle_epi8(old, shuf_mb),
+                         _mm_and_si128(mask_y, y));
+    new = _mm_adds_epi16(_mm_shuffle_epi8(old, shuf_new),
+                         _mm_adds_epi16(x, _mm_andnot_si128(mask_y, y)));
+
+    b = _mm_loadu_si128((__m128i*) &beta[8 * k]);
+    m0 = hmax_epi16(_mm_adds_epi16(m_b, b));
+    m1 = hmax_epi16(_mm_adds_epi16(new, b));
+
+    new = _mm_max_epi16(m_b, new);
+    norm = _mm_shuffle_epi8(new, shuf_norm);
+    old = _mm_subs_epi16(new, norm);
+
+    output[k - 1] = sat16((int32_t) m1 - m0);
+  }
+}
+
+#else
+
+void map_simd_beta(map_simd_t * s, int16_t * input, int16_t * parity,
+                   uint32_t long_cb)
+{
+  int16_t m_b[8], new[8], old[8];
+  int16_t x, y, xy;
+  int k;
+  uint32_t end = long_cb + RATE;
+  int16_t *beta = s->beta;
+  uint32_t i;
+
+  for (i = 0; i < 8; i++) {
+    old[i] = beta[8 * (end) + i];
+  }
+
+  for (k = end - 1; k >= 0; k--) {
+    x = input[k];
+    y = parity[k];
+
+    xy = sat16(x + y);
+
+    m_b[0] = sat16(old[4] + xy);
+    m_b[1] = old[4];
+    m_b[2] = sat16(old[5] + y);
+    m_b[3] = sat16(old[5] + x);
+    m_b[4] = sat16(old[6] + x);
+    m_b[5] = sat16(old[6] + y);
+    m_b[6] = old[7];
+    m_b[7] = sat16(old[7] + xy);
+
+    new[0] = old[0];
+    new[1] = sat16(old[0] + xy);
+    new[2] = sat16(old[1] + x);
+    new[3] = sat16(old[1] + y);
+    new[4] = sat16(old[2] + y);
+    new[5] = sat16(old[2] + x);
+    new[6] = sat16(old[3] + xy);
+    new[7] = old[3];
+
+    for (i = 0; i < 8; i++) {
+      if (m_b[i] > new[i])
+        new[i] = m_b[i];
+    }
+    for (i = 0; i < 8; i++) {
+      old[i] = sat16(new[i] - new[0]);
+      beta[8 * k + i] = old[i];
+    }
+  }
+}
+
+void map_simd_alpha(map_simd_t * s, int16_t * input, int16_t * parity,
+                    int16_t * output, uint32_t long_cb)
+{
+  int16_t m_b[8], new[8], old[8], max1[8], max0[8];
+  int16_t m1, m0;
+  int16_t x, y, xy;
+  uint32_t k;
+  uint32_t end = long_cb;
+  int16_t *beta = s->beta;
+  uint32_t i;
+
+  old[0] = 0;
+  for (i = 1; i < 8; i++) {
+    old[i] = -TDEC_SIMD_INF;
+  }
+
+  for (k = 1; k < end + 1; k++) {
+    x = input[k - 1];
+    y = parity[k - 1];
+
+    xy = sat16(x + y);
+
+    m_b[0] = old[0];
+    m_b[1] = sat16(old[3] + y);
+    m_b[2] = sat16(old[4] + y);
+    m_b[3] = old[7];
+    m_b[4] = old[1];
+    m_b[5] = sat16(old[2] + y);
+    m_b[6] = sat16(old[5] + y);
+    m_b[7] = old[6];
+
+    new[0] = sat16(old[1] + xy);
+    new[1] = sat16(old[2] + x);
+    new[2] = sat16(old[5] + x);
+    new[3] = sat16(old[6] + xy);
+    new[4] = sat16(old[0] + xy);
+    new[5] = sat16(old[3] + x);
+    new[6] = sat16(old[4] + x);
+    new[7] = sat16(old[7] + xy);
+
+    for (i = 0; i < 8; i++) {
+      max0[i] = sat16(m_b[i] + beta[8 * k + i]);
+      max1[i] = sat16(new[i] + beta[8 * k + i]);
+    }
+
+    m1 = max1[0];
+    m0 = max0[0];
+
+    for (i = 1; i < 8; i++) {
+      if (max1[i] > m1)
+        m1 = max1[i];
+      if (max0[i] > m0)
+        m0 = max0[i];
+    }
+
+    for (i = 0; i < 8; i++) {
+      if (m_b[i] > new[i])
+        new[i] = m_b[i];
+    }
+    for (i = 0; i < 8; i++) {
+      old[i] = sat16(new[i] - new[0]);
+    }
+
+    output[k - 1] = sat16((int32_t) m1 - m0);
+  }
+}
+
+#endif
+
+int map_simd_init(map_simd_t * h, int max_long_cb)
+{
+  bzero(h, sizeof(map_simd_t));
+  h->beta = vec_malloc(sizeof(int16_t) * (max_long_cb + TOTALTAIL + 1) * NUMSTATES);
+  if (!h->beta) {
+    perror("vec_malloc");
+    return -1;
+  }
+  h->max_long_cb = max_long_cb;
+  return 0;
+}
+
+void map_simd_free(map_simd_t * h)
+{
+  if (h->beta) {
+    free(h->beta);
+  }
+  bzero(h, sizeof(map_simd_t));
+}
+
+void map_simd_dec(map_simd_t * h, int16_t * input, int16_t * parity, int16_t * output,
+                  uint32_t long_cb)
+{
+  uint32_t k;
+
+  h->beta[(long_cb + TAIL) * NUMSTATES] = 0;
+  for (k = 1; k < NUMSTATES; k++)
+    h->beta[(long_cb + TAIL) * NUMSTATES + k] = -TDEC_SIMD_INF;
+
+  map_simd_beta(h, input, parity, long_cb);
+  map_simd_alpha(h, input, parity, output, long_cb);
+}
+
+/************************************************
+ *
+ *  TURBO DECODER INTERFACE
+ *
+ ************************************************/
+int tdec_simd_init(tdec_simd_t * h, uint32_t max_long_cb)
+{
+  int ret = -1;
+  bzero(h, sizeof(tdec_simd_t));
+  uint32_t len = max_long_cb + TOTALTAIL;
+
+  h->max_long_cb = max_long_cb;
+
+  h->llr1 = vec_malloc(sizeof(int16_t) * len);
+  if (!h->llr1) {
+    perror("vec_malloc");
+    goto clean_and_exit;
+  }
+  h->llr2 = vec_malloc(sizeof(int16_t) * len);
+  if (!h->llr2) {
+    perror("vec_malloc");
+    goto clean_and_exit;
+  }
+  h->w = vec_malloc(sizeof(int16_t) * len);
+  if (!h->w) {
+    perror("vec_malloc");
+    goto clean_and_exit;
+  }
+  h->syst = vec_malloc(sizeof(int16_t) * len);
+  if (!h->syst) {
+    perror("vec_malloc");
+    goto clean_and_exit;
+  }
+  h->parity = vec_malloc(sizeof(int16_t) * len);
+  if (!h->parity) {
+    perror("vec_malloc");
+    goto clean_and_exit;
+  }
+
+  if (map_simd_init(&h->dec, h->max_long_cb)) {
+    goto clean_and_exit;
+  }
+
+  if (tc_interl_init(&h->interleaver, h->max_long_cb) < 0) {
+    goto clean_and_exit;
+  }
+
+  ret = 0;
+clean_and_exit:if (ret == -1) {
+    tdec_simd_free(h);
+  }
+  return ret;
+}
+
+void tdec_simd_free(tdec_simd_t * h)
+{
+  if (h->llr1) {
+    free(h->llr1);
+  }
+  if (h->llr2) {
+    free(h->llr2);
+  }
+  if (h->w) {
+    free(h->w);
+  }
+  if (h->syst) {
+    free(h->syst);
+  }
+  if (h->parity) {
+    free(h->parity);
+  }
+
+  map_simd_free(&h->dec);
+
+  tc_interl_free(&h->interleaver);
+
+  bzero(h, sizeof(tdec_simd_t));
+}
+
+void tdec_simd_iteration(tdec_simd_t * h, int16_t * input, uint32_t long_cb)
+{
+  uint32_t i;
+
+  // Prepare systematic and parity bits for MAP DEC #1
+  for (i = 0; i < long_cb; i++) {
+    h->syst[i] = sat16(input[RATE * i] + h->w[i]);
+    h->parity[i] = input[RATE * i + 1];
+  }
+  for (i = long_cb; i < long_cb + RATE; i++) {
+    h->syst[i] = input[RATE * long_cb + NINPUTS * (i - long_cb)];
+    h->parity[i] = input[RATE * long_cb + NINPUTS * (i - long_cb) + 1];
+  }
+
+  // Run MAP DEC #1
+  map_simd_dec(&h->dec, h->syst, h->parity, h->llr1, long_cb);
+
+  // Prepare systematic and parity bits for MAP DEC #2
+  for (i = 0; i < long_cb; i++) {
+    h->syst[i] = sat16(h->llr1[h->interleaver.forward[i]]
+                       - h->w[h->interleaver.forward[i]]);
+    h->parity[i] = input[RATE * i + 2];
+  }
+  for (i = long_cb; i < long_cb + RATE; i++) {
+    h->syst[i] =
+      input[RATE * long_cb + NINPUTS * RATE + NINPUTS * (i - long_cb)];
+    h->parity[i] = input[RATE * long_cb + NINPUTS * RATE
+                         + NINPUTS * (i - long_cb) + 1];
+  }
+
+  // Run MAP DEC #2
+  map_simd_dec(&h->dec, h->syst, h->parity, h->llr2, long_cb);
+
+  // Update a-priori LLR from the last iteration
+  for (i = 0; i < long_cb; i++) {
+    h->w[i] = sat16(h->w[i] +
+                    sat16(h->llr2[h->interleaver.reverse[i]] - h->llr1[i]));
+  }
+}
+
+int tdec_simd_reset(tdec_simd_t * h, uint32_t long_cb)
+{
+  if (long_cb > h->max_long_cb) {
+    fprintf(stderr, "TDEC was initialized for max_long_cb=%d\n",
+            h->max_long_cb);
+    return -1;
+  }
+  memset(h->w, 0, sizeof(int16_t) * long_cb);
+  return tc_interl_LTE_gen(&h->interleaver, long_cb);
+}
+
+void tdec_simd_decision(tdec_simd_t * h, char *output, uint32_t long_cb)
+{
+  uint32_t i;
+  for (i = 0; i < long_cb; i++) {
+    output[i] = (h->llr2[h->interleaver.reverse[i]] > 0) ? 1 : 0;
+  }
+}
+
+static inline int llr16_positive(const void *llr, uint32_t idx)
+{
+  return ((const int16_t *) llr)[idx] > 0;
+}
+
+uint32_t tdec_simd_decision_crc(tdec_simd_t * h, uint8_t *output, uint32_t long_cb,
+                                uint32_t nof_filler, crc_t *crc)
+{
+  return tdec_pack_decision_crc(h->llr2, llr16_positive, h->interleaver.reverse,
+                                output, long_cb, nof_filler, crc);
+}
+
+void tdec_simd_run_all(tdec_simd_t * h, int16_t * input, char *output,
+                       uint32_t nof_iterations, uint32_t long_cb)
+{
+  uint32_t iter = 0;
+
+  tdec_simd_reset(h, long_cb);
+
+  do {
+    tdec_simd_iteration(h, input, long_cb);
+    iter++;
+  } while (iter < nof_iterations);
+
+  tdec_simd_decision(h, output, long_cb);
+}
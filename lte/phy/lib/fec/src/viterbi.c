@@ -40,10 +40,24 @@
 
 #define DEB 0
 
-int decode37(void *o, uint8_t *symbols, char *data, uint32_t frame_length) {
-  viterbi_t *q = o;
+/* Appends the first K-1 symbols to the end of the block, so that the tail-biting 
+ * trellis is decoded as if it started one constraint length before the block 
+ */
+static uint8_t *tail_biting_symbols(viterbi_t *q, uint8_t *symbols, uint32_t frame_length) {
   uint32_t i;
+  if (q->tail_biting) {
+    memcpy(q->tmp, symbols, 3 * frame_length * sizeof(char));
+    for (i = 0; i < 3 * (q->K - 1); i++) {
+      q->tmp[i + 3 * frame_length] = q->tmp[i];
+    }
+    return q->tmp;
+  } else {
+    return symbols;
+  }
+}
 
+int decode37(void *o, uint8_t *symbols, char *data, uint32_t frame_length) {
+  viterbi_t *q = o;
   uint32_t best_state;
 
   if (frame_length > q->framebits) {
@@ -56,17 +70,8 @@ int decode37(void *o, uint8_t *symbols, char *data, uint32_t frame_length) {
   init_viterbi37_port(q->ptr, q->tail_biting ? -1 : 0);
 
   /* Decode block */
-  if (q->tail_biting) {
-    memcpy(q->tmp, symbols, 3 * frame_length * sizeof(char));
-    for (i = 0; i < 3 * (q->K - 1); i++) {
-      q->tmp[i + 3 * frame_length] = q->tmp[i];
-    }
-  } else {
-    q->tmp = symbols;
-  }
-
-  update_viterbi37_blk_port(q->ptr, q->tmp, frame_length + q->K - 1,
-      q->tail_biting ? &best_state : NULL);
+  update_viterbi37_blk_port(q->ptr, tail_biting_symbols(q, symbols, frame_length), 
+      frame_length + q->K - 1, q->tail_biting ? &best_state : NULL);
 
   /* Do Viterbi chainback */
   chainback_viterbi37_port(q->ptr, data, frame_length,
@@ -75,6 +80,27 @@ int decode37(void *o, uint8_t *symbols, char *data, uint32_t frame_length) {
   return q->framebits;
 }
 
+int decode37_simd(void *o, uint8_t *symbols, char *data, uint32_t frame_length) {
+  viterbi_t *q = o;
+  uint32_t best_state;
+
+  if (frame_length > q->framebits) {
+    fprintf(stderr, "Initialized decoder for max frame length %d bits\n",
+        q->framebits);
+    return -1;
+  }
+
+  init_viterbi37_simd(q->ptr, q->tail_biting ? -1 : 0);
+
+  update_viterbi37_blk_simd(q->ptr, tail_biting_symbols(q, symbols, frame_length), 
+      frame_length + q->K - 1, q->tail_biting ? &best_state : NULL);
+
+  chainback_viterbi37_simd(q->ptr, data, frame_length,
+      q->tail_biting ? best_state : 0);
+
+  return q->framebits;
+}
+
 int decode39(void *o, uint8_t *symbols, char *data, uint32_t frame_length) {
   viterbi_t *q = o;
 
@@ -107,6 +133,17 @@ void free37(void *o) {
   delete_viterbi37_port(q->ptr);
 }
 
+void free37_simd(void *o) {
+  viterbi_t *q = o;
+  if (q->symbols_uc) {
+    free(q->symbols_uc);
+  }
+  if (q->tmp) {
+    free(q->tmp);
+  }
+  delete_viterbi37_simd(q->ptr);
+}
+
 void free39(void *o) {
   viterbi_t *q = o;
   if (q->symbols_uc) {
@@ -115,13 +152,14 @@ void free39(void *o) {
   delete_viterbi39_port(q->ptr);
 }
 
-int init37(viterbi_t *q, uint32_t poly[3], uint32_t framebits, bool tail_biting) {
+int init37(viterbi_t *q, uint32_t poly[3], uint32_t framebits, bool tail_biting, bool simd) {
   q->K = 7;
   q->R = 3;
   q->framebits = framebits;
   q->tail_biting = tail_biting;
-  q->decode = decode37;
-  q->free = free37;
+  q->decode = simd ? decode37_simd : decode37;
+  q->free = simd ? free37_simd : free37;
+  q->ptr = NULL;
   q->symbols_uc = malloc(3 * (q->framebits + q->K - 1) * sizeof(char));
   if (!q->symbols_uc) {
     perror("malloc");
@@ -131,16 +169,21 @@ int init37(viterbi_t *q, uint32_t poly[3], uint32_t framebits, bool tail_biting)
     q->tmp = malloc(3 * (q->framebits + q->K - 1) * sizeof(char));
     if (!q->tmp) {
       perror("malloc");
-      free37(q);
+      q->free(q);
       return -1;
     }
   } else {
     q->tmp = NULL;
   }
 
-  if ((q->ptr = create_viterbi37_port(poly, framebits)) == NULL) {
+  if (simd) {
+    q->ptr = create_viterbi37_simd(poly, framebits);
+  } else {
+    q->ptr = create_viterbi37_port(poly, framebits);
+  }
+  if (q->ptr == NULL) {
     fprintf(stderr, "create_viterbi37 failed\n");
-    free37(q);
+    q->free(q);
     return -1;
   } else {
     return 0;
@@ -177,7 +220,15 @@ int viterbi_init(viterbi_t *q, viterbi_type_t type, uint32_t poly[3],
     uint32_t max_frame_length, bool tail_bitting) {
   switch (type) {
   case viterbi_37:
-    return init37(q, poly, max_frame_length, tail_bitting);
+#ifdef LV_HAVE_SSE
+    return init37(q, poly, max_frame_length, tail_bitting, true);
+#else
+    return init37(q, poly, max_frame_length, tail_bitting, false);
+#endif
+  case viterbi_37_port:
+    return init37(q, poly, max_frame_length, tail_bitting, false);
+  case viterbi_37_simd:
+    return init37(q, poly, max_frame_length, tail_bitting, true);
   case viterbi_39:
     return init39(q, poly, max_frame_length, tail_bitting);
   default:
@@ -44,3 +44,21 @@ int update_viterbi37_blk_port(void *p,
                               unsigned char *syms, 
                               uint32_t nbits, 
                               uint32_t *best_state);
+
+void *create_viterbi37_simd(uint32_t polys[3], 
+                            uint32_t len);
+
+int init_viterbi37_simd(void *p, 
+                        uint32_t starting_state);
+
+int chainback_viterbi37_simd(void *p, 
+                             char *data, 
+                             uint32_t nbits, 
+                             uint32_t endstate);
+
+void delete_viterbi37_simd(void *p);
+
+int update_viterbi37_blk_simd(void *p, 
+                              unsigned char *syms, 
+                              uint32_t nbits, 
+                              uint32_t *best_state);
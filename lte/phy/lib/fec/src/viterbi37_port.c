@@ -18,10 +18,6 @@ typedef union {
   unsigned long w[2];
 } decision_t;
 
-static union {
-  unsigned char c[128];
-} Branchtab37[3];
-
 /* State info for instance of Viterbi decoder */
 struct v37 {
   metric_t metrics1; /* path metric buffer 1 */
@@ -29,6 +25,7 @@ struct v37 {
   decision_t *dp; /* Pointer to current decision */
   metric_t *old_metrics, *new_metrics; /* Pointers to path metrics, swapped on every bit */
   decision_t *decisions; /* Beginning of decisions for block */
+  unsigned char branchtab[3][32]; /* Branch metrics of this instance's polynomials */
 };
 
 /* Initialize Viterbi decoder for start of new frame */
@@ -50,15 +47,15 @@ int init_viterbi37_port(void *p, uint32_t starting_state) {
   return 0;
 }
 
-void set_viterbi37_polynomial_port(uint32_t polys[3]) {
+static void set_viterbi37_polynomial_port(struct v37 *vp, uint32_t polys[3]) {
   uint32_t state;
 
   for (state = 0; state < 32; state++) {
-    Branchtab37[0].c[state] =
+    vp->branchtab[0][state] =
         (polys[0] < 0) ^ parity((2 * state) & abs(polys[0])) ? 255 : 0;
-    Branchtab37[1].c[state] =
+    vp->branchtab[1][state] =
         (polys[1] < 0) ^ parity((2 * state) & abs(polys[1])) ? 255 : 0;
-    Branchtab37[2].c[state] =
+    vp->branchtab[2][state] =
         (polys[2] < 0) ^ parity((2 * state) & abs(polys[2])) ? 255 : 0;
   }
 }
@@ -67,8 +64,6 @@ void set_viterbi37_polynomial_port(uint32_t polys[3]) {
 void *create_viterbi37_port(uint32_t polys[3], uint32_t len) {
   struct v37 *vp;
 
-  set_viterbi37_polynomial_port(polys);
-
   if ((vp = (struct v37 *) malloc(sizeof(struct v37))) == NULL)
     return NULL ;
 
@@ -77,6 +72,7 @@ void *create_viterbi37_port(uint32_t polys[3], uint32_t len) {
     free(vp);
     return NULL ;
   }
+  set_viterbi37_polynomial_port(vp, polys);
   init_viterbi37_port(vp, 0);
 
   return vp;
@@ -128,8 +124,8 @@ void delete_viterbi37_port(void *p) {
 /* C-language butterfly */
 #define BFLY(i) {\
 unsigned int metric,m0,m1,decision;\
-    metric = (Branchtab37[0].c[i] ^ sym0) + (Branchtab37[1].c[i] ^ sym1) + \
-     (Branchtab37[2].c[i] ^ sym2);\
+    metric = (vp->branchtab[0][i] ^ sym0) + (vp->branchtab[1][i] ^ sym1) + \
+     (vp->branchtab[2][i] ^ sym2);\
     m0 = vp->old_metrics->w[i] + metric;\
     m1 = vp->old_metrics->w[i+32] + (765 - metric);\
     decision = (signed int)(m0-m1) > 0;\
@@ -0,0 +1,359 @@
+/**
+ *
+ * \section COPYRIGHT
+ *
+ * Copyright 2013-2014 The libLTE Developers. See the
+ * COPYRIGHT file at the top-level directory of this distribution.
+ *
+ * \section LICENSE
+ *
+ * This file is part of the libLTE library.
+ *
+ * libLTE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libLTE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * A copy of the GNU Lesser General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+/* K=7 r=1/3 Viterbi decoder with SSE/AVX2 16-bit path metrics.
+ *
+ * The 64 path metrics are kept in 16-bit lanes and renormalized after every bit by 
+ * subtracting the smallest one. Path metric differences never exceed 6 branches, 
+ * so no lane overflows and every decision is the same as in the 32-bit portable 
+ * decoder, which makes both decoders bit-exact. 
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "viterbi37.h"
+#include "parity.h"
+
+#ifdef LV_HAVE_SSE
+#include <smmintrin.h>
+#endif
+#ifdef LV_HAVE_AVX2
+#include <immintrin.h>
+#endif
+
+#define NOF_STATES 64
+
+/* Sum of the 3 branch metrics of the complementary branches */
+#define BRANCH_MAX 765
+
+typedef struct {
+  uint32_t w[2];
+} decision_simd_t;
+
+struct v37_simd {
+  int16_t metrics[NOF_STATES];
+  int16_t branchtab[3][NOF_STATES / 2];
+  decision_simd_t *dp;
+  decision_simd_t *decisions;
+};
+
+/* Initialize Viterbi decoder for start of new frame */
+int init_viterbi37_simd(void *p, uint32_t starting_state) {
+  struct v37_simd *vp = p;
+  uint32_t i;
+
+  if (p == NULL)
+    return -1;
+  for (i = 0; i < NOF_STATES; i++)
+    vp->metrics[i] = 63;
+  vp->dp = vp->decisions;
+  if (starting_state != -1) {
+    vp->metrics[starting_state & (NOF_STATES - 1)] = 0; /* Bias known start state */
+  }
+  return 0;
+}
+
+/* Branch tables are stored in each instance, so that decoders with different 
+ * polynomials can be used from different threads. 
+ */
+static void set_polynomial_simd(struct v37_simd *vp, uint32_t polys[3]) {
+  uint32_t state, i;
+  for (state = 0; state < NOF_STATES / 2; state++) {
+    for (i = 0; i < 3; i++) {
+      vp->branchtab[i][state] = parity((2 * state) & polys[i]) ? 255 : 0;
+    }
+  }
+}
+
+/* Create a new instance of a Viterbi decoder */
+void *create_viterbi37_simd(uint32_t polys[3], uint32_t len) {
+  struct v37_simd *vp;
+
+  if ((vp = (struct v37_simd *) malloc(sizeof(struct v37_simd))) == NULL)
+    return NULL;
+
+  if ((vp->decisions = malloc((len + 6) * sizeof(decision_simd_t))) == NULL) {
+    free(vp);
+    return NULL;
+  }
+  set_polynomial_simd(vp, polys);
+  init_viterbi37_simd(vp, 0);
+
+  return vp;
+}
+
+/* Viterbi chainback */
+int chainback_viterbi37_simd(void *p, char *data, uint32_t nbits, uint32_t endstate) {
+  struct v37_simd *vp = p;
+  decision_simd_t *d;
+  uint32_t k;
+
+  if (p == NULL)
+    return -1;
+
+  d = vp->decisions + 6; /* Look past tail */
+  endstate %= NOF_STATES;
+  while (nbits-- != 0) {
+    k = (d[nbits].w[endstate / 32] >> (endstate % 32)) & 1;
+    endstate = (endstate >> 1) | (k << 5);
+    data[nbits] = k;
+  }
+  return 0;
+}
+
+/* Delete instance of a Viterbi decoder */
+void delete_viterbi37_simd(void *p) {
+  struct v37_simd *vp = p;
+
+  if (vp != NULL) {
+    free(vp->decisions);
+    free(vp);
+  }
+}
+
+#ifdef LV_HAVE_AVX2
+
+/* Each step computes the butterflies of states i and i+32 for 16 values of i 
+ * at once. Unpacking works within 128-bit lanes, so the interleaved new metrics 
+ * and decisions are put back in state order with cross-lane permutes. 
+ */
+static void update_blk_avx2(struct v37_simd *vp, uint8_t *syms, uint32_t nbits) {
+  __m256i m[4], n[4], bt[3][2];
+  __m256i metric, inv, m0, m1, e, o, de, dodd, a, b, dec;
+  __m256i c765 = _mm256_set1_epi16(BRANCH_MAX);
+  __m256i s0, s1, s2;
+  __m128i mn;
+  decision_simd_t *d = vp->dp;
+  uint32_t i, g;
+
+  for (i = 0; i < 4; i++) {
+    m[i] = _mm256_loadu_si256((__m256i*) &vp->metrics[16 * i]);
+  }
+  for (i = 0; i < 3; i++) {
+    bt[i][0] = _mm256_loadu_si256((__m256i*) &vp->branchtab[i][0]);
+    bt[i][1] = _mm256_loadu_si256((__m256i*) &vp->branchtab[i][16]);
+  }
+
+  while (nbits--) {
+    s0 = _mm256_set1_epi16(*syms++);
+    s1 = _mm256_set1_epi16(*syms++);
+    s2 = _mm256_set1_epi16(*syms++);
+
+    for (g = 0; g < 2; g++) {
+      metric = _mm256_add_epi16(_mm256_add_epi16(_mm256_xor_si256(bt[0][g], s0),
+                                                 _mm256_xor_si256(bt[1][g], s1)),
+                                _mm256_xor_si256(bt[2][g], s2));
+      inv = _mm256_sub_epi16(c765, metric);
+
+      m0 = _mm256_add_epi16(m[g], metric);
+      m1 = _mm256_add_epi16(m[g + 2], inv);
+      e = _mm256_min_epi16(m0, m1);
+      de = _mm256_cmpgt_epi16(m0, m1);
+
+      m0 = _mm256_add_epi16(m[g], inv);
+      m1 = _mm256_add_epi16(m[g + 2], metric);
+      o = _mm256_min_epi16(m0, m1);
+      dodd = _mm256_cmpgt_epi16(m0, m1);
+
+      /* New states 2i and 2i+1 */
+      a = _mm256_unpacklo_epi16(e, o);
+      b = _mm256_unpackhi_epi16(e, o);
+      n[2 * g] = _mm256_permute2x128_si256(a, b, 0x20);
+      n[2 * g + 1] = _mm256_permute2x128_si256(a, b, 0x31);
+
+      a = _mm256_unpacklo_epi16(de, dodd);
+      b = _mm256_unpackhi_epi16(de, dodd);
+      dec = _mm256_packs_epi16(_mm256_permute2x128_si256(a, b, 0x20),
+                               _mm256_permute2x128_si256(a, b, 0x31));
+      dec = _mm256_permute4x64_epi64(dec, 0xD8);
+      d->w[g] = (uint32_t) _mm256_movemask_epi8(dec);
+    }
+    d++;
+
+    /* Renormalize */
+    a = _mm256_min_epi16(_mm256_min_epi16(n[0], n[1]), _mm256_min_epi16(n[2], n[3]));
+    mn = _mm_min_epu16(_mm256_castsi256_si128(a), _mm256_extracti128_si256(a, 1));
+    a = _mm256_broadcastw_epi16(_mm_minpos_epu16(mn));
+    for (i = 0; i < 4; i++) {
+      m[i] = _mm256_sub_epi16(n[i], a);
+    }
+  }
+
+  for (i = 0; i < 4; i++) {
+    _mm256_storeu_si256((__m256i*) &vp->metrics[16 * i], m[i]);
+  }
+  vp->dp = d;
+}
+
+#elif defined(LV_HAVE_SSE)
+
+/* Each step computes the butterflies of states i and i+32 for 8 values of i at once */
+static void update_blk_sse(struct v37_simd *vp, uint8_t *syms, uint32_t nbits) {
+  __m128i m[8], n[8];
+  __m128i metric, inv, m0, m1, e, o, de, dodd, dec;
+  __m128i c765 = _mm_set1_epi16(BRANCH_MAX);
+  __m128i s0, s1, s2, mn;
+  __m128i shuf_bcast = _mm_setr_epi8(0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1);
+  __m128i *bt0 = (__m128i*) vp->branchtab[0];
+  __m128i *bt1 = (__m128i*) vp->branchtab[1];
+  __m128i *bt2 = (__m128i*) vp->branchtab[2];
+  decision_simd_t *d = vp->dp;
+  uint32_t i, g;
+
+  for (i = 0; i < 8; i++) {
+    m[i] = _mm_loadu_si128((__m128i*) &vp->metrics[8 * i]);
+  }
+
+  while (nbits--) {
+    s0 = _mm_set1_epi16(*syms++);
+    s1 = _mm_set1_epi16(*syms++);
+    s2 = _mm_set1_epi16(*syms++);
+
+    for (g = 0; g < 4; g++) {
+      metric = _mm_add_epi16(_mm_add_epi16(_mm_xor_si128(_mm_loadu_si128(&bt0[g]), s0),
+                                           _mm_xor_si128(_mm_loadu_si128(&bt1[g]), s1)),
+                             _mm_xor_si128(_mm_loadu_si128(&bt2[g]), s2));
+      inv = _mm_sub_epi16(c765, metric);
+
+      m0 = _mm_add_epi16(m[g], metric);
+      m1 = _mm_add_epi16(m[g + 4], inv);
+      e = _mm_min_epi16(m0, m1);
+      de = _mm_cmpgt_epi16(m0, m1);
+
+      m0 = _mm_add_epi16(m[g], inv);
+      m1 = _mm_add_epi16(m[g + 4], metric);
+      o = _mm_min_epi16(m0, m1);
+      dodd = _mm_cmpgt_epi16(m0, m1);
+
+      /* New states 2i and 2i+1 */
+      n[2 * g] = _mm_unpacklo_epi16(e, o);
+      n[2 * g + 1] = _mm_unpackhi_epi16(e, o);
+
+      dec = _mm_packs_epi16(_mm_unpacklo_epi16(de, dodd), _mm_unpackhi_epi16(de, dodd));
+      if (g % 2) {
+        d->w[g / 2] |= (uint32_t) _mm_movemask_epi8(dec) << 16;
+      } else {
+        d->w[g / 2] = (uint32_t) _mm_movemask_epi8(dec);
+      }
+    }
+    d++;
+
+    /* Renormalize */
+    mn = _mm_min_epi16(_mm_min_epi16(_mm_min_epi16(n[0], n[1]), _mm_min_epi16(n[2], n[3])),
+                       _mm_min_epi16(_mm_min_epi16(n[4], n[5]), _mm_min_epi16(n[6], n[7])));
+    mn = _mm_shuffle_epi8(_mm_minpos_epu16(mn), shuf_bcast);
+    for (i = 0; i < 8; i++) {
+      m[i] = _mm_sub_epi16(n[i], mn);
+    }
+  }
+
+  for (i = 0; i < 8; i++) {
+    _mm_storeu_si128((__m128i*) &vp->metrics[8 * i], m[i]);
+  }
+  vp->dp = d;
+}
+
+#else
+
+/* Same butterflies and renormalization as the vector versions, one state at a time */
+static void update_blk_gen(struct v37_simd *vp, uint8_t *syms, uint32_t nbits) {
+  int16_t new[NOF_STATES];
+  int16_t metric, inv, m0, m1, mn;
+  decision_simd_t *d = vp->dp;
+  uint32_t i;
+
+  while (nbits--) {
+    d->w[0] = d->w[1] = 0;
+    for (i = 0; i < NOF_STATES / 2; i++) {
+      metric = (vp->branchtab[0][i] ^ syms[0]) + (vp->branchtab[1][i] ^ syms[1]) 
+             + (vp->branchtab[2][i] ^ syms[2]);
+      inv = BRANCH_MAX - metric;
+
+      m0 = vp->metrics[i] + metric;
+      m1 = vp->metrics[i + 32] + inv;
+      new[2 * i] = m0 > m1 ? m1 : m0;
+      d->w[i / 16] |= (uint32_t) (m0 > m1) << ((2 * i) % 32);
+
+      m0 = vp->metrics[i] + inv;
+      m1 = vp->metrics[i + 32] + metric;
+      new[2 * i + 1] = m0 > m1 ? m1 : m0;
+      d->w[i / 16] |= (uint32_t) (m0 > m1) << ((2 * i + 1) % 32);
+    }
+    syms += 3;
+    d++;
+
+    mn = new[0];
+    for (i = 1; i < NOF_STATES; i++) {
+      if (new[i] < mn) {
+        mn = new[i];
+      }
+    }
+    for (i = 0; i < NOF_STATES; i++) {
+      vp->metrics[i] = new[i] - mn;
+    }
+  }
+  vp->dp = d;
+}
+
+#endif
+
+/* Update decoder with a block of demodulated symbols
+ * Note that nbits is the number of decoded data bits, not the number
+ * of symbols!
+ */
+int update_viterbi37_blk_simd(void *p, uint8_t *syms, uint32_t nbits, uint32_t *best_state) {
+  struct v37_simd *vp = p;
+  uint32_t i, bst;
+  int16_t minmetric;
+
+  if (p == NULL)
+    return -1;
+
+#ifdef LV_HAVE_AVX2
+  update_blk_avx2(vp, syms, nbits);
+#elif defined(LV_HAVE_SSE)
+  update_blk_sse(vp, syms, nbits);
+#else
+  update_blk_gen(vp, syms, nbits);
+#endif
+
+  if (best_state) {
+    bst = 0;
+    minmetric = vp->metrics[0];
+    for (i = 1; i < NOF_STATES; i++) {
+      if (vp->metrics[i] < minmetric) {
+        bst = i;
+        minmetric = vp->metrics[i];
+      }
+    }
+    *best_state = bst;
+  }
+  return 0;
+}
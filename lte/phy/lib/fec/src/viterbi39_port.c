@@ -16,10 +16,6 @@ typedef union {
   unsigned long w[8];
 } decision_t;
 
-static union {
-  unsigned char c[128];
-} Branchtab39[3];
-
 /* State info for instance of Viterbi decoder */
 struct v39 {
   metric_t metrics1; /* path metric buffer 1 */
@@ -27,6 +23,7 @@ struct v39 {
   decision_t *dp; /* Pointer to current decision */
   metric_t *old_metrics, *new_metrics; /* Pointers to path metrics, swapped on every bit */
   decision_t *decisions; /* Beginning of decisions for block */
+  unsigned char branchtab[3][128]; /* Branch metrics of this instance's polynomials */
 };
 
 /* Initialize Viterbi decoder for start of new frame */
@@ -46,15 +43,15 @@ int init_viterbi39_port(void *p, uint32_t starting_state) {
   return 0;
 }
 
-void set_viterbi39_polynomial_port(uint32_t polys[3]) {
+static void set_viterbi39_polynomial_port(struct v39 *vp, uint32_t polys[3]) {
   uint32_t state;
 
   for (state = 0; state < 128; state++) {
-    Branchtab39[0].c[state] =
+    vp->branchtab[0][state] =
         (polys[0] < 0) ^ parity((2 * state) & abs(polys[0])) ? 255 : 0;
-    Branchtab39[1].c[state] =
+    vp->branchtab[1][state] =
         (polys[1] < 0) ^ parity((2 * state) & abs(polys[1])) ? 255 : 0;
-    Branchtab39[2].c[state] =
+    vp->branchtab[2][state] =
         (polys[2] < 0) ^ parity((2 * state) & abs(polys[2])) ? 255 : 0;
   }
 }
@@ -63,8 +60,6 @@ void set_viterbi39_polynomial_port(uint32_t polys[3]) {
 void *create_viterbi39_port(uint32_t polys[3], uint32_t len) {
   struct v39 *vp;
 
-  set_viterbi39_polynomial_port(polys);
-
   if ((vp = (struct v39 *) malloc(sizeof(struct v39))) == NULL)
     return NULL ;
 
@@ -73,6 +68,7 @@ void *create_viterbi39_port(uint32_t polys[3], uint32_t len) {
     free(vp);
     return NULL ;
   }
+  set_viterbi39_polynomial_port(vp, polys);
   init_viterbi39_port(vp, 0);
 
   return vp;
@@ -122,8 +118,8 @@ void delete_viterbi39_port(void *p) {
 /* C-language butterfly */
 #define BFLY(i) {\
 unsigned int metric,m0,m1,decision;\
-    metric = (Branchtab39[0].c[i] ^ sym0) + (Branchtab39[1].c[i] ^ sym1) + \
-     (Branchtab39[2].c[i] ^ sym2);\
+    metric = (vp->branchtab[0][i] ^ sym0) + (vp->branchtab[1][i] ^ sym1) + \
+     (vp->branchtab[2][i] ^ sym2);\
     m0 = vp->old_metrics->w[i] + metric;\
     m1 = vp->old_metrics->w[i+128] + (765 - metric);\
     decision = (signed int)(m0-m1) > 0;\
@@ -32,10 +32,14 @@
 #include <unistd.h>
 #include <math.h>
 #include <time.h>
+#include <sys/time.h>
 
 #include "liblte/phy/phy.h"
 #include "crc_test.h"
 
+#define NOF_ENGINES 2
+#define NOF_BENCH   1000
+
 int num_bits = 5001, crc_length = 24;
 unsigned int crc_poly = 0x1864CFB;
 unsigned int seed = 1;
@@ -71,9 +75,28 @@ void parse_args(int argc, char **argv) {
   }
 }
 
+/* Appends the packed bits in pieces of random whole bytes */
+uint32_t checksum_streaming(crc_t *h, uint8_t *data, int len) {
+  int n;
+  crc_reset(h);
+  while (len > 0) {
+    n = 8 * (rand() % 100);
+    if (n >= len) {
+      n = len;
+    }
+    crc_update_packed(h, data, n);
+    data += n / 8;
+    len -= n;
+  }
+  return crc_value(h);
+}
+
 int main(int argc, char **argv) {
-  int i;
+  int i, j, len, e;
+  const char *engine_names[NOF_ENGINES] = {"slice-by-8", "clmul"};
+  struct timeval t[3];
   char *data;
+  uint8_t *data_packed;
   unsigned int crc_word, expected_word;
   crc_t crc_p;
 
@@ -84,6 +107,11 @@ int main(int argc, char **argv) {
     perror("malloc");
     exit(-1);
   }
+  data_packed = malloc(sizeof(uint8_t) * ((num_bits + crc_length) / 8 + 1));
+  if (!data_packed) {
+    perror("malloc");
+    exit(-1);
+  }
 
   if (!seed) {
     seed = time(NULL);
@@ -103,7 +131,65 @@ int main(int argc, char **argv) {
   // generate CRC word
   crc_word = crc_checksum(&crc_p, data, num_bits);
 
+  // the packed CRC of every engine must match for every length
+  for (e = 0; e < NOF_ENGINES; e++) {
+    if (crc_set_engine(&crc_p, e)) {
+      printf("CRC engine %s not available\n", engine_names[e]);
+      continue;
+    }
+    for (i = 0; i <= num_bits; i++) {
+      bit_pack_vector(data, data_packed, i);
+      if (crc_checksum_packed(&crc_p, data_packed, i) != crc_checksum(&crc_p, data, i)) {
+        fprintf(stderr, "Packed CRC mismatch for %d bits with %s\n", i, engine_names[e]);
+        exit(-1);
+      }
+      if (checksum_streaming(&crc_p, data_packed, i) != crc_checksum_packed(&crc_p, data_packed, i)) {
+        fprintf(stderr, "Incremental CRC mismatch for %d bits with %s\n", i, engine_names[e]);
+        exit(-1);
+      }
+    }
+  }
+  
+  // throughput of the unpacked and packed checksums
+  bit_pack_vector(data, data_packed, num_bits);
+  gettimeofday(&t[1], NULL);
+  for (i = 0; i < NOF_BENCH; i++) {
+    crc_word = crc_checksum(&crc_p, data, num_bits);
+  }
+  gettimeofday(&t[2], NULL);
+  get_time_interval(t);
+  printf("unpacked: %.1f Mbps\n", 
+      (double) NOF_BENCH * num_bits / (t[0].tv_sec * 1e6 + t[0].tv_usec));
+  for (e = 0; e < NOF_ENGINES; e++) {
+    if (crc_set_engine(&crc_p, e)) {
+      continue;
+    }
+    gettimeofday(&t[1], NULL);
+    for (i = 0; i < NOF_BENCH; i++) {
+      crc_word = crc_checksum_packed(&crc_p, data_packed, num_bits);
+    }
+    gettimeofday(&t[2], NULL);
+    get_time_interval(t);
+    printf("%s: %.1f Mbps\n", engine_names[e], 
+        (double) NOF_BENCH * num_bits / (t[0].tv_sec * 1e6 + t[0].tv_usec));
+  }
+
+  // attaching the CRC to packed bits must give the same bits, at every alignment
+  for (i = 0; i < 8 && i <= num_bits; i++) {
+    len = num_bits - i;
+    bit_pack_vector(data, data_packed, len);
+    crc_attach(&crc_p, data, len);
+    crc_attach_packed(&crc_p, data_packed, len);
+    for (j = 0; j < len + crc_length; j++) {
+      if (((data_packed[j / 8] >> (7 - j % 8)) & 1) != data[j]) {
+        fprintf(stderr, "Packed CRC attach mismatch at bit %d for %d bits\n", j, len);
+        exit(-1);
+      }
+    }
+  }
+
   free(data);
+  free(data_packed);
 
   // check if generated word is as expected
   if (get_expected_word(num_bits, crc_length, crc_poly, seed,
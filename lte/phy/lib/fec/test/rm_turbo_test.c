@@ -38,14 +38,18 @@
 
 int nof_tx_bits = -1, nof_rx_bits = -1;
 int rv_idx = 0;
+int N_cb = 0;
+int soft_bits = 0;
+bool skip_rv0 = false;
 
 void usage(char *prog) {
-  printf("Usage: %s -t nof_tx_bits -r nof_rx_bits [-i rv_idx]\n", prog);
+  printf("Usage: %s -t nof_tx_bits -r nof_rx_bits [-i rv_idx] [-c N_cb] [-q soft buffer bits (16 or 8)]\n", prog);
+  printf("\t-f receive rv_idx only, as if rv_idx=0 was missed [Default receive both]\n");
 }
 
 void parse_args(int argc, char **argv) {
   int opt;
-  while ((opt = getopt(argc, argv, "tri")) != -1) {
+  while ((opt = getopt(argc, argv, "tricqf")) != -1) {
     switch (opt) {
     case 't':
       nof_tx_bits = atoi(argv[optind]);
@@ -56,6 +60,15 @@ void parse_args(int argc, char **argv) {
     case 'i':
       rv_idx = atoi(argv[optind]);
       break;
+    case 'c':
+      N_cb = atoi(argv[optind]);
+      break;
+    case 'q':
+      soft_bits = atoi(argv[optind]);
+      break;
+    case 'f':
+      skip_rv0 = true;
+      break;
     default:
       usage(argv[0]);
       exit(-1);
@@ -71,10 +84,196 @@ void parse_args(int argc, char **argv) {
   }
 }
 
+#define NCOLS 32
+
+static uint8_t RM_PERM_TC_GOLD[NCOLS] = { 0, 16, 8, 24, 4, 20, 12, 28, 2, 18, 10, 26,
+    6, 22, 14, 30, 1, 17, 9, 25, 5, 21, 13, 29, 3, 19, 11, 27, 7, 23, 15, 31 };
+
+/* Reference rate matcher, walking the circular buffer bit by bit. The library
+ * applies precomputed index plans instead and must produce the same output.
+ */
+static int rm_turbo_tx_gold(char *w_buff, uint32_t w_buff_len, char *input, uint32_t in_len, char *output,
+    uint32_t out_len, uint32_t rv_idx, uint32_t N_cb_lim) {
+
+  int ndummy, kidx;
+  int nrows, K_p;
+
+  int i, j, k, s, N_cb, k0;
+
+  nrows = (uint32_t) (in_len / 3 - 1) / NCOLS + 1;
+  K_p = nrows * NCOLS;
+  if (3 * K_p > w_buff_len) {
+    fprintf(stderr,
+        "Input too large. Max input length including dummy bits is %d (3x%dx32, in_len %d)\n",
+        w_buff_len, nrows, in_len);
+    return -1;
+  }
+
+  ndummy = K_p - in_len / 3;
+  if (ndummy < 0) {
+    ndummy = 0;
+  }
+
+  if (rv_idx == 0) {
+    /* Sub-block interleaver (5.1.4.1.1) and bit collection */
+    k = 0;
+    for (s = 0; s < 2; s++) {
+      for (j = 0; j < NCOLS; j++) {
+        for (i = 0; i < nrows; i++) {
+          if (s == 0) {
+            kidx = k % K_p;
+          } else {
+            kidx = K_p + 2 * (k % K_p);
+          }
+          if (i * NCOLS + RM_PERM_TC_GOLD[j] < ndummy) {
+            w_buff[kidx] = TX_NULL;
+          } else {
+            w_buff[kidx] = input[(i * NCOLS + RM_PERM_TC_GOLD[j] - ndummy) * 3 + s];
+          }
+          k++;
+        }
+      }
+    }
+
+    // d_k^(2) goes through special permutation
+    for (k = 0; k < K_p; k++) {
+      kidx = (RM_PERM_TC_GOLD[k / nrows] + NCOLS * (k % nrows) + 1) % K_p;
+      if ((kidx - ndummy) < 0) {
+        w_buff[K_p + 2 * k + 1] = TX_NULL;
+      } else {
+        w_buff[K_p + 2 * k + 1] = input[3 * (kidx - ndummy) + 2];
+      }
+    }
+  }
+
+  /* Bit selection and transmission 5.1.4.1.2 */
+  N_cb = 3 * K_p;
+  if (N_cb_lim && N_cb_lim < N_cb) {
+    N_cb = N_cb_lim;
+  }
+
+  k0 = nrows
+      * (2 * (uint32_t) ceilf((float) N_cb / (float) (8 * nrows)) * rv_idx + 2);
+  k = 0;
+  j = 0;
+
+  while (k < out_len) {
+    if (w_buff[(k0 + j) % N_cb] != TX_NULL) {
+      output[k] = w_buff[(k0 + j) % N_cb];
+      k++;
+    }
+    j++;
+  }
+  return 0;
+}
+
+static int rm_turbo_rx_gold(float *w_buff, uint32_t w_buff_len, float *input, uint32_t in_len, float *output,
+    uint32_t out_len, uint32_t rv_idx, uint32_t N_cb_lim) {
+
+  int nrows, ndummy, K_p, k0, N_cb, jp, kidx;
+  int i, j, k;
+  int d_i, d_j;
+  bool isdummy;
+
+  nrows = (uint32_t) (out_len / 3 - 1) / NCOLS + 1;
+  K_p = nrows * NCOLS;
+  if (3 * K_p > w_buff_len) {
+    fprintf(stderr,
+        "Input too large. Max output length including dummy bits is %d (3x%dx32, in_len %d)\n",
+        w_buff_len, nrows, out_len);
+    return -1;
+  }
+
+  ndummy = K_p - out_len / 3;
+  if (ndummy < 0) {
+    ndummy = 0;
+  }
+
+  if (rv_idx == 0) {
+    for (i = 0; i < 3 * K_p; i++) {
+      w_buff[i] = RX_NULL;
+    }    
+  }
+
+  /* Undo bit collection. Account for dummy bits */
+  N_cb = 3 * K_p;
+  if (N_cb_lim && N_cb_lim < N_cb) {
+    N_cb = N_cb_lim;
+  }
+  k0 = nrows
+      * (2 * (uint32_t) ceilf((float) N_cb / (float) (8 * nrows)) * rv_idx + 2);
+
+  k = 0;
+  j = 0;
+  while (k < in_len) {
+    jp = (k0 + j) % N_cb;
+
+    if (jp < K_p || !(jp % 2)) {
+      if (jp >= K_p) {
+        d_i = ((jp - K_p) / 2) / nrows;
+        d_j = ((jp - K_p) / 2) % nrows;
+      } else {
+        d_i = jp / nrows;
+        d_j = jp % nrows;
+      }
+      if (d_j * NCOLS + RM_PERM_TC_GOLD[d_i] >= ndummy) {
+        isdummy = false;
+      } else {
+        isdummy = true;
+      }
+    } else {
+      uint32_t jpp = (jp - K_p - 1) / 2;
+      kidx = (RM_PERM_TC_GOLD[jpp / nrows] + NCOLS * (jpp % nrows) + 1) % K_p;
+      if ((kidx - ndummy) < 0) {
+        isdummy = true;
+      } else {
+        isdummy = false;
+      }
+    }
+
+    if (!isdummy) {
+      if (w_buff[jp] == RX_NULL) {
+        w_buff[jp] = input[k];
+      } else if (input[k] != RX_NULL) {
+        w_buff[jp] += input[k]; /* soft combine LLRs */
+      }
+      k++;
+    }
+    j++;
+  }
+
+  /* interleaving and bit selection */
+  for (i = 0; i < out_len / 3; i++) {
+    d_i = (i + ndummy) / NCOLS;
+    d_j = (i + ndummy) % NCOLS;
+    for (j = 0; j < 3; j++) {
+      if (j != 2) {
+        kidx = K_p * j + (j + 1) * (RM_PERM_TC_GOLD[d_j] * nrows + d_i);
+      } else {
+        k = (i + ndummy - 1) % K_p;
+        if (k < 0)
+          k += K_p;
+        kidx = (k / NCOLS + nrows * RM_PERM_TC_GOLD[k % NCOLS]) % K_p;
+        kidx = 2 * kidx + K_p + 1;
+      }
+      if (w_buff[kidx] != RX_NULL) {
+        output[i * 3 + j] = w_buff[kidx];
+      } else {
+        output[i * 3 + j] = 0;
+      }
+    }
+  }
+  return 0;
+}
+
 int main(int argc, char **argv) {
-  int i;
-  char *bits, *rm_bits, *w_buff_c;
-  float *rm_symbols, *unrm_symbols, *w_buff_f;
+  int i, n, rv, ret;
+  float scale = 0;
+  int16_t *w_buff_s;
+  int8_t *w_buff_b;
+  char *bits, *rm_bits, *w_buff_c, *rm_bits_gold, *w_buff_c_gold, *w_buff_p;
+  uint8_t *bits_packed, *rm_bits_packed;
+  float *rm_symbols, *unrm_symbols, *w_buff_f, *unrm_symbols_gold, *w_buff_f_gold;
   int nof_errors;
 
   parse_args(argc, argv);
@@ -100,7 +299,7 @@ int main(int argc, char **argv) {
     exit(-1);
   }
   w_buff_f = malloc(sizeof(float) * nof_rx_bits * 10);
-  if (!w_buff_c) {
+  if (!w_buff_f) {
     perror("malloc");
     exit(-1);
   }
@@ -110,18 +309,99 @@ int main(int argc, char **argv) {
     exit(-1);
   }
 
+  rm_bits_gold = malloc(sizeof(char) * nof_rx_bits);
+  w_buff_c_gold = malloc(sizeof(char) * nof_tx_bits * 10);
+  unrm_symbols_gold = malloc(sizeof(float) * nof_tx_bits);
+  w_buff_f_gold = malloc(sizeof(float) * nof_rx_bits * 10);
+  w_buff_s = malloc(sizeof(int16_t) * nof_tx_bits * 2);
+  w_buff_b = malloc(sizeof(int8_t) * nof_tx_bits * 2);
+  w_buff_p = malloc(sizeof(char) * nof_tx_bits * 10);
+  bits_packed = malloc(sizeof(uint8_t) * (nof_tx_bits + 7) / 8);
+  rm_bits_packed = malloc(sizeof(uint8_t) * (nof_rx_bits + 7) / 8);
+  if (!rm_bits_gold || !w_buff_c_gold || !unrm_symbols_gold || !w_buff_f_gold || 
+      !w_buff_s || !w_buff_b || !w_buff_p || !bits_packed || !rm_bits_packed) {
+    perror("malloc");
+    exit(-1);
+  }
+
   for (i = 0; i < nof_tx_bits; i++) {
     bits[i] = rand() % 2;
   }
+  bit_pack_vector(bits, bits_packed, nof_tx_bits);
 
-  rm_turbo_tx(w_buff_c, nof_tx_bits * 10, bits, nof_tx_bits, rm_bits, nof_rx_bits, rv_idx);
-
-  for (i = 0; i < nof_rx_bits; i++) {
-    rm_symbols[i] = (float) rm_bits[i] ? 1 : -1;
+  /* Nothing received yet: stale soft buffers must not leak into the first reception */
+  bzero(w_buff_f, sizeof(float) * nof_rx_bits * 10);
+  for (i = 0; i < nof_rx_bits * 10; i++) {
+    w_buff_f_gold[i] = RX_NULL;
   }
+  memset(w_buff_s, 0x55, sizeof(int16_t) * nof_tx_bits * 2);
+  memset(w_buff_b, 0x55, sizeof(int8_t) * nof_tx_bits * 2);
 
-  rm_turbo_rx(w_buff_f, nof_rx_bits * 10, rm_symbols, nof_rx_bits, unrm_symbols, nof_tx_bits,
-      rv_idx);
+  /* Transmit rv_idx=0 first, which fills the circular buffer other redundancy
+   * versions are read from, and soft-combine it with rv_idx at the receiver */
+  for (n = 0; n < (rv_idx ? 2 : 1); n++) {
+    rv = n ? rv_idx : 0;
+    if (rm_turbo_tx_lim(w_buff_c, nof_tx_bits * 10, bits, nof_tx_bits, rm_bits, nof_rx_bits, 
+        rv, N_cb)) {
+      fprintf(stderr, "Error in rate matching\n");
+      exit(-1);
+    }
+    rm_turbo_tx_gold(w_buff_c_gold, nof_tx_bits * 10, bits, nof_tx_bits, rm_bits_gold,
+        nof_rx_bits, rv, N_cb);
+    if (memcmp(rm_bits, rm_bits_gold, nof_rx_bits)) {
+      printf("rv_idx=%d: rate matching output differs from the reference\n", rv);
+      exit(-1);
+    }
+    if (rm_turbo_tx_packed(w_buff_p, nof_tx_bits * 10, bits_packed, nof_tx_bits, rm_bits_packed, 
+        nof_rx_bits, rv, N_cb)) {
+      fprintf(stderr, "Error in packed rate matching\n");
+      exit(-1);
+    }
+    for (i = 0; i < nof_rx_bits; i++) {
+      if (((rm_bits_packed[i / 8] >> (7 - i % 8)) & 1) != rm_bits[i]) {
+        printf("rv_idx=%d: packed rate matching output differs at bit %d\n", rv, i);
+        exit(-1);
+      }
+    }
+
+    if (skip_rv0 && rv_idx && n == 0) {
+      continue;
+    }
+
+    for (i = 0; i < nof_rx_bits; i++) {
+      rm_symbols[i] = (float) rm_bits[i] ? 1 : -1;
+    }
+
+    switch (soft_bits) {
+    case 16:
+      ret = rm_turbo_rx_s(w_buff_s, nof_tx_bits * 2, rm_symbols, nof_rx_bits, unrm_symbols,
+          nof_tx_bits, rv, N_cb, &scale);
+      break;
+    case 8:
+      ret = rm_turbo_rx_b(w_buff_b, nof_tx_bits * 2, rm_symbols, nof_rx_bits, unrm_symbols,
+          nof_tx_bits, rv, N_cb, &scale);
+      break;
+    default:
+      ret = rm_turbo_rx_lim(w_buff_f, nof_rx_bits * 10, rm_symbols, nof_rx_bits, unrm_symbols,
+          nof_tx_bits, rv, N_cb);
+      scale = 0;
+    }
+    if (ret) {
+      fprintf(stderr, "Error in rate unmatching\n");
+      exit(-1);
+    }
+    rm_turbo_rx_gold(w_buff_f_gold, nof_rx_bits * 10, rm_symbols, nof_rx_bits,
+        unrm_symbols_gold, nof_tx_bits, rv, N_cb);
+    /* The compressed soft buffers are off by at most half a step per transmission */
+    for (i = 0; i < nof_tx_bits; i++) {
+      if (isnan(unrm_symbols[i]) || 
+          fabsf(unrm_symbols[i] - unrm_symbols_gold[i]) > (scale ? (n + 1) * 0.5 / scale : 0)) {
+        printf("rv_idx=%d: rate unmatching output %d differs from the reference (%f != %f)\n", 
+            rv, i, unrm_symbols[i], unrm_symbols_gold[i]);
+        exit(-1);
+      }
+    }
+  }
 
   nof_errors = 0;
   for (i = 0; i < nof_tx_bits; i++) {
@@ -134,6 +414,17 @@ int main(int argc, char **argv) {
   free(rm_bits);
   free(rm_symbols);
   free(unrm_symbols);
+  free(w_buff_c);
+  free(w_buff_f);
+  free(rm_bits_gold);
+  free(w_buff_c_gold);
+  free(unrm_symbols_gold);
+  free(w_buff_f_gold);
+  free(w_buff_s);
+  free(w_buff_b);
+  free(w_buff_p);
+  free(bits_packed);
+  free(rm_bits_packed);
 
   if (nof_errors) {
     printf("nof_errors=%d\n", nof_errors);
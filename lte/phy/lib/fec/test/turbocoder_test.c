@@ -50,6 +50,17 @@ int K = -1;
 int nof_iterations = MAX_ITERATIONS;
 int test_known_data = 0;
 int test_errors = 0;
+int test_fixed_point = 0;
+uint32_t window = 0;
+uint32_t nof_subblocks = 1;
+
+/* Scaling of the float LLRs before quantizing them for the fixed-point decoder */
+#define LLR_FIXED_SCALE 8.0
+
+/* Extra errors allowed with a sliding window or sub-blocks, as a fraction of
+ * the expected ones, since they may flip a few decisions */
+#define WINDOW_ERRORS_MARGIN   20
+#define SUBBLOCK_ERRORS_MARGIN 10
 
 #define SNR_POINTS      8
 #define SNR_MIN         0.0
@@ -64,12 +75,15 @@ void usage(char *prog) {
   printf("\t-l frame_length [Default %d]\n", frame_length);
   printf("\t-e ebno in dB [Default scan]\n");
   printf("\t-t test: check errors on exit [Default disabled]\n");
+  printf("\t-q test: check fixed-point decoder is bit-exact with the float decoder [Default disabled]\n");
+  printf("\t-w sliding window size [Default %d=whole block]\n", window);
+  printf("\t-p nof_subblocks decoded in parallel [Default %d]\n", nof_subblocks);
   printf("\t-s seed [Default 0=time]\n");
 }
 
 void parse_args(int argc, char **argv) {
   int opt;
-  while ((opt = getopt(argc, argv, "inlstvekt")) != -1) {
+  while ((opt = getopt(argc, argv, "inlstvektqwp")) != -1) {
     switch (opt) {
     case 'n':
       nof_frames = atoi(argv[optind]);
@@ -80,6 +94,15 @@ void parse_args(int argc, char **argv) {
     case 't':
       test_errors = 1;
       break;
+    case 'q':
+      test_fixed_point = 1;
+      break;
+    case 'w':
+      window = atoi(argv[optind]);
+      break;
+    case 'p':
+      nof_subblocks = atoi(argv[optind]);
+      break;
     case 'i':
       nof_iterations = atoi(argv[optind]);
       break;
@@ -131,16 +154,22 @@ int main(int argc, char **argv) {
   float *llr;
   unsigned char *llr_c;
   char *data_tx, *data_rx, *symbols;
-  uint32_t i, j;
+  uint8_t *data_packed, *symbols_packed;
+  uint32_t i, j, n;
   float var[SNR_POINTS];
   uint32_t snr_points;
   float ber[MAX_ITERATIONS][SNR_POINTS];
   uint32_t errors[100];
   uint32_t coded_length;
   struct timeval tdata[3];
-  float mean_usec;
+  float mean_usec, mean_usec_simd;
   tdec_t tdec;
   tcod_t tcod;
+  tdec_t tdec_q;
+  tdec_simd_t tdec_simd;
+  int16_t *llr_s = NULL;
+  float *llr_q = NULL;
+  thread_pool_t pool;
 
   parse_args(argc, argv);
 
@@ -189,6 +218,12 @@ int main(int argc, char **argv) {
     perror("malloc");
     exit(-1);
   }
+  data_packed = malloc(frame_length / 8 * sizeof(uint8_t));
+  symbols_packed = malloc((coded_length + 7) / 8 * sizeof(uint8_t));
+  if (!data_packed || !symbols_packed) {
+    perror("malloc");
+    exit(-1);
+  }
 
   if (tcod_init(&tcod, frame_length)) {
     fprintf(stderr, "Error initiating Turbo coder\n");
@@ -199,6 +234,35 @@ int main(int argc, char **argv) {
     fprintf(stderr, "Error initiating Turbo decoder\n");
     exit(-1);
   }
+  if (tdec_set_window(&tdec, window)) {
+    fprintf(stderr, "Error setting Turbo decoder window\n");
+    exit(-1);
+  }
+  if (thread_pool_init(&pool, nof_subblocks)) {
+    fprintf(stderr, "Error initiating thread pool\n");
+    exit(-1);
+  }
+
+  if (test_fixed_point) {
+    llr_s = malloc(coded_length * sizeof(int16_t));
+    if (!llr_s) {
+      perror("malloc");
+      exit(-1);
+    }
+    llr_q = malloc(coded_length * sizeof(float));
+    if (!llr_q) {
+      perror("malloc");
+      exit(-1);
+    }
+    if (tdec_init(&tdec_q, frame_length)) {
+      fprintf(stderr, "Error initiating Turbo decoder\n");
+      exit(-1);
+    }
+    if (tdec_simd_init(&tdec_simd, frame_length)) {
+      fprintf(stderr, "Error initiating fixed-point Turbo decoder\n");
+      exit(-1);
+    }
+  }
 
   float ebno_inc, esno_db;
   ebno_inc = (SNR_MAX - SNR_MIN) / SNR_POINTS;
@@ -216,6 +280,7 @@ int main(int argc, char **argv) {
   }
   for (i = 0; i < snr_points; i++) {
     mean_usec = 0;
+    mean_usec_simd = 0;
     frame_cnt = 0;
     bzero(errors, sizeof(int) * MAX_ITERATIONS);
     while (frame_cnt < nof_frames) {
@@ -236,6 +301,19 @@ int main(int argc, char **argv) {
         }
       } else {
         tcod_encode(&tcod, data_tx, symbols, frame_length);
+
+        /* the packed encoder must give the same bits */
+        bit_pack_vector(data_tx, data_packed, frame_length);
+        if (tcod_encode_packed(&tcod, data_packed, symbols_packed, frame_length)) {
+          fprintf(stderr, "Error encoding packed bits\n");
+          exit(-1);
+        }
+        for (j = 0; j < coded_length; j++) {
+          if (((symbols_packed[j / 8] >> (7 - j % 8)) & 1) != symbols[j]) {
+            fprintf(stderr, "Packed encoder output differs at bit %d\n", j);
+            exit(-1);
+          }
+        }
       }
 
       for (j = 0; j < coded_length; j++) {
@@ -247,6 +325,16 @@ int main(int argc, char **argv) {
       /* decoder */
       tdec_reset(&tdec, frame_length);
 
+      /* The reference float decoder runs on the same quantized LLRs */
+      if (test_fixed_point) {
+        vec_convert_fi(llr, llr_s, LLR_FIXED_SCALE, coded_length);
+        for (j = 0; j < coded_length; j++) {
+          llr_q[j] = (float) llr_s[j];
+        }
+        tdec_reset(&tdec_q, frame_length);
+        tdec_simd_reset(&tdec_simd, frame_length);
+      }
+
       uint32_t t;
       if (nof_iterations == -1) {
         t = MAX_ITERATIONS;
@@ -257,7 +345,14 @@ int main(int argc, char **argv) {
 
         if (!j)
           gettimeofday(&tdata[1], NULL); // Only measure 1 iteration
-        tdec_iteration(&tdec, llr, frame_length);
+        if (nof_subblocks > 1) {
+          if (tdec_iteration_par(&tdec, llr, frame_length, nof_subblocks, &pool)) {
+            fprintf(stderr, "Error decoding sub-blocks\n");
+            exit(-1);
+          }
+        } else {
+          tdec_iteration(&tdec, llr, frame_length);
+        }
         tdec_decision(&tdec, data_rx, frame_length);
         if (!j)
           gettimeofday(&tdata[2], NULL);
@@ -266,6 +361,28 @@ int main(int argc, char **argv) {
         if (!j)
           mean_usec = (float) mean_usec * 0.9 + (float) tdata[0].tv_usec * 0.1;
 
+        if (test_fixed_point) {
+          tdec_iteration(&tdec_q, llr_q, frame_length);
+
+          if (!j)
+            gettimeofday(&tdata[1], NULL);
+          tdec_simd_iteration(&tdec_simd, llr_s, frame_length);
+          if (!j)
+            gettimeofday(&tdata[2], NULL);
+          if (!j)
+            get_time_interval(tdata);
+          if (!j)
+            mean_usec_simd = (float) mean_usec_simd * 0.9 + (float) tdata[0].tv_usec * 0.1;
+
+          for (n = 0; n < frame_length; n++) {
+            if (tdec_q.llr2[n] != (float) tdec_simd.llr2[n]) {
+              fprintf(stderr, "Fixed-point decoder mismatch at frame %d, iteration %d, bit %d: %g != %d\n",
+                  frame_cnt, j + 1, n, tdec_q.llr2[n], tdec_simd.llr2[n]);
+              exit(-1);
+            }
+          }
+        }
+
         /* check errors */
         errors[j] += bit_diff(data_tx, data_rx, frame_length);
         if (j < MAX_ITERATIONS) {
@@ -278,6 +395,10 @@ int main(int argc, char **argv) {
       printf("BER: %.2e  ", (float) errors[j - 1] / (frame_cnt * frame_length));
       printf("%3.1f Mbps (%6.2f usec)", (float) frame_length / mean_usec,
           mean_usec);
+      if (test_fixed_point) {
+        printf(" fixed-point: %3.1f Mbps (%6.2f usec)",
+            (float) frame_length / mean_usec_simd, mean_usec_simd);
+      }
       printf("\r");
 
     }
@@ -300,12 +421,16 @@ int main(int argc, char **argv) {
           printf("BER: %g\t%u errors\n",
               (float) errors[j] / (frame_cnt * frame_length), errors[j]);
           if (test_errors) {
-            if (errors[j]
-                > get_expected_errors(frame_cnt, seed, j + 1, frame_length,
-                    ebno_db)) {
+            int expected = get_expected_errors(frame_cnt, seed, j + 1,
+                frame_length, ebno_db);
+            if (nof_subblocks > 1) {
+              expected += expected / SUBBLOCK_ERRORS_MARGIN + 1;
+            } else if (window) {
+              expected += expected / WINDOW_ERRORS_MARGIN + 1;
+            }
+            if (errors[j] > expected) {
               fprintf(stderr, "Expected %d errors but got %d\n",
-                  get_expected_errors(frame_cnt, seed, j + 1, frame_length,
-                      ebno_db), errors[j]);
+                  expected, errors[j]);
               exit(-1);
             } else {
               printf("Iter %d ok\n", j + 1);
@@ -321,9 +446,19 @@ int main(int argc, char **argv) {
   free(llr);
   free(llr_c);
   free(data_rx);
+  free(data_packed);
+  free(symbols_packed);
 
   tdec_free(&tdec);
   tcod_free(&tcod);
+  thread_pool_free(&pool);
+
+  if (test_fixed_point) {
+    free(llr_s);
+    free(llr_q);
+    tdec_free(&tdec_q);
+    tdec_simd_free(&tdec_simd);
+  }
 
   printf("\n");
   output_matlab(ber, snr_points);
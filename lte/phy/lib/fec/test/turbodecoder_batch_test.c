@@ -0,0 +1,243 @@
+/**
+ *
+ * \section COPYRIGHT
+ *
+ * Copyright 2013-2014 The libLTE Developers. See the
+ * COPYRIGHT file at the top-level directory of this distribution.
+ *
+ * \section LICENSE
+ *
+ * This file is part of the libLTE library.
+ *
+ * libLTE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libLTE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * A copy of the GNU Lesser General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <math.h>
+#include <time.h>
+
+#include <sys/time.h>
+#include "liblte/phy/phy.h"
+
+uint32_t frame_length = 1024, nof_frames = 20, nof_cb = 21;
+float ebno_db = 1.0;
+uint32_t seed = 0;
+uint32_t max_iterations = 8;
+
+/* Scaling of the float LLRs before quantizing them for the fixed-point decoder */
+#define LLR_FIXED_SCALE 8.0
+
+void usage(char *prog) {
+  printf("Usage: %s [nclies]\n", prog);
+  printf("\t-n nof_frames [Default %d]\n", nof_frames);
+  printf("\t-c nof_cb per frame [Default %d]\n", nof_cb);
+  printf("\t-l frame_length [Default %d]\n", frame_length);
+  printf("\t-i max_iterations [Default %d]\n", max_iterations);
+  printf("\t-e ebno in dB [Default %.1f]\n", ebno_db);
+  printf("\t-s seed [Default 0=time]\n");
+}
+
+void parse_args(int argc, char **argv) {
+  int opt;
+  while ((opt = getopt(argc, argv, "ncliesv")) != -1) {
+    switch (opt) {
+    case 'n':
+      nof_frames = atoi(argv[optind]);
+      break;
+    case 'c':
+      nof_cb = atoi(argv[optind]);
+      break;
+    case 'l':
+      frame_length = atoi(argv[optind]);
+      break;
+    case 'i':
+      max_iterations = atoi(argv[optind]);
+      break;
+    case 'e':
+      ebno_db = atof(argv[optind]);
+      break;
+    case 's':
+      seed = (unsigned int) strtoul(argv[optind], NULL, 0);
+      break;
+    case 'v':
+      verbose++;
+      break;
+    default:
+      usage(argv[0]);
+      exit(-1);
+    }
+  }
+}
+
+/* Checks that every code block decoded in the batch is bit-exact with
+ * decoding it alone with tdec_simd for the same number of iterations.
+ */
+int main(int argc, char **argv) {
+  uint32_t frame_cnt, i, j, it;
+  uint32_t coded_length;
+  char *data_tx, *symbols, *data_rx;
+  float *llr;
+  int16_t **llr_s;
+  char **outputs;
+  uint32_t *iterations;
+  tcod_t tcod;
+  tdec_simd_t tdec_simd;
+  tdec_batch_t tdec_batch;
+  crc_t crc;
+  float var, esno_db;
+  int nof_ok;
+  uint32_t total_ok = 0, total_iterations = 0;
+  struct timeval tdata[3];
+  double usec_batch = 0, usec_simd = 0;
+
+  parse_args(argc, argv);
+
+  if (!seed) {
+    seed = time(NULL);
+  }
+  srand(seed);
+
+  frame_length = lte_cb_size(lte_find_cb_index(frame_length));
+  coded_length = 3 * frame_length + TOTALTAIL;
+
+  esno_db = ebno_db + 10 * log10((double) 1 / 3);
+  var = sqrt(1 / (pow(10, esno_db / 10)));
+
+  data_tx = malloc(sizeof(char) * frame_length);
+  data_rx = malloc(sizeof(char) * frame_length);
+  symbols = malloc(sizeof(char) * coded_length);
+  llr = malloc(sizeof(float) * coded_length);
+  llr_s = malloc(sizeof(int16_t*) * nof_cb);
+  outputs = malloc(sizeof(char*) * nof_cb);
+  iterations = malloc(sizeof(uint32_t) * nof_cb);
+  if (!data_tx || !data_rx || !symbols || !llr || !llr_s || !outputs || !iterations) {
+    perror("malloc");
+    exit(-1);
+  }
+  for (i = 0; i < nof_cb; i++) {
+    llr_s[i] = malloc(sizeof(int16_t) * coded_length);
+    outputs[i] = malloc(sizeof(char) * frame_length);
+    if (!llr_s[i] || !outputs[i]) {
+      perror("malloc");
+      exit(-1);
+    }
+  }
+
+  if (tcod_init(&tcod, frame_length)) {
+    fprintf(stderr, "Error initiating Turbo coder\n");
+    exit(-1);
+  }
+  if (tdec_simd_init(&tdec_simd, frame_length)) {
+    fprintf(stderr, "Error initiating fixed-point Turbo decoder\n");
+    exit(-1);
+  }
+  if (tdec_batch_init(&tdec_batch, frame_length)) {
+    fprintf(stderr, "Error initiating batch Turbo decoder\n");
+    exit(-1);
+  }
+  if (crc_init(&crc, LTE_CRC24B, 24)) {
+    fprintf(stderr, "Error initiating CRC\n");
+    exit(-1);
+  }
+
+  printf("  Frame length: %d, %d code blocks per frame, %d lanes\n", frame_length,
+      nof_cb, tdec_batch_nof_lanes(&tdec_batch));
+
+  for (frame_cnt = 0; frame_cnt < nof_frames; frame_cnt++) {
+    for (i = 0; i < nof_cb; i++) {
+      for (j = 0; j < frame_length - 24; j++) {
+        data_tx[j] = rand() % 2;
+      }
+      crc_attach(&crc, data_tx, frame_length - 24);
+      tcod_encode(&tcod, data_tx, symbols, frame_length);
+      for (j = 0; j < coded_length; j++) {
+        llr[j] = symbols[j] ? sqrt(2) : -sqrt(2);
+      }
+      ch_awgn_f(llr, llr, var, coded_length);
+      vec_convert_fi(llr, llr_s[i], LLR_FIXED_SCALE, coded_length);
+    }
+
+    gettimeofday(&tdata[1], NULL);
+    nof_ok = tdec_run_batch(&tdec_batch, llr_s, outputs, nof_cb, frame_length,
+        max_iterations, &crc, iterations);
+    gettimeofday(&tdata[2], NULL);
+    get_time_interval(tdata);
+    usec_batch += tdata[0].tv_sec * 1e6 + tdata[0].tv_usec;
+
+    if (nof_ok < 0) {
+      fprintf(stderr, "Error decoding batch\n");
+      exit(-1);
+    }
+    total_ok += nof_ok;
+
+    for (i = 0; i < nof_cb; i++) {
+      gettimeofday(&tdata[1], NULL);
+      tdec_simd_reset(&tdec_simd, frame_length);
+      it = 0;
+      do {
+        tdec_simd_iteration(&tdec_simd, llr_s[i], frame_length);
+        tdec_simd_decision(&tdec_simd, data_rx, frame_length);
+        it++;
+      } while (it < max_iterations && crc_checksum(&crc, data_rx, frame_length));
+      gettimeofday(&tdata[2], NULL);
+      get_time_interval(tdata);
+      usec_simd += tdata[0].tv_sec * 1e6 + tdata[0].tv_usec;
+
+      if (it != iterations[i]) {
+        fprintf(stderr, "Frame %d, code block %d: batch run %d iterations, expected %d\n",
+            frame_cnt, i, iterations[i], it);
+        exit(-1);
+      }
+      for (j = 0; j < frame_length; j++) {
+        if (data_rx[j] != outputs[i][j]) {
+          fprintf(stderr, "Frame %d, code block %d: batch decoder mismatch at bit %d\n",
+              frame_cnt, i, j);
+          exit(-1);
+        }
+      }
+      total_iterations += iterations[i];
+    }
+  }
+
+  printf("  %d/%d code blocks ok, %.2f iterations on average\n", total_ok,
+      nof_frames * nof_cb, (float) total_iterations / (nof_frames * nof_cb));
+  printf("  Batch: %.1f Mbps, sequential: %.1f Mbps\n",
+      (double) nof_frames * nof_cb * frame_length / usec_batch,
+      (double) nof_frames * nof_cb * frame_length / usec_simd);
+
+  for (i = 0; i < nof_cb; i++) {
+    free(llr_s[i]);
+    free(outputs[i]);
+  }
+  free(llr_s);
+  free(outputs);
+  free(iterations);
+  free(data_tx);
+  free(data_rx);
+  free(symbols);
+  free(llr);
+
+  tcod_free(&tcod);
+  tdec_simd_free(&tdec_simd);
+  tdec_batch_free(&tdec_batch);
+
+  printf("Ok\n");
+  exit(0);
+}
@@ -131,6 +131,8 @@ int main(int argc, char **argv) {
   unsigned int errors[NTYPES];
   viterbi_type_t viterbi_type[NCODS];
   viterbi_t dec[NCODS];
+  viterbi_t dec_port[NCODS];
+  char *data_port;
   convcoder_t cod[NCODS];
   int coded_length[NCODS];
   int n, ncods, max_coded_length;
@@ -192,6 +194,9 @@ int main(int argc, char **argv) {
       max_coded_length = coded_length[i];
     }
     viterbi_init(&dec[i], viterbi_type[i], cod[i].poly, frame_length, cod[i].tail_biting);
+    if (viterbi_type[i] == viterbi_37) {
+      viterbi_init(&dec_port[i], viterbi_37_port, cod[i].poly, frame_length, cod[i].tail_biting);
+    }
     printf("Convolutional Code 1/3 K=%d Tail bitting: %s\n", cod[i].K, cod[i].tail_biting ? "yes" : "no");
   }
 
@@ -214,6 +219,12 @@ int main(int argc, char **argv) {
     }
   }
 
+  data_port = malloc(frame_length * sizeof(char));
+  if (!data_port) {
+    perror("malloc");
+    exit(-1);
+  }
+
   symbols = malloc(max_coded_length * sizeof(char));
   if (!symbols) {
     perror("malloc");
@@ -283,6 +294,16 @@ int main(int argc, char **argv) {
 
         /* decoder 1 */
         viterbi_decode_uc(&dec[n], llr_c, data_rx[1+n], frame_length);
+
+        /* The K=7 SIMD decoder must be bit-exact with the portable one */
+        if (viterbi_type[n] == viterbi_37) {
+          viterbi_decode_uc(&dec_port[n], llr_c, data_port, frame_length);
+          if (memcmp(data_port, data_rx[1+n], frame_length)) {
+            fprintf(stderr, "\nFrame %d: K=7 decoder output differs from the portable decoder\n", 
+                frame_cnt);
+            exit(-1);
+          }
+        }
       }
 
       /* check errors */
@@ -313,9 +334,13 @@ int main(int argc, char **argv) {
   }
   for (n=0;n<ncods;n++) {
     viterbi_free(&dec[n]);
+    if (viterbi_type[n] == viterbi_37) {
+      viterbi_free(&dec_port[n]);
+    }
   }
 
   free(data_tx);
+  free(data_port);
   free(symbols);
   free(llr);
   free(llr_c);
@@ -25,55 +25,109 @@
  *
  */
 
+
 #include <stdio.h>
 #include <assert.h>
 #include <complex.h>
 #include <string.h>
 #include <math.h>
+#include <float.h>
 
 #include "liblte/phy/common/phy_common.h"
 #include "liblte/phy/mimo/precoding.h"
 #include "liblte/phy/utils/vector.h"
 
+#ifdef LV_HAVE_SSE
+#include <smmintrin.h>
+
+/* Product of the two complex numbers in each half of a and b */
+static inline __m128 cmul_sse(__m128 a, __m128 b) {
+  __m128 br = _mm_moveldup_ps(b);
+  __m128 bi = _mm_movehdup_ps(b);
+  __m128 as = _mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1));
+  return _mm_addsub_ps(_mm_mul_ps(a, br), _mm_mul_ps(as, bi));
+}
+
+/* Loads *lo in the lower half and *hi in the upper half */
+static inline __m128 load_2c_sse(cf_t *lo, cf_t *hi) {
+  return _mm_loadh_pi(_mm_castpd_ps(_mm_load_sd((double*) lo)), (__m64*) hi);
+}
+#endif
+
+/* Position in the resource grid of the j-th symbol */
+#define RE_POS(re_idx, j) ((re_idx) ? (re_idx)[j] : (uint32_t) (j))
+
 int precoding_single(cf_t *x, cf_t *y, int nof_symbols) {
   memcpy(y, x, nof_symbols * sizeof(cf_t));
   return nof_symbols;
 }
+
 int precoding_diversity(cf_t *x[MAX_LAYERS], cf_t *y[MAX_PORTS], int nof_ports,
     int nof_symbols) {
-  int i;
+  int i = 0;
+  float s = (float) M_SQRT1_2;
+#ifdef LV_HAVE_SSE
+  __m128 scale = _mm_set1_ps(s);
+  /* -conj() of the lower half and conj() of the upper half */
+  __m128 mask = _mm_setr_ps(-0.0f, 0.0f, 0.0f, -0.0f);
+  __m128 a, b;
+#endif
   if (nof_ports == 2) {
-    /* FIXME: Use VOLK here */
-    for (i = 0; i < nof_symbols; i++) {
-      y[0][2 * i] = x[0][i] / sqrtf(2);
-      y[1][2 * i] = -conjf(x[1][i]) / sqrtf(2);
-      y[0][2 * i + 1] = x[1][i] / sqrtf(2);
-      y[1][2 * i + 1] = conjf(x[0][i]) / sqrtf(2);
+#ifdef LV_HAVE_SSE
+    for (; i < nof_symbols - 1; i += 2) {
+      a = _mm_mul_ps(_mm_loadu_ps((float*) &x[0][i]), scale);
+      b = _mm_mul_ps(_mm_loadu_ps((float*) &x[1][i]), scale);
+      _mm_storeu_ps((float*) &y[0][2 * i], _mm_movelh_ps(a, b));
+      _mm_storeu_ps((float*) &y[0][2 * i + 2], _mm_movehl_ps(b, a));
+      _mm_storeu_ps((float*) &y[1][2 * i], _mm_xor_ps(_mm_movelh_ps(b, a), mask));
+      _mm_storeu_ps((float*) &y[1][2 * i + 2], _mm_xor_ps(_mm_movehl_ps(a, b), mask));
+    }
+#endif
+    for (; i < nof_symbols; i++) {
+      y[0][2 * i] = x[0][i] * s;
+      y[1][2 * i] = -conjf(x[1][i]) * s;
+      y[0][2 * i + 1] = x[1][i] * s;
+      y[1][2 * i + 1] = conjf(x[0][i]) * s;
     }
     return 2 * i;
   } else if (nof_ports == 4) {
-    //int m_ap = (nof_symbols%4)?(nof_symbols*4-2):nof_symbols*4;
-    int m_ap = 4 * nof_symbols;
-    for (i = 0; i < m_ap / 4; i++) {
-      y[0][4 * i] = x[0][i] / sqrtf(2);
+#ifdef LV_HAVE_SSE
+    __m128 zero = _mm_setzero_ps();
+    for (; i < nof_symbols; i++) {
+      a = _mm_mul_ps(load_2c_sse(&x[0][i], &x[1][i]), scale);
+      b = _mm_mul_ps(load_2c_sse(&x[2][i], &x[3][i]), scale);
+      _mm_storeu_ps((float*) &y[0][4 * i], a);
+      _mm_storeu_ps((float*) &y[0][4 * i + 2], zero);
+      _mm_storeu_ps((float*) &y[1][4 * i], zero);
+      _mm_storeu_ps((float*) &y[1][4 * i + 2], b);
+      _mm_storeu_ps((float*) &y[2][4 * i], 
+          _mm_xor_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(1, 0, 3, 2)), mask));
+      _mm_storeu_ps((float*) &y[2][4 * i + 2], zero);
+      _mm_storeu_ps((float*) &y[3][4 * i], zero);
+      _mm_storeu_ps((float*) &y[3][4 * i + 2], 
+          _mm_xor_ps(_mm_shuffle_ps(b, b, _MM_SHUFFLE(1, 0, 3, 2)), mask));
+    }
+#endif
+    for (; i < nof_symbols; i++) {
+      y[0][4 * i] = x[0][i] * s;
       y[1][4 * i] = 0;
-      y[2][4 * i] = -conjf(x[1][i]) / sqrtf(2);
+      y[2][4 * i] = -conjf(x[1][i]) * s;
       y[3][4 * i] = 0;
 
-      y[0][4 * i + 1] = x[1][i] / sqrtf(2);
+      y[0][4 * i + 1] = x[1][i] * s;
       y[1][4 * i + 1] = 0;
-      y[2][4 * i + 1] = conjf(x[0][i]) / sqrtf(2);
+      y[2][4 * i + 1] = conjf(x[0][i]) * s;
       y[3][4 * i + 1] = 0;
 
       y[0][4 * i + 2] = 0;
-      y[1][4 * i + 2] = x[2][i] / sqrtf(2);
+      y[1][4 * i + 2] = x[2][i] * s;
       y[2][4 * i + 2] = 0;
-      y[3][4 * i + 2] = -conjf(x[3][i]) / sqrtf(2);
+      y[3][4 * i + 2] = -conjf(x[3][i]) * s;
 
       y[0][4 * i + 3] = 0;
-      y[1][4 * i + 3] = x[3][i] / sqrtf(2);
+      y[1][4 * i + 3] = x[3][i] * s;
       y[2][4 * i + 3] = 0;
-      y[3][4 * i + 3] = conjf(x[2][i]) / sqrtf(2);
+      y[3][4 * i + 3] = conjf(x[2][i]) * s;
     }
     return 4 * i;
   } else {
@@ -122,67 +176,178 @@ int precoding_type(cf_t *x[MAX_LAYERS], cf_t *y[MAX_PORTS], int nof_layers,
   return 0;
 }
 
-/* ZF detector */
-int predecoding_single_zf(cf_t *y, cf_t *ce, cf_t *x, int nof_symbols) {
-  for (int i=0;i<nof_symbols;i++) {
-    if (ce[i] == 0) {
-      ce[i] = 0.01;
-    }
+#ifdef LV_HAVE_SSE
+/* Equalizes the symbols y[k0] and y[k1] received in one RE each. noise is the
+ * noise variance, 0 for the ZF estimate.
+ */
+static inline void single_decode_re2(cf_t *y, cf_t *ce, uint32_t k0, uint32_t k1,
+    float noise, float snr_scale, cf_t *x, float *snr) {
+  __m128 conj = _mm_setr_ps(0.0f, -0.0f, 0.0f, -0.0f);
+  __m128 r = load_2c_sse(&y[k0], &y[k1]);
+  __m128 h = load_2c_sse(&ce[k0], &ce[k1]);
+  __m128 p = _mm_mul_ps(h, h);
+  __m128 hh = _mm_add_ps(p, _mm_shuffle_ps(p, p, _MM_SHUFFLE(2, 3, 0, 1)));
+  __m128 den = _mm_max_ps(_mm_add_ps(hh, _mm_set1_ps(noise)), _mm_set1_ps(FLT_MIN));
+  _mm_storeu_ps((float*) x, _mm_div_ps(cmul_sse(r, _mm_xor_ps(h, conj)), den));
+  if (snr) {
+    hh = _mm_mul_ps(hh, _mm_set1_ps(snr_scale));
+    snr[0] = _mm_cvtss_f32(hh);
+    snr[1] = _mm_cvtss_f32(_mm_movehl_ps(hh, hh));
+  }
+}
+#endif
+
+static inline void single_decode_re(cf_t *y, cf_t *ce, uint32_t k,
+    float noise, float snr_scale, cf_t *x, float *snr) {
+  cf_t h = ce[k];
+  float hh = crealf(h) * crealf(h) + cimagf(h) * cimagf(h);
+  *x = y[k] * conjf(h) / fmaxf(hh + noise, FLT_MIN);
+  if (snr) {
+    *snr = hh * snr_scale;
+  }
+}
+
+/* Alamouti combining of the symbols y[k0] and y[k1] sent from two ports with
+ * channels h0[k0] and h1[k0]. The result is scaled by sqrt(2)/(|h0|^2+|h1|^2+2*noise),
+ * which gives the ZF estimate if noise is 0 and the MMSE one otherwise.
+ */
+static inline void sfbc_decode_pair(cf_t *y, cf_t *h0, cf_t *h1, uint32_t k0, uint32_t k1,
+    float noise, float snr_scale, cf_t *x0, cf_t *x1, float *snr) {
+#ifdef LV_HAVE_SSE
+  __m128 conj = _mm_setr_ps(0.0f, -0.0f, 0.0f, -0.0f);
+  __m128 neg_hi = _mm_setr_ps(0.0f, 0.0f, -0.0f, -0.0f);
+  __m128 r = load_2c_sse(&y[k0], &y[k1]);
+  __m128 rs = _mm_shuffle_ps(r, r, _MM_SHUFFLE(1, 0, 3, 2));
+  __m128 a = load_2c_sse(&h0[k0], &h0[k0]);
+  __m128 b = load_2c_sse(&h1[k0], &h1[k0]);
+  /* [x0 | x1] = conj(h0) * [r0 | r1] + [h1 | -h1] * conj([r1 | r0]) */
+  __m128 z = _mm_add_ps(cmul_sse(r, _mm_xor_ps(a, conj)),
+                        cmul_sse(_mm_xor_ps(b, neg_hi), _mm_xor_ps(rs, conj)));
+  __m128 p = _mm_add_ps(_mm_mul_ps(a, a), _mm_mul_ps(b, b));
+  __m128 hh = _mm_add_ps(p, _mm_shuffle_ps(p, p, _MM_SHUFFLE(2, 3, 0, 1)));
+  __m128 den = _mm_max_ps(_mm_add_ps(hh, _mm_set1_ps(2 * noise)), _mm_set1_ps(FLT_MIN));
+  z = _mm_div_ps(_mm_mul_ps(z, _mm_set1_ps((float) M_SQRT2)), den);
+  _mm_storel_pi((__m64*) x0, z);
+  _mm_storeh_pi((__m64*) x1, z);
+  if (snr) {
+    snr[0] = _mm_cvtss_f32(hh) * snr_scale;
+    snr[1] = snr[0];
+  }
+#else
+  cf_t r0 = y[k0], r1 = y[k1], a = h0[k0], b = h1[k0];
+  float hh = crealf(a) * crealf(a) + cimagf(a) * cimagf(a)
+      + crealf(b) * crealf(b) + cimagf(b) * cimagf(b);
+  float den = fmaxf(hh + 2 * noise, FLT_MIN);
+  *x0 = (conjf(a) * r0 + b * conjf(r1)) * (float) M_SQRT2 / den;
+  *x1 = (conjf(a) * r1 - b * conjf(r0)) * (float) M_SQRT2 / den;
+  if (snr) {
+    snr[0] = hh * snr_scale;
+    snr[1] = snr[0];
+  }
+#endif
+}
+
+/* Single antenna detector. Reads y and ce at the positions re_idx, or the first
+ * nof_symbols if it is NULL.
+ */
+static int predecoding_single_gen(cf_t *y, cf_t *ce, uint32_t *re_idx, cf_t *x,
+    float *snr, float noise_estimate, int nof_symbols) {
+  int i = 0;
+  float snr_scale = noise_estimate > 0 ? 1 / noise_estimate : 1;
+#ifdef LV_HAVE_SSE
+  for (; i < nof_symbols - 1; i += 2) {
+    single_decode_re2(y, ce, RE_POS(re_idx, i), RE_POS(re_idx, i + 1), noise_estimate,
+        snr_scale, &x[i], snr ? &snr[i] : NULL);
+  }
+#endif
+  for (; i < nof_symbols; i++) {
+    single_decode_re(y, ce, RE_POS(re_idx, i), noise_estimate, snr_scale, &x[i],
+        snr ? &snr[i] : NULL);
   }
-  vec_div_ccc(y, ce, x, nof_symbols);
   return nof_symbols;
 }
 
-/* ZF detector */
-int predecoding_diversity_zf(cf_t *y, cf_t *ce[MAX_PORTS], cf_t *x[MAX_LAYERS],
-    int nof_ports, int nof_symbols) {
-  int i;
-  cf_t h0, h1, h2, h3, r0, r1, r2, r3;
-  float hh, hh02, hh13;
+/* Transmit diversity detector. The symbols of each layer are written to x or, if
+ * it is NULL, already layer-demapped to d. snr is in the order of d.
+ * Returns the number of symbols per layer.
+ */
+static int predecoding_diversity_gen(cf_t *y, cf_t *ce[MAX_PORTS], uint32_t *re_idx,
+    cf_t *x[MAX_LAYERS], cf_t *d, float *snr, float noise_estimate, int nof_ports,
+    int nof_symbols) {
+  int i, m_ap;
+  float snr_scale = noise_estimate > 0 ? 1 / (2 * noise_estimate) : 1;
   if (nof_ports == 2) {
-    /* TODO: Use VOLK here */
-    for (i = 0; i < nof_symbols / 2; i++) {
-      h0 = ce[0][2 * i];
-      h1 = ce[1][2 * i];
-      hh = crealf(h0) * crealf(h0) + cimagf(h0) * cimagf(h0)
-          + crealf(h1) * crealf(h1) + cimagf(h1) * cimagf(h1);
-      r0 = y[2 * i];
-      r1 = y[2 * i + 1];
-      if (hh == 0) {
-        hh = 1e-2;
-      }
-      x[0][i] = (conjf(h0) * r0 + h1 * conjf(r1)) / hh * sqrt(2);
-      x[1][i] = (-h1 * conj(r0) + conj(h0) * r1) / hh * sqrt(2);
+    m_ap = nof_symbols / 2;
+    for (i = 0; i < m_ap; i++) {
+      sfbc_decode_pair(y, ce[0], ce[1], RE_POS(re_idx, 2 * i), RE_POS(re_idx, 2 * i + 1),
+          noise_estimate, snr_scale, 
+          x ? &x[0][i] : &d[2 * i], x ? &x[1][i] : &d[2 * i + 1],
+          snr ? &snr[2 * i] : NULL);
     }
-    return i;
   } else if (nof_ports == 4) {
-
-    int m_ap = (nof_symbols % 4) ? ((nof_symbols - 2) / 4) : nof_symbols / 4;
+    m_ap = (nof_symbols % 4) ? ((nof_symbols - 2) / 4) : nof_symbols / 4;
     for (i = 0; i < m_ap; i++) {
-      h0 = ce[0][4 * i];
-      h1 = ce[1][4 * i + 2];
-      h2 = ce[2][4 * i];
-      h3 = ce[3][4 * i + 2];
-      hh02 = crealf(h0) * crealf(h0) + cimagf(h0) * cimagf(h0)
-          + crealf(h2) * crealf(h2) + cimagf(h2) * cimagf(h2);
-      hh13 = crealf(h1) * crealf(h1) + cimagf(h1) * cimagf(h1)
-          + crealf(h3) * crealf(h3) + cimagf(h3) * cimagf(h3);
-      r0 = y[4 * i];
-      r1 = y[4 * i + 1];
-      r2 = y[4 * i + 2];
-      r3 = y[4 * i + 3];
-
-      x[0][i] = (conjf(h0) * r0 + h2 * conjf(r1)) / hh02 * sqrt(2);
-      x[1][i] = (-h2 * conjf(r0) + conjf(h0) * r1) / hh02 * sqrt(2);
-      x[2][i] = (conjf(h1) * r2 + h3 * conjf(r3)) / hh13 * sqrt(2);
-      x[3][i] = (-h3 * conjf(r2) + conjf(h1) * r3) / hh13 * sqrt(2);
-
+      sfbc_decode_pair(y, ce[0], ce[2], RE_POS(re_idx, 4 * i), RE_POS(re_idx, 4 * i + 1),
+          noise_estimate, snr_scale, 
+          x ? &x[0][i] : &d[4 * i], x ? &x[1][i] : &d[4 * i + 1],
+          snr ? &snr[4 * i] : NULL);
+      sfbc_decode_pair(y, ce[1], ce[3], RE_POS(re_idx, 4 * i + 2), RE_POS(re_idx, 4 * i + 3),
+          noise_estimate, snr_scale, 
+          x ? &x[2][i] : &d[4 * i + 2], x ? &x[3][i] : &d[4 * i + 3],
+          snr ? &snr[4 * i + 2] : NULL);
     }
-    return i;
   } else {
     fprintf(stderr, "Number of ports must be 2 or 4 for transmit diversity\n");
     return -1;
   }
+  /* Symbols left out of the last group carry no information */
+  if (!x) {
+    for (i = nof_ports * m_ap; i < nof_symbols; i++) {
+      d[i] = 0;
+      if (snr) {
+        snr[i] = 0;
+      }
+    }
+  }
+  return m_ap;
+}
+
+/* ZF detector */
+int predecoding_single_zf(cf_t *y, cf_t *ce, cf_t *x, int nof_symbols) {
+  return predecoding_single_gen(y, ce, NULL, x, NULL, 0, nof_symbols);
+}
+
+/* MMSE detector */
+int predecoding_single_mmse(cf_t *y, cf_t *ce, cf_t *x, float *snr, float noise_estimate,
+    int nof_symbols) {
+  return predecoding_single_gen(y, ce, NULL, x, snr, noise_estimate, nof_symbols);
+}
+
+/* ZF detector */
+int predecoding_diversity_zf(cf_t *y, cf_t *ce[MAX_PORTS], cf_t *x[MAX_LAYERS],
+    int nof_ports, int nof_symbols) {
+  return predecoding_diversity_gen(y, ce, NULL, x, NULL, NULL, 0, nof_ports, nof_symbols);
+}
+
+/* MMSE detector */
+int predecoding_diversity_mmse(cf_t *y, cf_t *ce[MAX_PORTS], cf_t *x[MAX_LAYERS],
+    float *snr, float noise_estimate, int nof_ports, int nof_symbols) {
+  return predecoding_diversity_gen(y, ce, NULL, x, NULL, snr, noise_estimate, nof_ports,
+      nof_symbols);
+}
+
+int predecoding_single_idx(cf_t *y, cf_t *ce, uint32_t *re_idx, cf_t *d, float *snr,
+    float noise_estimate, int nof_symbols) {
+  return predecoding_single_gen(y, ce, re_idx, d, snr, noise_estimate, nof_symbols);
+}
+
+int predecoding_diversity_idx(cf_t *y, cf_t *ce[MAX_PORTS], uint32_t *re_idx, cf_t *d,
+    float *snr, float noise_estimate, int nof_ports, int nof_symbols) {
+  if (predecoding_diversity_gen(y, ce, re_idx, NULL, d, snr, noise_estimate, nof_ports,
+      nof_symbols) < 0) {
+    return -1;
+  }
+  return nof_symbols;
 }
 
 /* 36.211 v10.3.0 Section 6.3.4 */
@@ -41,17 +41,19 @@
 int nof_symbols = 1000;
 int nof_layers = 1, nof_ports = 1;
 char *mimo_type_name = NULL;
+float noise_estimate = 0;
 
 void usage(char *prog) {
   printf(
       "Usage: %s -m [single|diversity|multiplex] -l [nof_layers] -p [nof_ports]\n",
       prog);
   printf("\t-n num_symbols [Default %d]\n", nof_symbols);
+  printf("\t-e noise variance for the MMSE detector [Default ZF]\n");
 }
 
 void parse_args(int argc, char **argv) {
   int opt;
-  while ((opt = getopt(argc, argv, "mpln")) != -1) {
+  while ((opt = getopt(argc, argv, "mplne")) != -1) {
     switch (opt) {
     case 'n':
       nof_symbols = atoi(argv[optind]);
@@ -65,6 +67,9 @@ void parse_args(int argc, char **argv) {
     case 'm':
       mimo_type_name = argv[optind];
       break;
+    case 'e':
+      noise_estimate = atof(argv[optind]);
+      break;
     default:
       usage(argv[0]);
       exit(-1);
@@ -76,8 +81,26 @@ void parse_args(int argc, char **argv) {
   }
 }
 
+/* Channel power seen by the symbol j of the layer-demapped sequence */
+float channel_power(cf_t *h[MAX_PORTS], int j) {
+  int p0, p1, k;
+  if (nof_ports == 1) {
+    return cabsf(h[0][j]) * cabsf(h[0][j]);
+  } else if (nof_ports == 2) {
+    p0 = 0;
+    p1 = 1;
+    k = j - j % 2;
+  } else {
+    p0 = (j % 4) < 2 ? 0 : 1;
+    p1 = p0 + 2;
+    k = j - j % 2;
+  }
+  return cabsf(h[p0][k]) * cabsf(h[p0][k]) + cabsf(h[p1][k]) * cabsf(h[p1][k]);
+}
+
 int main(int argc, char **argv) {
   int i, j;
+  float *snr = NULL, hh;
   float mse;
   cf_t *x[MAX_LAYERS], *r[MAX_PORTS], *y[MAX_PORTS], *h[MAX_PORTS],
       *xr[MAX_LAYERS];
@@ -163,7 +186,36 @@ int main(int argc, char **argv) {
   }
 
   /* predecoding / equalization */
-  if (predecoding_type(r[0], h, xr, nof_ports, nof_layers,
+  if (noise_estimate > 0) {
+    snr = malloc(sizeof(float) * nof_symbols * nof_layers);
+    if (!snr) {
+      perror("malloc");
+      exit(-1);
+    }
+    if (type == SINGLE_ANTENNA) {
+      predecoding_single_mmse(r[0], h[0], xr[0], snr, noise_estimate, nof_symbols);
+    } else if (type == TX_DIVERSITY) {
+      predecoding_diversity_mmse(r[0], h, xr, snr, noise_estimate, nof_ports, 
+          nof_symbols * nof_layers);
+    } else {
+      fprintf(stderr, "MMSE detector only available for single antenna and diversity\n");
+      exit(-1);
+    }
+    /* check the SNR and remove the bias of the MMSE estimate */
+    for (j = 0; j < nof_symbols * nof_layers; j++) {
+      hh = channel_power(h, j);
+      /* the power of each layer is split between two ports in transmit diversity */
+      if (nof_ports > 1) {
+        hh /= 2;
+      }
+      if (fabsf(snr[j] - hh / noise_estimate) > 1e-4 * snr[j]) {
+        printf("Wrong SNR %f in symbol %d\n", snr[j], j);
+        exit(-1);
+      }
+      xr[j % nof_layers][j / nof_layers] *= (snr[j] + 1) / snr[j];
+    }
+    free(snr);
+  } else if (predecoding_type(r[0], h, xr, nof_ports, nof_layers,
       nof_symbols * nof_layers, type) < 0) {
     fprintf(stderr, "Error layer mapper encoder\n");
     exit(-1);
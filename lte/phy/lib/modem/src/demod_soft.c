@@ -30,6 +30,7 @@
 #include <strings.h>
 
 #include "liblte/phy/utils/bit.h"
+#include "liblte/phy/utils/vector.h"
 #include "liblte/phy/modem/demod_soft.h"
 #include "soft_algs.h"
 
@@ -58,15 +59,48 @@ int demod_soft_demodulate(demod_soft_t *q, const cf_t* symbols, float* llr, int
         q->table->symbol_table, q->table->soft_table.idx, q->sigma);
     break;
   case APPROX:
-/*    llr_approx(symbols, llr, nsymbols, q->table->nsymbols, q->table->nbits_x_symbol,
-        q->table->symbol_table, q->table->soft_table.idx, q->sigma);
-*/    llr_approx(symbols, llr, nsymbols, q->table->nsymbols, q->table->nbits_x_symbol,
-        q->table->symbol_table, q->table->soft_table.idx, q->table->soft_table.d_idx, q->table->soft_table.min_idx, q->sigma);
+    llr_approx(symbols, llr, nsymbols, q->table->nbits_x_symbol, q->sigma);
     break;
   }
   return nsymbols*q->table->nbits_x_symbol;
 }
 
+/* Demaps n symbols to the scratch buffer, weighting the LLRs of each symbol */
+static void demodulate_block(demod_soft_t *q, const cf_t* symbols, const float *weights, int n) {
+  int i, j, nbits = q->table->nbits_x_symbol;
+  demod_soft_demodulate(q, symbols, q->llr_block, n);
+  if (weights) {
+    for (i=0;i<n;i++) {
+      for (j=0;j<nbits;j++) {
+        q->llr_block[i*nbits+j] *= weights[i];
+      }
+    }
+  }
+}
+
+/* The float LLRs of each block stay in the cache until they are quantized */
+int demod_soft_demodulate_s(demod_soft_t *q, const cf_t* symbols, int16_t* llr, float scale, 
+                            const float *weights, int nsymbols) {
+  int i, n, nbits = q->table->nbits_x_symbol;
+  for (i=0;i<nsymbols;i+=n) {
+    n = nsymbols - i < DEMOD_SOFT_BLOCK_LEN ? nsymbols - i : DEMOD_SOFT_BLOCK_LEN;
+    demodulate_block(q, &symbols[i], weights ? &weights[i] : NULL, n);
+    vec_quant_fs(q->llr_block, &llr[i*nbits], scale, n*nbits);
+  }
+  return nsymbols*nbits;
+}
+
+int demod_soft_demodulate_b(demod_soft_t *q, const cf_t* symbols, int8_t* llr, float scale, 
+                            const float *weights, int nsymbols) {
+  int i, n, nbits = q->table->nbits_x_symbol;
+  for (i=0;i<nsymbols;i+=n) {
+    n = nsymbols - i < DEMOD_SOFT_BLOCK_LEN ? nsymbols - i : DEMOD_SOFT_BLOCK_LEN;
+    demodulate_block(q, &symbols[i], weights ? &weights[i] : NULL, n);
+    vec_quant_fc(q->llr_block, &llr[i*nbits], scale, n*nbits);
+  }
+  return nsymbols*nbits;
+}
+
 
 
 /* High-Level API */
@@ -27,6 +27,7 @@
 
 
 #include <stdlib.h>
+#include <string.h>
 #include <strings.h>
 #include <assert.h>
 
@@ -35,22 +36,149 @@
 
 /** Low-level API */
 
-int mod_modulate(modem_table_t* q, const char *bits, cf_t* symbols, uint32_t nbits) {
-  uint32_t i,j,idx;
-  char *b_ptr=(char*) bits;
-  j=0;
-  for (i=0;i<nbits;i+=q->nbits_x_symbol) {
-    idx = bit_unpack(&b_ptr,q->nbits_x_symbol);
+/* mod_modulate() packs its input this many bytes at a time. A multiple of 3 bytes, 
+ * so that 64QAM symbols never straddle two chunks. 
+ */
+#define MOD_CHUNK_BYTES   48
+
+/* Symbols are mapped in blocks of this size before scattering them to the grid */
+#define MOD_BLOCK_SYMBOLS 64
+
+/* Maps nsymbols symbols. BPSK, QPSK and 16QAM copy all the symbols of an input 
+ * byte at once from the byte table, 64QAM looks up 4 symbols from every 3 bytes. 
+ * Whatever is left, and tables without a fast path, go through a bit accumulator. 
+ */
+static int modulate_packed(modem_table_t* q, const uint8_t *bits, cf_t* symbols, uint32_t nsymbols) {
+  uint32_t i, j=0, w, idx, nbytes;
+  uint32_t acc=0, nacc=0;
+  uint32_t nb = q->nbits_x_symbol;
+  const uint8_t *b_ptr = bits;
+
+  if (q->byte_table) {
+    nbytes = nsymbols * nb / 8;
+    switch(nb) {
+    case 1:
+      for (i=0;i<nbytes;i++) {
+        memcpy(&symbols[8*i], &q->byte_table[8*b_ptr[i]], 8*sizeof(cf_t));
+      }
+      break;
+    case 2:
+      for (i=0;i<nbytes;i++) {
+        memcpy(&symbols[4*i], &q->byte_table[4*b_ptr[i]], 4*sizeof(cf_t));
+      }
+      break;
+    case 4:
+      for (i=0;i<nbytes;i++) {
+        memcpy(&symbols[2*i], &q->byte_table[2*b_ptr[i]], 2*sizeof(cf_t));
+      }
+      break;
+    }
+    j = nbytes * 8 / nb;
+    b_ptr += nbytes;
+  } else if (nb == 6 && q->nsymbols == 64) {
+    for (j=0;j+4<=nsymbols;j+=4) {
+      w = (b_ptr[0] << 16) | (b_ptr[1] << 8) | b_ptr[2];
+      symbols[j]   = q->symbol_table[w >> 18];
+      symbols[j+1] = q->symbol_table[(w >> 12) & 0x3f];
+      symbols[j+2] = q->symbol_table[(w >> 6) & 0x3f];
+      symbols[j+3] = q->symbol_table[w & 0x3f];
+      b_ptr += 3;
+    }
+  }
+  /* at most 6 bits per symbol, so one byte refills the accumulator */
+  for (;j<nsymbols;j++) {
+    if (nacc < nb) {
+      acc = (acc << 8) | *b_ptr++;
+      nacc += 8;
+    }
+    nacc -= nb;
+    idx = (acc >> nacc) & ((1 << nb) - 1);
     if (idx < q->nsymbols) {
-      symbols[j] = q->symbol_table[idx];      
+      symbols[j] = q->symbol_table[idx];
+    } else {
+      return LIBLTE_ERROR;
+    }
+  }
+  return nsymbols;
+}
+
+/* Same as modulate_packed() but writes symbol j to sf_symbols[re_idx[j]] */
+static int modulate_packed_re(modem_table_t* q, const uint8_t *bits, cf_t* sf_symbols, 
+                              const uint32_t *re_idx, uint32_t nsymbols) {
+  cf_t block[MOD_BLOCK_SYMBOLS];
+  uint32_t i, k, n;
+
+  for (i=0;i<nsymbols;i+=n) {
+    n = nsymbols - i;
+    if (n > MOD_BLOCK_SYMBOLS) {
+      n = MOD_BLOCK_SYMBOLS;
+    }
+    if (modulate_packed(q, &bits[i * q->nbits_x_symbol / 8], block, n) < 0) {
+      return LIBLTE_ERROR;
+    }
+    for (k=0;k<n;k++) {
+      sf_symbols[re_idx[i+k]] = block[k];
+    }
+  }
+  return nsymbols;
+}
+
+/* Packs the input one chunk at a time and maps it to symbols, or to 
+ * symbols[re_idx[j]] if re_idx is not NULL.
+ */
+static int modulate_chunks(modem_table_t* q, const char *bits, cf_t* symbols, 
+                           const uint32_t *re_idx, uint32_t nbits) {
+  uint8_t packed[MOD_CHUNK_BYTES];
+  uint32_t i, n, j=0;
+  int ret;
+
+  if (q->nbits_x_symbol == 0) {
+    return LIBLTE_ERROR;
+  }
+  nbits -= nbits % q->nbits_x_symbol;
+  for (i=0;i<nbits;i+=n) {
+    n = nbits - i;
+    if (n > 8*MOD_CHUNK_BYTES) {
+      n = 8*MOD_CHUNK_BYTES;
+    }
+    bit_pack_vector((char*) &bits[i], packed, n);
+    if (re_idx) {
+      ret = modulate_packed_re(q, packed, symbols, &re_idx[j], n / q->nbits_x_symbol);
     } else {
+      ret = modulate_packed(q, packed, &symbols[j], n / q->nbits_x_symbol);
+    }
+    if (ret < 0) {
       return LIBLTE_ERROR;
     }
-    j++;
+    j += ret;
   }
   return j;
 }
 
+int mod_modulate(modem_table_t* q, const char *bits, cf_t* symbols, uint32_t nbits) {
+  return modulate_chunks(q, bits, symbols, NULL, nbits);
+}
+
+int mod_modulate_re(modem_table_t* q, const char *bits, cf_t* sf_symbols, 
+                    const uint32_t *re_idx, uint32_t nbits) {
+  return modulate_chunks(q, bits, sf_symbols, re_idx, nbits);
+}
+
+int mod_modulate_packed(modem_table_t* q, const uint8_t *bits, cf_t* symbols, uint32_t nbits) {
+  if (q->nbits_x_symbol == 0 || nbits % q->nbits_x_symbol) {
+    return LIBLTE_ERROR;
+  }
+  return modulate_packed(q, bits, symbols, nbits / q->nbits_x_symbol);
+}
+
+int mod_modulate_packed_re(modem_table_t* q, const uint8_t *bits, cf_t* sf_symbols, 
+                           const uint32_t *re_idx, uint32_t nbits) {
+  if (q->nbits_x_symbol == 0 || nbits % q->nbits_x_symbol) {
+    return LIBLTE_ERROR;
+  }
+  return modulate_packed_re(q, bits, sf_symbols, re_idx, nbits / q->nbits_x_symbol);
+}
+
 
 /* High-Level API */
 int mod_initialize(mod_hl* hl) {
@@ -43,6 +43,28 @@ static int table_create(modem_table_t* q) {
   return q->symbol_table==NULL;
 }
 
+/* Builds the byte-to-symbols table used by the modulator when a byte holds a 
+ * whole number of symbols. 64QAM and tables with unused indices have none. 
+ */
+static int byte_table_create(modem_table_t* q) {
+  uint32_t b, k, spb, nb = q->nbits_x_symbol;
+  q->byte_table = NULL;
+  if ((nb != 1 && nb != 2 && nb != 4) || q->nsymbols != (1 << nb)) {
+    return LIBLTE_SUCCESS;
+  }
+  spb = 8 / nb;
+  q->byte_table = malloc(256*spb*sizeof(cf_t));
+  if (!q->byte_table) {
+    return LIBLTE_ERROR;
+  }
+  for (b=0;b<256;b++) {
+    for (k=0;k<spb;k++) {
+      q->byte_table[b*spb+k] = q->symbol_table[(b >> (8-(k+1)*nb)) & (q->nsymbols-1)];
+    }
+  }
+  return LIBLTE_SUCCESS;
+}
+
 void modem_table_init(modem_table_t* q) {
   bzero((void*)q,sizeof(modem_table_t));
 }
@@ -50,6 +72,9 @@ void modem_table_free(modem_table_t* q) {
   if (q->symbol_table) {
     free(q->symbol_table);
   }
+  if (q->byte_table) {
+    free(q->byte_table);
+  }
   bzero(q, sizeof(modem_table_t));
 }
 void modem_table_reset(modem_table_t* q) {
@@ -68,7 +93,7 @@ int modem_table_set(modem_table_t* q, cf_t* table, soft_table_t *soft_table, uin
   memcpy(q->symbol_table,table,q->nsymbols*sizeof(cf_t));
   memcpy(&q->soft_table,soft_table,sizeof(soft_table_t));
   q->nbits_x_symbol = nbits_x_symbol;
-  return LIBLTE_SUCCESS;
+  return byte_table_create(q);
 }
 
 int modem_table_lte(modem_table_t* q, lte_mod_t modulation, bool compute_soft_demod) {
@@ -106,5 +131,5 @@ int modem_table_lte(modem_table_t* q, lte_mod_t modulation, bool compute_soft_de
     set_64QAMtable(q->symbol_table, &q->soft_table, compute_soft_demod);
     break;
   }
-  return LIBLTE_SUCCESS;
+  return byte_table_create(q);
 }
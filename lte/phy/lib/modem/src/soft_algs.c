@@ -25,630 +25,256 @@
  *
  */
 
-
-
 #include <stdio.h>
 #include <math.h>
 #include <complex.h>
 #include <stdint.h>
 #include <string.h>
 
+#include "liblte/phy/modem/modem_table.h"
 #include "soft_algs.h"
-#include "liblte/phy/utils/vector.h"
-
-#define QAM16_THRESHOLD         2/sqrt(10)
-#define QAM64_THRESHOLD_1       2/sqrt(42)
-#define QAM64_THRESHOLD_2       4/sqrt(42)
-#define QAM64_THRESHOLD_3       6/sqrt(42)
-
-
-typedef _Complex float cf_t;
-
-// There are 3 implemenations: 1 - based on zones; 2 - using volk, 3 - straightforward C
-#define LLR_APPROX_IMPLEMENTATION 1
-
-#if LLR_APPROX_IMPLEMENTATION == 1
-
-float dd[10000][7];             // 7 distances that are needed to compute LLR approx for 64QAM 
-uint32_t zone[10000];           // Zone of received symbol with respect to grid of QAM constellation diagram
+#include "lte_tables.h"
 
+#if defined(LV_HAVE_AVX2)
+#include <immintrin.h>
+#elif defined(LV_HAVE_SSE)
+#include <smmintrin.h>
+#endif
 
-/**
- * @ingroup Received modulation symbol zone
- * Determine location of received modulation symbol
+/* Max-log LLRs in closed form.
  *
- * \param in input symbol (_Complex float)
- * \param z associated zone in constellation diagram (int)
- * \param N number of symbols
- */
-static void zone_QPSK(const cf_t * in, uint32_t * z, int N)
-{
-
-  int s;
-  float re, im;
-
-  for (s = 0; s < N; s++) {
-
-    re = __real__ in[s];
-    im = __imag__ in[s];
-
-    if (re > 0) {
-      if (im > 0) {             /* 1st Quadrand (upper-right) */
-        z[s] = 0;
-      } else {                  /* 4th Quadrand (lower-right) */
-        z[s] = 1;
-      }
-    } else {
-      if (im > 0) {             /* 2nd Quadrand (upper-left) */
-        z[s] = 2;
-      } else {                  /* 3rd Quadrand (lower-left) */
-        z[s] = 3;
-      }
-    }
-  }
-}
-
-/**
- * @ingroup Received modulation symbol zone
- * Determine location of received modulation symbol
+ * Every LTE constellation is the product of two Gray-mapped PAMs with levels
+ * p*c, p=1,3,5,7: I carries bits 0, 2 and 4 and Q carries bits 1, 3 and 5.
+ * For one axis with received value x and y=|x|, the squared distance to the
+ * nearest point at level p of the same sign is x^2 + l_p, where
  *
- * \param in input symbol (_Complex float)
- * \param z associated zone in constellation diagram (int)
- * \param N number of symbols
- */
-static void zone_QAM16(const cf_t * in, uint32_t * z, int N)
-{
-
-  int s;
-  float re, im;
-
-  for (s = 0; s < N; s++) {
-
-    re = __real__ in[s];
-    im = __imag__ in[s];
-
-    if (re > 0) {
-      if (im > 0) {             /* 1st Quadrand (upper-right) */
-        if (re > QAM16_THRESHOLD) {
-          if (im > QAM16_THRESHOLD) {
-            z[s] = 3;
-          } else {
-            z[s] = 2;
-          }
-        } else {
-          if (im > QAM16_THRESHOLD) {
-            z[s] = 1;
-          } else {
-            z[s] = 0;
-          }
-        }
-      } else {                  /* 4th Quadrand (lower-right) */
-        if (re > QAM16_THRESHOLD) {
-          if (im < -QAM16_THRESHOLD) {
-            z[s] = 7;
-          } else {
-            z[s] = 6;
-          }
-        } else {
-          if (im < -QAM16_THRESHOLD) {
-            z[s] = 5;
-          } else {
-            z[s] = 4;
-          }
-        }
-      }
-    } else {
-      if (im > 0) {             /* 2nd Quadrand (upper-left) */
-        if (re < -QAM16_THRESHOLD) {
-          if (im > QAM16_THRESHOLD) {
-            z[s] = 11;
-          } else {
-            z[s] = 10;
-          }
-        } else {
-          if (im > QAM16_THRESHOLD) {
-            z[s] = 9;
-          } else {
-            z[s] = 8;
-          }
-        }
-      } else {                  /* 3rd Quadrand (lower-left) */
-        if (re < -QAM16_THRESHOLD) {
-          if (im < -QAM16_THRESHOLD) {
-            z[s] = 15;
-          } else {
-            z[s] = 14;
-          }
-        } else {
-          if (im < -QAM16_THRESHOLD) {
-            z[s] = 13;
-          } else {
-            z[s] = 12;
-          }
-        }
-      }
-    }
-  }
-}
-
-/**
- * @ingroup Received modulation symbol zone
- * Determine location of received modulation symbol
+ *   l_p = (p*c)^2 - 2*p*c*y
+ *
+ * is a line in y. The nearest point with the opposite sign is always at -c,
+ * so every LLR (distance to the '0' set minus distance to the '1' set) is a
+ * difference of minima of these lines:
+ *
+ *   bit 0:             (min_p l_p - c^2 - 2*c*y) * sign(x)
+ *   16QAM bit 2:       l_1 - l_3
+ *   64QAM bit 2:       min(l_1, l_3) - min(l_5, l_7)
+ *   64QAM bit 4:       min(l_3, l_5) - min(l_1, l_7)
  *
- * \param in input symbol (_Complex float)
- * \param z associated zone in constellation diagram (int)
- * \param N number of symbols
+ * This is exactly the nearest-point approximation, without zones or tables.
+ * Since I and Q alternate in memory, each SIMD lane processes one axis.
  */
 
-static void zone_QAM64(const cf_t * in, uint32_t * z, int N)
-{
-
-  int s;
-  float re, im;
-
-  for (s = 0; s < N; s++) {
-
-    re = __real__ in[s];
-    im = __imag__ in[s];
-
-    if (re > 0) {
-
-      if (im > 0) {
-
-        if (re > QAM64_THRESHOLD_2) {
-
-          if (re > QAM64_THRESHOLD_3) {
-
-            if (im > QAM64_THRESHOLD_2) {
-              if (im > QAM64_THRESHOLD_3) {
-                z[s] = 15;
-              } else {
-                z[s] = 14;
-              }
-            } else if (im > QAM64_THRESHOLD_1) {
-              z[s] = 10;
-            } else {
-              z[s] = 11;
-            }
-
-          } else {
-
-            if (im > QAM64_THRESHOLD_2) {
-              if (im > QAM64_THRESHOLD_3) {
-                z[s] = 13;
-              } else {
-                z[s] = 12;
-              }
-            } else if (im > QAM64_THRESHOLD_1) {
-              z[s] = 8;
-            } else {
-              z[s] = 9;
-            }
-          }
-
-        } else if (re > QAM64_THRESHOLD_1) {
-
-          if (im > QAM64_THRESHOLD_2) {
-            if (im > QAM64_THRESHOLD_3) {
-              z[s] = 5;
-            } else {
-              z[s] = 4;
-            }
-          } else if (im > QAM64_THRESHOLD_1) {
-            z[s] = 0;
-          } else {
-            z[s] = 1;
-          }
-
-        } else {
-          if (im > QAM64_THRESHOLD_2) {
-            if (im > QAM64_THRESHOLD_3) {
-              z[s] = 7;
-            } else {
-              z[s] = 6;
-            }
-          } else if (im > QAM64_THRESHOLD_1) {
-            z[s] = 2;
-          } else {
-            z[s] = 3;
-          }
-        }
-
-      } else {                  /* forth quadrant (lower-right) */
-
-        if (re > QAM64_THRESHOLD_2) {
-
-          if (re > QAM64_THRESHOLD_3) {
-
-            if (im < -QAM64_THRESHOLD_2) {
-              if (im < -QAM64_THRESHOLD_3) {
-                z[s] = 31;
-              } else {
-                z[s] = 30;
-              }
-            } else if (im < -QAM64_THRESHOLD_1) {
-              z[s] = 26;
-            } else {
-              z[s] = 27;
-            }
-
-          } else {
-
-            if (im < -QAM64_THRESHOLD_2) {
-              if (im < -QAM64_THRESHOLD_3) {
-                z[s] = 29;
-              } else {
-                z[s] = 28;
-              }
-            } else if (im < -QAM64_THRESHOLD_1) {
-              z[s] = 24;
-            } else {
-              z[s] = 25;
-            }
-          }
-
-        } else if (re > QAM64_THRESHOLD_1) {
-
-          if (im < -QAM64_THRESHOLD_2) {
-            if (im < -QAM64_THRESHOLD_3) {
-              z[s] = 21;
-            } else {
-              z[s] = 20;
-            }
-          } else if (im < -QAM64_THRESHOLD_1) {
-            z[s] = 16;
-          } else {
-            z[s] = 17;
-          }
-
-        } else {
-          if (im < -QAM64_THRESHOLD_2) {
-            if (im < -QAM64_THRESHOLD_3) {
-              z[s] = 23;
-            } else {
-              z[s] = 22;
-            }
-          } else if (im < -QAM64_THRESHOLD_1) {
-            z[s] = 18;
-          } else {
-            z[s] = 19;
-          }
-        }
-      }
-
-    } else {                    /* re < 0 */
-
-      if (im > 0) {             /* second quadrant (upper-left) */
-
-        if (re < -QAM64_THRESHOLD_2) {
-
-          if (re < -QAM64_THRESHOLD_3) {
-
-            if (im > QAM64_THRESHOLD_2) {
-              if (im > QAM64_THRESHOLD_3) {
-                z[s] = 47;
-              } else {
-                z[s] = 46;
-              }
-            } else if (im > QAM64_THRESHOLD_1) {
-              z[s] = 42;
-            } else {
-              z[s] = 43;
-            }
-
-          } else {
-
-            if (im > QAM64_THRESHOLD_2) {
-              if (im > QAM64_THRESHOLD_3) {
-                z[s] = 45;
-              } else {
-                z[s] = 44;
-              }
-            } else if (im > QAM64_THRESHOLD_1) {
-              z[s] = 40;
-            } else {
-              z[s] = 41;
-            }
-          }
-
-        } else if (re < -QAM64_THRESHOLD_1) {
-
-          if (im > QAM64_THRESHOLD_2) {
-            if (im > QAM64_THRESHOLD_3) {
-              z[s] = 37;
-            } else {
-              z[s] = 36;
-            }
-          } else if (im > QAM64_THRESHOLD_1) {
-            z[s] = 32;
-          } else {
-            z[s] = 33;
-          }
-
-        } else {
-          if (im > QAM64_THRESHOLD_2) {
-            if (im > QAM64_THRESHOLD_3) {
-              z[s] = 39;
-            } else {
-              z[s] = 38;
-            }
-          } else if (im > QAM64_THRESHOLD_1) {
-            z[s] = 34;
-          } else {
-            z[s] = 35;
-          }
-        }
-      } else {                  /* third quadrant (lower-left) */
-        if (re < -QAM64_THRESHOLD_2) {
-
-          if (re < -QAM64_THRESHOLD_3) {
-
-            if (im < -QAM64_THRESHOLD_2) {
-              if (im < -QAM64_THRESHOLD_3) {
-                z[s] = 63;
-              } else {
-                z[s] = 62;
-              }
-            } else if (im < -QAM64_THRESHOLD_1) {
-              z[s] = 58;
-            } else {
-              z[s] = 59;
-            }
-
-          } else {
-
-            if (im < -QAM64_THRESHOLD_2) {
-              if (im < -QAM64_THRESHOLD_3) {
-                z[s] = 61;
-              } else {
-                z[s] = 60;
-              }
-            } else if (im < -QAM64_THRESHOLD_1) {
-              z[s] = 56;
-            } else {
-              z[s] = 57;
-            }
-          }
-
-        } else if (re < -QAM64_THRESHOLD_1) {
-
-          if (im < -QAM64_THRESHOLD_2) {
-            if (im < -QAM64_THRESHOLD_3) {
-              z[s] = 53;
-            } else {
-              z[s] = 52;
-            }
-          } else if (im < -QAM64_THRESHOLD_1) {
-            z[s] = 48;
-          } else {
-            z[s] = 49;
-          }
-
-        } else {
-          if (im < -QAM64_THRESHOLD_2) {
-            if (im < -QAM64_THRESHOLD_3) {
-              z[s] = 55;
-            } else {
-              z[s] = 54;
-            }
-          } else if (im < -QAM64_THRESHOLD_1) {
-            z[s] = 50;
-          } else {
-            z[s] = 51;
-          }
-        }
-
-      }
-    }
+typedef struct {
+  float a[4];     // (p*c)^2/sigma2 for p=1,3,5,7
+  float b[4];     // 2*p*c/sigma2
+} llr_lines_t;
+
+static void llr_lines_init(llr_lines_t *l, float c, float sigma2) {
+  int i;
+  for (i = 0; i < 4; i++) {
+    float p = (float) (2 * i + 1);
+    l->a[i] = p * p * c * c / sigma2;
+    l->b[i] = 2 * p * c / sigma2;
   }
 }
 
-static void compute_zone(const cf_t * in, uint32_t * z, int N, int B)
-{
-  switch (B) {
-    case 1:{
-        memset(zone, 0, N * sizeof(int));
-        break;
-      }                         /* BPSK */
-    case 2:{
-        zone_QPSK(in, z, N);
-        break;
-      }                         /* QPSK */
-    case 4:{
-        zone_QAM16(in, z, N);
-        break;
-      }                         /* 16QAM */
-    case 6:{
-        zone_QAM64(in, z, N);
-        break;
-      }                         /* 64QAM */
-  }
+/* LLRs of bits 0 and 2 of one 16QAM axis */
+static inline void llr_axis_qam16(const llr_lines_t *l, float x, float *b0, float *b2) {
+  float y = fabsf(x);
+  float l1 = l->a[0] - l->b[0] * y;
+  float l3 = l->a[1] - l->b[1] * y;
+  float m = (l1 < l3 ? l1 : l3) - (l->a[0] + l->b[0] * y);
+  *b0 = x < 0 ? -m : m;
+  *b2 = l1 - l3;
 }
 
-static void compute_square_dist(const cf_t * in, cf_t * symbols,
-                                uint32_t(*idx)[7], int N, int B)
-{
-  int s, b;
-  float *d_ptr;
-  cf_t symbols_extract[7];
-
-  for (s = 0; s < N; s++) {     /* N: number of received symbols */
-    d_ptr = dd[s];
-    for (b = 0; b < B + 1; b++) {
-      symbols_extract[b] = symbols[idx[zone[s]][b]];    /* only subset of distances to constellation points needed for LLR approx */
-      //x = __real__ in[s] - __real__ symbols[idx[zone[s]][b]];
-      //y = __imag__ in[s] - __imag__ symbols[idx[zone[s]][b]];
-      //dd[s][b] = x*x + y*y;
-      //printf("\n%f + j %f", __real__ symbols_extract[b], __imag__ symbols_extract[b]);
-    }
-    vec_square_dist(in[s], symbols_extract, d_ptr, B + 1);      /* B+1 distances to be computed */
-  }
+/* LLRs of bits 0, 2 and 4 of one 64QAM axis */
+static inline void llr_axis_qam64(const llr_lines_t *l, float x, float *b0, float *b2, float *b4) {
+  float y = fabsf(x);
+  float l1 = l->a[0] - l->b[0] * y;
+  float l3 = l->a[1] - l->b[1] * y;
+  float l5 = l->a[2] - l->b[2] * y;
+  float l7 = l->a[3] - l->b[3] * y;
+  float m13 = l1 < l3 ? l1 : l3;
+  float m57 = l5 < l7 ? l5 : l7;
+  float m35 = l3 < l5 ? l3 : l5;
+  float m17 = l1 < l7 ? l1 : l7;
+  float m = (m13 < m57 ? m13 : m57) - (l->a[0] + l->b[0] * y);
+  *b0 = x < 0 ? -m : m;
+  *b2 = m13 - m57;
+  *b4 = m35 - m17;
 }
 
-static void compute_llr(int N, int B, uint32_t(*min)[64][6], float sigma2,
-                        float *out)
-{
-  int s, b;
+static void llr_approx_bpsk(const cf_t *in, float *out, int N, float sigma2) {
+  int s;
+  float g = -4 * BPSK_LEVEL / sigma2;
   for (s = 0; s < N; s++) {
-    for (b = 0; b < B; b++) {   /* bits per symbol */
-      out[s * B + b] =
-        (dd[s][min[0][zone[s]][b]] - dd[s][min[1][zone[s]][b]]) / sigma2;
-    }
+    out[s] = g * (__real__ in[s] + __imag__ in[s]);
   }
 }
 
-void llr_approx(const _Complex float *in, float *out, int N, int M, int B,
-                _Complex float *symbols, uint32_t(*S)[6][32], uint32_t(*idx)[7],
-                uint32_t(*min)[64][6], float sigma2)
-{
-  if ((M == 2) || (M == 4) || (M == 16) || (M == 64)) {
-    compute_zone(in, zone, N, B);
-    compute_square_dist(in, symbols, idx, N, B);
-    compute_llr(N, B, min, sigma2, out);
+static void llr_approx_qpsk(const cf_t *in, float *out, int N, float sigma2) {
+  const float *x = (const float*) in;
+  float g = -4 * QPSK_LEVEL / sigma2;
+  int i = 0;
+#if defined(LV_HAVE_AVX2)
+  __m256 gv = _mm256_set1_ps(g);
+  for (; i < 2 * N - 7; i += 8) {
+    _mm256_storeu_ps(&out[i], _mm256_mul_ps(gv, _mm256_loadu_ps(&x[i])));
   }
-}
-
-#elif LLR_APPROX_IMPLEMENTATION == 2
-
-float d[10000][64];
-float num[10000], den[10000];
-
-static void compute_square_dist(const cf_t * in, cf_t * symbols, int N, int M)
-{
-  int s;
-  float *d_ptr;
-  for (s = 0; s < N; s++) {
-    d_ptr = d[s];
-    vec_square_dist(in[s], symbols, d_ptr, M);
+#elif defined(LV_HAVE_SSE)
+  __m128 gv = _mm_set1_ps(g);
+  for (; i < 2 * N - 3; i += 4) {
+    _mm_storeu_ps(&out[i], _mm_mul_ps(gv, _mm_loadu_ps(&x[i])));
   }
-}
-
-static void compute_min_dist(uint32_t(*S)[6][32], int N, int B, int M)
-{
-  int s, b, i;
-  for (s = 0; s < N; s++) {
-    for (b = 0; b < B; b++) {   /* bits per symbol */
-      /* initiate num[b] and den[b] */
-      num[s * B + b] = 1e10;
-      den[s * B + b] = 1e10;
-
-      for (i = 0; i < M / 2; i++) {
-        if (d[s][S[0][b][i]] < num[s * B + b]) {
-          num[s * B + b] = d[s][S[0][b][i]];
-        }
-        if (d[s][S[1][b][i]] < den[s * B + b]) {
-          den[s * B + b] = d[s][S[1][b][i]];
-        }
-      }
-    }
+#endif
+  for (; i < 2 * N; i++) {
+    out[i] = g * x[i];
   }
 }
 
-static void compute_llr(int N, int B, float sigma2, float *out)
-{
-  int s, b;
-  for (s = 0; s < N; s++) {
-    for (b = 0; b < B; b++) {       /* bits per symbol */
-      out[s * B + b] = (num[s * B + b] - den[s * B + b]) / sigma2;
-    }
+static void llr_approx_qam16(const cf_t *in, float *out, int N, float sigma2) {
+  const float *x = (const float*) in;
+  llr_lines_t l;
+  int s = 0;
+
+  llr_lines_init(&l, QAM16_LEVEL_1, sigma2);
+
+#if defined(LV_HAVE_AVX2)
+  __m256 sign = _mm256_set1_ps(-0.0f);
+  __m256 a1 = _mm256_set1_ps(l.a[0]), b1 = _mm256_set1_ps(l.b[0]);
+  __m256 a3 = _mm256_set1_ps(l.a[1]), b3 = _mm256_set1_ps(l.b[1]);
+  for (; s < N - 3; s += 4) {
+    __m256 v = _mm256_loadu_ps(&x[2 * s]);
+    __m256 y = _mm256_andnot_ps(sign, v);
+    __m256 l1 = _mm256_sub_ps(a1, _mm256_mul_ps(b1, y));
+    __m256 l3 = _mm256_sub_ps(a3, _mm256_mul_ps(b3, y));
+    __m256 m = _mm256_sub_ps(_mm256_min_ps(l1, l3), _mm256_add_ps(a1, _mm256_mul_ps(b1, y)));
+    __m256 p = _mm256_xor_ps(m, _mm256_and_ps(sign, v));
+    __m256 r = _mm256_sub_ps(l1, l3);
+    /* Each 128-bit lane holds 2 symbols: [p0 p1 r0 r1] [p2 p3 r2 r3] */
+    __m256 v0 = _mm256_castpd_ps(_mm256_unpacklo_pd(_mm256_castps_pd(p), _mm256_castps_pd(r)));
+    __m256 v1 = _mm256_castpd_ps(_mm256_unpackhi_pd(_mm256_castps_pd(p), _mm256_castps_pd(r)));
+    _mm256_storeu_ps(&out[4 * s], _mm256_permute2f128_ps(v0, v1, 0x20));
+    _mm256_storeu_ps(&out[4 * s + 8], _mm256_permute2f128_ps(v0, v1, 0x31));
   }
-}
-
-void llr_approx(const _Complex float *in, float *out, int N, int M, int B,
-                _Complex float *symbols, uint32_t(*S)[6][32], float sigma2)
-{
-
-  if (M <= 64) {
-    compute_square_dist(in, symbols, N, M);
-
-    compute_min_dist(S, N, B, M);
-
-    compute_llr(N, B, sigma2, out);
+#elif defined(LV_HAVE_SSE)
+  __m128 sign = _mm_set1_ps(-0.0f);
+  __m128 a1 = _mm_set1_ps(l.a[0]), b1 = _mm_set1_ps(l.b[0]);
+  __m128 a3 = _mm_set1_ps(l.a[1]), b3 = _mm_set1_ps(l.b[1]);
+  for (; s < N - 1; s += 2) {
+    __m128 v = _mm_loadu_ps(&x[2 * s]);
+    __m128 y = _mm_andnot_ps(sign, v);
+    __m128 l1 = _mm_sub_ps(a1, _mm_mul_ps(b1, y));
+    __m128 l3 = _mm_sub_ps(a3, _mm_mul_ps(b3, y));
+    __m128 m = _mm_sub_ps(_mm_min_ps(l1, l3), _mm_add_ps(a1, _mm_mul_ps(b1, y)));
+    __m128 p = _mm_xor_ps(m, _mm_and_ps(sign, v));
+    __m128 r = _mm_sub_ps(l1, l3);
+    _mm_storeu_ps(&out[4 * s], _mm_movelh_ps(p, r));
+    _mm_storeu_ps(&out[4 * s + 4], _mm_movehl_ps(r, p));
   }
-  for (b = 0; b < B; b++) {  /* bits per symbol */
-    out[s * B + b] = (num[s * B + b] - den[s * B + b]) / sigma2;
+#endif
+  for (; s < N; s++) {
+    llr_axis_qam16(&l, x[2 * s], &out[4 * s], &out[4 * s + 2]);
+    llr_axis_qam16(&l, x[2 * s + 1], &out[4 * s + 1], &out[4 * s + 3]);
   }
 }
 
-void llr_approx(const _Complex float *in, float *out, int N, int M, int B,
-                _Complex float *symbols, uint32_t(*S)[6][32], uint32_t(*idx)[7],
-                uint32_t(*min)[64][6], float sigma2)
-{
-
-  if (M <= 64) {
-    compute_square_dist(in, symbols, N, M);
-
-    compute_min_dist(S, N, B, M);
-
-    compute_llr(N, B, sigma2, out);
+static void llr_approx_qam64(const cf_t *in, float *out, int N, float sigma2) {
+  const float *x = (const float*) in;
+  llr_lines_t l;
+  int s = 0;
+
+  llr_lines_init(&l, QAM64_LEVEL_1, sigma2);
+
+#if defined(LV_HAVE_AVX2)
+  __m256 sign = _mm256_set1_ps(-0.0f);
+  __m256 a1 = _mm256_set1_ps(l.a[0]), b1 = _mm256_set1_ps(l.b[0]);
+  __m256 a3 = _mm256_set1_ps(l.a[1]), b3 = _mm256_set1_ps(l.b[1]);
+  __m256 a5 = _mm256_set1_ps(l.a[2]), b5 = _mm256_set1_ps(l.b[2]);
+  __m256 a7 = _mm256_set1_ps(l.a[3]), b7 = _mm256_set1_ps(l.b[3]);
+  for (; s < N - 3; s += 4) {
+    __m256 v = _mm256_loadu_ps(&x[2 * s]);
+    __m256 y = _mm256_andnot_ps(sign, v);
+    __m256 l1 = _mm256_sub_ps(a1, _mm256_mul_ps(b1, y));
+    __m256 l3 = _mm256_sub_ps(a3, _mm256_mul_ps(b3, y));
+    __m256 l5 = _mm256_sub_ps(a5, _mm256_mul_ps(b5, y));
+    __m256 l7 = _mm256_sub_ps(a7, _mm256_mul_ps(b7, y));
+    __m256 m13 = _mm256_min_ps(l1, l3);
+    __m256 m57 = _mm256_min_ps(l5, l7);
+    __m256 m = _mm256_sub_ps(_mm256_min_ps(m13, m57), _mm256_add_ps(a1, _mm256_mul_ps(b1, y)));
+    __m256 p = _mm256_xor_ps(m, _mm256_and_ps(sign, v));
+    __m256 r = _mm256_sub_ps(m13, m57);
+    __m256 t = _mm256_sub_ps(_mm256_min_ps(l3, l5), _mm256_min_ps(l1, l7));
+    /* Each 128-bit lane holds 2 symbols: [p0 p1 r0 r1] [t0 t1 p2 p3] [r2 r3 t2 t3] */
+    __m256 v0 = _mm256_castpd_ps(_mm256_unpacklo_pd(_mm256_castps_pd(p), _mm256_castps_pd(r)));
+    __m256 v1 = _mm256_blend_ps(t, p, 0xCC);
+    __m256 v2 = _mm256_castpd_ps(_mm256_unpackhi_pd(_mm256_castps_pd(r), _mm256_castps_pd(t)));
+    _mm256_storeu_ps(&out[6 * s], _mm256_permute2f128_ps(v0, v1, 0x20));
+    _mm256_storeu_ps(&out[6 * s + 8], _mm256_permute2f128_ps(v2, v0, 0x30));
+    _mm256_storeu_ps(&out[6 * s + 16], _mm256_permute2f128_ps(v1, v2, 0x31));
+  }
+#elif defined(LV_HAVE_SSE)
+  __m128 sign = _mm_set1_ps(-0.0f);
+  __m128 a1 = _mm_set1_ps(l.a[0]), b1 = _mm_set1_ps(l.b[0]);
+  __m128 a3 = _mm_set1_ps(l.a[1]), b3 = _mm_set1_ps(l.b[1]);
+  __m128 a5 = _mm_set1_ps(l.a[2]), b5 = _mm_set1_ps(l.b[2]);
+  __m128 a7 = _mm_set1_ps(l.a[3]), b7 = _mm_set1_ps(l.b[3]);
+  for (; s < N - 1; s += 2) {
+    __m128 v = _mm_loadu_ps(&x[2 * s]);
+    __m128 y = _mm_andnot_ps(sign, v);
+    __m128 l1 = _mm_sub_ps(a1, _mm_mul_ps(b1, y));
+    __m128 l3 = _mm_sub_ps(a3, _mm_mul_ps(b3, y));
+    __m128 l5 = _mm_sub_ps(a5, _mm_mul_ps(b5, y));
+    __m128 l7 = _mm_sub_ps(a7, _mm_mul_ps(b7, y));
+    __m128 m13 = _mm_min_ps(l1, l3);
+    __m128 m57 = _mm_min_ps(l5, l7);
+    __m128 m = _mm_sub_ps(_mm_min_ps(m13, m57), _mm_add_ps(a1, _mm_mul_ps(b1, y)));
+    __m128 p = _mm_xor_ps(m, _mm_and_ps(sign, v));
+    __m128 r = _mm_sub_ps(m13, m57);
+    __m128 t = _mm_sub_ps(_mm_min_ps(l3, l5), _mm_min_ps(l1, l7));
+    _mm_storeu_ps(&out[6 * s], _mm_movelh_ps(p, r));
+    _mm_storeu_ps(&out[6 * s + 4], _mm_blend_ps(t, p, 0xC));
+    _mm_storeu_ps(&out[6 * s + 8], _mm_movehl_ps(t, r));
+  }
+#endif
+  for (; s < N; s++) {
+    llr_axis_qam64(&l, x[2 * s], &out[6 * s], &out[6 * s + 2], &out[6 * s + 4]);
+    llr_axis_qam64(&l, x[2 * s + 1], &out[6 * s + 1], &out[6 * s + 3], &out[6 * s + 5]);
   }
 }
 
-#else
-
 /**
  * @ingroup Soft Modulation Demapping based on the approximate
  * log-likelihood algorithm
- * Common algorithm that approximates the log-likelihood ratio. It takes
- * only the two closest constellation symbols into account, one with a '0'
- * and the other with a '1' at the given bit position.
+ * Approximates the log-likelihood ratio taking only the two closest
+ * constellation symbols into account, one with a '0' and the other with a
+ * '1' at the given bit position. Only valid for the LTE constellations.
+ * Positive values mean that the bit is more likely to be a '1'.
  *
  * \param in input symbols (_Complex float)
  * \param out output symbols (float)
  * \param N Number of input symbols
- * \param M Number of constellation points
  * \param B Number of bits per symbol
- * \param symbols constellation symbols
- * \param S Soft demapping auxiliary matrix
  * \param sigma2 Noise vatiance
  */
-void llr_approx(const _Complex float *in, float *out, int N, int M, int B,
-                _Complex float *symbols, uint32_t(*S)[6][32], uint32_t(*idx)[7],
-                uint32_t(*min)[64][6], float sigma2)
+void llr_approx(const _Complex float *in, float *out, int N, int B, float sigma2)
 {
-  int i, s, b;
-  float num, den;
-  int change_sign = -1;
-  float x, y, d[64];
-
-  for (s = 0; s < N; s++) {     /* recevied symbols */
-    /* Compute the distances squared d[i] between the received symbol and all constellation points */
-    for (i = 0; i < M; i++) {
-      x = __real__ in[s] - __real__ symbols[i];
-      y = __imag__ in[s] - __imag__ symbols[i];
-      d[i] = x * x + y * y;
-    }
-
-    for (b = 0; b < B; b++) {   /* bits per symbol */
-      /* initiate num[b] and den[b] */
-      num = d[S[0][b][0]];
-      den = d[S[1][b][0]];
-
-      /* Minimum distance squared search between recevied symbol and a constellation point with a
-         '1' and a '0' for each bit position */
-      for (i = 1; i < M / 2; i++) {     /* half the constellation points have '1'|'0' at any given bit position */
-        if (d[S[0][b][i]] < num) {
-          num = d[S[0][b][i]];
-        }
-        if (d[S[1][b][i]] < den) {
-          den = d[S[1][b][i]];
-        }
-      }
-      /* Theoretical LLR and approximate LLR values are positive if
-       * symbol(s) with '0' is/are closer and negative if symbol(s)
-       * with '1' are closer.
-       * Change sign if mapping negative to '0' and positive to '1' */
-      out[s * B + b] = change_sign * (den - num) / sigma2;
-      if (s < 10)
-        printf("out[%d]=%f=%f/%f\n", s * B + b, out[s * B + b], num, den);
-    }
-/*      if (s<10)
-        printf("out[%d]=%f=%f/%f\n",s*B+b,out[s*B+b], num,den);
-  */ }
-
+  switch (B) {
+  case 1:
+    llr_approx_bpsk(in, out, N, sigma2);
+    break;
+  case 2:
+    llr_approx_qpsk(in, out, N, sigma2);
+    break;
+  case 4:
+    llr_approx_qam16(in, out, N, sigma2);
+    break;
+  case 6:
+    llr_approx_qam64(in, out, N, sigma2);
+    break;
+  }
 }
 
-#endif
 
 /**
  * @ingroup Soft Modulation Demapping based on the approximate
@@ -93,12 +93,15 @@ void parse_args(int argc, char **argv) {
 
 
 int main(int argc, char **argv) {
-  int i;
+  int i, j;
+  uint32_t idx, nsymbols;
   modem_table_t mod;
   demod_hard_t demod_hard;
   demod_soft_t demod_soft;
   char *input, *output;
-  cf_t *symbols;
+  uint8_t *input_packed;
+  uint32_t *re_idx;
+  cf_t *symbols, *symbols_packed;
   float *llr;
 
 //  unsigned long strt, fin;
@@ -107,7 +110,8 @@ int main(int argc, char **argv) {
   
   parse_args(argc, argv);
 
-  /* initialize objects */
+  /* initialize objects. The table must not depend on the initial contents of mod */
+  memset(&mod, 0xaa, sizeof(modem_table_t));
   if (modem_table_lte(&mod, modulation, soft_output)) {
     fprintf(stderr, "Error initializing modem table\n");
     exit(-1);
@@ -144,6 +148,21 @@ int main(int argc, char **argv) {
     perror("malloc");
     exit(-1);
   }
+  symbols_packed = malloc(sizeof(cf_t) * num_bits / mod.nbits_x_symbol);
+  if (!symbols_packed) {
+    perror("malloc");
+    exit(-1);
+  }
+  input_packed = malloc(sizeof(uint8_t) * (num_bits + 7) / 8);
+  if (!input_packed) {
+    perror("malloc");
+    exit(-1);
+  }
+  re_idx = malloc(sizeof(uint32_t) * num_bits / mod.nbits_x_symbol);
+  if (!re_idx) {
+    perror("malloc");
+    exit(-1);
+  }
 
   llr = malloc(sizeof(float) * num_bits);
   if (!llr) {
@@ -159,7 +178,54 @@ int main(int argc, char **argv) {
   }
 
   /* modulate */
-  mod_modulate(&mod, input, symbols, num_bits);
+  nsymbols = num_bits / mod.nbits_x_symbol;
+  if (mod_modulate(&mod, input, symbols, num_bits) != nsymbols) {
+    fprintf(stderr, "Error modulating bits\n");
+    exit(-1);
+  }
+
+  /* every symbol must be the table entry of its bits */
+  for (i=0;i<nsymbols;i++) {
+    idx = 0;
+    for (j=0;j<mod.nbits_x_symbol;j++) {
+      idx = (idx << 1) | input[i*mod.nbits_x_symbol+j];
+    }
+    if (symbols[i] != mod.symbol_table[idx]) {
+      fprintf(stderr, "Wrong symbol %d\n", i);
+      exit(-1);
+    }
+  }
+
+  /* packed bits must give the same symbols */
+  bit_pack_vector(input, input_packed, num_bits);
+  if (mod_modulate_packed(&mod, input_packed, symbols_packed, num_bits) 
+      != num_bits / mod.nbits_x_symbol) {
+    fprintf(stderr, "Error modulating packed bits\n");
+    exit(-1);
+  }
+  if (memcmp(symbols, symbols_packed, sizeof(cf_t) * num_bits / mod.nbits_x_symbol)) {
+    fprintf(stderr, "Packed and unpacked modulation differ\n");
+    exit(-1);
+  }
+
+  /* and so must writing them to mapped positions, here in reverse order */
+  for (i=0;i<nsymbols;i++) {
+    re_idx[i] = nsymbols - 1 - i;
+  }
+  for (i=0;i<2;i++) {
+    bzero(symbols_packed, sizeof(cf_t) * nsymbols);
+    if (i == 0) {
+      mod_modulate_re(&mod, input, symbols_packed, re_idx, num_bits);
+    } else {
+      mod_modulate_packed_re(&mod, input_packed, symbols_packed, re_idx, num_bits);
+    }
+    for (j=0;j<nsymbols;j++) {
+      if (symbols_packed[re_idx[j]] != symbols[j]) {
+        fprintf(stderr, "Mapped %smodulation differs at symbol %d\n", i?"packed ":"", j);
+        exit(-1);
+      }
+    }
+  }
 
   /* demodulate */
   if (soft_output) {
@@ -186,6 +252,9 @@ int main(int argc, char **argv) {
 
   free(llr);
   free(symbols);
+  free(symbols_packed);
+  free(input_packed);
+  free(re_idx);
   free(output);
   free(input);
 
@@ -106,13 +106,37 @@ float mse_threshold() {
   }
 }
 
+/* Max-log LLRs by exhaustive search of the nearest constellation points */
+void llr_maxlog(modem_table_t *mod, cf_t *in, float *out, int nsymbols, float sigma2) {
+  int s, b, i;
+  float d, dmin[2];
+  for (s=0;s<nsymbols;s++) {
+    for (b=0;b<mod->nbits_x_symbol;b++) {
+      dmin[0] = dmin[1] = INFINITY;
+      for (i=0;i<mod->nsymbols;i++) {
+        int bit = (i >> (mod->nbits_x_symbol - 1 - b)) & 1;
+        d = crealf(in[s] - mod->symbol_table[i]) * crealf(in[s] - mod->symbol_table[i]) +
+            cimagf(in[s] - mod->symbol_table[i]) * cimagf(in[s] - mod->symbol_table[i]);
+        if (d < dmin[bit]) {
+          dmin[bit] = d;
+        }
+      }
+      out[s*mod->nbits_x_symbol+b] = (dmin[0] - dmin[1]) / sigma2;
+    }
+  }
+}
+
+#define LLR_FIXED_SCALE 4.0
+
 int main(int argc, char **argv) {
   int i;
   modem_table_t mod;
   demod_soft_t demod_soft;
   char *input, *output;
   cf_t *symbols;
-  float *llr_exact, *llr_approx;
+  float *llr_exact, *llr_approx, *llr_ref;
+  int16_t *llr_s;
+  int8_t *llr_b;
 
   parse_args(argc, argv);
 
@@ -159,6 +183,14 @@ int main(int argc, char **argv) {
     exit(-1);
   }
 
+  llr_ref = malloc(sizeof(float) * num_bits);
+  llr_s = malloc(sizeof(int16_t) * num_bits);
+  llr_b = malloc(sizeof(int8_t) * num_bits);
+  if (!llr_ref || !llr_s || !llr_b) {
+    perror("malloc");
+    exit(-1);
+  }
+
   /* generate random data */
   srand(0);
   
@@ -211,12 +243,38 @@ int main(int argc, char **argv) {
     if (mse > mse_threshold()) {
         goto clean_exit; 
     }
+
+    /* The approximation must be the max-log LLR */
+    llr_maxlog(&mod, symbols, llr_ref, num_bits / mod.nbits_x_symbol, demod_soft.sigma);
+    for (i=0;i<num_bits;i++) {
+      if (fabsf(llr_approx[i] - llr_ref[i]) > 1e-4 * (1 + fabsf(llr_ref[i]))) {
+        fprintf(stderr, "LLR %d is %f, max-log LLR is %f\n", i, llr_approx[i], llr_ref[i]);
+        mse = -1;
+        goto clean_exit;
+      }
+    }
+
+    /* Fixed-point outputs */
+    demod_soft_demodulate_s(&demod_soft, symbols, llr_s, LLR_FIXED_SCALE, NULL, num_bits / mod.nbits_x_symbol);
+    demod_soft_demodulate_b(&demod_soft, symbols, llr_b, LLR_FIXED_SCALE, NULL, num_bits / mod.nbits_x_symbol);
+    for (i=0;i<num_bits;i++) {
+      float x = LLR_FIXED_SCALE * llr_approx[i];
+      if (fabsf(llr_s[i] - x) > 0.5001 || 
+          fabsf(llr_b[i] - (x > 127 ? 127 : (x < -127 ? -127 : x))) > 0.5001) {
+        fprintf(stderr, "Fixed-point LLR %d is %d/%d, expected %f\n", i, llr_s[i], llr_b[i], x);
+        mse = -1;
+        goto clean_exit;
+      }
+    }
   }
   ret = 0; 
 
 clean_exit:  
   free(llr_exact);
   free(llr_approx);
+  free(llr_ref);
+  free(llr_s);
+  free(llr_b);
   free(symbols);
   free(output);
   free(input);
@@ -225,7 +283,7 @@ clean_exit:
 
   if (ret == 0) {
     printf("Ok Mean Throughput: %.2f. Mbps ExTime: %.2f us\n", num_bits/mean_texec, mean_texec);    
-  } else {
+  } else if (mse >= 0) {
     printf("Error: MSE too large (%f > %f)\n", mse, mse_threshold());
   }
   exit(ret);
@@ -165,21 +165,14 @@ int pcfich_decode(pcfich_t *q, cf_t *slot_symbols, cf_t *ce[MAX_PORTS],
       ce_precoding[i] = q->ce[i];
     }
 
-    /* extract symbols */
+    /* extract symbols and channel estimates */
     if (q->nof_symbols
-        != regs_pcfich_get(q->regs, slot_symbols, q->pcfich_symbols[0])) {
+        != regs_pcfich_get_ce(q->regs, slot_symbols, ce, q->cell.nof_ports, 
+                              q->pcfich_symbols[0], ce_precoding)) {
       fprintf(stderr, "There was an error getting the PCFICH symbols\n");
       return LIBLTE_ERROR;
     }
 
-    /* extract channel estimates */
-    for (i = 0; i < q->cell.nof_ports; i++) {
-      if (q->nof_symbols != regs_pcfich_get(q->regs, ce[i], q->ce[i])) {
-        fprintf(stderr, "There was an error getting the PCFICH symbols\n");
-        return LIBLTE_ERROR;
-      }
-    }
-
     /* in control channels, only diversity is supported */
     if (q->cell.nof_ports == 1) {
       /* no need for layer demapping */
@@ -48,6 +48,7 @@
 
 
 #define MIN(a,b) ((a>b)?b:a)
+#define MAX(a,b) ((a>b)?a:b)
 
 
 #define NOF_COMMON_FORMATS      2
@@ -68,7 +69,7 @@ static void set_cfi(pdcch_t *q, uint32_t cfi) {
 /** Initializes the PDCCH transmitter and receiver */
 int pdcch_init(pdcch_t *q, regs_t *regs, lte_cell_t cell) {
   int ret = LIBLTE_ERROR_INVALID_INPUTS;
-  uint32_t i;
+  uint32_t i, nof_symbols;
 
   if (q                         != NULL &&
       regs                      != NULL &&
@@ -81,8 +82,12 @@ int pdcch_init(pdcch_t *q, regs_t *regs, lte_cell_t cell) {
 
     /* Allocate memory for the largest aggregation level L=3 */
     q->max_bits = PDCCH_FORMAT_NOF_BITS(3);
+    
+    /* and for all the CCEs of the control region with CFI=3 */
+    q->max_region_bits = (regs_pdcch_nregs(q->regs, 3) / 9) * 72;
+    nof_symbols = MAX(q->max_bits, q->max_region_bits) / 2;
 
-    INFO("Init PDCCH: %d bits, %d symbols, %d ports\n", q->max_bits, q->max_bits/2, q->cell.nof_ports);
+    INFO("Init PDCCH: %d bits, %d symbols, %d ports\n", q->max_bits, nof_symbols, q->cell.nof_ports);
 
     if (modem_table_lte(&q->mod, LTE_QPSK, true)) {
       goto clean;
@@ -118,21 +123,27 @@ int pdcch_init(pdcch_t *q, regs_t *regs, lte_cell_t cell) {
       goto clean;
     }
 
-    q->pdcch_d = malloc(sizeof(cf_t) * q->max_bits / 2);
+    q->pdcch_d = malloc(sizeof(cf_t) * nof_symbols);
     if (!q->pdcch_d) {
       goto clean;
     }
 
+    q->llr_region = malloc(sizeof(float) * q->max_region_bits);
+    if (!q->llr_region) {
+      goto clean;
+    }
+    q->nof_threads = 1;
+
     for (i = 0; i < MAX_PORTS; i++) {
-      q->ce[i] = malloc(sizeof(cf_t) * q->max_bits / 2);
+      q->ce[i] = malloc(sizeof(cf_t) * nof_symbols);
       if (!q->ce[i]) {
         goto clean;
       }
-      q->pdcch_x[i] = malloc(sizeof(cf_t) * q->max_bits / 2);
+      q->pdcch_x[i] = malloc(sizeof(cf_t) * nof_symbols);
       if (!q->pdcch_x[i]) {
         goto clean;
       }
-      q->pdcch_symbols[i] = malloc(sizeof(cf_t) * q->max_bits / 2);
+      q->pdcch_symbols[i] = malloc(sizeof(cf_t) * nof_symbols);
       if (!q->pdcch_symbols[i]) {
         goto clean;
       }
@@ -147,9 +158,27 @@ int pdcch_init(pdcch_t *q, regs_t *regs, lte_cell_t cell) {
   return ret;
 }
 
+static void dci_decoders_free(pdcch_t *q) {
+  uint32_t i;
+  if (q->dci_decoders) {
+    for (i = 0; i < q->nof_threads; i++) {
+      viterbi_free(&q->dci_decoders[i].decoder);
+    }
+    free(q->dci_decoders);
+    q->dci_decoders = NULL;
+  }
+}
+
 void pdcch_free(pdcch_t *q) {
   int i;
 
+  if (q->dci_decoders) {
+    thread_pool_free(&q->pool);
+    dci_decoders_free(q);
+  }
+  if (q->llr_region) {
+    free(q->llr_region);
+  }
   if (q->pdcch_e) {
     free(q->pdcch_e);
   }
@@ -179,6 +208,53 @@ void pdcch_free(pdcch_t *q) {
   viterbi_free(&q->decoder);
 }
 
+/** Sets the number of threads used by pdcch_blind_search() to decode the DCI hypotheses. 
+ * Each thread owns its own Viterbi decoder. With nof_threads=1 the hypotheses are 
+ * decoded sequentially by the calling thread. 
+ */
+int pdcch_set_threads(pdcch_t *q, uint32_t nof_threads) {
+  uint32_t i;
+  uint32_t poly[3] = { 0x6D, 0x4F, 0x57 };
+
+  if (q           != NULL       &&
+      nof_threads  > 0          &&
+      nof_threads <= PDCCH_MAX_THREADS)
+  {
+    if (q->dci_decoders) {
+      thread_pool_free(&q->pool);
+      dci_decoders_free(q);
+    }
+    q->nof_threads = 1;
+
+    if (nof_threads > 1) {
+      q->dci_decoders = calloc(nof_threads, sizeof(pdcch_dci_decoder_t));
+      if (!q->dci_decoders) {
+        perror("calloc");
+        return LIBLTE_ERROR;
+      }
+      q->nof_threads = nof_threads;
+      for (i = 0; i < nof_threads; i++) {
+        if (viterbi_init(&q->dci_decoders[i].decoder, viterbi_37, poly, DCI_MAX_BITS + 16, true)) {
+          goto clean;
+        }
+        if (crc_init(&q->dci_decoders[i].crc, LTE_CRC16, 16)) {
+          goto clean;
+        }
+      }
+      if (thread_pool_init(&q->pool, nof_threads)) {
+        goto clean;
+      }
+    }
+    return LIBLTE_SUCCESS;
+clean:
+    dci_decoders_free(q);
+    q->nof_threads = 1;
+    return LIBLTE_ERROR;
+  } else {
+    return LIBLTE_ERROR_INVALID_INPUTS;
+  }
+}
+
 /** 36.213 v9.1.1 
  * Computes up to max_candidates UE-specific candidates for DCI messages and saves them 
  * in the structure pointed by c.
@@ -271,7 +347,8 @@ uint32_t pdcch_common_locations(pdcch_t *q, dci_location_t *c, uint32_t max_cand
  *
  * TODO: UE transmit antenna selection CRC mask
  */
-static int dci_decode(pdcch_t *q, float *e, char *data, uint32_t E, uint32_t nof_bits, uint16_t *crc) {
+static int dci_decode(pdcch_t *q, viterbi_t *decoder, crc_t *crc_p, float *e, char *data, 
+                      uint32_t E, uint32_t nof_bits, uint16_t *crc) {
 
   float tmp[3 * (DCI_MAX_BITS + 16)];
   uint16_t p_bits, crc_res;
@@ -292,7 +369,7 @@ static int dci_decode(pdcch_t *q, float *e, char *data, uint32_t E, uint32_t nof
     }
 
     /* viterbi decoder */
-    viterbi_decode_f(&q->decoder, tmp, data, nof_bits + 16);
+    viterbi_decode_f(decoder, tmp, data, nof_bits + 16);
 
     if (VERBOSE_ISDEBUG()) {
       bit_fprint(stdout, data, nof_bits + 16);
@@ -300,7 +377,7 @@ static int dci_decode(pdcch_t *q, float *e, char *data, uint32_t E, uint32_t nof
 
     x = &data[nof_bits];
     p_bits = (uint16_t) bit_unpack(&x, 16);
-    crc_res = ((uint16_t) crc_checksum(&q->crc, data, nof_bits) & 0xffff);
+    crc_res = ((uint16_t) crc_checksum(crc_p, data, nof_bits) & 0xffff);
     DEBUG("p_bits: 0x%x, crc_checksum: 0x%x, crc_rem: 0x%x\n", p_bits, crc_res,
         p_bits ^ crc_res);
     
@@ -328,7 +405,7 @@ int pdcch_decode_msg(pdcch_t *q, dci_msg_t *msg, dci_format_t format, uint16_t *
   {
     uint32_t nof_bits = dci_format_sizeof(format, q->cell.nof_prb);
     
-    ret = dci_decode(q, q->pdcch_llr, msg->data, q->e_bits, nof_bits, crc_rem);
+    ret = dci_decode(q, &q->decoder, &q->crc, q->pdcch_llr, msg->data, q->e_bits, nof_bits, crc_rem);
     if (ret == LIBLTE_SUCCESS) {
       msg->nof_bits = nof_bits;
     }
@@ -336,6 +413,62 @@ int pdcch_decode_msg(pdcch_t *q, dci_msg_t *msg, dci_format_t format, uint16_t *
   return ret;
 }
 
+/* Demodulates and descrambles the 72 bits of each of the nof_cce CCEs starting at ncce. 
+ * Every REG is equalised on its own, so the LLRs of a CCE do not depend on the range it 
+ * is extracted with. 
+ */
+static int extract_llr(pdcch_t *q, cf_t *sf_symbols, cf_t *ce[MAX_PORTS], 
+                       uint32_t ncce, uint32_t nof_cce, uint32_t nsubframe, float *llr) {
+  uint32_t i;
+  uint32_t e_bits = 72 * nof_cce;
+  uint32_t nof_symbols = e_bits/2;
+  cf_t *x[MAX_LAYERS];
+
+  INFO("Extracting LLRs: E: %d, nCCE: %d, SF: %d\n", e_bits, ncce, nsubframe);
+
+  /* number of layers equals number of ports */
+  for (i = 0; i < q->cell.nof_ports; i++) {
+    x[i] = q->pdcch_x[i];
+  }
+  memset(&x[q->cell.nof_ports], 0, sizeof(cf_t*) * (MAX_LAYERS - q->cell.nof_ports));
+
+  /* extract symbols and channel estimates */
+  int n = regs_pdcch_get_offset_ce(q->regs, sf_symbols, ce, q->cell.nof_ports, q->pdcch_symbols[0], 
+                                   q->ce, ncce * 9, nof_cce * 9);
+  if (nof_symbols != n) {
+    fprintf(stderr, "Expected %d PDCCH symbols but got %d symbols\n", nof_symbols, n);
+    return LIBLTE_ERROR;
+  }
+
+  /* in control channels, only diversity is supported */
+  if (q->cell.nof_ports == 1) {
+    /* no need for layer demapping */
+    predecoding_single_zf(q->pdcch_symbols[0], q->ce[0], q->pdcch_d, nof_symbols);
+  } else {
+    predecoding_diversity_zf(q->pdcch_symbols[0], q->ce, x, q->cell.nof_ports, nof_symbols);
+    layerdemap_diversity(x, q->pdcch_d, q->cell.nof_ports, nof_symbols / q->cell.nof_ports);
+  }
+
+  DEBUG("pdcch d symbols: ", 0);
+  if (VERBOSE_ISDEBUG()) {
+    vec_fprint_c(stdout, q->pdcch_d, nof_symbols);
+  }
+
+  /* demodulate symbols */
+  demod_soft_sigma_set(&q->demod, 1.0);
+  demod_soft_demodulate(&q->demod, q->pdcch_d, llr, nof_symbols);
+
+  DEBUG("llr: ", 0);
+  if (VERBOSE_ISDEBUG()) {
+    vec_fprint_f(stdout, llr, e_bits);
+  }
+
+  /* descramble */
+  scrambling_f_offset(&q->seq_pdcch[nsubframe], llr, 72 * ncce, e_bits);
+
+  return LIBLTE_SUCCESS;
+}
+
 /** Extracts the LLRs from dci_location_t location of the subframe and stores them in the pdcch_t structure. 
  * DCI messages can be extracted from this location calling the function pdcch_decode_msg(). 
  * Every time this function is called (with a different location), the last demodulated symbols are overwritten and
@@ -346,10 +479,6 @@ int pdcch_extract_llr(pdcch_t *q, cf_t *sf_symbols, cf_t *ce[MAX_PORTS],
 
   int ret = LIBLTE_ERROR_INVALID_INPUTS;
   
-  /* Set pointers for layermapping & precoding */
-  uint32_t i, nof_symbols;
-  cf_t *x[MAX_LAYERS];
-
   if (q                 != NULL && 
       nsubframe         <  10   &&
       cfi               >  0    &&
@@ -359,70 +488,265 @@ int pdcch_extract_llr(pdcch_t *q, cf_t *sf_symbols, cf_t *ce[MAX_PORTS],
     set_cfi(q, cfi);
     
     q->e_bits = PDCCH_FORMAT_NOF_BITS(location.L);
-    nof_symbols = q->e_bits/2;
     ret = LIBLTE_ERROR;
     
     if (location.ncce + PDCCH_FORMAT_NOF_CCE(location.L) <= q->nof_cce) {  
-      
-      INFO("Extracting LLRs: E: %d, nCCE: %d, L: %d, SF: %d, CFI: %d\n",
-          q->e_bits, location.ncce, location.L, nsubframe, cfi);
+      ret = extract_llr(q, sf_symbols, ce, location.ncce, PDCCH_FORMAT_NOF_CCE(location.L), 
+                        nsubframe, q->pdcch_llr);
+    } else {
+        fprintf(stderr, "Illegal DCI message nCCE: %d, L: %d, nof_cce: %d\n",  location.ncce, location.L, q->nof_cce);
+    }
+  } 
+  return ret;  
+}
 
-      /* number of layers equals number of ports */
-      for (i = 0; i < q->cell.nof_ports; i++) {
-        x[i] = q->pdcch_x[i];
-      }
-      memset(&x[q->cell.nof_ports], 0, sizeof(cf_t*) * (MAX_LAYERS - q->cell.nof_ports));
+/** Extracts the LLRs of all the CCEs in the control region of the subframe in one pass. 
+ * Must be called once per subframe, after regs_set_cfi(), before pdcch_blind_search(). 
+ */
+int pdcch_extract_llr_region(pdcch_t *q, cf_t *sf_symbols, cf_t *ce[MAX_PORTS], 
+                             uint32_t nsubframe, uint32_t cfi) {
 
-      /* extract symbols */
-      int n = regs_pdcch_get_offset(q->regs, sf_symbols, q->pdcch_symbols[0], 
-                                    location.ncce * 9, PDCCH_FORMAT_NOF_REGS(location.L));
-      if (nof_symbols != n) {
-        fprintf(stderr, "Expected %d PDCCH symbols but got %d symbols\n", nof_symbols, n);
-        return ret;
-      }
+  int ret = LIBLTE_ERROR_INVALID_INPUTS;
+  
+  if (q                 != NULL && 
+      sf_symbols        != NULL &&
+      nsubframe         <  10   &&
+      cfi               >  0    &&
+      cfi               <  4)
+  {
+    set_cfi(q, cfi);
+    q->region_nof_cce = 0;
 
-      /* extract channel estimates */
-      for (i = 0; i < q->cell.nof_ports; i++) {
-        n = regs_pdcch_get_offset(q->regs, ce[i], q->ce[i], 
-                                  location.ncce * 9, PDCCH_FORMAT_NOF_REGS(location.L));
-        if (nof_symbols != n) {
-          fprintf(stderr, "Expected %d PDCCH symbols but got %d symbols\n", nof_symbols, n);
-          return ret;
-        }
-      }
+    ret = extract_llr(q, sf_symbols, ce, 0, q->nof_cce, nsubframe, q->llr_region);
+    if (ret == LIBLTE_SUCCESS) {
+      q->region_nof_cce = q->nof_cce;
+    }
+  }
+  return ret;
+}
 
-      /* in control channels, only diversity is supported */
-      if (q->cell.nof_ports == 1) {
-        /* no need for layer demapping */
-        predecoding_single_zf(q->pdcch_symbols[0], q->ce[0], q->pdcch_d, nof_symbols);
-      } else {
-        predecoding_diversity_zf(q->pdcch_symbols[0], q->ce, x, q->cell.nof_ports, nof_symbols);
-        layerdemap_diversity(x, q->pdcch_d, q->cell.nof_ports, nof_symbols / q->cell.nof_ports);
-      }
+#define PDCCH_MAX_HYPOTHESES    (PDCCH_MAX_LOCATIONS * PDCCH_MAX_FORMATS)
 
-      DEBUG("pdcch d symbols: ", 0);
-      if (VERBOSE_ISDEBUG()) {
-        vec_fprint_c(stdout, q->pdcch_d, nof_symbols);
-      }
+/* Blind search state shared by the workers. Each hypothesis is a different 
+ * (location, payload size) pair and is decoded once. 
+ */
+typedef struct {
+  pdcch_t *q;
+  uint32_t nof_hypotheses;
+  dci_location_t location[PDCCH_MAX_HYPOTHESES];
+  uint32_t nof_bits[PDCCH_MAX_HYPOTHESES];
+  int ret[PDCCH_MAX_HYPOTHESES];
+  uint16_t crc_rem[PDCCH_MAX_HYPOTHESES];
+  char data[PDCCH_MAX_HYPOTHESES][DCI_MAX_BITS + 16];
+} pdcch_search_job_t;
+
+/* Returns the index of the hypothesis, adding it if it is not in the job yet */
+static uint32_t add_hypothesis(pdcch_search_job_t *job, dci_location_t location, uint32_t nof_bits) {
+  uint32_t h;
+  for (h = 0; h < job->nof_hypotheses; h++) {
+    if (job->location[h].ncce == location.ncce && 
+        job->location[h].L    == location.L    && 
+        job->nof_bits[h]      == nof_bits) 
+    {
+      return h;
+    }
+  }
+  job->location[h] = location;
+  job->nof_bits[h] = nof_bits;
+  job->nof_hypotheses++;
+  return h;
+}
+
+static void decode_hypothesis(pdcch_search_job_t *job, uint32_t h, viterbi_t *decoder, crc_t *crc) {
+  pdcch_t *q = job->q;
+
+  job->ret[h] = dci_decode(q, decoder, crc, &q->llr_region[72 * job->location[h].ncce], job->data[h], 
+                           PDCCH_FORMAT_NOF_BITS(job->location[h].L), job->nof_bits[h], &job->crc_rem[h]);
+}
+
+/* Thread pool job: decodes one hypothesis using the worker's own decoder */
+static void decode_hypothesis_job(void *arg, uint32_t h, uint32_t worker_idx) {
+  pdcch_search_job_t *job = (pdcch_search_job_t*) arg;
+  pdcch_dci_decoder_t *d = &job->q->dci_decoders[worker_idx];
+
+  decode_hypothesis(job, h, &d->decoder, &d->crc);
+}
+
+/* Checks the locations against the extracted control region and adds one hypothesis for 
+ * every different (location, payload size). hyp[l * nof_formats + f] is set to the 
+ * hypothesis of location l and format f. 
+ */
+static int search_init(pdcch_t *q, pdcch_search_job_t *job, dci_location_t *locations, 
+                       uint32_t nof_locations, dci_format_t *formats, uint32_t nof_formats, 
+                       uint32_t *hyp) 
+{
+  uint32_t i, j;
+
+  if (!q->region_nof_cce) {
+    fprintf(stderr, "Must call pdcch_extract_llr_region() first\n");
+    return LIBLTE_ERROR;
+  }
+  job->q = q;
+  job->nof_hypotheses = 0;
+  for (i = 0; i < nof_locations; i++) {
+    if (!dci_location_isvalid(&locations[i]) || 
+        locations[i].ncce + PDCCH_FORMAT_NOF_CCE(locations[i].L) > q->region_nof_cce) 
+    {
+      fprintf(stderr, "Illegal DCI message nCCE: %d, L: %d, nof_cce: %d\n", 
+              locations[i].ncce, locations[i].L, q->region_nof_cce);
+      return LIBLTE_ERROR;
+    }
+    for (j = 0; j < nof_formats; j++) {
+      hyp[i * nof_formats + j] = add_hypothesis(job, locations[i], 
+                                                dci_format_sizeof(formats[j], q->cell.nof_prb));
+    }
+  }
+  return LIBLTE_SUCCESS;
+}
+
+static int search_run(pdcch_t *q, pdcch_search_job_t *job) {
+  uint32_t h;
+
+  if (q->nof_threads > 1 && job->nof_hypotheses > 1) {
+    thread_pool_run(&q->pool, job->nof_hypotheses, decode_hypothesis_job, job);
+  } else {
+    for (h = 0; h < job->nof_hypotheses; h++) {
+      decode_hypothesis(job, h, &q->decoder, &q->crc);
+    }
+  }
+  for (h = 0; h < job->nof_hypotheses; h++) {
+    if (job->ret[h]) {
+      return LIBLTE_ERROR;
+    }
+  }
+  return LIBLTE_SUCCESS;
+}
+
+static bool rnti_match(uint16_t crc_rem, uint16_t *rntis, uint32_t nof_rntis) {
+  uint32_t i;
+  for (i = 0; i < nof_rntis; i++) {
+    if (crc_rem == rntis[i]) {
+      return true;
+    }
+  }
+  return false;
+}
 
-      /* demodulate symbols */
-      demod_soft_sigma_set(&q->demod, 1.0);
-      demod_soft_demodulate(&q->demod, q->pdcch_d, q->pdcch_llr, nof_symbols);
+static void candidate_set(pdcch_candidate_t *c, pdcch_search_job_t *job, uint32_t h) {
+  c->location = job->location[h];
+  c->rnti = job->crc_rem[h];
+  c->msg.nof_bits = job->nof_bits[h];
+  memcpy(c->msg.data, job->data[h], c->msg.nof_bits * sizeof(char));
+  INFO("Found DCI message RNTI: 0x%x, nCCE: %d, L: %d\n", c->rnti, c->location.ncce, c->location.L);
+}
 
-      DEBUG("llr: ", 0);
-      if (VERBOSE_ISDEBUG()) {
-        vec_fprint_f(stdout, q->pdcch_llr, q->e_bits);
+/** Blind decoding of the PDCCH. Decodes all (location, format) hypotheses from the LLRs 
+ * saved by pdcch_extract_llr_region(), in parallel if pdcch_set_threads() was called. 
+ * Formats with the same payload size are decoded once. 
+ * Up to max_candidates messages whose CRC remainder matches one of the nof_rntis RNTIs are 
+ * saved in candidates, sorted by location and then by format. 
+ * Returns the number of candidates found or a negative value on error. 
+ */
+int pdcch_blind_search(pdcch_t *q, dci_location_t *locations, uint32_t nof_locations, 
+                       dci_format_t *formats, uint32_t nof_formats, 
+                       uint16_t *rntis, uint32_t nof_rntis, 
+                       pdcch_candidate_t *candidates, uint32_t max_candidates) 
+{
+  pdcch_search_job_t job;
+  uint32_t hyp[PDCCH_MAX_HYPOTHESES];
+  uint32_t i, h, k;
+
+  if (q                 != NULL                 && 
+      locations         != NULL                 &&
+      formats           != NULL                 &&
+      rntis             != NULL                 &&
+      candidates        != NULL                 &&
+      nof_locations     <= PDCCH_MAX_LOCATIONS  &&
+      nof_formats       <= PDCCH_MAX_FORMATS)
+  {
+    if (search_init(q, &job, locations, nof_locations, formats, nof_formats, hyp)) {
+      return LIBLTE_ERROR;
+    }
+    if (search_run(q, &job)) {
+      return LIBLTE_ERROR;
+    }
+
+    k = 0;
+    for (i = 0; i < nof_locations * nof_formats && k < max_candidates; i++) {
+      h = hyp[i];
+      if (rnti_match(job.crc_rem[h], rntis, nof_rntis)) {
+        bzero(&candidates[k], sizeof(pdcch_candidate_t));
+        candidate_set(&candidates[k], &job, h);
+        candidates[k].format = formats[i % nof_formats];
+        k++;
       }
+    }
+    return (int) k;
+  } else {
+    return LIBLTE_ERROR_INVALID_INPUTS;
+  }
+}
 
-      /* descramble */
-      scrambling_f_offset(&q->seq_pdcch[nsubframe], q->pdcch_llr, 72 * location.ncce, q->e_bits);
+/** Decodes every DCI message in the locations, for all the formats and RNTIs. 
+ * Each (location, payload size) is Viterbi decoded once, whatever the number of formats 
+ * of that size, and the RNTI is read from the CRC remainder. The format and type of each 
+ * message found are given by dci_msg_get_type(), with crnti the C-RNTI of the UE, if any. 
+ * A message can decode in several overlapping locations, e.g. at ncce=0 with L=2 when 
+ * it was sent with L=3. Only the first location in the list is reported. 
+ * With rntis NULL or nof_rntis 0 any CRC remainder is taken as the RNTI, as in a passive 
+ * monitor, and only payloads rejected by dci_msg_get_type() are discarded. 
+ * Returns the number of messages saved in candidates or a negative value on error. 
+ */
+int pdcch_decode_all(pdcch_t *q, dci_location_t *locations, uint32_t nof_locations, 
+                     dci_format_t *formats, uint32_t nof_formats, 
+                     uint16_t *rntis, uint32_t nof_rntis, uint16_t crnti, 
+                     pdcch_candidate_t *candidates, uint32_t max_candidates) 
+{
+  pdcch_search_job_t job;
+  uint32_t hyp[PDCCH_MAX_HYPOTHESES];
+  uint32_t h, j, k;
+  pdcch_candidate_t *c;
+
+  if (q                 != NULL                 && 
+      locations         != NULL                 &&
+      formats           != NULL                 &&
+      candidates        != NULL                 &&
+      nof_locations     <= PDCCH_MAX_LOCATIONS  &&
+      nof_formats       <= PDCCH_MAX_FORMATS)
+  {
+    if (search_init(q, &job, locations, nof_locations, formats, nof_formats, hyp)) {
+      return LIBLTE_ERROR;
+    }
+    if (search_run(q, &job)) {
+      return LIBLTE_ERROR;
+    }
 
-      ret = LIBLTE_SUCCESS;
-    } else {
-        fprintf(stderr, "Illegal DCI message nCCE: %d, L: %d, nof_cce: %d\n",  location.ncce, location.L, q->nof_cce);
+    k = 0;
+    for (h = 0; h < job.nof_hypotheses && k < max_candidates; h++) {
+      if (rntis == NULL || nof_rntis == 0 || rnti_match(job.crc_rem[h], rntis, nof_rntis)) {
+        c = &candidates[k];
+        candidate_set(c, &job, h);
+        if (dci_msg_get_type(&c->msg, &c->type, q->cell.nof_prb, c->rnti, crnti)) {
+          continue;
+        }
+        c->format = c->type.format;
+        for (j = 0; j < k; j++) {
+          if (candidates[j].rnti         == c->rnti         && 
+              candidates[j].msg.nof_bits == c->msg.nof_bits && 
+              !memcmp(candidates[j].msg.data, c->msg.data, c->msg.nof_bits)) 
+          {
+            break;
+          }
+        }
+        if (j == k) {
+          k++;
+        }
+      }
     }
-  } 
-  return ret;  
+    return (int) k;
+  } else {
+    return LIBLTE_ERROR_INVALID_INPUTS;
+  }
 }
 
 
@@ -52,16 +52,19 @@ const lte_mod_t modulations[4] =
     
 
 
-int pdsch_cp(pdsch_t *q, cf_t *input, cf_t *output, ra_prb_t *prb_alloc,
-    uint32_t nsubframe, bool put) {
+/* Computes the positions in the resource grid of the RE carrying the PDSCH, in
+ * the order they are mapped. Returns the number of RE.
+ *
+ * 36.211 10.3 section 6.3.5
+ */
+static uint32_t pdsch_re_map_build(pdsch_t *q, ra_prb_t *prb_alloc, uint32_t nsubframe,
+    uint32_t *re_idx) {
   uint32_t s, n, l, lp, lstart, lend, nof_refs;
   bool is_pbch, is_sss;
-  cf_t *in_ptr = input, *out_ptr = output;
+  uint32_t *idx_ptr = re_idx;
+  uint32_t grid_pos = 0;
   uint32_t offset = 0;
 
-  INFO("%s %d RE from %d PRB\n", put ? "Putting" : "Getting",
-      prb_alloc->re_sf[nsubframe], prb_alloc->slot[0].nof_prb);
-
   if (q->cell.nof_ports == 1) {
     nof_refs = 2;
   } else {
@@ -96,13 +99,7 @@ int pdsch_cp(pdsch_t *q, cf_t *input, cf_t *output, ra_prb_t *prb_alloc,
           }
         }
         lp = l + s * CP_NSYMB(q->cell.cp);
-        if (put) {
-          out_ptr = &output[(lp * q->cell.nof_prb + prb_alloc->slot[s].prb_idx[n])
-              * RE_X_RB];
-        } else {
-          in_ptr = &input[(lp * q->cell.nof_prb + prb_alloc->slot[s].prb_idx[n])
-              * RE_X_RB];
-        }
+        grid_pos = (lp * q->cell.nof_prb + prb_alloc->slot[s].prb_idx[n]) * RE_X_RB;
         if (l >= lstart && l < lend) {
           if (SYMBOL_HAS_REF(l, q->cell.cp, q->cell.nof_ports)) {
             if (nof_refs == 2 && l != 0) {
@@ -110,40 +107,122 @@ int pdsch_cp(pdsch_t *q, cf_t *input, cf_t *output, ra_prb_t *prb_alloc,
             } else {
               offset = q->cell.id % 3;
             }
-            prb_cp_ref(&in_ptr, &out_ptr, offset, nof_refs, nof_refs, put);
+            prb_idx_ref(&grid_pos, &idx_ptr, offset, nof_refs, nof_refs);
           } else {
-            prb_cp(&in_ptr, &out_ptr, 1);
+            prb_idx(&grid_pos, &idx_ptr, RE_X_RB);
           }
         }
         if ((q->cell.nof_prb % 2) && ((is_pbch && l < lstart) || (is_sss && l >= lend))) {
           if (prb_alloc->slot[s].prb_idx[n] == q->cell.nof_prb / 2 - 3) {
             if (SYMBOL_HAS_REF(l, q->cell.cp, q->cell.nof_ports)) {
-              prb_cp_ref(&in_ptr, &out_ptr, offset, nof_refs, nof_refs/2, put);
+              prb_idx_ref(&grid_pos, &idx_ptr, offset, nof_refs, nof_refs/2);
             } else {
-              prb_cp_half(&in_ptr, &out_ptr, 1);
+              prb_idx(&grid_pos, &idx_ptr, RE_X_RB / 2);
             }
           } else if (prb_alloc->slot[s].prb_idx[n] == q->cell.nof_prb / 2 + 3) {
-            if (put) {
-              out_ptr += 6;
-            } else {
-              in_ptr += 6;
-            }
+            grid_pos += 6;
             if (SYMBOL_HAS_REF(l, q->cell.cp, q->cell.nof_ports)) {
-              prb_cp_ref(&in_ptr, &out_ptr, offset, nof_refs, nof_refs/2, put);
+              prb_idx_ref(&grid_pos, &idx_ptr, offset, nof_refs, nof_refs/2);
             } else {
-              prb_cp_half(&in_ptr, &out_ptr, 1);
+              prb_idx(&grid_pos, &idx_ptr, RE_X_RB / 2);
             }
           }
         }
       }
     }
   }
+  return (uint32_t) (idx_ptr - re_idx);
+}
+
+static uint32_t re_map_sf_type(uint32_t nsubframe) {
+  if (nsubframe == 0 || nsubframe == 5) {
+    return nsubframe;
+  } else {
+    return 1;
+  }
+}
+
+/* FNV-1a over the fields of the allocation the RE map depends on */
+static uint32_t re_map_hash(ra_prb_t *prb_alloc, uint32_t sf_type) {
+  uint32_t s, n;
+  uint32_t h = 2166136261u;
+  h = (h ^ sf_type) * 16777619u;
+  h = (h ^ prb_alloc->lstart) * 16777619u;
+  for (s = 0; s < 2; s++) {
+    h = (h ^ prb_alloc->slot[s].nof_prb) * 16777619u;
+    for (n = 0; n < prb_alloc->slot[s].nof_prb; n++) {
+      h = (h ^ prb_alloc->slot[s].prb_idx[n]) * 16777619u;
+    }
+  }
+  return h;
+}
+
+static bool re_map_match(pdsch_re_map_t *map, uint32_t hash, ra_prb_t *prb_alloc,
+    uint32_t sf_type) {
+  uint32_t s;
+  if (map->hash    != hash              ||
+      map->sf_type != sf_type           ||
+      map->lstart  != prb_alloc->lstart)
+  {
+    return false;
+  }
+  for (s = 0; s < 2; s++) {
+    if (map->slot[s].nof_prb != prb_alloc->slot[s].nof_prb ||
+        memcmp(map->slot[s].prb_idx, prb_alloc->slot[s].prb_idx,
+            sizeof(uint32_t) * prb_alloc->slot[s].nof_prb)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/* Returns the RE map of the allocation in the cache, computing it and
+ * replacing the least recently used one if it is not there. Returns NULL if
+ * the allocation does not fit in the cell.
+ */
+static pdsch_re_map_t *pdsch_re_map(pdsch_t *q, ra_prb_t *prb_alloc, uint32_t nsubframe) {
+  uint32_t i, s;
+  uint32_t sf_type = re_map_sf_type(nsubframe);
+  uint32_t hash = re_map_hash(prb_alloc, sf_type);
+  pdsch_re_map_t *map = NULL;
+
+  if (prb_alloc->slot[0].nof_prb > q->cell.nof_prb ||
+      prb_alloc->slot[1].nof_prb > q->cell.nof_prb) {
+    return NULL;
+  }
 
-  if (put) {
-    return abs((int) (input - in_ptr));
+  q->re_map_clock++;
+  for (i = 0; i < q->nof_re_maps; i++) {
+    if (re_map_match(&q->re_maps[i], hash, prb_alloc, sf_type)) {
+      q->re_maps[i].last_used = q->re_map_clock;
+      return &q->re_maps[i];
+    }
+  }
+
+  if (q->nof_re_maps < PDSCH_RE_MAP_CACHE_LEN) {
+    map = &q->re_maps[q->nof_re_maps++];
   } else {
-    return abs((int) (output - out_ptr));
+    map = &q->re_maps[0];
+    for (i = 1; i < PDSCH_RE_MAP_CACHE_LEN; i++) {
+      if (q->re_maps[i].last_used < map->last_used) {
+        map = &q->re_maps[i];
+      }
+    }
+  }
+
+  map->hash = hash;
+  map->sf_type = sf_type;
+  map->lstart = prb_alloc->lstart;
+  for (s = 0; s < 2; s++) {
+    map->slot[s].nof_prb = prb_alloc->slot[s].nof_prb;
+    memcpy(map->slot[s].prb_idx, prb_alloc->slot[s].prb_idx,
+        sizeof(uint32_t) * prb_alloc->slot[s].nof_prb);
   }
+  map->nof_re = pdsch_re_map_build(q, prb_alloc, nsubframe, map->re_idx);
+  map->last_used = q->re_map_clock;
+
+  INFO("New PDSCH RE map with %d RE from %d PRB\n", map->nof_re, prb_alloc->slot[0].nof_prb);
+  return map;
 }
 
 /**
@@ -155,7 +234,12 @@ int pdsch_cp(pdsch_t *q, cf_t *input, cf_t *output, ra_prb_t *prb_alloc,
  */
 int pdsch_put(pdsch_t *q, cf_t *pdsch_symbols, cf_t *sf_symbols,
     ra_prb_t *prb_alloc, uint32_t subframe) {
-  return pdsch_cp(q, pdsch_symbols, sf_symbols, prb_alloc, subframe, true);
+  pdsch_re_map_t *map = pdsch_re_map(q, prb_alloc, subframe);
+  if (!map) {
+    return LIBLTE_ERROR_INVALID_INPUTS;
+  }
+  regs_scatter(pdsch_symbols, map->re_idx, sf_symbols, map->nof_re);
+  return map->nof_re;
 }
 
 /**
@@ -167,7 +251,55 @@ int pdsch_put(pdsch_t *q, cf_t *pdsch_symbols, cf_t *sf_symbols,
  */
 int pdsch_get(pdsch_t *q, cf_t *sf_symbols, cf_t *pdsch_symbols,
     ra_prb_t *prb_alloc, uint32_t subframe) {
-  return pdsch_cp(q, sf_symbols, pdsch_symbols, prb_alloc, subframe, false);
+  pdsch_re_map_t *map = pdsch_re_map(q, prb_alloc, subframe);
+  if (!map) {
+    return LIBLTE_ERROR_INVALID_INPUTS;
+  }
+  regs_gather(sf_symbols, map->re_idx, pdsch_symbols, map->nof_re);
+  return map->nof_re;
+}
+
+/* Weights the LLRs of each symbol by its SNR relative to the average one. The
+ * turbo decoder is insensitive to a common scaling of the LLRs but not to how
+ * reliable each of them is with respect to the others.
+ */
+static void llr_weight_snr(float *llr, float *snr, uint32_t nbits_x_symbol, 
+    uint32_t nof_symbols) {
+  uint32_t i, j;
+  float w;
+  float avg = vec_acc_ff(snr, nof_symbols) / nof_symbols;
+  if (avg > 0) {
+    for (i = 0; i < nof_symbols; i++) {
+      w = snr[i] / avg;
+      for (j = 0; j < nbits_x_symbol; j++) {
+        llr[i * nbits_x_symbol + j] *= w;
+      }
+    }
+  }
+}
+
+/**
+ * Extracts the PDSCH and the channel estimates of each port from the resource
+ * grid, equalizes and layer-demaps them in a single pass, without the
+ * intermediate buffers of pdsch_get(). Uses the MMSE detector if a noise
+ * estimate has been set with pdsch_set_noise_estimate() and ZF otherwise.
+ * If snr is not NULL it receives the post-equalization SNR of each symbol.
+ *
+ * Returns the number of symbols written to d
+ */
+int pdsch_get_equalized(pdsch_t *q, cf_t *sf_symbols, cf_t *ce[MAX_PORTS], cf_t *d,
+    float *snr, ra_prb_t *prb_alloc, uint32_t subframe) {
+  pdsch_re_map_t *map = pdsch_re_map(q, prb_alloc, subframe);
+  if (!map) {
+    return LIBLTE_ERROR_INVALID_INPUTS;
+  }
+  if (q->cell.nof_ports == 1) {
+    return predecoding_single_idx(sf_symbols, ce[0], map->re_idx, d, snr, 
+        q->noise_estimate, map->nof_re);
+  } else {
+    return predecoding_diversity_idx(sf_symbols, ce, map->re_idx, d, snr, 
+        q->noise_estimate, q->cell.nof_ports, map->nof_re);
+  }
 }
 
 /** Initializes the PDCCH transmitter and receiver */
@@ -205,6 +337,9 @@ int pdsch_init(pdsch_t *q, lte_cell_t cell) {
     demod_soft_alg_set(&q->demod, APPROX);
     
     q->rnti_is_set = false; 
+    q->fused_equalizer = true;
+    q->nof_threads = 1;
+    q->nof_subblocks = 1;
 
     if (tcod_init(&q->encoder, MAX_LONG_CB)) {
       goto clean;
@@ -212,12 +347,23 @@ int pdsch_init(pdsch_t *q, lte_cell_t cell) {
     if (tdec_init(&q->decoder, MAX_LONG_CB)) {
       goto clean;
     }
+    if (tdec_simd_init(&q->decoder_simd, MAX_LONG_CB)) {
+      goto clean;
+    }
+    if (sequence_cache_init(&q->seq_cache, PDSCH_SEQ_CACHE_LEN)) {
+      goto clean;
+    }
+    q->seq_pdsch = &q->seq_cache;
 
     // Allocate floats for reception (LLRs)
     q->cb_in = malloc(sizeof(char) * MAX_LONG_CB);
     if (!q->cb_in) {
       goto clean;
     }
+    q->cb_in_b = malloc(sizeof(uint8_t) * (MAX_LONG_CB / 8 + 1));
+    if (!q->cb_in_b) {
+      goto clean;
+    }
     
     q->cb_out = malloc(sizeof(float) * (3 * MAX_LONG_CB + 12));
     if (!q->cb_out) {
@@ -229,12 +375,21 @@ int pdsch_init(pdsch_t *q, lte_cell_t cell) {
     if (!q->pdsch_e) {
       goto clean;
     }
+    q->pdsch_e_b = malloc(sizeof(uint8_t) * (q->max_symbols * q->mod[3].nbits_x_symbol / 8 + 1));
+    if (!q->pdsch_e_b) {
+      goto clean;
+    }
     
     q->pdsch_d = malloc(sizeof(cf_t) * q->max_symbols);
     if (!q->pdsch_d) {
       goto clean;
     }
 
+    q->pdsch_snr = malloc(sizeof(float) * q->max_symbols);
+    if (!q->pdsch_snr) {
+      goto clean;
+    }
+
     for (i = 0; i < q->cell.nof_ports; i++) {
       q->ce[i] = malloc(sizeof(cf_t) * q->max_symbols);
       if (!q->ce[i]) {
@@ -250,6 +405,14 @@ int pdsch_init(pdsch_t *q, lte_cell_t cell) {
       }
     }
 
+    for (i = 0; i < PDSCH_RE_MAP_CACHE_LEN; i++) {
+      q->re_maps[i].re_idx = malloc(sizeof(uint32_t) * q->max_symbols);
+      if (!q->re_maps[i].re_idx) {
+        perror("malloc");
+        goto clean;
+      }
+    }
+
     ret = LIBLTE_SUCCESS;
   }
   clean: 
@@ -265,15 +428,24 @@ void pdsch_free(pdsch_t *q) {
   if (q->cb_in) {
     free(q->cb_in);
   }
+  if (q->cb_in_b) {
+    free(q->cb_in_b);
+  }
   if (q->cb_out) {
     free(q->cb_out);
   }
   if (q->pdsch_e) {
     free(q->pdsch_e);
   }
+  if (q->pdsch_e_b) {
+    free(q->pdsch_e_b);
+  }
   if (q->pdsch_d) {
     free(q->pdsch_d);
   }
+  if (q->pdsch_snr) {
+    free(q->pdsch_snr);
+  }
   for (i = 0; i < q->cell.nof_ports; i++) {
     if (q->ce[i]) {
       free(q->ce[i]);
@@ -286,30 +458,202 @@ void pdsch_free(pdsch_t *q) {
     }
   }
 
-  for (i = 0; i < NSUBFRAMES_X_FRAME; i++) {
-    sequence_free(&q->seq_pdsch[i]);
+  for (i = 0; i < PDSCH_RE_MAP_CACHE_LEN; i++) {
+    if (q->re_maps[i].re_idx) {
+      free(q->re_maps[i].re_idx);
+    }
   }
 
+  sequence_cache_free(&q->seq_cache);
+
   for (i = 0; i < 4; i++) {
     modem_table_free(&q->mod[i]);
   }
   tdec_free(&q->decoder);
+  tdec_simd_free(&q->decoder_simd);
   tcod_free(&q->encoder);
 
+  pdsch_set_threads(q, 1);
 }
 
-int pdsch_set_rnti(pdsch_t *q, uint16_t rnti) {
+static void cb_decoders_free(pdsch_t *q) {
+  uint32_t i;
+  if (q->cb_decoders) {
+    for (i = 0; i < q->nof_threads; i++) {
+      tdec_free(&q->cb_decoders[i].decoder);
+      tdec_simd_free(&q->cb_decoders[i].decoder_simd);
+      if (q->cb_decoders[i].cb_in) {
+        free(q->cb_decoders[i].cb_in);
+      }
+      if (q->cb_decoders[i].cb_in_b) {
+        free(q->cb_decoders[i].cb_in_b);
+      }
+      if (q->cb_decoders[i].cb_out) {
+        free(q->cb_decoders[i].cb_out);
+      }
+    }
+    free(q->cb_decoders);
+    q->cb_decoders = NULL;
+  }
+}
+
+/** Sets the number of threads used to decode the code blocks of a transport block. 
+ * Each thread owns its own turbo decoder. With nof_threads=1 the code blocks are 
+ * decoded sequentially by the calling thread. 
+ */
+int pdsch_set_threads(pdsch_t *q, uint32_t nof_threads) {
   uint32_t i;
-  for (i = 0; i < NSUBFRAMES_X_FRAME; i++) {
-    if (sequence_pdsch(&q->seq_pdsch[i], rnti, 0, 2 * i, q->cell.id,
-        q->max_symbols * q->mod[3].nbits_x_symbol)) {
-      return LIBLTE_ERROR; 
+  
+  if (q           != NULL       &&
+      nof_threads  > 0          &&
+      nof_threads <= PDSCH_MAX_THREADS)
+  {
+    if (q->cb_decoders) {
+      thread_pool_free(&q->pool);
+      cb_decoders_free(q);
+    }
+    q->nof_threads = 1;
+    
+    if (nof_threads > 1) {
+      q->cb_decoders = calloc(nof_threads, sizeof(pdsch_cb_decoder_t));
+      if (!q->cb_decoders) {
+        perror("calloc");
+        return LIBLTE_ERROR;
+      }
+      q->nof_threads = nof_threads;
+      for (i = 0; i < nof_threads; i++) {
+        if (tdec_init(&q->cb_decoders[i].decoder, MAX_LONG_CB)) {
+          goto clean;
+        }
+        if (tdec_simd_init(&q->cb_decoders[i].decoder_simd, MAX_LONG_CB)) {
+          goto clean;
+        }
+        if (crc_init(&q->cb_decoders[i].crc_tb, LTE_CRC24A, 24)) {
+          goto clean;
+        }
+        if (crc_init(&q->cb_decoders[i].crc_cb, LTE_CRC24B, 24)) {
+          goto clean;
+        }
+        q->cb_decoders[i].cb_in = malloc(sizeof(char) * MAX_LONG_CB);
+        if (!q->cb_decoders[i].cb_in) {
+          goto clean;
+        }
+        q->cb_decoders[i].cb_in_b = malloc(sizeof(uint8_t) * (MAX_LONG_CB / 8 + 1));
+        if (!q->cb_decoders[i].cb_in_b) {
+          goto clean;
+        }
+        q->cb_decoders[i].cb_out = malloc(sizeof(float) * (3 * MAX_LONG_CB + 12));
+        if (!q->cb_decoders[i].cb_out) {
+          goto clean;
+        }
+      }
+      if (thread_pool_init(&q->pool, nof_threads)) {
+        goto clean;
+      }
     }
+    return LIBLTE_SUCCESS;
+clean:
+    cb_decoders_free(q);
+    q->nof_threads = 1;
+    return LIBLTE_ERROR;
+  } else {
+    return LIBLTE_ERROR_INVALID_INPUTS;
+  }
+}
+
+/** Splits a transport block made of a single code block in nof_subblocks sub-blocks 
+ * which are decoded concurrently by the threads set with pdsch_set_threads(). This 
+ * reduces the decoding latency of large code blocks at the cost of a small loss. 
+ * nof_subblocks=1 (default) decodes the whole block at once. 
+ */
+int pdsch_set_subblocks(pdsch_t *q, uint32_t nof_subblocks) {
+  if (q             != NULL       &&
+      nof_subblocks  > 0          &&
+      nof_subblocks <= TDEC_MAX_SUBBLOCKS)
+  {
+    q->nof_subblocks = nof_subblocks;
+    return LIBLTE_SUCCESS;
+  } else {
+    return LIBLTE_ERROR_INVALID_INPUTS;
+  }
+}
+
+/* Chooses between the fused extraction and equalization of pdsch_get_equalized()
+ * (default) and the step by step path through pdsch_get(), predecoding and layer
+ * demapping, which leaves every intermediate buffer available for debugging.
+ */
+int pdsch_set_fused_equalizer(pdsch_t *q, bool enabled) {
+  if (q != NULL) {
+    q->fused_equalizer = enabled;
+    return LIBLTE_SUCCESS;
+  } else {
+    return LIBLTE_ERROR_INVALID_INPUTS;
+  }
+}
+
+/* Sets the noise variance per RE used by the MMSE detector, which also weights
+ * the LLR of each symbol by its post-equalization SNR. A noise estimate of 0
+ * (default) selects the ZF detector and unweighted LLRs.
+ */
+int pdsch_set_noise_estimate(pdsch_t *q, float noise_estimate) {
+  if (q              != NULL &&
+      noise_estimate >= 0)
+  {
+    q->noise_estimate = noise_estimate;
+    return LIBLTE_SUCCESS;
+  } else {
+    return LIBLTE_ERROR_INVALID_INPUTS;
+  }
+}
+
+/* Selects float (default) or fixed-point LLRs from the demapper to the turbo 
+ * decoder (see pdsch_llr_t). The fixed-point decoder does not split code blocks 
+ * in sub-blocks, so pdsch_set_subblocks() only applies to float LLRs. 
+ */
+int pdsch_set_llr_format(pdsch_t *q, pdsch_llr_t llr_format) {
+  if (q          != NULL &&
+      llr_format <= PDSCH_LLR_INT8)
+  {
+    q->llr_format = llr_format;
+    return LIBLTE_SUCCESS;
+  } else {
+    return LIBLTE_ERROR_INVALID_INPUTS;
   }
+}
+
+/* Sets the RNTI used by pdsch_encode() and pdsch_decode(). The scrambling 
+ * sequences are generated on demand, so changing it is cheap. 
+ */
+int pdsch_set_rnti(pdsch_t *q, uint16_t rnti) {
   q->rnti_is_set = true; 
   q->rnti = rnti; 
   return LIBLTE_SUCCESS;
 }
+
+/* Uses a scrambling sequence cache shared with other PDSCH objects, for 
+ * instance when monitoring many users, which may run in different threads. 
+ * cache must outlive q. If cache is NULL the own cache is used again. 
+ */
+int pdsch_set_sequence_cache(pdsch_t *q, sequence_cache_t *cache) {
+  if (q != NULL) {
+    q->seq_pdsch = cache ? cache : &q->seq_cache;
+    return LIBLTE_SUCCESS;
+  } else {
+    return LIBLTE_ERROR_INVALID_INPUTS;
+  }
+}
+
+/* Scrambling sequence of codeword 0 for the rnti and subframe with at least 
+ * len bits, to be released with sequence_cache_put() 
+ */
+static sequence_t *pdsch_sequence(pdsch_t *q, uint16_t rnti, uint32_t subframe, uint32_t len) {
+  sequence_t *seq = sequence_cache_get(q->seq_pdsch, 
+      sequence_pdsch_c_init(rnti, 0, 2 * subframe, q->cell.id), len);
+  if (!seq) {
+    fprintf(stderr, "Error generating PDSCH scrambling sequence\n");
+  }
+  return seq;
+}
 /* Calculate Codeblock Segmentation as in Section 5.1.2 of 36.212 */
 static int codeblock_segmentation(struct cb_segm *s, uint32_t tbs) {
   uint32_t Bp, B, idx1;
@@ -355,7 +699,6 @@ int pdsch_harq_init(pdsch_harq_t *p, pdsch_t *pdsch) {
   int ret = LIBLTE_ERROR_INVALID_INPUTS;
   
   if (p != NULL) {    
-    uint32_t i;
     bzero(p, sizeof(pdsch_harq_t));
     
     p->cell = pdsch->cell;
@@ -363,62 +706,130 @@ int pdsch_harq_init(pdsch_harq_t *p, pdsch_t *pdsch) {
     if (ret != LIBLTE_ERROR) {
       p->max_cb =  (uint32_t) ret / (6114 - 24) + 1; 
       
-      p->pdsch_w_buff_f = malloc(sizeof(float*) * p->max_cb);
-      if (!p->pdsch_w_buff_f) {
-        perror("malloc");
-        return LIBLTE_ERROR;
-      }
-      
-      p->pdsch_w_buff_c = malloc(sizeof(char*) * p->max_cb);
-      if (!p->pdsch_w_buff_c) {
-        perror("malloc");
+      /* The circular buffers are allocated by the first transmission using them */
+      p->pdsch_w_buff_rx = calloc(p->max_cb, sizeof(void*));
+      p->w_buff_rx_len = calloc(p->max_cb, sizeof(uint32_t));
+      p->w_buff_scale = calloc(p->max_cb, sizeof(float));
+      p->pdsch_w_buff_tx = calloc(p->max_cb, sizeof(void*));
+      p->w_buff_tx_len = calloc(p->max_cb, sizeof(uint32_t));
+      if (!p->pdsch_w_buff_rx || !p->w_buff_rx_len || !p->w_buff_scale || 
+          !p->pdsch_w_buff_tx || !p->w_buff_tx_len) 
+      {
+        perror("calloc");
+        pdsch_harq_free(p);
         return LIBLTE_ERROR;
       }
-      
-      // We add 50 % larger buffer to the maximum expected bits per subframe
-      // FIXME: Use HARQ buffer limitation based on UE category
-      p->w_buff_size = p->cell.nof_prb * MAX_PDSCH_RE(p->cell.cp) * 6 * 2 / p->max_cb;
-      for (i=0;i<p->max_cb;i++) {
-        p->pdsch_w_buff_f[i] = malloc(sizeof(float) * p->w_buff_size);
-        if (!p->pdsch_w_buff_f[i]) {
-          perror("malloc");
-          return LIBLTE_ERROR;
-        }
-        p->pdsch_w_buff_c[i] = malloc(sizeof(char) * p->w_buff_size);
-        if (!p->pdsch_w_buff_c[i]) {
-          perror("malloc");
-          return LIBLTE_ERROR;
-        }
-      }      
       ret = LIBLTE_SUCCESS;
     }
   }
   return ret;
 }
 
+static void harq_free_buffers(void **buff, uint32_t *buff_len, uint32_t max_cb) {
+  uint32_t i;
+  if (buff && buff_len) {
+    for (i=0;i<max_cb;i++) {
+      if (buff[i]) {
+        free(buff[i]);
+        buff[i] = NULL;
+      }
+      buff_len[i] = 0;
+    }
+  }
+}
+
 void pdsch_harq_free(pdsch_harq_t *p) {
   if (p) {
-    uint32_t i;
-    if (p->pdsch_w_buff_f) {
-      for (i=0;i<p->max_cb;i++) {
-        if (p->pdsch_w_buff_f[i]) {
-          free(p->pdsch_w_buff_f[i]);
-        }
-      }
-      free(p->pdsch_w_buff_f);
+    harq_free_buffers(p->pdsch_w_buff_rx, p->w_buff_rx_len, p->max_cb);
+    harq_free_buffers(p->pdsch_w_buff_tx, p->w_buff_tx_len, p->max_cb);
+    if (p->pdsch_w_buff_rx) {
+      free(p->pdsch_w_buff_rx);
     }
-    if (p->pdsch_w_buff_c) {
-      for (i=0;i<p->max_cb;i++) {
-        if (p->pdsch_w_buff_c[i]) {
-          free(p->pdsch_w_buff_c[i]);
-        }
-      }
-      free(p->pdsch_w_buff_c);
+    if (p->w_buff_rx_len) {
+      free(p->w_buff_rx_len);
+    }
+    if (p->w_buff_scale) {
+      free(p->w_buff_scale);
+    }
+    if (p->pdsch_w_buff_tx) {
+      free(p->pdsch_w_buff_tx);
+    }
+    if (p->w_buff_tx_len) {
+      free(p->w_buff_tx_len);
     }
     bzero(p, sizeof(pdsch_harq_t));
   }
 }
 
+/* Makes sure the circular buffer of a code block has at least len elements of 
+ * the given size. A new buffer starts with all LLRs at zero. 
+ */
+static int harq_buffer_alloc(void **buff, uint32_t *buff_len, uint32_t len, size_t size) {
+  if (*buff_len < len) {
+    if (*buff) {
+      free(*buff);
+    }
+    *buff = calloc(len, size);
+    if (!*buff) {
+      perror("calloc");
+      *buff_len = 0;
+      return LIBLTE_ERROR;
+    }
+    *buff_len = len;
+  }
+  return LIBLTE_SUCCESS;
+}
+
+/* Total number of soft channel bits N_soft and K_C for each UE category (36.306 
+ * Table 4.1-1 and 36.212 5.1.4.1.2). Categories 6 and 7 assume up to 2 layers. 
+ */
+static const uint32_t ue_category_nsoft[8] = {250368, 1237248, 1237248, 1827072, 
+                                              3667200, 3654144, 3654144, 35982720};
+static const uint32_t ue_category_kc[8]    = {1, 1, 1, 1, 1, 2, 2, 5};
+
+/* Soft buffer size of each code block N_cb = N_IR/C (36.212 5.1.4.1.2) for FDD, 
+ * with M_DL_HARQ=8 and K_MIMO=1 (no spatial multiplexing). rm_turbo_*_lim() 
+ * limit it to the size of the circular buffer. 
+ */
+static void harq_set_ncb(pdsch_harq_t *p) {
+  uint32_t N_ir;
+  if (p->ue_category && p->cb_segm.C) {
+    N_ir = ue_category_nsoft[p->ue_category - 1] / (ue_category_kc[p->ue_category - 1] * 8);
+    p->N_cb = N_ir / p->cb_segm.C;
+  } else {
+    p->N_cb = 0; 
+  }
+}
+
+int pdsch_harq_set_softbuf(pdsch_harq_t *p, pdsch_softbuf_t softbuf) {
+  if (p                  != NULL                 &&
+      softbuf            <= PDSCH_SOFTBUF_INT8)
+  {
+    if (softbuf != p->softbuf) {
+      harq_free_buffers(p->pdsch_w_buff_rx, p->w_buff_rx_len, p->max_cb);
+      p->softbuf = softbuf; 
+    }
+    return LIBLTE_SUCCESS;
+  } else {
+    return LIBLTE_ERROR_INVALID_INPUTS;
+  }
+}
+
+/* Sets the UE category used for the soft buffer size limitation, or 0 to use the 
+ * whole circular buffer. The eNodeB and the UE must use the same category. 
+ */
+int pdsch_harq_set_ue_category(pdsch_harq_t *p, uint32_t ue_category) {
+  if (p                  != NULL                 &&
+      ue_category        <= 8)
+  {
+    p->ue_category = ue_category; 
+    harq_set_ncb(p);
+    return LIBLTE_SUCCESS;
+  } else {
+    return LIBLTE_ERROR_INVALID_INPUTS;
+  }
+}
+
 int pdsch_harq_setup(pdsch_harq_t *p, ra_mcs_t mcs, ra_prb_t *prb_alloc) {
   int ret = LIBLTE_ERROR_INVALID_INPUTS;
   
@@ -453,6 +864,7 @@ int pdsch_harq_setup(pdsch_harq_t *p, ra_mcs_t mcs, ra_prb_t *prb_alloc) {
         p->cb_segm.C, p->max_cb);
       return LIBLTE_ERROR;
     }       
+    harq_set_ncb(p);
     ret = LIBLTE_SUCCESS;    
   }
   return ret;
@@ -468,126 +880,251 @@ uint32_t pdsch_last_noi(pdsch_t *q) {
 }
 
 
+/* Transport block being decoded, shared by all code block decoding jobs */
+typedef struct {
+  pdsch_t *q;
+  void *data;
+  void *parity;
+  bool packed;
+  uint32_t tbs;
+  uint32_t nb_e;
+  pdsch_harq_t *harq_process;
+  uint32_t rv_idx;
+  int cb_ret[PDSCH_MAX_CB];
+} pdsch_tb_job_t;
+
+/* Decodes code block i with the given decoder and scratch buffers, writing the 
+ * decoded bits at their position in data. Each code block reads and writes disjoint 
+ * regions of e_bits, data and the HARQ buffers so that they can be decoded in any order. 
+ * 
+ * Returns the number of turbo iterations or LIBLTE_ERROR. 
+ */
+static int decode_cb(pdsch_tb_job_t *job, uint32_t i, tdec_t *decoder, tdec_simd_t *decoder_simd, 
+                     crc_t *crc_tb, crc_t *crc_cb, char *cb_in, uint8_t *cb_in_b, void *cb_out) 
+{
+  pdsch_harq_t *harq_process = job->harq_process; 
+  struct cb_segm *s = &harq_process->cb_segm; 
+  pdsch_llr_t llr_format = job->q->llr_format;
+  void *e_bits = job->q->pdsch_e;
+  uint32_t cb_len, rp, wp, rlen, F, n_e, n1, w_len;
+  uint32_t nof_iterations, crc_rem;
+  void **w_buff; 
+  int ret;
+  bool early_stop;
+  crc_t *crc_ptr; 
+
+  /* Get read/write lengths */
+  if (i < s->C - s->C2) {
+    cb_len = s->K1;
+  } else {
+    cb_len = s->K2;
+  }
+  if (s->C == 1) {
+    rlen = cb_len;
+  } else {
+    rlen = cb_len - 24;
+  }
+  if (i == 0) {
+    F = s->F;
+  } else {
+    F = 0;
+  }
+  if (i < s->C - 1) {
+    n_e = job->nb_e / s->C;
+  } else {
+    n_e = job->nb_e - (s->C - 1) * (job->nb_e / s->C);
+  }
+
+  /* Read/write pointers are the accumulated lengths of the previous CBs */
+  rp = i * (job->nb_e / s->C);
+  if (i > 0) {
+    n1 = i < s->C - s->C2 ? i : s->C - s->C2;
+    wp = n1 * (s->K1 - 24) + (i - n1) * (s->K2 - 24) - s->F;
+  } else {
+    wp = 0;
+  }
+
+  DEBUG("CB#%d: cb_len: %d, rlen: %d, wp: %d, rp: %d, F: %d, E: %d\n", i,
+      cb_len, rlen - F, wp, rp, F, n_e);
+
+  /* Rate Unmatching */
+  w_len = rm_turbo_buff_len(3 * cb_len + 12, harq_process->N_cb);
+  w_buff = &harq_process->pdsch_w_buff_rx[i];
+  switch (harq_process->softbuf) {
+  case PDSCH_SOFTBUF_INT16:
+    ret = harq_buffer_alloc(w_buff, &harq_process->w_buff_rx_len[i], w_len, sizeof(int16_t));
+    if (!ret && llr_format == PDSCH_LLR_INT16) {
+      ret = rm_turbo_rx_fixed_s(*w_buff, w_len, &((int16_t*) e_bits)[rp], n_e, cb_out, 
+                                3 * cb_len + 12, job->rv_idx, harq_process->N_cb);
+    } else if (!ret) {
+      ret = rm_turbo_rx_s(*w_buff, w_len, &((float*) e_bits)[rp], n_e, cb_out, 3 * cb_len + 12, 
+                          job->rv_idx, harq_process->N_cb, &harq_process->w_buff_scale[i]);
+    }
+    break;
+  case PDSCH_SOFTBUF_INT8:
+    ret = harq_buffer_alloc(w_buff, &harq_process->w_buff_rx_len[i], w_len, sizeof(int8_t));
+    if (!ret && llr_format == PDSCH_LLR_INT8) {
+      ret = rm_turbo_rx_fixed_b(*w_buff, w_len, &((int8_t*) e_bits)[rp], n_e, cb_out, 
+                                3 * cb_len + 12, job->rv_idx, harq_process->N_cb);
+    } else if (!ret) {
+      ret = rm_turbo_rx_b(*w_buff, w_len, &((float*) e_bits)[rp], n_e, cb_out, 3 * cb_len + 12, 
+                          job->rv_idx, harq_process->N_cb, &harq_process->w_buff_scale[i]);
+    }
+    break;
+  default:
+    ret = harq_buffer_alloc(w_buff, &harq_process->w_buff_rx_len[i], w_len, sizeof(float));
+    if (!ret) {
+      ret = rm_turbo_rx_lim(*w_buff, w_len, &((float*) e_bits)[rp], n_e, cb_out, 
+                            3 * cb_len + 12, job->rv_idx, harq_process->N_cb);
+    }
+    break;
+  }
+  if (ret) {
+    fprintf(stderr, "Error in rate matching\n");
+    return LIBLTE_ERROR;
+  }
+
+  /* Turbo Decoding with CRC-based early stopping */
+  nof_iterations = 0; 
+  early_stop = false;
+  if (llr_format != PDSCH_LLR_FLOAT) {
+    tdec_simd_reset(decoder_simd, cb_len);
+  } else {
+    tdec_reset(decoder, cb_len);
+  }
+        
+  do {
+    
+    if (llr_format != PDSCH_LLR_FLOAT) {
+      tdec_simd_iteration(decoder_simd, cb_out, cb_len);
+    } else if (s->C == 1 && job->q->nof_subblocks > 1) {
+      if (tdec_iteration_par(decoder, cb_out, cb_len, job->q->nof_subblocks, 
+                             job->q->nof_threads > 1 ? &job->q->pool : NULL)) {
+        return LIBLTE_ERROR;
+      }
+    } else {
+      tdec_iteration(decoder, cb_out, cb_len); 
+    }
+    nof_iterations++;
+    
+    /* Check the Codeblock CRC (or the Transport Block CRC if there is only one 
+     * Codeblock) on the packed hard decision and stop early if correct. The 
+     * filler bits are zero and do not change the CRC. 
+     */
+    if (s->C > 1) {
+      crc_ptr = crc_cb; 
+    } else {
+      crc_ptr = crc_tb; 
+    }
+    if (llr_format != PDSCH_LLR_FLOAT) {
+      crc_rem = tdec_simd_decision_crc(decoder_simd, cb_in_b, cb_len, F, crc_ptr);
+    } else {
+      crc_rem = tdec_decision_crc(decoder, cb_in_b, cb_len, F, crc_ptr);
+    }
+    if (!crc_rem) {
+      early_stop = true;           
+    }
+    
+  } while (nof_iterations < TDEC_MAX_ITERATIONS && !early_stop);
+  
+  if (job->packed) {
+    if (i < s->C - 1) {
+      bit_copy(job->data, wp, cb_in_b, F, rlen - F);
+    } else {
+      bit_copy(job->data, wp, cb_in_b, F, rlen - F - 24);
+      bit_copy(job->parity, 0, cb_in_b, rlen - 24, 24);
+    }
+    return (int) nof_iterations;
+  }
+
+  bit_unpack_vector(cb_in_b, cb_in, cb_len);
+        
+  /* Copy data to another buffer, removing the Codeblock CRC */
+  if (i < s->C - 1) {
+    memcpy(&((char*) job->data)[wp], &cb_in[F], (rlen - F) * sizeof(char));
+  } else {
+    DEBUG("Last CB, appending parity: %d to %d from %d and 24 from %d\n",
+        rlen - F - 24, wp, F, rlen - 24);
+    
+    /* Append Transport Block parity bits to the last CB */
+    memcpy(&((char*) job->data)[wp], &cb_in[F], (rlen - F - 24) * sizeof(char));
+    memcpy(job->parity, &cb_in[rlen - 24], 24 * sizeof(char));
+  }
+  return (int) nof_iterations;
+}
+
+/* Thread pool job: decodes one code block using the worker's own decoder */
+static void decode_cb_job(void *arg, uint32_t i, uint32_t worker_idx) {
+  pdsch_tb_job_t *job = (pdsch_tb_job_t*) arg; 
+  pdsch_cb_decoder_t *d = &job->q->cb_decoders[worker_idx];
+  
+  job->cb_ret[i] = decode_cb(job, i, &d->decoder, &d->decoder_simd, &d->crc_tb, &d->crc_cb, 
+                             d->cb_in, d->cb_in_b, d->cb_out);
+}
+
 /* Decode a transport block according to 36.212 5.3.2
  *
+ * With packed=true the decoded bits are written packed MSB first. 
  */
-int pdsch_decode_tb(pdsch_t *q, char *data, uint32_t tbs, uint32_t nb_e, 
-                    pdsch_harq_t *harq_process, uint32_t rv_idx) 
+static int decode_tb(pdsch_t *q, void *data, bool packed, uint32_t tbs, uint32_t nb_e, 
+                     pdsch_harq_t *harq_process, uint32_t rv_idx) 
 {
   char parity[24];
   char *p_parity = parity;
+  uint8_t parity_b[3];
   uint32_t par_rx, par_tx;
   uint32_t i;
-  uint32_t cb_len, rp, wp, rlen, F, n_e;
-  float *e_bits = q->pdsch_e;
+  pdsch_tb_job_t job;
   
   if (q         != NULL   && 
       data      != NULL   &&       
-      nb_e      < q->max_symbols * q->mod[3].nbits_x_symbol)
+      nb_e      < q->max_symbols * q->mod[3].nbits_x_symbol && 
+      harq_process->cb_segm.C <= PDSCH_MAX_CB)
   {
 
-    rp = 0;
-    rp = 0;
-    wp = 0;
-    for (i = 0; i < harq_process->cb_segm.C; i++) {
-
-      /* Get read/write lengths */
-      if (i < harq_process->cb_segm.C - harq_process->cb_segm.C2) {
-        cb_len = harq_process->cb_segm.K1;
-      } else {
-        cb_len = harq_process->cb_segm.K2;
-      }
-      if (harq_process->cb_segm.C == 1) {
-        rlen = cb_len;
-      } else {
-        rlen = cb_len - 24;
-      }
-      if (i == 0) {
-        F = harq_process->cb_segm.F;
-      } else {
-        F = 0;
-      }
-
-      if (i < harq_process->cb_segm.C - 1) {
-        n_e = nb_e / harq_process->cb_segm.C;
-      } else {
-        n_e = nb_e - rp;
+    job.q = q; 
+    job.data = data; 
+    job.parity = packed ? (void*) parity_b : (void*) parity; 
+    job.packed = packed; 
+    job.tbs = tbs; 
+    job.nb_e = nb_e; 
+    job.harq_process = harq_process; 
+    job.rv_idx = rv_idx; 
+    
+    /* Packed code blocks only start at byte boundaries, and never write the same 
+     * byte, if the transport block size is a multiple of 8 bits. 
+     */
+    if (q->nof_threads > 1 && harq_process->cb_segm.C > 1 && (!packed || tbs % 8 == 0)) {
+      /* Code blocks are handed out to the first idle worker */
+      thread_pool_run(&q->pool, harq_process->cb_segm.C, decode_cb_job, &job);
+    } else {
+      for (i = 0; i < harq_process->cb_segm.C; i++) {
+        job.cb_ret[i] = decode_cb(&job, i, &q->decoder, &q->decoder_simd, &q->crc_tb, 
+                                  &q->crc_cb, q->cb_in, q->cb_in_b, q->cb_out);
       }
-
-      DEBUG("CB#%d: cb_len: %d, rlen: %d, wp: %d, rp: %d, F: %d, E: %d\n", i,
-          cb_len, rlen - F, wp, rp, F, n_e);
-
-      
-      /* Rate Unmatching */
-      if (rm_turbo_rx(harq_process->pdsch_w_buff_f[i], harq_process->w_buff_size,  
-                  &e_bits[rp], n_e, 
-                  (float*) q->cb_out, 3 * cb_len + 12, rv_idx)) {
-        fprintf(stderr, "Error in rate matching\n");
+    }
+    
+    for (i = 0; i < harq_process->cb_segm.C; i++) {
+      if (job.cb_ret[i] < 0) {
         return LIBLTE_ERROR;
       }
-
-      /* Turbo Decoding with CRC-based early stopping */
-      q->nof_iterations = 0; 
-      bool early_stop = false;
-      uint32_t len_crc; 
-      char *cb_in_ptr; 
-      crc_t *crc_ptr; 
-      tdec_reset(&q->decoder, cb_len);
-            
-      do {
-        
-        tdec_iteration(&q->decoder, (float*) q->cb_out, cb_len); 
-        q->nof_iterations++;
-        
-        if (harq_process->cb_segm.C > 1) {
-          len_crc = cb_len; 
-          cb_in_ptr = q->cb_in; 
-          crc_ptr = &q->crc_cb; 
-        } else {
-          len_crc = tbs+24; 
-          bzero(q->cb_in, F*sizeof(char));
-          cb_in_ptr = &q->cb_in[F];
-          crc_ptr = &q->crc_tb; 
-        }
-
-        tdec_decision(&q->decoder, q->cb_in, cb_len);
-  
-        /* Check Codeblock CRC and stop early if incorrect */
-        if (!crc_checksum(crc_ptr, cb_in_ptr, len_crc)) {
-          early_stop = true;           
-        }
-        
-      } while (q->nof_iterations < TDEC_MAX_ITERATIONS && !early_stop);
-            
+      q->nof_iterations = (uint32_t) job.cb_ret[i];
       q->average_nof_iterations = EXPAVERAGE((float) q->nof_iterations, 
                                              q->average_nof_iterations, 
                                              q->average_nof_iterations_n);
       q->average_nof_iterations_n++;
-
-      /* Copy data to another buffer, removing the Codeblock CRC */
-      if (i < harq_process->cb_segm.C - 1) {
-        memcpy(&data[wp], &q->cb_in[F], (rlen - F) * sizeof(char));
-      } else {
-        DEBUG("Last CB, appending parity: %d to %d from %d and 24 from %d\n",
-            rlen - F - 24, wp, F, rlen - 24);
-        
-        /* Append Transport Block parity bits to the last CB */
-        memcpy(&data[wp], &q->cb_in[F], (rlen - F - 24) * sizeof(char));
-        memcpy(parity, &q->cb_in[rlen - 24], 24 * sizeof(char));
-      }
-
-      /* Set read/write pointers */
-      wp += (rlen - F);
-      rp += n_e;
     }
 
-    DEBUG("END CB#%d: wp: %d, rp: %d\n", i, wp, rp);
-
-    // Compute transport block CRC
-    par_rx = crc_checksum(&q->crc_tb, data, tbs);
+    DEBUG("END CB#%d\n", i);
 
-    // check parity bits
-    par_tx = bit_unpack(&p_parity, 24);
+    // Compute transport block CRC and check parity bits
+    if (packed) {
+      par_rx = crc_checksum_packed(&q->crc_tb, data, tbs);
+      par_tx = ((uint32_t) parity_b[0] << 16) | ((uint32_t) parity_b[1] << 8) | parity_b[2];
+    } else {
+      par_rx = crc_checksum(&q->crc_tb, data, tbs);
+      par_tx = bit_unpack(&p_parity, 24);
+    }
 
     if (!par_rx) {
       INFO("\n\tCAUTION!! Received all-zero transport block\n\n", 0);
@@ -605,15 +1142,90 @@ int pdsch_decode_tb(pdsch_t *q, char *data, uint32_t tbs, uint32_t nb_e,
   }
 }
 
-/** Decodes the PDSCH from the received symbols
+int pdsch_decode_tb(pdsch_t *q, char *data, uint32_t tbs, uint32_t nb_e, 
+                    pdsch_harq_t *harq_process, uint32_t rv_idx) 
+{
+  return decode_tb(q, data, false, tbs, nb_e, harq_process, rv_idx);
+}
+
+/* Mean energy of the LTE QAM constellations is 1, so the innermost points are at 
+ * +-c on each axis with c^2 = 3/(2*(M-1)) 
+ */
+static float mod_inner_level2(uint32_t nbits_x_symbol) {
+  return 3.0 / (2 * ((1 << nbits_x_symbol) - 1));
+}
+
+/* Demaps and descrambles q->pdsch_d to fixed-point LLRs in q->pdsch_e, with the 
+ * scaling described in pdsch_llr_t. The HARQ process is switched to soft buffers 
+ * of the same type only with rv_idx=0, since switching discards the buffers a 
+ * retransmission is combined with. 
+ */
+static int pdsch_llr_fixed(pdsch_t *q, float *snr, sequence_t *seq, 
+    pdsch_harq_t *harq_process, uint32_t nof_symbols, uint32_t nof_bits_e, 
+    uint32_t rv_idx) {
+  uint32_t nbits = q->mod[harq_process->mcs.mod - 1].nbits_x_symbol;
+  pdsch_softbuf_t softbuf;
+  float scale, avg;
+  
+  softbuf = q->llr_format == PDSCH_LLR_INT16 ? PDSCH_SOFTBUF_INT16 : PDSCH_SOFTBUF_INT8;
+  if (softbuf != harq_process->softbuf) {
+    if (rv_idx != 0) {
+      fprintf(stderr, "HARQ soft buffers do not match the LLR format, set them before rv_idx=%d\n", 
+              rv_idx);
+      return LIBLTE_ERROR;
+    }
+    if (pdsch_harq_set_softbuf(harq_process, softbuf)) {
+      return LIBLTE_ERROR;
+    }
+  }
+  
+  /* LLR of 1 for the sign bits of the innermost points */
+  demod_soft_sigma_set(&q->demod, 2 * mod_inner_level2(nbits));
+  scale = q->llr_format == PDSCH_LLR_INT16 ? PDSCH_LLR_UNIT_S : PDSCH_LLR_UNIT_B;
+  
+  /* Weights are relative to the average SNR, as in llr_weight_snr() */
+  if (snr) {
+    avg = vec_acc_ff(snr, nof_symbols) / nof_symbols;
+    if (avg > 0) {
+      scale /= avg;
+    } else {
+      snr = NULL;
+    }
+  }
+  
+  if (q->llr_format == PDSCH_LLR_INT16) {
+    demod_soft_demodulate_s(&q->demod, q->pdsch_d, q->pdsch_e, scale, snr, nof_symbols);
+    scrambling_s_offset(seq, q->pdsch_e, 0, nof_bits_e);
+  } else {
+    demod_soft_demodulate_b(&q->demod, q->pdsch_d, q->pdsch_e, scale, snr, nof_symbols);
+    scrambling_sb_offset(seq, q->pdsch_e, 0, nof_bits_e);
+  }
+  return LIBLTE_SUCCESS;
+}
+
+/** Decodes the PDSCH from the received symbols with the RNTI set with pdsch_set_rnti()
  */
 int pdsch_decode(pdsch_t *q, cf_t *sf_symbols, cf_t *ce[MAX_PORTS], char *data, uint32_t subframe, 
                  pdsch_harq_t *harq_process, uint32_t rv_idx) 
 {
+  if (q != NULL && !q->rnti_is_set) {
+    fprintf(stderr, "Must call pdsch_set_rnti() to set the encoder/decoder RNTI\n");
+    return LIBLTE_ERROR_INVALID_INPUTS;
+  }
+  return pdsch_decode_rnti(q, sf_symbols, ce, data, subframe, harq_process, rv_idx, 
+                           q != NULL ? q->rnti : 0);
+}
+
+static int decode_rnti(pdsch_t *q, cf_t *sf_symbols, cf_t *ce[MAX_PORTS], void *data, bool packed, 
+                       uint32_t subframe, pdsch_harq_t *harq_process, uint32_t rv_idx, 
+                       uint16_t rnti) 
+{
 
   /* Set pointers for layermapping & precoding */
   uint32_t i, n;
   cf_t *x[MAX_LAYERS];
+  float *snr;
+  sequence_t *seq;
   uint32_t nof_symbols, nof_bits, nof_bits_e;
   
   if (q                     != NULL &&
@@ -632,82 +1244,117 @@ int pdsch_decode(pdsch_t *q, cf_t *sf_symbols, cf_t *ce[MAX_PORTS], char *data,
     INFO("Decoding PDSCH SF: %d, Mod %d, NofBits: %d, NofSymbols: %d, NofBitsE: %d, rv_idx: %d\n",
         subframe, harq_process->mcs.mod, nof_bits, nof_symbols, nof_bits_e, rv_idx);
 
+    /* the post-equalization SNR is only meaningful with a noise estimate */
+    snr = q->noise_estimate > 0 ? q->pdsch_snr : NULL;
+
     /* number of layers equals number of ports */
     for (i = 0; i < q->cell.nof_ports; i++) {
       x[i] = q->pdsch_x[i];
     }
     memset(&x[q->cell.nof_ports], 0, sizeof(cf_t*) * (MAX_LAYERS - q->cell.nof_ports));
       
-    /* extract symbols */
-    n = pdsch_get(q, sf_symbols, q->pdsch_symbols[0], &harq_process->prb_alloc, subframe);
-    if (n != nof_symbols) {
-      fprintf(stderr, "Error expecting %d symbols but got %d\n", nof_symbols, n);
-      return LIBLTE_ERROR;
-    }
-
-    /* extract channel estimates */
-    for (i = 0; i < q->cell.nof_ports; i++) {
-      n = pdsch_get(q, ce[i], q->ce[i], &harq_process->prb_alloc, subframe);
+    if (q->fused_equalizer) {
+      /* extract, equalize and layer-demap in a single pass */
+      n = pdsch_get_equalized(q, sf_symbols, ce, q->pdsch_d, snr, &harq_process->prb_alloc, subframe);
       if (n != nof_symbols) {
         fprintf(stderr, "Error expecting %d symbols but got %d\n", nof_symbols, n);
         return LIBLTE_ERROR;
       }
-    }
-      
-    /* TODO: only diversity is supported */
-    if (q->cell.nof_ports == 1) {
-      /* no need for layer demapping */
-      predecoding_single_zf(q->pdsch_symbols[0], q->ce[0], q->pdsch_d,
-          nof_symbols);
     } else {
-      predecoding_diversity_zf(q->pdsch_symbols[0], q->ce, x, q->cell.nof_ports,
-          nof_symbols);
-      layerdemap_diversity(x, q->pdsch_d, q->cell.nof_ports,
-          nof_symbols / q->cell.nof_ports);
+      /* extract symbols */
+      n = pdsch_get(q, sf_symbols, q->pdsch_symbols[0], &harq_process->prb_alloc, subframe);
+      if (n != nof_symbols) {
+        fprintf(stderr, "Error expecting %d symbols but got %d\n", nof_symbols, n);
+        return LIBLTE_ERROR;
+      }
+
+      /* extract channel estimates */
+      for (i = 0; i < q->cell.nof_ports; i++) {
+        n = pdsch_get(q, ce[i], q->ce[i], &harq_process->prb_alloc, subframe);
+        if (n != nof_symbols) {
+          fprintf(stderr, "Error expecting %d symbols but got %d\n", nof_symbols, n);
+          return LIBLTE_ERROR;
+        }
+      }
+      
+      /* TODO: only diversity is supported */
+      if (q->cell.nof_ports == 1) {
+        /* no need for layer demapping */
+        predecoding_single_mmse(q->pdsch_symbols[0], q->ce[0], q->pdsch_d, snr,
+            q->noise_estimate, nof_symbols);
+      } else {
+        predecoding_diversity_mmse(q->pdsch_symbols[0], q->ce, x, snr, q->noise_estimate,
+            q->cell.nof_ports, nof_symbols);
+        layerdemap_diversity(x, q->pdsch_d, q->cell.nof_ports,
+            nof_symbols / q->cell.nof_ports);
+      }
     }
-    
-    /* demodulate symbols 
-     * The MAX-log-MAP algorithm used in turbo decoding is unsensitive to SNR estimation, 
-     * thus we don't need tot set it in the LLRs normalization
-     */
-    demod_soft_sigma_set(&q->demod, 2.0 / q->mod[harq_process->mcs.mod - 1].nbits_x_symbol);
+
+    seq = pdsch_sequence(q, rnti, subframe, nof_bits_e);
+    if (!seq) {
+      return LIBLTE_ERROR;
+    }
+
     demod_soft_table_set(&q->demod, &q->mod[harq_process->mcs.mod - 1]);
-    demod_soft_demodulate(&q->demod, q->pdsch_d, q->pdsch_e, nof_symbols);
- 
-    /*
-    for (int j=0;j<nof_symbols;j++) {
-      if (isnan(crealf(q->pdsch_d[j])) || isnan(cimagf(q->pdsch_d[j]))) {
-        printf("\nerror in d[%d]=%f+%f symbols:%f+%f ce0:%f+%f ce1:%f+%f\n",j,
-               crealf(q->pdsch_d[j]), cimagf(q->pdsch_d[j]), 
-               crealf(q->pdsch_symbols[0][j]), cimagf(q->pdsch_symbols[0][j]), 
-               crealf(q->ce[0][j]), cimagf(q->ce[0][j]), 
-               crealf(q->ce[1][j]), cimagf(q->ce[1][j])
-              );
-      }
-    }
-    */
-
-    /* descramble */
-    scrambling_f_offset(&q->seq_pdsch[subframe], q->pdsch_e, 0, nof_bits_e);
+    if (q->llr_format == PDSCH_LLR_FLOAT) {
+      /* demodulate symbols 
+       * The MAX-log-MAP algorithm used in turbo decoding is unsensitive to SNR estimation, 
+       * thus we don't need tot set it in the LLRs normalization
+       */
+      demod_soft_sigma_set(&q->demod, 2.0 / q->mod[harq_process->mcs.mod - 1].nbits_x_symbol);
+      demod_soft_demodulate(&q->demod, q->pdsch_d, q->pdsch_e, nof_symbols);
+      if (snr) {
+        llr_weight_snr(q->pdsch_e, snr, q->mod[harq_process->mcs.mod - 1].nbits_x_symbol, 
+            nof_symbols);
+      }
+
+      /* descramble */
+      scrambling_f_offset(seq, q->pdsch_e, 0, nof_bits_e);
+    } else if (pdsch_llr_fixed(q, snr, seq, harq_process, nof_symbols, nof_bits_e, rv_idx)) {
+      sequence_cache_put(q->seq_pdsch, seq);
+      return LIBLTE_ERROR;
+    }
+    sequence_cache_put(q->seq_pdsch, seq);
     
-    return pdsch_decode_tb(q, data, nof_bits, nof_bits_e, harq_process, rv_idx);
+    return decode_tb(q, data, packed, nof_bits, nof_bits_e, harq_process, rv_idx);
   } else {
     return LIBLTE_ERROR_INVALID_INPUTS;
   }
 }
 
+/** Decodes the PDSCH from the received symbols scrambled for rnti
+ */
+int pdsch_decode_rnti(pdsch_t *q, cf_t *sf_symbols, cf_t *ce[MAX_PORTS], char *data, uint32_t subframe, 
+                      pdsch_harq_t *harq_process, uint32_t rv_idx, uint16_t rnti) 
+{
+  return decode_rnti(q, sf_symbols, ce, data, false, subframe, harq_process, rv_idx, rnti);
+}
+
+/** Same as pdsch_decode_rnti() with the decoded bits packed MSB first, 8 per byte
+ */
+int pdsch_decode_packed(pdsch_t *q, cf_t *sf_symbols, cf_t *ce[MAX_PORTS], uint8_t *data, 
+                        uint32_t subframe, pdsch_harq_t *harq_process, uint32_t rv_idx, 
+                        uint16_t rnti) 
+{
+  return decode_rnti(q, sf_symbols, ce, data, true, subframe, harq_process, rv_idx, rnti);
+}
+
 /* Encode a transport block according to 36.212 5.3.2
  *
+ * With packed=true data and the rate matched bits in q->pdsch_e are packed MSB first. 
+ * The HARQ circular buffers hold one bit per char in both cases. 
  */
-int pdsch_encode_tb(pdsch_t *q, char *data, uint32_t tbs, uint32_t nb_e, 
-                    pdsch_harq_t *harq_process, uint32_t rv_idx) 
+static int encode_tb(pdsch_t *q, void *data, bool packed, uint32_t tbs, uint32_t nb_e, 
+                     pdsch_harq_t *harq_process, uint32_t rv_idx) 
 {
   char parity[24];
   char *p_parity = parity;
+  uint8_t parity_b[3];
   uint32_t par;
   uint32_t i;
-  uint32_t cb_len, rp, wp, rlen, F, n_e;
+  uint32_t cb_len, rp, wp, rlen, F, n_e, w_len;
   char *e_bits = q->pdsch_e;
+  uint8_t *cb_out_b = q->cb_out;
   int ret = LIBLTE_ERROR_INVALID_INPUTS; 
   
   if (q             != NULL &&
@@ -715,111 +1362,159 @@ int pdsch_encode_tb(pdsch_t *q, char *data, uint32_t tbs, uint32_t nb_e,
       nb_e          <  q->max_symbols * q->mod[3].nbits_x_symbol)
   {
   
-    if (q->rnti_is_set) {
-      if (rv_idx == 0) {
-        /* Compute transport block CRC */
-        par = crc_checksum(&q->crc_tb, data, tbs);
+    if (rv_idx == 0 && packed) {
+      par = crc_checksum_packed(&q->crc_tb, data, tbs);
+      parity_b[0] = (uint8_t) (par >> 16);
+      parity_b[1] = (uint8_t) (par >> 8);
+      parity_b[2] = (uint8_t) par;
+    } else if (rv_idx == 0) {
+      /* Compute transport block CRC */
+      par = crc_checksum(&q->crc_tb, data, tbs);
+
+      /* parity bits will be appended later */
+      bit_pack(par, &p_parity, 24);
+
+      if (VERBOSE_ISDEBUG()) {
+        DEBUG("DATA: ", 0);
+        vec_fprint_b(stdout, data, tbs);
+        DEBUG("PARITY: ", 0);
+        vec_fprint_b(stdout, parity, 24);
+      }
 
-        /* parity bits will be appended later */
-        bit_pack(par, &p_parity, 24);
+      /* Add filler bits to the new data buffer */
+      for (i = 0; i < harq_process->cb_segm.F; i++) {
+        q->cb_in[i] = LTE_NULL_BIT;
+      }
+    }
+    
+    wp = 0;
+    rp = 0;
+    for (i = 0; i < harq_process->cb_segm.C; i++) {
 
-        if (VERBOSE_ISDEBUG()) {
-          DEBUG("DATA: ", 0);
-          vec_fprint_b(stdout, data, tbs);
-          DEBUG("PARITY: ", 0);
-          vec_fprint_b(stdout, parity, 24);
-        }
+      /* Get read lengths */
+      if (i < harq_process->cb_segm.C - harq_process->cb_segm.C2) {
+        cb_len = harq_process->cb_segm.K1;
+      } else {
+        cb_len = harq_process->cb_segm.K2;
+      }
+      if (harq_process->cb_segm.C > 1) {
+        rlen = cb_len - 24;
+      } else {
+        rlen = cb_len;
+      }
+      if (i == 0) {
+        F = harq_process->cb_segm.F;
+      } else {
+        F = 0;
+      }
 
-        /* Add filler bits to the new data buffer */
-        for (i = 0; i < harq_process->cb_segm.F; i++) {
-          q->cb_in[i] = LTE_NULL_BIT;
-        }
+      if (i < harq_process->cb_segm.C - 1) {
+        n_e = nb_e / harq_process->cb_segm.C;
+      } else {
+        n_e = nb_e - wp;
       }
-      
-      wp = 0;
-      rp = 0;
-      for (i = 0; i < harq_process->cb_segm.C; i++) {
 
-        /* Get read lengths */
-        if (i < harq_process->cb_segm.C - harq_process->cb_segm.C2) {
-          cb_len = harq_process->cb_segm.K1;
+      INFO("CB#%d: cb_len: %d, rlen: %d, wp: %d, rp: %d, F: %d, E: %d\n", i,
+          cb_len, rlen - F, wp, rp, F, n_e);
+
+      if (rv_idx == 0 && packed) {
+        /* Filler bits are zero */
+        bzero(q->cb_in_b, (F + 7) / 8);
+        if (i < harq_process->cb_segm.C - 1) {
+          bit_copy(q->cb_in_b, F, data, rp, rlen - F);
         } else {
-          cb_len = harq_process->cb_segm.K2;
+          bit_copy(q->cb_in_b, F, data, rp, rlen - F - 24);
+          bit_copy(q->cb_in_b, rlen - 24, parity_b, 0, 24);
         }
         if (harq_process->cb_segm.C > 1) {
-          rlen = cb_len - 24;
-        } else {
-          rlen = cb_len;
-        }
-        if (i == 0) {
-          F = harq_process->cb_segm.F;
-        } else {
-          F = 0;
+          crc_attach_packed(&q->crc_cb, q->cb_in_b, rlen);
         }
-
+        tcod_encode_packed(&q->encoder, q->cb_in_b, cb_out_b, cb_len);
+      } else if (rv_idx == 0) {
+        /* Copy data to another buffer, making space for the Codeblock CRC */
         if (i < harq_process->cb_segm.C - 1) {
-          n_e = nb_e / harq_process->cb_segm.C;
+          memcpy(&q->cb_in[F], &((char*) data)[rp], (rlen - F) * sizeof(char));
         } else {
-          n_e = nb_e - wp;
-        }
-
-        INFO("CB#%d: cb_len: %d, rlen: %d, wp: %d, rp: %d, F: %d, E: %d\n", i,
-            cb_len, rlen - F, wp, rp, F, n_e);
-
-        if (rv_idx == 0) {
-          /* Copy data to another buffer, making space for the Codeblock CRC */
-          if (i < harq_process->cb_segm.C - 1) {
-            memcpy(&q->cb_in[F], &data[rp], (rlen - F) * sizeof(char));
-          } else {
-            INFO("Last CB, appending parity: %d from %d and 24 to %d\n",
-                rlen - F - 24, rp, rlen - 24);
-            /* Append Transport Block parity bits to the last CB */
-            memcpy(&q->cb_in[F], &data[rp], (rlen - F - 24) * sizeof(char));
-            memcpy(&q->cb_in[rlen - 24], parity, 24 * sizeof(char));
-          }        
-          if (harq_process->cb_segm.C > 1) {
-            /* Attach Codeblock CRC */
-            crc_attach(&q->crc_cb, q->cb_in, rlen);
-          }
-          if (VERBOSE_ISDEBUG()) {
-            DEBUG("CB#%d Len=%d: ", i, cb_len);
-            vec_fprint_b(stdout, q->cb_in, cb_len);
-          }
-          /* Turbo Encoding */
-          tcod_encode(&q->encoder, q->cb_in, (char*) q->cb_out, cb_len);
+          INFO("Last CB, appending parity: %d from %d and 24 to %d\n",
+              rlen - F - 24, rp, rlen - 24);
+          /* Append Transport Block parity bits to the last CB */
+          memcpy(&q->cb_in[F], &((char*) data)[rp], (rlen - F - 24) * sizeof(char));
+          memcpy(&q->cb_in[rlen - 24], parity, 24 * sizeof(char));
+        }        
+        if (harq_process->cb_segm.C > 1) {
+          /* Attach Codeblock CRC */
+          crc_attach(&q->crc_cb, q->cb_in, rlen);
         }
-        
-        /* Rate matching */
-        if (rm_turbo_tx(harq_process->pdsch_w_buff_c[i], harq_process->w_buff_size, 
-                    (char*) q->cb_out, 3 * cb_len + 12,
-                    &e_bits[wp], n_e, rv_idx))
-        {
-          fprintf(stderr, "Error in rate matching\n");
-          return LIBLTE_ERROR;
+        if (VERBOSE_ISDEBUG()) {
+          DEBUG("CB#%d Len=%d: ", i, cb_len);
+          vec_fprint_b(stdout, q->cb_in, cb_len);
         }
-
-        /* Set read/write pointers */
-        rp += (rlen - F);
-        wp += n_e;
+        /* Turbo Encoding */
+        tcod_encode(&q->encoder, q->cb_in, (char*) q->cb_out, cb_len);
       }
-
-      INFO("END CB#%d: wp: %d, rp: %d\n", i, wp, rp);
       
-      ret = LIBLTE_SUCCESS;      
-    } else {
-      fprintf(stderr, "Must call pdsch_set_rnti() to set the encoder/decoder RNTI\n");  
+      /* Rate matching */
+      w_len = rm_turbo_buff_len(3 * cb_len + 12, harq_process->N_cb);
+      if (harq_buffer_alloc(&harq_process->pdsch_w_buff_tx[i], &harq_process->w_buff_tx_len[i], 
+                            w_len, sizeof(char))) 
+      {
+        return LIBLTE_ERROR;
+      }
+      if (packed) {
+        ret = rm_turbo_tx_packed(harq_process->pdsch_w_buff_tx[i], w_len, 
+                  cb_out_b, 3 * cb_len + 12, q->pdsch_e_b, n_e, rv_idx, harq_process->N_cb);
+        bit_copy((uint8_t*) e_bits, wp, q->pdsch_e_b, 0, n_e);
+      } else {
+        ret = rm_turbo_tx_lim(harq_process->pdsch_w_buff_tx[i], w_len, 
+                  (char*) q->cb_out, 3 * cb_len + 12,
+                  &e_bits[wp], n_e, rv_idx, harq_process->N_cb);
+      }
+      if (ret) {
+        fprintf(stderr, "Error in rate matching\n");
+        return LIBLTE_ERROR;
+      }
+
+      /* Set read/write pointers */
+      rp += (rlen - F);
+      wp += n_e;
     }
+
+    INFO("END CB#%d: wp: %d, rp: %d\n", i, wp, rp);
+    
+    ret = LIBLTE_SUCCESS;      
   } 
   return ret; 
 }
 
-/** Converts the PDSCH data bits to symbols mapped to the slot ready for transmission
+int pdsch_encode_tb(pdsch_t *q, char *data, uint32_t tbs, uint32_t nb_e, 
+                    pdsch_harq_t *harq_process, uint32_t rv_idx) 
+{
+  return encode_tb(q, data, false, tbs, nb_e, harq_process, rv_idx);
+}
+
+/** Converts the PDSCH data bits to symbols mapped to the slot ready for transmission, 
+ * with the RNTI set with pdsch_set_rnti()
  */
 int pdsch_encode(pdsch_t *q, char *data, cf_t *sf_symbols[MAX_PORTS], uint32_t subframe, 
                  pdsch_harq_t *harq_process, uint32_t rv_idx) 
 {
-  int i;
+  if (q != NULL && !q->rnti_is_set) {
+    fprintf(stderr, "Must call pdsch_set_rnti() to set the encoder/decoder RNTI\n");
+    return LIBLTE_ERROR_INVALID_INPUTS;
+  }
+  return pdsch_encode_rnti(q, data, sf_symbols, subframe, harq_process, rv_idx, 
+                           q != NULL ? q->rnti : 0);
+}
+
+static int encode_rnti(pdsch_t *q, void *data, bool packed, cf_t *sf_symbols[MAX_PORTS], 
+                       uint32_t subframe, pdsch_harq_t *harq_process, uint32_t rv_idx, 
+                       uint16_t rnti) 
+{
+  int i, n;
   uint32_t nof_symbols, nof_bits, nof_bits_e;
+  sequence_t *seq;
+  modem_table_t *mod;
+  pdsch_re_map_t *map;
   /* Set pointers for layermapping & precoding */
   cf_t *x[MAX_LAYERS];
    int ret = LIBLTE_ERROR_INVALID_INPUTS; 
@@ -830,69 +1525,111 @@ int pdsch_encode(pdsch_t *q, char *data, cf_t *sf_symbols[MAX_PORTS], uint32_t s
        harq_process  != NULL)
   {
 
-    if (q->rnti_is_set) {
-      for (i=0;i<q->cell.nof_ports;i++) {
-        if (sf_symbols[i] == NULL) {
-          return LIBLTE_ERROR_INVALID_INPUTS;
-        }
-      }
-      
-      nof_bits = harq_process->mcs.tbs;
-      nof_symbols = harq_process->prb_alloc.re_sf[subframe];
-      nof_bits_e = nof_symbols * q->mod[harq_process->mcs.mod - 1].nbits_x_symbol;
-
-      if (harq_process->mcs.tbs == 0) {
-        return LIBLTE_ERROR_INVALID_INPUTS;      
-      }
-      
-      if (nof_bits > nof_bits_e) {
-        fprintf(stderr, "Invalid code rate %.2f\n", (float) nof_bits / nof_bits_e);
+    for (i=0;i<q->cell.nof_ports;i++) {
+      if (sf_symbols[i] == NULL) {
         return LIBLTE_ERROR_INVALID_INPUTS;
       }
+    }
+    
+    nof_bits = harq_process->mcs.tbs;
+    nof_symbols = harq_process->prb_alloc.re_sf[subframe];
+    nof_bits_e = nof_symbols * q->mod[harq_process->mcs.mod - 1].nbits_x_symbol;
 
-      if (nof_symbols > q->max_symbols) {
-        fprintf(stderr,
-            "Error too many RE per subframe (%d). PDSCH configured for %d RE (%d PRB)\n",
-            nof_symbols, q->max_symbols, q->cell.nof_prb);
-        return LIBLTE_ERROR_INVALID_INPUTS;
-      }
+    if (harq_process->mcs.tbs == 0) {
+      return LIBLTE_ERROR_INVALID_INPUTS;      
+    }
+    
+    if (nof_bits > nof_bits_e) {
+      fprintf(stderr, "Invalid code rate %.2f\n", (float) nof_bits / nof_bits_e);
+      return LIBLTE_ERROR_INVALID_INPUTS;
+    }
 
-      INFO("Encoding PDSCH SF: %d, Mod %d, NofBits: %d, NofSymbols: %d, NofBitsE: %d, rv_idx: %d\n",
-          subframe, harq_process->mcs.mod, nof_bits, nof_symbols, nof_bits_e, rv_idx);
+    if (nof_symbols > q->max_symbols) {
+      fprintf(stderr,
+          "Error too many RE per subframe (%d). PDSCH configured for %d RE (%d PRB)\n",
+          nof_symbols, q->max_symbols, q->cell.nof_prb);
+      return LIBLTE_ERROR_INVALID_INPUTS;
+    }
 
-      /* number of layers equals number of ports */
-      for (i = 0; i < q->cell.nof_ports; i++) {
-        x[i] = q->pdsch_x[i];
-      }
-      memset(&x[q->cell.nof_ports], 0, sizeof(cf_t*) * (MAX_LAYERS - q->cell.nof_ports));
+    INFO("Encoding PDSCH SF: %d, Mod %d, NofBits: %d, NofSymbols: %d, NofBitsE: %d, rv_idx: %d\n",
+        subframe, harq_process->mcs.mod, nof_bits, nof_symbols, nof_bits_e, rv_idx);
 
-      if (pdsch_encode_tb(q, data, nof_bits, nof_bits_e, harq_process, rv_idx)) {
-        fprintf(stderr, "Error encoding TB\n");
-        return LIBLTE_ERROR;
-      }
-      
-      scrambling_b_offset(&q->seq_pdsch[subframe], (char*) q->pdsch_e, 0, nof_bits_e);
+    /* number of layers equals number of ports */
+    for (i = 0; i < q->cell.nof_ports; i++) {
+      x[i] = q->pdsch_x[i];
+    }
+    memset(&x[q->cell.nof_ports], 0, sizeof(cf_t*) * (MAX_LAYERS - q->cell.nof_ports));
 
-      mod_modulate(&q->mod[harq_process->mcs.mod - 1], (char*) q->pdsch_e, q->pdsch_d, nof_bits_e);
+    if (encode_tb(q, data, packed, nof_bits, nof_bits_e, harq_process, rv_idx)) {
+      fprintf(stderr, "Error encoding TB\n");
+      return LIBLTE_ERROR;
+    }
+    
+    seq = pdsch_sequence(q, rnti, subframe, nof_bits_e);
+    if (!seq) {
+      return LIBLTE_ERROR;
+    }
+    if (packed) {
+      scrambling_b_packed_offset(seq, q->pdsch_e, 0, nof_bits_e);
+    } else {
+      scrambling_b_offset(seq, (char*) q->pdsch_e, 0, nof_bits_e);
+    }
+    sequence_cache_put(q->seq_pdsch, seq);
+    mod = &q->mod[harq_process->mcs.mod - 1];
 
-      /* TODO: only diversity supported */
-      if (q->cell.nof_ports > 1) {
-        layermap_diversity(q->pdsch_d, x, q->cell.nof_ports, nof_symbols);
-        precoding_diversity(x, q->pdsch_symbols, q->cell.nof_ports,
-            nof_symbols / q->cell.nof_ports);
+    if (q->cell.nof_ports == 1) {
+      /* single antenna: modulate straight into the resource elements */
+      map = pdsch_re_map(q, &harq_process->prb_alloc, subframe);
+      if (!map || map->nof_re < nof_symbols) {
+        return LIBLTE_ERROR_INVALID_INPUTS;
+      }
+      if (packed) {
+        n = mod_modulate_packed_re(mod, q->pdsch_e, sf_symbols[0], map->re_idx, nof_bits_e);
+      } else {
+        n = mod_modulate_re(mod, (char*) q->pdsch_e, sf_symbols[0], map->re_idx, nof_bits_e);
+      }
+      if (n < 0) {
+        fprintf(stderr, "Error modulating PDSCH\n");
+        return LIBLTE_ERROR;
+      }
+    } else {
+      if (packed) {
+        n = mod_modulate_packed(mod, q->pdsch_e, q->pdsch_d, nof_bits_e);
       } else {
-        memcpy(q->pdsch_symbols[0], q->pdsch_d, nof_symbols * sizeof(cf_t));
+        n = mod_modulate(mod, (char*) q->pdsch_e, q->pdsch_d, nof_bits_e);
+      }
+      if (n < 0) {
+        fprintf(stderr, "Error modulating PDSCH\n");
+        return LIBLTE_ERROR;
       }
+      /* TODO: only diversity supported */
+      layermap_diversity(q->pdsch_d, x, q->cell.nof_ports, nof_symbols);
+      precoding_diversity(x, q->pdsch_symbols, q->cell.nof_ports,
+          nof_symbols / q->cell.nof_ports);
 
       /* mapping to resource elements */
       for (i = 0; i < q->cell.nof_ports; i++) {
         pdsch_put(q, q->pdsch_symbols[i], sf_symbols[i], &harq_process->prb_alloc, subframe);
       }
-      ret = LIBLTE_SUCCESS;
-    } else {
-     fprintf(stderr, "Must call pdsch_set_rnti() to set the encoder/decoder RNTI\n");       
     }
+    ret = LIBLTE_SUCCESS;
   } 
   return ret; 
 }
-  
\ No newline at end of file
+
+/** Converts the PDSCH data bits to symbols mapped to the slot ready for transmission, 
+ * scrambled for rnti
+ */
+int pdsch_encode_rnti(pdsch_t *q, char *data, cf_t *sf_symbols[MAX_PORTS], uint32_t subframe, 
+                      pdsch_harq_t *harq_process, uint32_t rv_idx, uint16_t rnti) 
+{
+  return encode_rnti(q, data, false, sf_symbols, subframe, harq_process, rv_idx, rnti);
+}
+
+/** Same as pdsch_encode_rnti() with the data bits packed MSB first, 8 per byte
+ */
+int pdsch_encode_packed(pdsch_t *q, uint8_t *data, cf_t *sf_symbols[MAX_PORTS], uint32_t subframe, 
+                        pdsch_harq_t *harq_process, uint32_t rv_idx, uint16_t rnti) 
+{
+  return encode_rnti(q, data, true, sf_symbols, subframe, harq_process, rv_idx, rnti);
+}
@@ -182,21 +182,14 @@ int phich_decode(phich_t *q, cf_t *slot_symbols, cf_t *ce[MAX_PORTS],
     ce_precoding[i] = q->ce[i];
   }
 
-  /* extract symbols */
+  /* extract symbols and channel estimates */
   if (PHICH_MAX_NSYMB
-      != regs_phich_get(q->regs, slot_symbols, q->phich_symbols[0], ngroup)) {
+      != regs_phich_get_ce(q->regs, slot_symbols, ce, q->cell.nof_ports, 
+                           q->phich_symbols[0], ce_precoding, ngroup)) {
     fprintf(stderr, "There was an error getting the phich symbols\n");
     return LIBLTE_ERROR;
   }
 
-  /* extract channel estimates */
-  for (i = 0; i < q->cell.nof_ports; i++) {
-    if (PHICH_MAX_NSYMB != regs_phich_get(q->regs, ce[i], q->ce[i], ngroup)) {
-      fprintf(stderr, "There was an error getting the phich symbols\n");
-      return LIBLTE_ERROR;
-    }
-  }
-
   /* in control channels, only diversity is supported */
   if (q->cell.nof_ports == 1) {
     /* no need for layer demapping */
@@ -85,3 +85,31 @@ void prb_get_ref_(cf_t **input, cf_t **output, int offset, int nof_refs,
   prb_cp_ref(input, output, offset, nof_refs, nof_intervals, true);
 }
 
+/* Index counterparts of the functions above. They append to *re_idx the
+ * positions of the resource grid that the copy would read (or write), starting
+ * at position *grid_pos.
+ */
+void prb_idx_ref(uint32_t *grid_pos, uint32_t **re_idx, int offset, int nof_refs,
+    int nof_intervals) {
+  int i;
+
+  int ref_interval = ((RE_X_RB / nof_refs) - 1);
+  prb_idx(grid_pos, re_idx, offset);
+  for (i = 0; i < nof_intervals - 1; i++) {
+    (*grid_pos)++;
+    prb_idx(grid_pos, re_idx, ref_interval);
+  }
+  if (ref_interval - offset > 0) {
+    (*grid_pos)++;
+    prb_idx(grid_pos, re_idx, ref_interval - offset);
+  }
+}
+
+void prb_idx(uint32_t *grid_pos, uint32_t **re_idx, int nof_re) {
+  int i;
+  for (i = 0; i < nof_re; i++) {
+    (*re_idx)[i] = *grid_pos + i;
+  }
+  *re_idx += nof_re;
+  *grid_pos += nof_re;
+}
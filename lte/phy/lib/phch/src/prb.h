@@ -25,6 +25,7 @@
  *
  */
 
+#include <stdint.h>
 
 typedef _Complex float cf_t;
 
@@ -32,6 +33,9 @@ void prb_cp_ref(cf_t **input, cf_t **output, int offset, int nof_refs,
     int nof_intervals, bool advance_input);
 void prb_cp(cf_t **input, cf_t **output, int nof_prb);
 void prb_cp_half(cf_t **input, cf_t **output, int nof_prb);
+void prb_idx_ref(uint32_t *grid_pos, uint32_t **re_idx, int offset, int nof_refs,
+    int nof_intervals);
+void prb_idx(uint32_t *grid_pos, uint32_t **re_idx, int nof_re);
 void prb_put_ref_(cf_t **input, cf_t **output, int offset, int nof_refs,
     int nof_intervals);
 void phch_get_prb_ref(cf_t **input, cf_t **output, int offset, int nof_refs,
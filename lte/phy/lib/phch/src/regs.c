@@ -36,6 +36,8 @@
 
 #define REG_IDX(r, i, n) r->k[i]+r->l*n*RE_X_RB
 
+#define MIN(a,b) ((a>b)?b:a)
+
 
 regs_reg_t *regs_find_reg(regs_t *h, uint32_t k, uint32_t l);
 int regs_put_reg(regs_reg_t *reg, 
@@ -55,6 +57,9 @@ int regs_get_reg(regs_reg_t *reg,
 
 int regs_reset_reg(regs_reg_t *reg, cf_t *slot_symbols, uint32_t nof_prb);
 
+int regs_ch_init_idx(regs_ch_t *ch, uint32_t nof_prb);
+void regs_ch_free_idx(regs_ch_t *ch);
+
 
 /***************************************************************
  *
@@ -68,6 +73,7 @@ void regs_pdcch_free(regs_t *h) {
     if (h->pdcch[i].regs) {
       free(h->pdcch[i].regs);
     }
+    regs_ch_free_idx(&h->pdcch[i]);
   }
 }
 
@@ -143,6 +149,10 @@ int regs_pdcch_init(regs_t *h) {
     h->pdcch[cfi].nof_regs = (h->pdcch[cfi].nof_regs/9)*9;
     free(tmp);
     tmp = NULL;
+
+    if (regs_ch_init_idx(&h->pdcch[cfi], h->cell.nof_prb)) {
+      goto clean_and_exit;
+    }
   }
 
   ret = LIBLTE_SUCCESS;
@@ -172,13 +182,9 @@ int regs_pdcch_nregs(regs_t *h, uint32_t cfi) {
 int regs_pdcch_put_offset(regs_t *h, cf_t *pdcch_symbols, cf_t *slot_symbols, uint32_t start_reg, uint32_t nof_regs) {
   if (h->cfi_initiated) {
     if (start_reg + nof_regs <= h->pdcch[h->cfi].nof_regs) {
-      uint32_t i, k;
-      k = 0;
-      for (i=start_reg;i<start_reg+nof_regs;i++) {
-        regs_put_reg(h->pdcch[h->cfi].regs[i], &pdcch_symbols[k], slot_symbols, h->cell.nof_prb);
-        k += 4;
-      }
-      return k;      
+      regs_scatter(pdcch_symbols, &h->pdcch[h->cfi].re_idx[start_reg * REGS_RE_X_REG], 
+                   slot_symbols, nof_regs * REGS_RE_X_REG);
+      return nof_regs * REGS_RE_X_REG;      
     } else {
       fprintf(stderr, "Out of range: start_reg + nof_reg must be lower than %d\n", h->pdcch[h->cfi].nof_regs);
       return LIBLTE_ERROR;      
@@ -194,15 +200,17 @@ int regs_pdcch_put(regs_t *h, cf_t *pdcch_symbols, cf_t *slot_symbols) {
 }
 
 int regs_pdcch_get_offset(regs_t *h, cf_t *slot_symbols, cf_t *pdcch_symbols, uint32_t start_reg, uint32_t nof_regs) {
+  return regs_pdcch_get_offset_ce(h, slot_symbols, NULL, 0, pdcch_symbols, NULL, start_reg, nof_regs);
+}
+
+int regs_pdcch_get_offset_ce(regs_t *h, cf_t *slot_symbols, cf_t *ce[MAX_PORTS], uint32_t nof_ports, 
+                             cf_t *pdcch_symbols, cf_t *pdcch_ce[MAX_PORTS], 
+                             uint32_t start_reg, uint32_t nof_regs) {
   if (h->cfi_initiated) {
     if (start_reg + nof_regs <= h->pdcch[h->cfi].nof_regs) {
-      uint32_t i, k;  
-      k = 0;
-      for (i=start_reg;i<start_reg + nof_regs;i++) {
-        regs_get_reg(h->pdcch[h->cfi].regs[i], slot_symbols, &pdcch_symbols[k], h->cell.nof_prb);
-        k += 4;
-      }
-      return k;    
+      regs_gather_ce(slot_symbols, ce, nof_ports, &h->pdcch[h->cfi].re_idx[start_reg * REGS_RE_X_REG], 
+                     pdcch_symbols, pdcch_ce, nof_regs * REGS_RE_X_REG);
+      return nof_regs * REGS_RE_X_REG;    
     } else {
       fprintf(stderr, "Out of range: start_reg + nof_reg must be lower than %d\n", h->pdcch[h->cfi].nof_regs);
       return LIBLTE_ERROR;
@@ -261,6 +269,7 @@ int regs_phich_init(regs_t *h) {
   }
   INFO("Creating %d PHICH mapping units. %s length, Ng=%.2f\n",h->ngroups_phich,
       h->phich_len==PHICH_EXT?"Extended":"Normal",ng);
+  bzero(h->phich, sizeof(regs_ch_t) * h->ngroups_phich);
   for (i=0;i<h->ngroups_phich;i++) {
     h->phich[i].nof_regs = REGS_PHICH_REGS_X_GROUP;
     h->phich[i].regs = malloc(sizeof(regs_reg_t*) * REGS_PHICH_REGS_X_GROUP);
@@ -308,6 +317,9 @@ int regs_phich_init(regs_t *h) {
       INFO("Assigned PHICH REG#%d (%d,%d)\n",nreg,h->phich[mi].regs[i]->k0,li);
       nreg++;
     }
+    if (regs_ch_init_idx(&h->phich[mi], h->cell.nof_prb)) {
+      goto clean_and_exit;
+    }
   }
 
   // now the number of mapping units = number of groups for normal cp. For extended cp
@@ -324,8 +336,10 @@ clean_and_exit:
         if (h->phich[i].regs) {
           free(h->phich[i].regs);
         }
+        regs_ch_free_idx(&h->phich[i]);
       }
       free(h->phich);
+      h->phich = NULL;
     }
   }
   for (i=0;i<3;i++) {
@@ -346,8 +360,10 @@ void regs_phich_free(regs_t *h) {
       if (h->phich[i].regs) {
         free(h->phich[i].regs);
       }
+      regs_ch_free_idx(&h->phich[i]);
     }
     free(h->phich);
+    h->phich = NULL;
   }
 }
 
@@ -383,10 +399,10 @@ int regs_phich_add(regs_t *h, cf_t phich_symbols[REGS_PHICH_NSYM], uint32_t ngro
     ngroup /= 2;
   }
   regs_ch_t *rch = &h->phich[ngroup];
-  for (i = 0; i < rch->nof_regs && i*REGS_RE_X_REG < REGS_PHICH_NSYM; i++) {
-    regs_add_reg(rch->regs[i], &phich_symbols[i*REGS_RE_X_REG], slot_symbols, h->cell.nof_prb);
+  for (i = 0; i < rch->nof_regs * REGS_RE_X_REG && i < REGS_PHICH_NSYM; i++) {
+    slot_symbols[rch->re_idx[i]] += phich_symbols[i];
   }
-  return i*REGS_RE_X_REG;
+  return i;
 }
 
 /**
@@ -404,8 +420,8 @@ int regs_phich_reset(regs_t *h, cf_t *slot_symbols) {
       ng = ngroup;
     }
     regs_ch_t *rch = &h->phich[ng];
-    for (i = 0; i < rch->nof_regs && i*REGS_RE_X_REG < REGS_PHICH_NSYM; i++) {
-      regs_reset_reg(rch->regs[i], slot_symbols, h->cell.nof_prb);
+    for (i = 0; i < rch->nof_regs * REGS_RE_X_REG && i < REGS_PHICH_NSYM; i++) {
+      slot_symbols[rch->re_idx[i]] = 0;
     }
   }
   return LIBLTE_SUCCESS;
@@ -417,6 +433,16 @@ int regs_phich_reset(regs_t *h, cf_t *slot_symbols) {
  * Returns the number of written symbols, or -1 on error
  */
 int regs_phich_get(regs_t *h, cf_t *slot_symbols, cf_t phich_symbols[REGS_PHICH_NSYM], uint32_t ngroup) {
+  return regs_phich_get_ce(h, slot_symbols, NULL, 0, phich_symbols, NULL, ngroup);
+}
+
+/**
+ * Gets the PHICH symbols and the channel estimates of nof_ports ports in one pass
+ *
+ * Returns the number of written symbols, or -1 on error
+ */
+int regs_phich_get_ce(regs_t *h, cf_t *slot_symbols, cf_t *ce[MAX_PORTS], uint32_t nof_ports, 
+                      cf_t phich_symbols[REGS_PHICH_NSYM], cf_t *phich_ce[MAX_PORTS], uint32_t ngroup) {
   uint32_t i;
   if (ngroup >= h->ngroups_phich) {
     fprintf(stderr, "Error invalid ngroup %d\n", ngroup);
@@ -426,10 +452,9 @@ int regs_phich_get(regs_t *h, cf_t *slot_symbols, cf_t phich_symbols[REGS_PHICH_
     ngroup /= 2;
   }
   regs_ch_t *rch = &h->phich[ngroup];
-  for (i = 0; i < rch->nof_regs && i*REGS_RE_X_REG < REGS_PHICH_NSYM; i++) {
-    regs_get_reg(rch->regs[i], slot_symbols, &phich_symbols[i*REGS_RE_X_REG], h->cell.nof_prb);
-  }
-  return i*REGS_RE_X_REG;
+  i = MIN(rch->nof_regs * REGS_RE_X_REG, REGS_PHICH_NSYM);
+  regs_gather_ce(slot_symbols, ce, nof_ports, rch->re_idx, phich_symbols, phich_ce, i);
+  return i;
 }
 
 
@@ -485,13 +510,14 @@ int regs_pcfich_init(regs_t *h) {
       INFO("Assigned PCFICH REG#%d (%d,0)\n", i, k);
     }
   }
-  return LIBLTE_SUCCESS;
+  return regs_ch_init_idx(ch, h->cell.nof_prb);
 }
 
 void regs_pcfich_free(regs_t *h) {
   if (h->pcfich.regs) {
     free(h->pcfich.regs);
   }
+  regs_ch_free_idx(&h->pcfich);
 }
 
 uint32_t regs_pcfich_nregs(regs_t *h) {
@@ -506,11 +532,9 @@ uint32_t regs_pcfich_nregs(regs_t *h) {
 int regs_pcfich_put(regs_t *h, cf_t pcfich_symbols[REGS_PCFICH_NSYM], cf_t *slot_symbols) {
   regs_ch_t *rch = &h->pcfich;
 
-  uint32_t i;
-  for (i = 0; i < rch->nof_regs && i*REGS_RE_X_REG < REGS_PCFICH_NSYM; i++) {
-    regs_put_reg(rch->regs[i], &pcfich_symbols[i*REGS_RE_X_REG], slot_symbols, h->cell.nof_prb);
-  }
-  return i*REGS_RE_X_REG;
+  uint32_t n = MIN(rch->nof_regs * REGS_RE_X_REG, REGS_PCFICH_NSYM);
+  regs_scatter(pcfich_symbols, rch->re_idx, slot_symbols, n);
+  return n;
 }
 
 /**
@@ -519,12 +543,20 @@ int regs_pcfich_put(regs_t *h, cf_t pcfich_symbols[REGS_PCFICH_NSYM], cf_t *slot
  * Returns the number of written symbols, or -1 on error
  */
 int regs_pcfich_get(regs_t *h, cf_t *slot_symbols, cf_t ch_data[REGS_PCFICH_NSYM]) {
+  return regs_pcfich_get_ce(h, slot_symbols, NULL, 0, ch_data, NULL);
+}
+
+/**
+ * Gets the PCFICH symbols and the channel estimates of nof_ports ports in one pass
+ *
+ * Returns the number of written symbols, or -1 on error
+ */
+int regs_pcfich_get_ce(regs_t *h, cf_t *slot_symbols, cf_t *ce[MAX_PORTS], uint32_t nof_ports, 
+                       cf_t ch_data[REGS_PCFICH_NSYM], cf_t *ch_ce[MAX_PORTS]) {
   regs_ch_t *rch = &h->pcfich;
-  uint32_t i;
-  for (i = 0; i < rch->nof_regs && i*REGS_RE_X_REG < REGS_PCFICH_NSYM; i++) {
-    regs_get_reg(rch->regs[i], slot_symbols, &ch_data[i*REGS_RE_X_REG], h->cell.nof_prb);
-  }
-  return i*REGS_RE_X_REG;
+  uint32_t n = MIN(rch->nof_regs * REGS_RE_X_REG, REGS_PCFICH_NSYM);
+  regs_gather_ce(slot_symbols, ce, nof_ports, rch->re_idx, ch_data, ch_ce, n);
+  return n;
 }
 
 
@@ -556,6 +588,101 @@ regs_reg_t *regs_find_reg(regs_t *h, uint32_t k, uint32_t l) {
   return NULL;
 }
 
+/**
+ * Precomputes the resource grid index of each RE of the channel REGs, so that 
+ * the symbols are read and written with a single gather or scatter 
+ */
+int regs_ch_init_idx(regs_ch_t *ch, uint32_t nof_prb) {
+  uint32_t i, j;
+  ch->re_idx = malloc(sizeof(uint32_t) * ch->nof_regs * REGS_RE_X_REG);
+  if (!ch->re_idx) {
+    perror("malloc");
+    return LIBLTE_ERROR;
+  }
+  for (i = 0; i < ch->nof_regs; i++) {
+    for (j = 0; j < REGS_RE_X_REG; j++) {
+      ch->re_idx[i * REGS_RE_X_REG + j] = REG_IDX(ch->regs[i], j, nof_prb);
+    }
+  }
+  return LIBLTE_SUCCESS;
+}
+
+void regs_ch_free_idx(regs_ch_t *ch) {
+  if (ch->re_idx) {
+    free(ch->re_idx);
+    ch->re_idx = NULL;
+  }
+}
+
+/**
+ * Reads the nof_re symbols at positions re_idx of the resource grid
+ */
+void regs_gather(cf_t *slot_symbols, uint32_t *re_idx, cf_t *data, uint32_t nof_re) {
+  uint32_t i = 0;
+  for (; i + 4 <= nof_re; i += 4) {
+    data[i]   = slot_symbols[re_idx[i]];
+    data[i+1] = slot_symbols[re_idx[i+1]];
+    data[i+2] = slot_symbols[re_idx[i+2]];
+    data[i+3] = slot_symbols[re_idx[i+3]];
+  }
+  for (; i < nof_re; i++) {
+    data[i] = slot_symbols[re_idx[i]];
+  }
+}
+
+/**
+ * Reads the nof_re symbols at positions re_idx of the resource grid and the channel 
+ * estimates of nof_ports ports at the same positions, walking re_idx only once
+ */
+void regs_gather_ce(cf_t *slot_symbols, cf_t *ce[MAX_PORTS], uint32_t nof_ports, uint32_t *re_idx, 
+                    cf_t *data, cf_t *ce_data[MAX_PORTS], uint32_t nof_re) {
+  uint32_t i, p, k;
+  switch (nof_ports) {
+  case 0:
+    regs_gather(slot_symbols, re_idx, data, nof_re);
+    break;
+  case 1:
+    for (i = 0; i < nof_re; i++) {
+      k = re_idx[i];
+      data[i] = slot_symbols[k];
+      ce_data[0][i] = ce[0][k];
+    }
+    break;
+  case 2:
+    for (i = 0; i < nof_re; i++) {
+      k = re_idx[i];
+      data[i] = slot_symbols[k];
+      ce_data[0][i] = ce[0][k];
+      ce_data[1][i] = ce[1][k];
+    }
+    break;
+  default:
+    for (i = 0; i < nof_re; i++) {
+      k = re_idx[i];
+      data[i] = slot_symbols[k];
+      for (p = 0; p < nof_ports; p++) {
+        ce_data[p][i] = ce[p][k];
+      }
+    }
+  }
+}
+
+/**
+ * Writes nof_re symbols at positions re_idx of the resource grid
+ */
+void regs_scatter(cf_t *data, uint32_t *re_idx, cf_t *slot_symbols, uint32_t nof_re) {
+  uint32_t i = 0;
+  for (; i + 4 <= nof_re; i += 4) {
+    slot_symbols[re_idx[i]]   = data[i];
+    slot_symbols[re_idx[i+1]] = data[i+1];
+    slot_symbols[re_idx[i+2]] = data[i+2];
+    slot_symbols[re_idx[i+3]] = data[i+3];
+  }
+  for (; i < nof_re; i++) {
+    slot_symbols[re_idx[i]] = data[i];
+  }
+}
+
 /**
  * Returns the number of REGs in a PRB
  * 36.211 Section 6.2.4
@@ -66,7 +66,11 @@ int sequence_pdcch(sequence_t *seq, uint32_t nslot, uint32_t cell_id, uint32_t l
 /**
  * 36.211 6.3.1
  */
+uint32_t sequence_pdsch_c_init(unsigned short rnti, int q, uint32_t nslot, uint32_t cell_id) {
+  return (rnti<<14) + (q<<13) + ((nslot/2)<<9) + cell_id;
+}
+
 int sequence_pdsch(sequence_t *seq, unsigned short rnti, int q, uint32_t nslot, uint32_t cell_id, uint32_t len) {
   bzero(seq, sizeof(sequence_t));
-  return sequence_LTEPRS(seq, len, (rnti<<14) + (q<<13) + ((nslot/2)<<9) + cell_id);
+  return sequence_LTEPRS(seq, len, sequence_pdsch_c_init(rnti, q, nslot, cell_id));
 }
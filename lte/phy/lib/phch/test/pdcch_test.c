@@ -41,6 +41,7 @@ lte_cell_t cell = {
 };
 
 uint32_t cfi = 1;
+uint32_t nof_threads = 1;
 
 void usage(char *prog) {
   printf("Usage: %s [cell.cpv]\n", prog);
@@ -48,12 +49,13 @@ void usage(char *prog) {
   printf("\t-f cfi [Default %d]\n", cfi);
   printf("\t-p cell.nof_ports [Default %d]\n", cell.nof_ports);
   printf("\t-n cell.nof_prb [Default %d]\n", cell.nof_prb);
+  printf("\t-t nof_threads [Default %d]\n", nof_threads);
   printf("\t-v [set verbose to debug, default none]\n");
 }
 
 void parse_args(int argc, char **argv) {
   int opt;
-  while ((opt = getopt(argc, argv, "cell.cpnfv")) != -1) {
+  while ((opt = getopt(argc, argv, "cell.cpnftv")) != -1) {
     switch (opt) {
     case 'p':
       cell.nof_ports = atoi(argv[optind]);
@@ -67,6 +69,9 @@ void parse_args(int argc, char **argv) {
     case 'c':
       cell.id = atoi(argv[optind]);
       break;
+    case 't':
+      nof_threads = atoi(argv[optind]);
+      break;
     case 'v':
       verbose++;
       break;
@@ -106,6 +111,10 @@ int test_dci_payload_size() {
 int main(int argc, char **argv) {
   pdcch_t pdcch;
   dci_msg_t dci_tx[2], dci_rx[2], dci_tmp;
+  pdcch_candidate_t candidates[2], all_candidates[2 * PDCCH_MAX_FORMATS];
+  int nof_candidates, nof_found;
+  dci_format_t format = Format1;
+  uint16_t rntis[2] = { 1234, 1235 };
   dci_location_t dci_locations[2];
   ra_pdsch_t ra_dl;
   regs_t regs;
@@ -157,6 +166,11 @@ int main(int argc, char **argv) {
     exit(-1);
   }
 
+  if (pdcch_set_threads(&pdcch, nof_threads)) {
+    fprintf(stderr, "Error setting PDCCH threads\n");
+    exit(-1);
+  }
+
   nof_dcis = 2;
   bzero(&ra_dl, sizeof(ra_pdsch_t));
   ra_dl.harq_process = 0;
@@ -211,6 +225,72 @@ int main(int argc, char **argv) {
       goto quit;
     }
   }
+
+  /* The blind search must find the same messages */
+  if (pdcch_extract_llr_region(&pdcch, slot_symbols[0], ce, 0, cfi)) {
+    fprintf(stderr, "Error extracting LLRs\n");
+    goto quit;
+  }
+  for (i = 0; i < nof_dcis; i++) {
+    if (pdcch_extract_llr(&pdcch, slot_symbols[0], ce, dci_locations[i], 0, cfi)) {
+      fprintf(stderr, "Error extracting LLRs\n");
+      goto quit;
+    }
+    if (memcmp(pdcch.pdcch_llr, &pdcch.llr_region[72 * dci_locations[i].ncce], 
+               sizeof(float) * pdcch.e_bits)) {
+      printf("Error in DCI %d: Control region LLRs do not match\n", i);
+      goto quit;
+    }
+  }
+  if (pdcch_blind_search(&pdcch, dci_locations, nof_dcis, &format, 1, 
+                         rntis, nof_dcis, candidates, 2) != nof_dcis) {
+    printf("Blind search did not find %d DCI messages\n", nof_dcis);
+    goto quit;
+  }
+  for (i = 0; i < nof_dcis; i++) {
+    j = candidates[i].rnti - 1234;
+    if (candidates[i].msg.nof_bits != dci_tx[j].nof_bits || 
+        memcmp(dci_tx[j].data, candidates[i].msg.data, dci_tx[j].nof_bits)) {
+      printf("Error in blind search DCI %d: Received data does not match\n", j);
+      goto quit;
+    }
+  }
+
+  /* Decoding all formats and RNTIs must find them too */
+  const dci_format_t all_formats[4] = { Format0, Format1, Format1A, Format1C };
+  if (pdcch_decode_all(&pdcch, dci_locations, nof_dcis, (dci_format_t*) all_formats, 4, 
+                       rntis, nof_dcis, 0, candidates, 2) != nof_dcis) {
+    printf("Decode all did not find %d DCI messages\n", nof_dcis);
+    goto quit;
+  }
+  for (i = 0; i < nof_dcis; i++) {
+    j = candidates[i].rnti - 1234;
+    if (candidates[i].format != Format1 || candidates[i].type.type != PDSCH_SCHED || 
+        memcmp(dci_tx[j].data, candidates[i].msg.data, dci_tx[j].nof_bits)) {
+      printf("Error in decode all DCI %d: Received data does not match\n", j);
+      goto quit;
+    }
+  }
+
+  /* Without RNTIs, as a passive monitor, the messages must be among the candidates */
+  nof_candidates = pdcch_decode_all(&pdcch, dci_locations, nof_dcis, (dci_format_t*) all_formats, 4, 
+                                    NULL, 0, 0, all_candidates, 2 * PDCCH_MAX_FORMATS);
+  if (nof_candidates < nof_dcis) {
+    printf("Decode all without RNTIs found %d candidates\n", nof_candidates);
+    goto quit;
+  }
+  nof_found = 0;
+  for (i = 0; i < nof_candidates; i++) {
+    j = all_candidates[i].rnti - 1234;
+    if (j >= 0 && j < nof_dcis && all_candidates[i].format == Format1 && 
+        !memcmp(dci_tx[j].data, all_candidates[i].msg.data, dci_tx[j].nof_bits)) {
+      nof_found++;
+    }
+  }
+  if (nof_found != nof_dcis) {
+    printf("Decode all without RNTIs found %d of %d DCI messages\n", nof_found, nof_dcis);
+    goto quit;
+  }
   ret = 0;
 
 quit: 
@@ -56,6 +56,41 @@ const int test_re_num[N_TESTS][3] = {
 
 cf_t in[200000], out[200000];
 
+/* Puts a ramp with pdsch_put() and checks that pdsch_get() gets it back and that
+ * no other RE of the grid was written.
+ */
+int check_put_get(pdsch_t *pdsch, ra_prb_t *prb_alloc, uint32_t sf, int nof_re) {
+  int i, nof_grid_re;
+
+  nof_grid_re = 0;
+  bzero(in, sizeof(cf_t) * nof_re);
+  bzero(out, sizeof(cf_t) * pdsch->max_symbols);
+  for (i=0;i<nof_re;i++) {
+    in[i] = i + 1;
+  }
+  if (pdsch_put(pdsch, in, out, prb_alloc, sf) != nof_re) {
+    return -1;
+  }
+  for (i=0;i<pdsch->max_symbols;i++) {
+    if (out[i] != 0) {
+      nof_grid_re++;
+    }
+  }
+  if (nof_grid_re != nof_re) {
+    return -1;
+  }
+  bzero(in, sizeof(cf_t) * nof_re);
+  if (pdsch_get(pdsch, out, in, prb_alloc, sf) != nof_re) {
+    return -1;
+  }
+  for (i=0;i<nof_re;i++) {
+    if (in[i] != i + 1) {
+      return -1;
+    }
+  }
+  return 0;
+}
+
 int main(int argc, char **argv) {
   int i, n, np, r;
   ra_prb_t prb_alloc;
@@ -105,6 +140,23 @@ int main(int argc, char **argv) {
       if (r != prb_alloc.re_sf[n]) {
         goto go_out;
       }
+      if (check_put_get(&pdsch, &prb_alloc, n, r)) {
+        printf("Error in put/get of SF %d test %d\n", n, i);
+        exit(-1);
+      }
+    }
+    /* Cycle through more allocations than the RE map cache holds */
+    for (np=0;np<2*PDSCH_RE_MAP_CACHE_LEN;np++) {
+      for (n=0;n<10;n++) {
+        prb_alloc.slot[0].nof_prb = test_re_prb[i] - np % 3;
+        prb_alloc.slot[1].nof_prb = test_re_prb[i] - np % 3;
+        prb_alloc.lstart = 1 + np % 3;
+        r = pdsch_get(&pdsch, in, out, &prb_alloc, n);
+        if (r <= 0 || check_put_get(&pdsch, &prb_alloc, n, r)) {
+          printf("Error in put/get of SF %d test %d after %d allocations\n", n, i, np);
+          exit(-1);
+        }
+      }
     }
     pdsch_free(&pdsch);
   }
@@ -46,9 +46,19 @@ uint32_t tbs = 0;
 uint32_t subframe = 1;
 lte_mod_t modulation = LTE_BPSK;
 uint32_t rv_idx = 0;
+uint32_t nof_threads = 1;
+uint32_t nof_subblocks = 1;
+uint32_t ue_category = 0;
+pdsch_softbuf_t softbuf = PDSCH_SOFTBUF_FLOAT;
+pdsch_llr_t llr_format = PDSCH_LLR_FLOAT;
+bool fused_equalizer = true;
+bool rnti_param = false;
+bool packed = false;
+bool missed_rv0 = false;
+uint16_t rnti = 1234;
 
 void usage(char *prog) {
-  printf("Usage: %s [cpsrnfvmt] -l TBS \n", prog);
+  printf("Usage: %s [cpsrnfvmtbquxeiko] -l TBS \n", prog);
   printf("\t-m modulation (1: BPSK, 2: QPSK, 3: QAM16, 4: QAM64) [Default BPSK]\n");
   printf("\t-c cell id [Default %d]\n", cell.id);
   printf("\t-s subframe [Default %d]\n", subframe);
@@ -56,12 +66,21 @@ void usage(char *prog) {
   printf("\t-f cfi [Default %d]\n", cfi);
   printf("\t-p cell.nof_ports [Default %d]\n", cell.nof_ports);
   printf("\t-n cell.nof_prb [Default %d]\n", cell.nof_prb);
+  printf("\t-t number of decoder threads [Default %d]\n", nof_threads);
+  printf("\t-b number of sub-blocks of single code blocks [Default %d]\n", nof_subblocks);
+  printf("\t-q soft buffer bits (32: float, 16 or 8) [Default 32]\n");
+  printf("\t-u UE category for the soft buffer size [Default none]\n");
+  printf("\t-x LLR bits from the demapper to the decoder (32: float, 16 or 8) [Default 32]\n");
+  printf("\t-e use the step by step equalizer instead of the fused one\n");
+  printf("\t-i pass the RNTI in each call with a shared one-entry sequence cache and check another RNTI fails\n");
+  printf("\t-k check the packed-bit encoder gives the same symbols and decode to packed bits\n");
+  printf("\t-o decode rv_idx only, as if the earlier transmissions were missed\n");
   printf("\t-v [set verbose to debug, default none]\n");
 }
 
 void parse_args(int argc, char **argv) {
   int opt;
-  while ((opt = getopt(argc, argv, "lcpnfvmtsr")) != -1) {
+  while ((opt = getopt(argc, argv, "lcpnfvmtbsrquxeiko")) != -1) {
     switch(opt) {
     case 'm':
       switch(atoi(argv[optind])) {
@@ -101,6 +120,53 @@ void parse_args(int argc, char **argv) {
     case 'c':
       cell.id = atoi(argv[optind]);
       break;
+    case 't':
+      nof_threads = atoi(argv[optind]);
+      break;
+    case 'b':
+      nof_subblocks = atoi(argv[optind]);
+      break;
+    case 'q':
+      switch(atoi(argv[optind])) {
+      case 16:
+        softbuf = PDSCH_SOFTBUF_INT16;
+        break;
+      case 8:
+        softbuf = PDSCH_SOFTBUF_INT8;
+        break;
+      default:
+        softbuf = PDSCH_SOFTBUF_FLOAT;
+        break;
+      }
+      break;
+    case 'u':
+      ue_category = atoi(argv[optind]);
+      break;
+    case 'x':
+      switch(atoi(argv[optind])) {
+      case 16:
+        llr_format = PDSCH_LLR_INT16;
+        break;
+      case 8:
+        llr_format = PDSCH_LLR_INT8;
+        break;
+      default:
+        llr_format = PDSCH_LLR_FLOAT;
+        break;
+      }
+      break;
+    case 'e':
+      fused_equalizer = false;
+      break;
+    case 'i':
+      rnti_param = true;
+      break;
+    case 'k':
+      packed = true;
+      break;
+    case 'o':
+      missed_rv0 = true;
+      break;
     case 'v':
       verbose++;
       break;
@@ -115,22 +181,143 @@ void parse_args(int argc, char **argv) {
   }
 }
 
+/* Checks that the fused equalizer gives the same symbols as pdsch_get()
+ * followed by the ZF predecoder and the layer demapper, with a random channel
+ */
+int check_equalizer(pdsch_t *q, cf_t *sf_symbols, ra_prb_t *prb_alloc, uint32_t nof_re) {
+  cf_t *ce[MAX_PORTS], *x[MAX_LAYERS], *d;
+  uint32_t i, j;
+  int n, ret = -1;
+
+  bzero(ce, sizeof(cf_t*) * MAX_PORTS);
+  bzero(x, sizeof(cf_t*) * MAX_LAYERS);
+  d = malloc(sizeof(cf_t) * q->max_symbols);
+  if (!d) {
+    perror("malloc");
+    return -1;
+  }
+  for (i=0;i<q->cell.nof_ports;i++) {
+    ce[i] = malloc(sizeof(cf_t) * nof_re);
+    x[i] = malloc(sizeof(cf_t) * q->max_symbols);
+    if (!ce[i] || !x[i]) {
+      perror("malloc");
+      goto clean;
+    }
+    for (j=0;j<nof_re;j++) {
+      ce[i][j] = (float) rand() / RAND_MAX + _Complex_I * ((float) rand() / RAND_MAX - 0.5);
+    }
+  }
+
+  n = pdsch_get_equalized(q, sf_symbols, ce, d, NULL, prb_alloc, subframe);
+  if (n != prb_alloc->re_sf[subframe]) {
+    fprintf(stderr, "Fused equalizer returned %d symbols\n", n);
+    goto clean;
+  }
+  pdsch_get(q, sf_symbols, q->pdsch_symbols[0], prb_alloc, subframe);
+  for (i=0;i<q->cell.nof_ports;i++) {
+    pdsch_get(q, ce[i], q->ce[i], prb_alloc, subframe);
+  }
+  if (q->cell.nof_ports == 1) {
+    predecoding_single_zf(q->pdsch_symbols[0], q->ce[0], q->pdsch_d, n);
+  } else {
+    predecoding_diversity_zf(q->pdsch_symbols[0], q->ce, x, q->cell.nof_ports, n);
+    layerdemap_diversity(x, q->pdsch_d, q->cell.nof_ports, n / q->cell.nof_ports);
+  }
+  for (i=0;i<(n/q->cell.nof_ports)*q->cell.nof_ports;i++) {
+    if (d[i] != q->pdsch_d[i]) {
+      fprintf(stderr, "Fused equalizer mismatch at symbol %d\n", i);
+      goto clean;
+    }
+  }
+  ret = 0;
+clean:
+  for (i=0;i<q->cell.nof_ports;i++) {
+    if (ce[i]) {
+      free(ce[i]);
+    }
+    if (x[i]) {
+      free(x[i]);
+    }
+  }
+  free(d);
+  return ret;
+}
+
+/* Decoding a transmission scrambled for another RNTI must fail. A second HARQ 
+ * process is used so that the soft buffers of the right one are not modified. 
+ */
+int check_other_rnti(pdsch_t *q, cf_t *sf_symbols, cf_t *ce[MAX_PORTS], ra_mcs_t mcs, 
+                     ra_prb_t *prb_alloc, uint32_t rv) {
+  pdsch_harq_t harq_process;
+  char *data;
+  int ret = -1;
+
+  data = malloc(sizeof(char) * mcs.tbs);
+  if (!data) {
+    perror("malloc");
+    return -1;
+  }
+  if (pdsch_harq_init(&harq_process, q) || 
+      pdsch_harq_setup(&harq_process, mcs, prb_alloc)) {
+    fprintf(stderr, "Error configuring HARQ process\n");
+    goto clean;
+  }
+  if (pdsch_decode_rnti(q, sf_symbols, ce, data, subframe, &harq_process, rv, rnti + 1) == LIBLTE_SUCCESS) {
+    fprintf(stderr, "Decoded with RNTI 0x%x a transmission for RNTI 0x%x\n", rnti + 1, rnti);
+    goto clean;
+  }
+  ret = 0;
+clean:
+  pdsch_harq_free(&harq_process);
+  free(data);
+  return ret;
+}
+
+/* A retransmission decoded with the other fixed-point LLR format must fail and 
+ * keep the soft buffers it would be combined with 
+ */
+int check_softbuf_mismatch(pdsch_t *q, cf_t *sf_symbols, cf_t *ce[MAX_PORTS], char *data, 
+                           pdsch_harq_t *harq_process, uint32_t rv) {
+  pdsch_softbuf_t softbuf = harq_process->softbuf;
+  void *w_buff = harq_process->pdsch_w_buff_rx[0];
+  int ret = -1;
+
+  pdsch_set_llr_format(q, llr_format == PDSCH_LLR_INT16 ? PDSCH_LLR_INT8 : PDSCH_LLR_INT16);
+  if (pdsch_decode_rnti(q, sf_symbols, ce, data, subframe, harq_process, rv, rnti) == LIBLTE_SUCCESS) {
+    fprintf(stderr, "Decoded rv_idx=%d with a different LLR format\n", rv);
+  } else if (harq_process->softbuf != softbuf || 
+             harq_process->pdsch_w_buff_rx[0] != w_buff) {
+    fprintf(stderr, "Soft buffers changed by rv_idx=%d with a different LLR format\n", rv);
+  } else {
+    ret = 0;
+  }
+  pdsch_set_llr_format(q, llr_format);
+  return ret;
+}
+
 int main(int argc, char **argv) {
   pdsch_t pdsch;
+  sequence_cache_t seq_cache;
   uint32_t i, j;
-  char *data = NULL;
+  char *data = NULL, *data_rx = NULL;
+  uint8_t *data_packed = NULL, *data_packed_rx = NULL;
   cf_t *ce[MAX_PORTS];
   uint32_t nof_re;
   cf_t *slot_symbols[MAX_PORTS];
+  cf_t *slot_symbols_packed[MAX_PORTS];
   int ret = -1;
   struct timeval t[3];
   ra_mcs_t mcs;
   ra_prb_t prb_alloc;
   pdsch_harq_t harq_process;
   uint32_t rv;
+  int r;
 
   parse_args(argc,argv);
 
+  bzero(&seq_cache, sizeof(sequence_cache_t));
+  bzero(slot_symbols_packed, sizeof(cf_t*) * MAX_PORTS);
+
   nof_re = 2 * CPNORM_NSYMB * cell.nof_prb * RE_X_RB;
 
   mcs.tbs = tbs;
@@ -158,10 +345,24 @@ int main(int argc, char **argv) {
       perror("malloc");
       goto quit;
     }
+    if (packed) {
+      slot_symbols_packed[i] = calloc(sizeof(cf_t) , nof_re);
+      if (!slot_symbols_packed[i]) {
+        perror("malloc");
+        goto quit;
+      }
+    }
   }
 
   data = malloc(sizeof(char) * mcs.tbs);
-  if (!data) {
+  data_rx = malloc(sizeof(char) * mcs.tbs);
+  if (!data || !data_rx) {
+    perror("malloc");
+    goto quit;
+  }
+  data_packed = malloc(sizeof(uint8_t) * (mcs.tbs + 7) / 8);
+  data_packed_rx = malloc(sizeof(uint8_t) * (mcs.tbs + 7) / 8);
+  if (!data_packed || !data_packed_rx) {
     perror("malloc");
     goto quit;
   }
@@ -171,13 +372,41 @@ int main(int argc, char **argv) {
     goto quit;
   }
   
-  pdsch_set_rnti(&pdsch, 1234);
+  if (rnti_param) {
+    /* every change of RNTI evicts the only sequence */
+    if (sequence_cache_init(&seq_cache, 1)) {
+      fprintf(stderr, "Error initiating sequence cache\n");
+      goto quit;
+    }
+    pdsch_set_sequence_cache(&pdsch, &seq_cache);
+  } else {
+    pdsch_set_rnti(&pdsch, rnti);
+  }
+  
+  if (pdsch_set_threads(&pdsch, nof_threads)) {
+    fprintf(stderr, "Error setting %d decoder threads\n", nof_threads);
+    goto quit;
+  }
+  
+  if (pdsch_set_subblocks(&pdsch, nof_subblocks)) {
+    fprintf(stderr, "Error setting %d sub-blocks\n", nof_subblocks);
+    goto quit;
+  }
   
+  pdsch_set_fused_equalizer(&pdsch, fused_equalizer);
+  pdsch_set_llr_format(&pdsch, llr_format);
+
   if (pdsch_harq_init(&harq_process, &pdsch)) {
     fprintf(stderr, "Error initiating HARQ process\n");
     goto quit;
   }
   
+  if (pdsch_harq_set_softbuf(&harq_process, softbuf) || 
+      pdsch_harq_set_ue_category(&harq_process, ue_category)) {
+    fprintf(stderr, "Error configuring HARQ soft buffers\n");
+    goto quit;
+  }
+  
   if (pdsch_harq_setup(&harq_process, mcs, &prb_alloc)) {
     fprintf(stderr, "Error configuring HARQ process\n");
     goto quit;
@@ -186,13 +415,38 @@ int main(int argc, char **argv) {
   for (i=0;i<mcs.tbs;i++) {
     data[i] = rand()%2;
   }
+  bit_pack_vector(data, data_packed, mcs.tbs);
 
   for (rv=0;rv<=rv_idx;rv++) {
     printf("Encoding rv_idx=%d\n",rv);
-    if (pdsch_encode(&pdsch, data, slot_symbols, subframe, &harq_process, rv)) {
+    if (rnti_param) {
+      r = pdsch_encode_rnti(&pdsch, data, slot_symbols, subframe, &harq_process, rv, rnti);
+    } else {
+      r = pdsch_encode(&pdsch, data, slot_symbols, subframe, &harq_process, rv);
+    }
+    if (r) {
       fprintf(stderr, "Error encoding PDSCH\n");
       goto quit;
     }
+    
+    /* the packed path reuses the circular buffers filled by the char path */
+    if (packed) {
+      if (pdsch_encode_packed(&pdsch, data_packed, slot_symbols_packed, subframe, &harq_process, 
+                              rv, rnti)) {
+        fprintf(stderr, "Error encoding packed PDSCH\n");
+        goto quit;
+      }
+      for (i=0;i<cell.nof_ports;i++) {
+        if (memcmp(slot_symbols[i], slot_symbols_packed[i], sizeof(cf_t) * nof_re)) {
+          fprintf(stderr, "Packed and unpacked PDSCH symbols differ in port %d\n", i);
+          goto quit;
+        }
+      }
+    }
+
+    if (missed_rv0 && rv < rv_idx) {
+      continue;
+    }
 
     /* combine outputs */
     for (i=0;i<cell.nof_ports;i++) {
@@ -204,8 +458,27 @@ int main(int argc, char **argv) {
       }
     }
     
+    if (rnti_param && rv == 0) {
+      if (check_other_rnti(&pdsch, slot_symbols[0], ce, mcs, &prb_alloc, rv)) {
+        goto quit;
+      }
+    }
+    
+    if (llr_format != PDSCH_LLR_FLOAT && rv > 0) {
+      if (check_softbuf_mismatch(&pdsch, slot_symbols[0], ce, data_rx, &harq_process, rv)) {
+        goto quit;
+      }
+    }
+    
     gettimeofday(&t[1], NULL);
-    int r = pdsch_decode(&pdsch, slot_symbols[0], ce, data, subframe, &harq_process, rv);
+    if (packed) {
+      r = pdsch_decode_packed(&pdsch, slot_symbols[0], ce, data_packed_rx, subframe, &harq_process, 
+                              rv, rnti);
+    } else if (rnti_param) {
+      r = pdsch_decode_rnti(&pdsch, slot_symbols[0], ce, data_rx, subframe, &harq_process, rv, rnti);
+    } else {
+      r = pdsch_decode(&pdsch, slot_symbols[0], ce, data_rx, subframe, &harq_process, rv);
+    }
     gettimeofday(&t[2], NULL);
     get_time_interval(t);
     if (r) {
@@ -216,10 +489,31 @@ int main(int argc, char **argv) {
       printf("DECODED OK in %d:%d (%.2f Mbps)\n", (int) t[0].tv_sec, (int) t[0].tv_usec, (float) mcs.tbs/t[0].tv_usec);
     }
     
+    /* a correct CRC is not enough, an all-zero block passes it */
+    if (packed) {
+      for (i=0;i<mcs.tbs;i++) {
+        if (((data_packed_rx[i/8] >> (7-i%8)) & 1) != data[i]) {
+          fprintf(stderr, "Packed decoded bit %d differs\n", i);
+          ret = -1;
+          goto quit;
+        }
+      }
+    } else if (memcmp(data, data_rx, mcs.tbs)) {
+      fprintf(stderr, "Decoded bits differ\n");
+      ret = -1;
+      goto quit;
+    }
+
+    if (check_equalizer(&pdsch, slot_symbols[0], &prb_alloc, nof_re)) {
+      ret = -1;
+      goto quit;
+    }
+    
   }
   ret = 0;
 quit:
   pdsch_free(&pdsch);
+  sequence_cache_free(&seq_cache);
 
   for (i=0;i<cell.nof_ports;i++) {
     if (ce[i]) {
@@ -228,10 +522,22 @@ quit:
     if (slot_symbols[i]) {
       free(slot_symbols[i]);
     }
+    if (slot_symbols_packed[i]) {
+      free(slot_symbols_packed[i]);
+    }
   }
   if (data) {
     free(data);
   }
+  if (data_rx) {
+    free(data_rx);
+  }
+  if (data_packed) {
+    free(data_packed);
+  }
+  if (data_packed_rx) {
+    free(data_packed_rx);
+  }
   if (ret) {
     printf("Error\n");
   } else {
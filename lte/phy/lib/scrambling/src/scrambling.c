@@ -31,16 +31,158 @@
 #include <assert.h>
 #include "liblte/phy/scrambling/scrambling.h"
 
+#if defined(LV_HAVE_AVX2)
+#include <immintrin.h>
+#elif defined(LV_HAVE_SSE)
+#include <smmintrin.h>
+#endif
+
+/* Scrambling sequences are read from their packed form 64 bits at a time. 
+ * seq_word() returns the 64 sequence bits starting at bit pos, in the same 
+ * byte order as they are stored in memory (MSB first within each byte), so 
+ * on x86 the k-th sequence byte is (w >> 8*k) & 0xff. 
+ */
+static inline uint8_t seq_byte(sequence_t *s, uint32_t pos) {
+  uint8_t *c = &s->c_packed[pos / 8];
+  uint32_t r = pos % 8;
+  return r ? (uint8_t) ((c[0] << r) | (c[1] >> (8 - r))) : c[0];
+}
+
+static inline uint64_t seq_word(sequence_t *s, uint32_t pos) {
+  uint64_t w;
+  int i;
+
+  if (pos % 8 == 0) {
+    memcpy(&w, &s->c_packed[pos / 8], sizeof(uint64_t));
+  } else {
+    uint8_t b[8];
+    for (i = 0; i < 8; i++) {
+      b[i] = seq_byte(s, pos + 8 * i);
+    }
+    memcpy(&w, b, sizeof(uint64_t));
+  }
+  return w;
+}
+
 void scrambling_f(sequence_t *s, float *data) {
   scrambling_f_offset(s, data, 0, s->len);
 }
 
+/* Floats are descrambled flipping their sign bit. Each sequence bit is 
+ * expanded to a lane mask holding only the sign bit. 
+ */
 void scrambling_f_offset(sequence_t *s, float *data, int offset, int len) {
-  int i;  
+  int i = 0, j;
   assert (len + offset <= s->len);
 
-  for (i = 0; i < len; i++) {
-    data[i] = data[i] * (1 - 2 * s->c[i + offset]);
+#if defined(LV_HAVE_AVX2)
+  const __m256i sh = _mm256_setr_epi32(24, 25, 26, 27, 28, 29, 30, 31);
+  const __m256i sign = _mm256_set1_epi32(0x80000000);
+  for (; i + 64 <= len; i += 64) {
+    uint64_t w = seq_word(s, i + offset);
+    for (j = 0; j < 8; j++) {
+      __m256i m = _mm256_and_si256(_mm256_sllv_epi32(_mm256_set1_epi32((int) (w >> 8 * j)), sh), sign);
+      __m256 x = _mm256_loadu_ps(&data[i + 8 * j]);
+      _mm256_storeu_ps(&data[i + 8 * j], _mm256_xor_ps(x, _mm256_castsi256_ps(m)));
+    }
+  }
+#elif defined(LV_HAVE_SSE)
+  const __m128i sel = _mm_setr_epi32(0x80, 0x40, 0x20, 0x10);
+  const __m128i sign = _mm_set1_epi32(0x80000000);
+  for (; i + 64 <= len; i += 64) {
+    uint64_t w = seq_word(s, i + offset);
+    for (j = 0; j < 16; j++) {
+      __m128i v = _mm_set1_epi32((int) ((w >> 8 * (j / 2)) & 0xff) << 4 * (j % 2));
+      __m128i m = _mm_and_si128(_mm_cmpeq_epi32(_mm_and_si128(v, sel), sel), sign);
+      __m128 x = _mm_loadu_ps(&data[i + 4 * j]);
+      _mm_storeu_ps(&data[i + 4 * j], _mm_xor_ps(x, _mm_castsi128_ps(m)));
+    }
+  }
+#endif
+  for (; i < len; i++) {
+    if (s->c[i + offset]) {
+      data[i] = -data[i];
+    }
+  }
+}
+
+/* Fixed-point LLRs are negated as (x ^ m) - m, where m is all ones for the 
+ * lanes to flip. They must be saturated symmetrically so that negating them 
+ * does not overflow. 
+ */
+void scrambling_s_offset(sequence_t *s, int16_t *data, int offset, int len) {
+  int i = 0, j;
+  assert (len + offset <= s->len);
+
+#if defined(LV_HAVE_AVX2)
+  const __m256i sel = _mm256_setr_epi16(0x80, 0x40, 0x20, 0x10, 0x8, 0x4, 0x2, 0x1, 
+      0x8000, 0x4000, 0x2000, 0x1000, 0x800, 0x400, 0x200, 0x100);
+  for (; i + 64 <= len; i += 64) {
+    uint64_t w = seq_word(s, i + offset);
+    for (j = 0; j < 4; j++) {
+      __m256i m = _mm256_set1_epi16((short) (w >> 16 * j));
+      m = _mm256_cmpeq_epi16(_mm256_and_si256(m, sel), sel);
+      __m256i x = _mm256_loadu_si256((__m256i*) &data[i + 16 * j]);
+      x = _mm256_sub_epi16(_mm256_xor_si256(x, m), m);
+      _mm256_storeu_si256((__m256i*) &data[i + 16 * j], x);
+    }
+  }
+#elif defined(LV_HAVE_SSE)
+  const __m128i sel = _mm_setr_epi16(0x80, 0x40, 0x20, 0x10, 0x8, 0x4, 0x2, 0x1);
+  for (; i + 64 <= len; i += 64) {
+    uint64_t w = seq_word(s, i + offset);
+    for (j = 0; j < 8; j++) {
+      __m128i m = _mm_set1_epi16((short) (w >> 8 * j));
+      m = _mm_cmpeq_epi16(_mm_and_si128(m, sel), sel);
+      __m128i x = _mm_loadu_si128((__m128i*) &data[i + 8 * j]);
+      x = _mm_sub_epi16(_mm_xor_si128(x, m), m);
+      _mm_storeu_si128((__m128i*) &data[i + 8 * j], x);
+    }
+  }
+#endif
+  for (; i < len; i++) {
+    if (s->c[i + offset]) {
+      data[i] = -data[i];
+    }
+  }
+}
+
+void scrambling_sb_offset(sequence_t *s, int8_t *data, int offset, int len) {
+  int i = 0, j;
+  assert (len + offset <= s->len);
+
+#if defined(LV_HAVE_AVX2)
+  const __m256i sel = _mm256_set1_epi64x(0x0102040810204080);
+  const __m256i idx = _mm256_setr_epi8(0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1, 
+      2, 2, 2, 2, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 3, 3);
+  for (; i + 64 <= len; i += 64) {
+    uint64_t w = seq_word(s, i + offset);
+    for (j = 0; j < 2; j++) {
+      __m256i m = _mm256_shuffle_epi8(_mm256_set1_epi32((int) (w >> 32 * j)), idx);
+      m = _mm256_cmpeq_epi8(_mm256_and_si256(m, sel), sel);
+      __m256i x = _mm256_loadu_si256((__m256i*) &data[i + 32 * j]);
+      x = _mm256_sub_epi8(_mm256_xor_si256(x, m), m);
+      _mm256_storeu_si256((__m256i*) &data[i + 32 * j], x);
+    }
+  }
+#elif defined(LV_HAVE_SSE)
+  const __m128i sel = _mm_set1_epi64x(0x0102040810204080);
+  const __m128i idx = _mm_setr_epi8(0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1);
+  for (; i + 64 <= len; i += 64) {
+    uint64_t w = seq_word(s, i + offset);
+    for (j = 0; j < 4; j++) {
+      __m128i m = _mm_shuffle_epi8(_mm_cvtsi32_si128((int) (w >> 16 * j)), idx);
+      m = _mm_cmpeq_epi8(_mm_and_si128(m, sel), sel);
+      __m128i x = _mm_loadu_si128((__m128i*) &data[i + 16 * j]);
+      x = _mm_sub_epi8(_mm_xor_si128(x, m), m);
+      _mm_storeu_si128((__m128i*) &data[i + 16 * j], x);
+    }
+  }
+#endif
+  for (; i < len; i++) {
+    if (s->c[i + offset]) {
+      data[i] = -data[i];
+    }
   }
 }
 
@@ -58,18 +200,40 @@ void scrambling_c_offset(sequence_t *s, cf_t *data, int offset, int len) {
 }
 
 void scrambling_b(sequence_t *s, char *data) {
-  int i;
-
-  for (i = 0; i < s->len; i++) {
-    data[i] = (data[i] + s->c[i]) % 2;
-  }
+  scrambling_b_offset(s, data, 0, s->len);
 }
 
 void scrambling_b_offset(sequence_t *s, char *data, int offset, int len) {
   int i;
   assert (len + offset <= s->len);
   for (i = 0; i < len; i++) {
-    data[i] = (data[i] + s->c[i + offset]) % 2;
+    data[i] ^= s->c[i + offset];
+  }
+}
+
+void scrambling_b_packed(sequence_t *s, uint8_t *data) {
+  scrambling_b_packed_offset(s, data, 0, s->len);
+}
+
+/* Scrambles len bits packed MSB first in data. The unused bits of the last 
+ * byte are left untouched. 
+ */
+void scrambling_b_packed_offset(sequence_t *s, uint8_t *data, int offset, int len) {
+  int i;
+  uint64_t w, x;
+  assert (len + offset <= s->len);
+
+  for (i = 0; i + 64 <= len; i += 64) {
+    w = seq_word(s, i + offset);
+    memcpy(&x, &data[i / 8], sizeof(uint64_t));
+    x ^= w;
+    memcpy(&data[i / 8], &x, sizeof(uint64_t));
+  }
+  for (; i + 8 <= len; i += 8) {
+    data[i / 8] ^= seq_byte(s, i + offset);
+  }
+  if (i < len) {
+    data[i / 8] ^= seq_byte(s, i + offset) & (uint8_t) (0xff << (8 - (len - i)));
   }
 }
 
@@ -81,12 +81,98 @@ void parse_args(int argc, char **argv) {
 int init_sequence(sequence_t *seq, char *name) {
   if (!strcmp(name, "PBCH")) {
     return sequence_pbch(seq, cp, cell_id);
+  } else if (!strcmp(name, "PDSCH")) {
+    return sequence_pdsch(seq, 1234, 0, 0, cell_id, 110 * 12 * 14 * 6);
   } else {
     fprintf(stderr, "Unsupported sequence name %s\n", name);
     return -1;
   }
 }
 
+/* Offsets and lengths at which the scrambling kernels are compared with the 
+ * one bit per char sequence. 
+ */
+#define NOF_OFFSETS 5
+
+void get_offset(sequence_t *seq, int k, int *offset, int *len) {
+  int offsets[NOF_OFFSETS] = {0, 1, 7, 64, 133};
+  *offset = offsets[k];
+  *len = seq->len - *offset - k;
+}
+
+int test_packed(sequence_t *seq) {
+  int i, k, offset, len;
+  char *input = malloc(sizeof(char) * seq->len);
+  char *bits = malloc(sizeof(char) * seq->len);
+  uint8_t *packed = malloc(sizeof(uint8_t) * (seq->len + 7) / 8);
+  if (!input || !bits || !packed) {
+    perror("malloc");
+    exit(-1);
+  }
+  for (k = 0; k < NOF_OFFSETS; k++) {
+    get_offset(seq, k, &offset, &len);
+    for (i = 0; i < len; i++) {
+      input[i] = rand() % 2;
+      bits[i] = input[i];
+    }
+    bit_pack_vector(bits, packed, len);
+    scrambling_b_offset(seq, bits, offset, len);
+    scrambling_b_packed_offset(seq, packed, offset, len);
+    for (i = 0; i < len; i++) {
+      if (bits[i] != (input[i] ^ seq->c[i + offset]) || 
+          ((packed[i / 8] >> (7 - i % 8)) & 1) != bits[i]) {
+        printf("Error in packed bit %d, offset %d\n", i, offset);
+        return -1;
+      }
+    }
+  }
+  free(input);
+  free(bits);
+  free(packed);
+  return 0;
+}
+
+int test_fixed(sequence_t *seq) {
+  int i, k, offset, len;
+  int16_t *x_s = malloc(sizeof(int16_t) * seq->len);
+  int16_t *y_s = malloc(sizeof(int16_t) * seq->len);
+  int8_t *x_b = malloc(sizeof(int8_t) * seq->len);
+  int8_t *y_b = malloc(sizeof(int8_t) * seq->len);
+  float *x_f = malloc(sizeof(float) * seq->len);
+  float *y_f = malloc(sizeof(float) * seq->len);
+  if (!x_s || !y_s || !x_b || !y_b || !x_f || !y_f) {
+    perror("malloc");
+    exit(-1);
+  }
+  for (k = 0; k < NOF_OFFSETS; k++) {
+    get_offset(seq, k, &offset, &len);
+    for (i = 0; i < len; i++) {
+      x_s[i] = (rand() % (2 * INT16_MAX + 1)) - INT16_MAX;
+      x_b[i] = (rand() % (2 * INT8_MAX + 1)) - INT8_MAX;
+      x_f[i] = (float) rand() / RAND_MAX - 0.5;
+      y_s[i] = x_s[i];
+      y_b[i] = x_b[i];
+      y_f[i] = x_f[i];
+    }
+    scrambling_s_offset(seq, y_s, offset, len);
+    scrambling_sb_offset(seq, y_b, offset, len);
+    scrambling_f_offset(seq, y_f, offset, len);
+    for (i = 0; i < len; i++) {
+      int sign = 1 - 2 * seq->c[i + offset];
+      if (y_s[i] != sign * x_s[i] || y_b[i] != sign * x_b[i] || y_f[i] != sign * x_f[i]) {
+        printf("Error in LLR %d, offset %d\n", i, offset);
+        return -1;
+      }
+    }
+  }
+  free(x_s);
+  free(y_s);
+  free(x_b);
+  free(y_b);
+  free(x_f);
+  free(y_f);
+  return 0;
+}
 
 int main(int argc, char **argv) {
   int i;
@@ -96,6 +182,7 @@ int main(int argc, char **argv) {
 
   parse_args(argc, argv);
 
+  bzero(&seq, sizeof(sequence_t));
   if (init_sequence(&seq, sequence_name) == -1) {
     fprintf(stderr, "Error initiating sequence %s\n", sequence_name);
     exit(-1);
@@ -129,6 +216,10 @@ int main(int argc, char **argv) {
     }
     free(input_b);
     free(scrambled_b);
+
+    if (test_packed(&seq)) {
+      exit(-1);
+    }
   } else {
     input_f = malloc(sizeof(float) * seq.len);
     if (!input_f) {
@@ -158,6 +249,10 @@ int main(int argc, char **argv) {
 
     free(input_f);
     free(scrambled_f);
+
+    if (test_fixed(&seq)) {
+      exit(-1);
+    }
   }
   printf("Ok\n");
   sequence_free(&seq);
@@ -147,12 +147,12 @@ int frame_cnt=0;
 
 int ue_dl_decode(ue_dl_t *q, cf_t *input, char *data, uint32_t sf_idx, uint16_t rnti) 
 {
-  uint32_t cfi, cfi_distance, i;
+  uint32_t cfi, cfi_distance;
   ra_pdsch_t ra_dl;
   dci_location_t locations[10];
-  dci_msg_t dci_msg;
+  pdcch_candidate_t candidate;
   uint32_t nof_locations;
-  uint16_t crc_rem; 
+  int nof_candidates = 0;
   dci_format_t format; 
   pbch_mib_t mib; 
   int ret = LIBLTE_ERROR; 
@@ -220,21 +220,19 @@ int ue_dl_decode(ue_dl_t *q, cf_t *input, char *data, uint32_t sf_idx, uint16_t
     }
 
 
-    crc_rem = 0;
-    for (i=0;i<nof_locations && crc_rem != rnti;i++) {
-      if (pdcch_extract_llr(&q->pdcch, q->sf_symbols, q->ce, locations[i], sf_idx, cfi)) {
-        fprintf(stderr, "Error extracting LLRs\n");
-        return LIBLTE_ERROR;
-      }
-      if (pdcch_decode_msg(&q->pdcch, &dci_msg, format, &crc_rem)) {
-        fprintf(stderr, "Error decoding DCI msg\n");
-        return LIBLTE_ERROR;
-      }
-      INFO("Decoded DCI message RNTI: 0x%x\n", crc_rem);
+    if (pdcch_extract_llr_region(&q->pdcch, q->sf_symbols, q->ce, sf_idx, cfi)) {
+      fprintf(stderr, "Error extracting LLRs\n");
+      return LIBLTE_ERROR;
+    }
+    nof_candidates = pdcch_blind_search(&q->pdcch, locations, nof_locations, &format, 1, 
+                                        &rnti, 1, &candidate, 1);
+    if (nof_candidates < 0) {
+      fprintf(stderr, "Error decoding DCI msg\n");
+      return LIBLTE_ERROR;
     }
       
-    if (crc_rem == rnti) {
-      if (dci_msg_to_ra_dl(&dci_msg, rnti, q->user_rnti, q->cell, cfi, &ra_dl)) {
+    if (nof_candidates > 0) {
+      if (dci_msg_to_ra_dl(&candidate.msg, rnti, q->user_rnti, q->cell, cfi, &ra_dl)) {
         fprintf(stderr, "Error unpacking PDSCH scheduling DCI message\n");
         return LIBLTE_ERROR;
       }
@@ -266,8 +264,8 @@ int ue_dl_decode(ue_dl_t *q, cf_t *input, char *data, uint32_t sf_idx, uint16_t
         }
       }
       if (q->harq_process[0].mcs.mod > 0) {
-        ret = pdsch_decode(&q->pdsch, q->sf_symbols, q->ce, data, sf_idx, 
-            &q->harq_process[0], rvidx);
+        ret = pdsch_decode_rnti(&q->pdsch, q->sf_symbols, q->ce, data, sf_idx, 
+            &q->harq_process[0], rvidx, rnti);
         if (ret == LIBLTE_ERROR) {
           if (rnti == SIRNTI && rvidx == 1) {
             q->pkt_errors++;
@@ -275,7 +273,7 @@ int ue_dl_decode(ue_dl_t *q, cf_t *input, char *data, uint32_t sf_idx, uint16_t
             q->pkt_errors++;                
           }            
         } else if (ret == LIBLTE_ERROR_INVALID_INPUTS) {
-          fprintf(stderr, "Error calling pdsch_decode()\n");
+          fprintf(stderr, "Error calling pdsch_decode_rnti()\n");
           return LIBLTE_ERROR; 
         } else if (ret == LIBLTE_SUCCESS) {
           if (VERBOSE_ISINFO()) {
@@ -295,7 +293,7 @@ int ue_dl_decode(ue_dl_t *q, cf_t *input, char *data, uint32_t sf_idx, uint16_t
     }
   }
 
-  if (crc_rem == rnti && ret == LIBLTE_SUCCESS) {        
+  if (nof_candidates > 0 && ret == LIBLTE_SUCCESS) {        
     return ra_dl.mcs.tbs;    
   } else {
     return 0;
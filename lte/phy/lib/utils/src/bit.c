@@ -28,6 +28,7 @@
 
 #include <stdint.h>
 #include <stdio.h>
+#include <string.h>
 
 #include "liblte/phy/utils/bit.h"
 
@@ -53,6 +54,91 @@ uint32_t bit_unpack(char **bits, int nof_bits)
     return value;
 }
 
+/* Packs one bit per char into bytes, MSB first. The unused bits of the last 
+ * byte are set to zero. 
+ */
+void bit_pack_vector(char *bits, uint8_t *packed, int nof_bits)
+{
+    int i, j;
+    uint8_t byte;
+
+    for (i = 0; i < nof_bits / 8; i++) {
+      byte = 0;
+      for (j = 0; j < 8; j++) {
+        byte |= (bits[8 * i + j] & 0x1) << (7 - j);
+      }
+      packed[i] = byte;
+    }
+    if (nof_bits % 8) {
+      byte = 0;
+      for (j = 0; j < nof_bits % 8; j++) {
+        byte |= (bits[8 * i + j] & 0x1) << (7 - j);
+      }
+      packed[i] = byte;
+    }
+}
+
+/* Unpacks bytes, MSB first, into one bit per char */
+void bit_unpack_vector(uint8_t *packed, char *bits, int nof_bits)
+{
+    int i, j;
+
+    for (i = 0; i < nof_bits / 8; i++) {
+      for (j = 0; j < 8; j++) {
+        bits[8 * i + j] = (packed[i] >> (7 - j)) & 0x1;
+      }
+    }
+    for (j = 0; j < nof_bits % 8; j++) {
+      bits[8 * i + j] = (packed[i] >> (7 - j)) & 0x1;
+    }
+}
+
+/* Copies nof_bits packed MSB first from bit src_offset of src to bit dst_offset 
+ * of dst. The bits of dst outside the destination range are not modified. 
+ */
+void bit_copy(uint8_t *dst, uint32_t dst_offset, uint8_t *src, uint32_t src_offset, 
+              uint32_t nof_bits)
+{
+    uint32_t i, n, r;
+    uint8_t byte, mask;
+
+    /* Copy bit by bit up to a byte boundary of dst */
+    while (nof_bits > 0 && dst_offset % 8) {
+      mask = 0x80 >> (dst_offset % 8);
+      if ((src[src_offset / 8] >> (7 - src_offset % 8)) & 0x1) {
+        dst[dst_offset / 8] |= mask;
+      } else {
+        dst[dst_offset / 8] &= ~mask;
+      }
+      dst_offset++;
+      src_offset++;
+      nof_bits--;
+    }
+
+    dst += dst_offset / 8;
+    src += src_offset / 8;
+    n = nof_bits / 8;
+    r = src_offset % 8;
+    if (r == 0) {
+      memcpy(dst, src, n);
+    } else {
+      for (i = 0; i < n; i++) {
+        dst[i] = (uint8_t) ((src[i] << r) | (src[i + 1] >> (8 - r)));
+      }
+    }
+
+    /* Remaining bits of the last byte */
+    nof_bits %= 8;
+    if (nof_bits) {
+      byte = (uint8_t) (src[n] << r);
+      if (r + nof_bits > 8) {
+        byte |= src[n + 1] >> (8 - r);
+      }
+      mask = (uint8_t) (0xff << (8 - nof_bits));
+      dst[n] = (dst[n] & ~mask) | (byte & mask);
+    }
+}
+
 void bit_fprint(FILE *stream, char *bits, int nof_bits) {
   int i;
 
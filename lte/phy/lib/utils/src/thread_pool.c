@@ -0,0 +1,159 @@
+/**
+ *
+ * \section COPYRIGHT
+ *
+ * Copyright 2013-2014 The libLTE Developers. See the
+ * COPYRIGHT file at the top-level directory of this distribution.
+ *
+ * \section LICENSE
+ *
+ * This file is part of the libLTE library.
+ *
+ * libLTE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libLTE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * A copy of the GNU Lesser General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <strings.h>
+#include <pthread.h>
+
+#include "liblte/phy/utils/thread_pool.h"
+
+struct thread_pool_worker {
+  thread_pool_t *pool;
+  uint32_t idx;
+};
+
+/* Executes pending jobs until there are no more left. Called with the mutex locked */
+static void run_jobs(thread_pool_t *q, uint32_t worker_idx) {
+  uint32_t job_idx;
+  while (q->next_job < q->nof_jobs) {
+    job_idx = q->next_job++;
+    pthread_mutex_unlock(&q->mutex);
+
+    q->job(q->arg, job_idx, worker_idx);
+
+    pthread_mutex_lock(&q->mutex);
+    q->pending_jobs--;
+    if (!q->pending_jobs) {
+      pthread_cond_signal(&q->cvar_done);
+    }
+  }
+}
+
+static void *worker_thread(void *arg) {
+  struct thread_pool_worker *w = (struct thread_pool_worker*) arg;
+  thread_pool_t *q = w->pool;
+
+  pthread_mutex_lock(&q->mutex);
+  while (!q->stop) {
+    run_jobs(q, w->idx);
+    if (!q->stop) {
+      pthread_cond_wait(&q->cvar_jobs, &q->mutex);
+    }
+  }
+  pthread_mutex_unlock(&q->mutex);
+  return NULL;
+}
+
+int thread_pool_init(thread_pool_t *q, uint32_t nof_workers) {
+  uint32_t i;
+
+  if (q == NULL || nof_workers == 0) {
+    return -1;
+  }
+
+  bzero(q, sizeof(thread_pool_t));
+
+  pthread_mutex_init(&q->mutex, NULL);
+  pthread_cond_init(&q->cvar_jobs, NULL);
+  pthread_cond_init(&q->cvar_done, NULL);
+  q->nof_workers = 1;
+
+  if (nof_workers > 1) {
+    q->threads = malloc(sizeof(pthread_t) * (nof_workers - 1));
+    if (!q->threads) {
+      perror("malloc");
+      goto clean;
+    }
+    q->workers = malloc(sizeof(struct thread_pool_worker) * (nof_workers - 1));
+    if (!q->workers) {
+      perror("malloc");
+      goto clean;
+    }
+    for (i = 0; i < nof_workers - 1; i++) {
+      q->workers[i].pool = q;
+      q->workers[i].idx = i + 1;
+      if (pthread_create(&q->threads[i], NULL, worker_thread, &q->workers[i])) {
+        perror("pthread_create");
+        goto clean;
+      }
+      q->nof_workers++;
+    }
+  }
+  return 0;
+
+clean:
+  thread_pool_free(q);
+  return -1;
+}
+
+void thread_pool_free(thread_pool_t *q) {
+  uint32_t i;
+  if (q->nof_workers) {
+    pthread_mutex_lock(&q->mutex);
+    q->stop = true;
+    pthread_cond_broadcast(&q->cvar_jobs);
+    pthread_mutex_unlock(&q->mutex);
+
+    for (i = 0; i < q->nof_workers - 1; i++) {
+      pthread_join(q->threads[i], NULL);
+    }
+
+    pthread_mutex_destroy(&q->mutex);
+    pthread_cond_destroy(&q->cvar_jobs);
+    pthread_cond_destroy(&q->cvar_done);
+  }
+  if (q->threads) {
+    free(q->threads);
+  }
+  if (q->workers) {
+    free(q->workers);
+  }
+  bzero(q, sizeof(thread_pool_t));
+}
+
+void thread_pool_run(thread_pool_t *q, uint32_t nof_jobs, thread_pool_job_t job, void *arg) {
+  pthread_mutex_lock(&q->mutex);
+
+  q->job = job;
+  q->arg = arg;
+  q->nof_jobs = nof_jobs;
+  q->next_job = 0;
+  q->pending_jobs = nof_jobs;
+  pthread_cond_broadcast(&q->cvar_jobs);
+
+  /* The calling thread is worker 0 */
+  run_jobs(q, 0);
+
+  while (q->pending_jobs) {
+    pthread_cond_wait(&q->cvar_done, &q->mutex);
+  }
+  q->nof_jobs = 0;
+  q->next_job = 0;
+
+  pthread_mutex_unlock(&q->mutex);
+}
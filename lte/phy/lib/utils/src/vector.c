@@ -27,6 +27,7 @@
 
 
 #include <float.h>
+#include <math.h>
 #include <complex.h>
 #include <stdlib.h>
 #include <string.h>
@@ -38,6 +39,10 @@
 #include "volk/volk.h"
 #endif
 
+#ifdef LV_HAVE_SSE
+#include <smmintrin.h>
+#endif
+
 int vec_acc_ii(int *x, uint32_t len) {
   int i;
   int z=0;
@@ -461,9 +466,25 @@ uint32_t vec_max_abs_ci(cf_t *x, uint32_t len) {
 }
 
 void vec_quant_fuc(float *in, unsigned char *out, float gain, float offset, float clip, uint32_t len) {
-  int i;
+  int i = 0;
   int tmp;
-  for (i=0;i<len;i++) {
+#ifdef LV_HAVE_SSE
+  /* Truncate 16 values at a time. Packing with saturation clips them to 0..255 */
+  if (clip >= 0 && clip <= 255) {
+    __m128 g = _mm_set1_ps(gain);
+    __m128 o = _mm_set1_ps(offset);
+    __m128i c = _mm_set1_epi8((char) (uint8_t) clip);
+    __m128i a, b;
+    for (;i<(int) len-15;i+=16) {
+      a = _mm_packs_epi32(_mm_cvttps_epi32(_mm_add_ps(o, _mm_mul_ps(g, _mm_loadu_ps(&in[i])))), 
+                          _mm_cvttps_epi32(_mm_add_ps(o, _mm_mul_ps(g, _mm_loadu_ps(&in[i+4])))));
+      b = _mm_packs_epi32(_mm_cvttps_epi32(_mm_add_ps(o, _mm_mul_ps(g, _mm_loadu_ps(&in[i+8])))), 
+                          _mm_cvttps_epi32(_mm_add_ps(o, _mm_mul_ps(g, _mm_loadu_ps(&in[i+12])))));
+      _mm_storeu_si128((__m128i*) &out[i], _mm_min_epu8(_mm_packus_epi16(a, b), c));
+    }
+  }
+#endif
+  for (;i<len;i++) {
     tmp = (int) (offset + gain * in[i]);
     if (tmp < 0)
       tmp = 0;
@@ -474,3 +495,55 @@ void vec_quant_fuc(float *in, unsigned char *out, float gain, float offset, floa
 
 }
 
+/* Saturates x symmetrically to [-max, max] so that the result can be negated */
+static inline float quant_clip(float x, float max) {
+  if (x > max) {
+    return max;
+  } else if (x < -max) {
+    return -max;
+  } else {
+    return x;
+  }
+}
+
+#ifdef LV_HAVE_SSE
+/* Scales 4 values, saturates them to [-max, max] and rounds them to int32 */
+static inline __m128i quant_sse(float *in, __m128 g, __m128 max) {
+  __m128 x = _mm_mul_ps(g, _mm_loadu_ps(in));
+  x = _mm_min_ps(_mm_max_ps(x, _mm_sub_ps(_mm_setzero_ps(), max)), max);
+  return _mm_cvtps_epi32(x);
+}
+#endif
+
+void vec_quant_fs(float *in, int16_t *out, float gain, uint32_t len) {
+  int i = 0;
+#ifdef LV_HAVE_SSE
+  __m128 g = _mm_set1_ps(gain);
+  __m128 max = _mm_set1_ps(INT16_MAX);
+  for (;i<(int) len-7;i+=8) {
+    _mm_storeu_si128((__m128i*) &out[i], _mm_packs_epi32(quant_sse(&in[i], g, max), 
+                                                         quant_sse(&in[i+4], g, max)));
+  }
+#endif
+  for (;i<len;i++) {
+    out[i] = (int16_t) lrintf(quant_clip(gain * in[i], INT16_MAX));
+  }
+}
+
+void vec_quant_fc(float *in, int8_t *out, float gain, uint32_t len) {
+  int i = 0;
+#ifdef LV_HAVE_SSE
+  __m128 g = _mm_set1_ps(gain);
+  __m128 max = _mm_set1_ps(INT8_MAX);
+  __m128i a, b;
+  for (;i<(int) len-15;i+=16) {
+    a = _mm_packs_epi32(quant_sse(&in[i], g, max), quant_sse(&in[i+4], g, max));
+    b = _mm_packs_epi32(quant_sse(&in[i+8], g, max), quant_sse(&in[i+12], g, max));
+    _mm_storeu_si128((__m128i*) &out[i], _mm_packs_epi16(a, b));
+  }
+#endif
+  for (;i<len;i++) {
+    out[i] = (int8_t) lrintf(quant_clip(gain * in[i], INT8_MAX));
+  }
+}
+